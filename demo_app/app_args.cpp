@@ -25,6 +25,25 @@ const char AppArgs::testHelpString[] =
     "-test : If specified, compare the GPU-generated mipmaps to CPU-generated\n"
     "mipmaps; affects benchmark and -i images if any.\n";
 
+const char AppArgs::bufferOutputHelpString[] =
+    "-buffer : Generate the -i mipmaps (for -o and -test) directly in the\n"
+    "host-visible staging buffer instead of the image, skipping the\n"
+    "image-to-buffer copy. Ignores -pipeline.\n";
+
+const char AppArgs::instrumentPrefixHelpString[] =
+    "-instrument [prefix] : Generate the -i mipmaps with the -pipeline\n"
+    "alternative compiled with NVPRO_PYRAMID_INSTRUMENT, and write the\n"
+    "per-dispatch workgroup duration histograms to [prefix].json and a\n"
+    "heatmap of workgroup durations to [prefix].png. Needs VK_KHR_shader_clock.\n"
+    "Should specify -i as well.\n"
+    "Implicitly disables opening a window.\n";
+
+const char AppArgs::subgroupSizeHelpString[] =
+    "-subgroup-size [int] : Require this compute subgroup size (needs\n"
+    "VK_EXT_subgroup_size_control) instead of the supported size nearest 32,\n"
+    "e.g. with -test to check sizes 4, 8, 16 or 64. Pipeline alternatives\n"
+    "with extras/ fast pipelines use only their general pipeline unless 32.\n";
+
 const char AppArgs::animationTextureHelpString[] =
     "-texture [int] [int] : Specify the texture size that the state of the\n"
      "animation is drawn to.\n";
@@ -33,6 +52,19 @@ const char AppArgs::benchmarkFilenameHelpString[] =
     "-benchmark [filename] : dump json nanosecond timing info to named file.\n"
     "Implicitly disables opening a window.\n";
 
+const char AppArgs::hdrFilenameHelpString[] =
+    "-hdr [file] : .hdr image used (tiled) as input for the RGBA16F/RGBA32F\n"
+    "benchmark. If not specified, a synthetic HDR image is used.\n";
+
+const char AppArgs::pipelineCacheFilenameHelpString[] =
+    "-pipelinecache [file] : Load the compute pipeline cache from, and save it\n"
+    "to, this file (default vk_compute_mipmaps_pipeline_cache.bin; ignored if\n"
+    "saved for another device or driver version). Empty string to disable.\n";
+
+const char AppArgs::prewarmPipelinesHelpString[] =
+    "-prewarm : create all mipmap pipeline alternatives in the background on\n"
+    "startup, instead of each when first used.\n";
+
 const char AppArgs::dumpPipelineStatsHelpString[] =
     "-stats : print static performance statistics for compute pipelines.\n";
 
@@ -68,14 +100,20 @@ void parseArgs(int argc, char** argv, AppArgs* outArgs)
 
     if (strcmp(arg, "-h") == 0 || strcmp(arg, "/?") == 0)
     {
-      printf("%s:\n%s\n%s\n%s\n%s\n%s\n%s\n%s\n%s",
+      printf("%s:\n%s\n%s\n%s\n%s\n%s\n%s\n%s\n%s\n%s\n%s\n%s\n%s\n%s\n%s",
         argv[0],
         AppArgs::inputFilenameHelpString,
         AppArgs::outputFilenameHelpString,
         AppArgs::outputPipelineAlternativeLabelHelpString,
         AppArgs::testHelpString,
+        AppArgs::bufferOutputHelpString,
+        AppArgs::instrumentPrefixHelpString,
+        AppArgs::subgroupSizeHelpString,
         AppArgs::animationTextureHelpString,
         AppArgs::benchmarkFilenameHelpString,
+        AppArgs::hdrFilenameHelpString,
+        AppArgs::pipelineCacheFilenameHelpString,
+        AppArgs::prewarmPipelinesHelpString,
         AppArgs::dumpPipelineStatsHelpString,
         AppArgs::openWindowHelpString);
       exit(0);
@@ -103,6 +141,25 @@ void parseArgs(int argc, char** argv, AppArgs* outArgs)
     {
       outArgs->test = true;
     }
+    else if (strcmp(arg, "-buffer") == 0)
+    {
+      outArgs->bufferOutput = true;
+    }
+    else if (strcmp(arg, "-instrument") == 0)
+    {
+      windowImplicitlyDisabled = true;
+      checkNeededParam(arg, param0);
+      outArgs->instrumentPrefix = param0;
+      ++i;
+    }
+    else if (strcmp(arg, "-subgroup-size") == 0)
+    {
+      checkNeededParam(arg, param0);
+      x = strtol(param0, &endptr, 0);
+      if (*endptr != '\0' || x <= 0) badNumber(param0);
+      outArgs->subgroupSize = uint32_t(x);
+      ++i;
+    }
     else if (strcmp(arg, "-texture") == 0)
     {
       checkNeededParam(arg, param0);
@@ -124,6 +181,22 @@ void parseArgs(int argc, char** argv, AppArgs* outArgs)
       outArgs->benchmarkFilename = param0;
       ++i;
     }
+    else if (strcmp(arg, "-hdr") == 0)
+    {
+      checkNeededParam(arg, param0);
+      outArgs->hdrFilename = param0;
+      ++i;
+    }
+    else if (strcmp(arg, "-pipelinecache") == 0)
+    {
+      checkNeededParam(arg, param0);
+      outArgs->pipelineCacheFilename = param0;
+      ++i;
+    }
+    else if (strcmp(arg, "-prewarm") == 0)
+    {
+      outArgs->prewarmPipelines = true;
+    }
     else if (strcmp(arg, "-stats") == 0)
     {
       outArgs->dumpPipelineStats = true;
@@ -20,6 +20,20 @@ struct AppArgs
   bool test;
   static const char testHelpString[];
 
+  // Generate the -i mipmaps directly in the staging buffer.
+  bool bufferOutput = false;
+  static const char bufferOutputHelpString[];
+
+  // Filename prefix for the workgroup timestamp report of generating
+  // the -i mipmaps; if specified, use instrumented pipelines.
+  std::string instrumentPrefix = "";
+  static const char instrumentPrefixHelpString[];
+
+  // Compute subgroup size to require instead of the one chosen by
+  // chooseComputeSubgroupSize; 0 for its choice.
+  uint32_t subgroupSize = 0;
+  static const char subgroupSizeHelpString[];
+
   // Size of texture that the animation is drawn to.
   uint32_t animationTextureWidth = 16384, animationTextureHeight = 16384;
   static const char animationTextureHelpString[];
@@ -29,6 +43,20 @@ struct AppArgs
   std::string benchmarkFilename = "";
   static const char benchmarkFilenameHelpString[];
 
+  // Optional .hdr input for the RGBA16F/RGBA32F benchmark.
+  std::string hdrFilename = "";
+  static const char hdrFilenameHelpString[];
+
+  // File that the compute pipeline cache is loaded from and saved to;
+  // empty to disable.
+  std::string pipelineCacheFilename = "vk_compute_mipmaps_pipeline_cache.bin";
+  static const char pipelineCacheFilenameHelpString[];
+
+  // Flag that creates all mipmap pipelines in a background thread on
+  // startup, instead of each on first use.
+  bool prewarmPipelines = false;
+  static const char prewarmPipelinesHelpString[];
+
   // Flag that enables static performance statistics for compute pipelines.
   bool dumpPipelineStats = false;
   static const char dumpPipelineStatsHelpString[];
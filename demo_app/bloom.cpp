@@ -0,0 +1,269 @@
+// Copyright 2021 NVIDIA CORPORATION
+// SPDX-License-Identifier: Apache-2.0
+
+// Implementation functions for the bloom effect.
+#include "bloom.hpp"
+
+#include <cassert>
+
+#include "nvvk/error_vk.hpp"
+
+#include "make_compute_pipeline.hpp"
+#include "nvpro_pyramid_bloom.hpp"
+
+Bloom::Bloom(VkDevice              device,
+             VkPhysicalDevice      physicalDevice,
+             VkDescriptorSetLayout sceneTextureLayout,
+             bool                  dumpPipelineStats,
+             uint32_t              sceneWidth,
+             uint32_t              sceneHeight)
+    : m_device(device)
+    , m_computeDescriptorContainer(device)
+    , m_textureDescriptorContainer(device)
+{
+  m_allocator.init(device, physicalDevice);
+
+  // Linear filtering for compositing; the compute shaders only use
+  // texelFetch. Repeat to match the tiled scene texture.
+  VkSamplerCreateInfo samplerInfo = {
+      VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO, nullptr, 0,
+      VK_FILTER_LINEAR, VK_FILTER_LINEAR,
+      VK_SAMPLER_MIPMAP_MODE_NEAREST,
+      VK_SAMPLER_ADDRESS_MODE_REPEAT,
+      VK_SAMPLER_ADDRESS_MODE_REPEAT,
+      VK_SAMPLER_ADDRESS_MODE_REPEAT};
+  samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+  NVVK_CHECK(vkCreateSampler(device, &samplerInfo, nullptr, &m_sampler));
+
+  // Set up descriptor set layouts (general layout images), matching
+  // bloom_preamble.glsl and bloom_upsample.comp.
+  m_computeDescriptorContainer.addBinding(
+      0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, uint32_t(m_downStorageViews.size()),
+      VK_SHADER_STAGE_COMPUTE_BIT);
+  m_computeDescriptorContainer.addBinding(
+      1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1,
+      VK_SHADER_STAGE_COMPUTE_BIT, &m_sampler);
+  m_computeDescriptorContainer.addBinding(
+      2, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, uint32_t(m_upStorageViews.size()),
+      VK_SHADER_STAGE_COMPUTE_BIT);
+  m_computeDescriptorContainer.addBinding(
+      3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1,
+      VK_SHADER_STAGE_COMPUTE_BIT, &m_sampler);
+  m_computeDescriptorContainer.initLayout();
+  m_computeDescriptorContainer.initPool(1);
+
+  m_textureDescriptorContainer.addBinding(
+      0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1,
+      VK_SHADER_STAGE_ALL, &m_sampler);
+  m_textureDescriptorContainer.initLayout();
+  m_textureDescriptorContainer.initPool(1);
+
+  // Set up compute pipelines, sharing one layout.
+  VkDescriptorSetLayout setLayouts[] = {
+      sceneTextureLayout, m_computeDescriptorContainer.getLayout()};
+  VkPushConstantRange pushConstantRange = {
+      VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t)};
+  VkPipelineLayoutCreateInfo layoutInfo = {
+      VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO, nullptr, 0,
+      2, setLayouts, 1, &pushConstantRange};
+  NVVK_CHECK(vkCreatePipelineLayout(device, &layoutInfo, nullptr, &m_layout));
+  const char* filenames[] = {"bloom_downsample_general_pipeline.comp.spv",
+                             "bloom_downsample_fast_pipeline.comp.spv",
+                             "bloom_upsample.comp.spv"};
+  VkPipeline* pipelines[] = {&m_downsampleGeneralPipeline,
+                             &m_downsampleFastPipeline, &m_upsamplePipeline};
+  makeComputePipelines(device, 3, filenames, dumpPipelineStats, m_layout,
+                       pipelines);
+
+  resize(sceneWidth, sceneHeight);
+}
+
+Bloom::~Bloom()
+{
+  vkDestroyPipeline(m_device, m_upsamplePipeline, nullptr);
+  vkDestroyPipeline(m_device, m_downsampleFastPipeline, nullptr);
+  vkDestroyPipeline(m_device, m_downsampleGeneralPipeline, nullptr);
+  vkDestroyPipelineLayout(m_device, m_layout, nullptr);
+  m_computeDescriptorContainer.deinit();
+  m_textureDescriptorContainer.deinit();
+  destroyImages();
+  vkDestroySampler(m_device, m_sampler, nullptr);
+  m_allocator.deinit();
+}
+
+void Bloom::destroyImages()
+{
+  for (auto* pViews : {&m_downStorageViews, &m_upStorageViews})
+  {
+    for (VkImageView& view : *pViews)
+    {
+      if (view) vkDestroyImageView(m_device, view, nullptr);
+      view = VK_NULL_HANDLE;
+    }
+  }
+  vkDestroyImageView(m_device, m_downView, nullptr);
+  vkDestroyImageView(m_device, m_upView, nullptr);
+  m_downView = m_upView = VK_NULL_HANDLE;
+  if (m_downImage.image) m_allocator.destroy(m_downImage);
+  if (m_upImage.image) m_allocator.destroy(m_upImage);
+}
+
+void Bloom::resize(uint32_t sceneWidth, uint32_t sceneHeight)
+{
+  destroyImages();
+  m_width      = sceneWidth;
+  m_height     = sceneHeight;
+  m_needsClear = true;
+
+  // Count levels as nvproCmdPyramidDispatch does, up to s_maxLevels.
+  m_levels = 0;
+  for (uint32_t x = sceneWidth, y = sceneHeight; x != 0 || y != 0; x >>= 1, y >>= 1)
+  {
+    ++m_levels;
+  }
+  m_levels = m_levels < s_maxLevels ? m_levels : s_maxLevels;
+
+  // Create images and image views; at least one level even if too
+  // small to bloom, so the composite texture stays valid.
+  uint32_t imageLevels = m_levels > 1 ? m_levels - 1 : 1;
+  uint32_t width       = sceneWidth >> 1 ? sceneWidth >> 1 : 1u;
+  uint32_t height      = sceneHeight >> 1 ? sceneHeight >> 1 : 1u;
+  VkImageCreateInfo imageInfo = {
+      VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO, nullptr, 0,
+      VK_IMAGE_TYPE_2D, VK_FORMAT_R16G16B16A16_SFLOAT, {width, height, 1},
+      imageLevels, 1, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_TILING_OPTIMAL,
+      VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT
+          | VK_IMAGE_USAGE_STORAGE_BIT,
+      VK_SHARING_MODE_EXCLUSIVE, 0, nullptr, VK_IMAGE_LAYOUT_UNDEFINED};
+  m_downImage = m_allocator.createImage(imageInfo);
+  m_upImage   = m_allocator.createImage(imageInfo);
+
+  VkImageViewCreateInfo viewInfo = {
+      VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO, nullptr, 0,
+      VK_NULL_HANDLE, VK_IMAGE_VIEW_TYPE_2D, imageInfo.format, {},
+      {VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_REMAINING_MIP_LEVELS, 0, 1}};
+  viewInfo.image = m_downImage.image;
+  NVVK_CHECK(vkCreateImageView(m_device, &viewInfo, nullptr, &m_downView));
+  viewInfo.image = m_upImage.image;
+  NVVK_CHECK(vkCreateImageView(m_device, &viewInfo, nullptr, &m_upView));
+  for (uint32_t level = 0; level < imageLevels; ++level)
+  {
+    viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1};
+    viewInfo.image            = m_downImage.image;
+    NVVK_CHECK(vkCreateImageView(m_device, &viewInfo, nullptr,
+                                 &m_downStorageViews[level]));
+    viewInfo.image = m_upImage.image;
+    NVVK_CHECK(vkCreateImageView(m_device, &viewInfo, nullptr,
+                                 &m_upStorageViews[level]));
+  }
+
+  // Update descriptors; dummy data for excess mip levels, as in ScopedImage.
+  VkWriteDescriptorSet  write{};
+  VkDescriptorImageInfo descriptorInfo = {
+      VK_NULL_HANDLE, m_downView, VK_IMAGE_LAYOUT_GENERAL};
+  write = m_computeDescriptorContainer.makeWrite(0, 1, &descriptorInfo, 0);
+  vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
+  descriptorInfo.imageView = m_upView;
+  write = m_computeDescriptorContainer.makeWrite(0, 3, &descriptorInfo, 0);
+  vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
+  write = m_textureDescriptorContainer.makeWrite(0, 0, &descriptorInfo, 0);
+  vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
+  for (uint32_t i = 0; i < uint32_t(m_downStorageViews.size()); ++i)
+  {
+    uint32_t level = i < imageLevels ? i : imageLevels - 1;
+    descriptorInfo.imageView = m_downStorageViews[level];
+    write = m_computeDescriptorContainer.makeWrite(0, 0, &descriptorInfo, i);
+    vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
+    descriptorInfo.imageView = m_upStorageViews[level];
+    write = m_computeDescriptorContainer.makeWrite(0, 2, &descriptorInfo, i);
+    vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
+  }
+}
+
+void Bloom::cmdBloom(VkCommandBuffer cmdBuf, VkDescriptorSet sceneTexture)
+{
+  if (m_levels < 3)
+  {
+    cmdClearIfNeeded(cmdBuf);
+    return;
+  }
+
+  // Wait for the scene to be written, and for the previous frame's
+  // composite to finish before discarding the images' contents.
+  VkMemoryBarrier sceneBarrier = {
+      VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr,
+      VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+      VK_ACCESS_SHADER_READ_BIT};
+  VkImageMemoryBarrier imageBarriers[2];
+  for (int i = 0; i < 2; ++i)
+  {
+    imageBarriers[i] = {
+        VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER, nullptr,
+        0, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL,
+        0, 0, i == 0 ? m_downImage.image : m_upImage.image,
+        {VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_REMAINING_MIP_LEVELS, 0, 1}};
+  }
+  vkCmdPipelineBarrier(cmdBuf,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT
+                           | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
+                           | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                       1, &sceneBarrier, 0, nullptr, 2, imageBarriers);
+
+  VkDescriptorSet descriptorSets[] = {
+      sceneTexture, m_computeDescriptorContainer.getSet(0)};
+  vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_layout,
+                          0, 2, descriptorSets, 0, nullptr);
+  NvproPyramidBloomPipelines pipelines{
+      {m_downsampleGeneralPipeline, m_downsampleFastPipeline, m_layout, 0},
+      m_upsamplePipeline};
+  nvproCmdPyramidBloomDispatch(cmdBuf, pipelines, m_width, m_height, m_levels);
+
+  // Composite reads the result.
+  VkMemoryBarrier barrier = {
+      VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr,
+      VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT};
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                       1, &barrier, 0, nullptr, 0, nullptr);
+  m_needsClear = false;
+}
+
+void Bloom::cmdClearIfNeeded(VkCommandBuffer cmdBuf)
+{
+  if (!m_needsClear) return;
+
+  VkImageMemoryBarrier imageBarriers[2];
+  for (int i = 0; i < 2; ++i)
+  {
+    imageBarriers[i] = {
+        VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER, nullptr,
+        0, VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        0, 0, i == 0 ? m_downImage.image : m_upImage.image,
+        {VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_REMAINING_MIP_LEVELS, 0, 1}};
+  }
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                       0, nullptr, 0, nullptr, 2, imageBarriers);
+
+  VkClearColorValue       zero{};
+  VkImageSubresourceRange range = imageBarriers[0].subresourceRange;
+  vkCmdClearColorImage(cmdBuf, m_downImage.image,
+                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &zero, 1, &range);
+  vkCmdClearColorImage(cmdBuf, m_upImage.image,
+                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &zero, 1, &range);
+
+  for (VkImageMemoryBarrier& barrier : imageBarriers)
+  {
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout     = VK_IMAGE_LAYOUT_GENERAL;
+  }
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                       0, nullptr, 0, nullptr, 2, imageBarriers);
+  m_needsClear = false;
+}
@@ -0,0 +1,94 @@
+// Copyright 2021 NVIDIA CORPORATION
+// SPDX-License-Identifier: Apache-2.0
+#ifndef VK_COMPUTE_MIPMAPS_DEMO_BLOOM_HPP_
+#define VK_COMPUTE_MIPMAPS_DEMO_BLOOM_HPP_
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include "nvvk/descriptorsets_vk.hpp"
+#include "nvvk/resourceallocator_vk.hpp"
+
+// Class holding the images, descriptors, and compute pipelines for
+// the bloom effect of nvpro_pyramid_bloom.hpp, applied to the base
+// level of the drawn image and composited by SwapImagePipeline.
+class Bloom
+{
+  // Borrowed
+  VkDevice m_device;
+
+  nvvk::ResourceAllocatorDedicated m_allocator;
+
+  // Scene (base image) size, and bloom levels including the scene.
+  // Bloom is skipped (up image left cleared) if fewer than 3 levels.
+  uint32_t m_width{}, m_height{}, m_levels{};
+
+  // Half-size down and up chain images; level n is bloom level n + 1.
+  nvvk::Image                 m_downImage{}, m_upImage{};
+  VkImageView                 m_downView{}, m_upView{};
+  std::array<VkImageView, 16> m_downStorageViews{}, m_upStorageViews{};
+  VkSampler                   m_sampler{};
+
+  // Set if the images were (re)allocated and not yet written.
+  bool m_needsClear{};
+
+  // set=1 of the compute pipelines (set=0 is the scene texture); and
+  // the up image texture for SwapImagePipeline.
+  nvvk::DescriptorSetContainer m_computeDescriptorContainer;
+  nvvk::DescriptorSetContainer m_textureDescriptorContainer;
+
+  VkPipelineLayout m_layout{};
+  VkPipeline       m_downsampleGeneralPipeline{};
+  VkPipeline       m_downsampleFastPipeline{};
+  VkPipeline       m_upsamplePipeline{};
+
+  void destroyImages();
+
+public:
+  // Maximum bloom levels (including the scene); the fast pipeline can
+  // then fill the whole down chain in one dispatch for suitable sizes.
+  static constexpr uint32_t s_maxLevels = 7;
+
+  // sceneTextureLayout: layout of the descriptor set passed to
+  // cmdBloom, one combined image sampler at binding 0.
+  Bloom(VkDevice              device,
+        VkPhysicalDevice      physicalDevice,
+        VkDescriptorSetLayout sceneTextureLayout,
+        bool                  dumpPipelineStats,
+        uint32_t              sceneWidth,
+        uint32_t              sceneHeight);
+
+  ~Bloom();
+
+  Bloom(Bloom&&) = delete;
+
+  // Change the scene size immediately. Consider vkQueueWaitIdle before.
+  void resize(uint32_t sceneWidth, uint32_t sceneHeight);
+
+  uint32_t getWidth() const { return m_width; }
+  uint32_t getHeight() const { return m_height; }
+
+  // Descriptor set with the bloom result as combined image sampler
+  // (binding 0, level 0, general layout), for compositing.
+  VkDescriptorSetLayout getTextureDescriptorSetLayout() const
+  {
+    return m_textureDescriptorContainer.getLayout();
+  }
+
+  VkDescriptorSet getTextureDescriptorSet() const
+  {
+    return m_textureDescriptorContainer.getSet(0);
+  }
+
+  // Record commands to bloom level 0 of the scene texture, with
+  // barriers before (scene writes, prior reads of the result) and
+  // after (fragment shader reads of the result).
+  void cmdBloom(VkCommandBuffer cmdBuf, VkDescriptorSet sceneTexture);
+
+  // Clear the images and transition them to general layout, if they
+  // have not been written since allocation. Needed before compositing
+  // with bloom disabled, as the texture is bound regardless.
+  void cmdClearIfNeeded(VkCommandBuffer cmdBuf);
+};
+
+#endif /* !VK_COMPUTE_MIPMAPS_DEMO_BLOOM_HPP_ */
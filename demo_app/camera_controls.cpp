@@ -39,4 +39,6 @@ void updateFromControls(const CameraControls&  controls,
   outPushConstant->filterMode           = controls.filterMode;
   outPushConstant->sceneMode            = controls.sceneMode;
   outPushConstant->backgroundBrightness = controls.backgroundBrightness;
+  outPushConstant->bloomIntensity =
+      controls.doBloom ? controls.bloomIntensity : 0.0f;
 }
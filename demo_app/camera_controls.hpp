@@ -26,6 +26,10 @@ struct CameraControls
 
   float backgroundBrightness = 0.01f;
 
+  // Bloom the drawn image (see bloom.hpp), and its composite scale.
+  bool  doBloom        = false;
+  float bloomIntensity = 0.15f;
+
   // 2D camera controls
   // Texel coord is offset + scale * pixelCoordinate.
   nvmath::vec2 offset, scale = {1, 1};
@@ -113,7 +113,8 @@ SwapImagePipeline::SwapImagePipeline(
     VkDevice              device,
     VkPhysicalDevice      physicalDevice,
     const SwapRenderPass& renderPass,
-    VkDescriptorSetLayout samplerDescriptorSetLayout)
+    VkDescriptorSetLayout samplerDescriptorSetLayout,
+    VkDescriptorSetLayout bloomDescriptorSetLayout)
     : m_device(device)
 {
   // Set up camera UBOs
@@ -151,7 +152,8 @@ SwapImagePipeline::SwapImagePipeline(
   VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
   pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
   VkDescriptorSetLayout setLayouts[] = {samplerDescriptorSetLayout,
-                                        m_bufferDescriptors.getLayout()};
+                                        m_bufferDescriptors.getLayout(),
+                                        bloomDescriptorSetLayout};
   pipelineLayoutInfo.setLayoutCount = arraySize(setLayouts);
   pipelineLayoutInfo.pSetLayouts    = setLayouts;
   VkPushConstantRange range{VK_SHADER_STAGE_FRAGMENT_BIT, 0,
@@ -184,6 +186,7 @@ void SwapImagePipeline::cmdBindDraw(VkCommandBuffer       cmdBuf,
                                     SwapImagePushConstant pushConstant,
                                     CameraTransforms      cameraTransforms,
                                     VkDescriptorSet       baseColorSampler,
+                                    VkDescriptorSet       bloomSampler,
                                     bool                  parity)
 {
   vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline);
@@ -191,7 +194,8 @@ void SwapImagePipeline::cmdBindDraw(VkCommandBuffer       cmdBuf,
                      sizeof pushConstant, &pushConstant);
   *m_bufferMaps[parity]               = cameraTransforms;
   VkDescriptorSet cameraUniformBuffer = m_bufferDescriptors.getSet(parity);
-  VkDescriptorSet descriptorSets[]    = {baseColorSampler, cameraUniformBuffer};
+  VkDescriptorSet descriptorSets[]    = {baseColorSampler, cameraUniformBuffer,
+                                         bloomSampler};
   vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, m_layout,
                           0, arraySize(descriptorSets), descriptorSets,
                           0, nullptr);
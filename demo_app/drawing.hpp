@@ -90,9 +90,10 @@ struct CameraTransforms;
 // disables depth test and write. The vertex shader hard-codes drawing a
 // full-screen triangle.
 //
-// Takes 2 descriptor sets as input, each containing one combined
-// 2D image sampler binding. set 0 is the base color texture, set 1 is
-// the camera transforms UBO, which is also managed by this class.
+// Takes 3 descriptor sets as input. set 0 is the base color texture
+// (one combined 2D image sampler binding), set 1 is the camera
+// transforms UBO, which is also managed by this class, and set 2 is
+// the bloom texture (one combined 2D image sampler binding).
 // There are 2 UBOs; alternate per frame.
 class SwapImagePipeline
 {
@@ -109,12 +110,13 @@ class SwapImagePipeline
   nvvk::DescriptorSetContainer     m_bufferDescriptors;  // One set per buffer.
 
 public:
-  // Need to borrow a descriptor set layout with one combined image
+  // Need to borrow descriptor set layouts with one combined image
   // sampler binding that allows fragment shader use.
   SwapImagePipeline(VkDevice              device,
                     VkPhysicalDevice      physicalDevice,
                     const SwapRenderPass& renderPass,
-                    VkDescriptorSetLayout samplerDescriptorSetLayout);
+                    VkDescriptorSetLayout samplerDescriptorSetLayout,
+                    VkDescriptorSetLayout bloomDescriptorSetLayout);
 
   SwapImagePipeline(SwapImagePipeline&&) = delete;
 
@@ -139,13 +141,14 @@ public:
 
   // Bind the pipeline, set the push constant and descriptors, and
   // record commands to draw. Must be called within the render pass
-  // used to create the pipeline. The descriptor set must contain one
+  // used to create the pipeline. The descriptor sets must contain one
   // combined image sampler2D binding.  Alternating UBOs are used to
   // pass CameraTransforms; parity must alternate per frame.
   void cmdBindDraw(VkCommandBuffer       cmdBuf,
                    SwapImagePushConstant pushConstant,
                    CameraTransforms      cameraTransforms,
                    VkDescriptorSet       baseColorSampler,
+                   VkDescriptorSet       bloomSampler,
                    bool                  parity);
 };
 
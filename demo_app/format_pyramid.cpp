@@ -0,0 +1,963 @@
+// Copyright 2021 NVIDIA CORPORATION
+// SPDX-License-Identifier: Apache-2.0
+
+// Implementation of FormatPyramid and its benchmark; see
+// format_pyramid_configs.cpp for the configurations themselves.
+#include "format_pyramid.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <stdio.h>
+#include <string.h>
+
+#include "nvvk/error_vk.hpp"
+#include "nvvk/shadermodulemanager_vk.hpp"
+
+#include "make_compute_pipeline.hpp"
+#include "nvpro_pyramid_bc1.hpp"
+#include "nvpro_pyramid_dispatch.hpp"
+#include "search_paths.hpp"
+#include "shader_include_cache.hpp"
+#include "timestamps.hpp"
+
+static VkImageAspectFlags aspectFromFormat(VkFormat format)
+{
+  switch (format)
+  {
+    case VK_FORMAT_D16_UNORM:
+    case VK_FORMAT_X8_D24_UNORM_PACK32:
+    case VK_FORMAT_D32_SFLOAT:
+      return VK_IMAGE_ASPECT_DEPTH_BIT;
+    default:
+      return VK_IMAGE_ASPECT_COLOR_BIT;
+  }
+}
+
+// Create flags and usage of the aux image.
+static VkImageCreateFlags auxImageFlags(const FormatPyramidConfig& config)
+{
+  VkImageCreateFlags flags = 0;
+  if (config.auxStorageFormat != VK_FORMAT_UNDEFINED)
+  {
+    flags |= VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT
+           | VK_IMAGE_CREATE_EXTENDED_USAGE_BIT;
+  }
+  if (config.auxBlockEdge > 1)
+  {
+    flags |= VK_IMAGE_CREATE_BLOCK_TEXEL_VIEW_COMPATIBLE_BIT;
+  }
+  return flags;
+}
+
+static VkImageUsageFlags auxImageUsage(const FormatPyramidConfig& config)
+{
+  VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+                          | VK_IMAGE_USAGE_TRANSFER_DST_BIT
+                          | VK_IMAGE_USAGE_STORAGE_BIT;
+  return config.auxSampled ? usage | VK_IMAGE_USAGE_SAMPLED_BIT : usage;
+}
+
+// Usage of the base image; multisampled ones are written by
+// m_fillPipeline (but still go through the transfer dst layout).
+static VkImageUsageFlags baseImageUsage(const FormatPyramidConfig& config)
+{
+  VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT
+                          | VK_IMAGE_USAGE_SAMPLED_BIT;
+  return config.baseSamples != VK_SAMPLE_COUNT_1_BIT ?
+             usage | VK_IMAGE_USAGE_STORAGE_BIT : usage;
+}
+
+bool FormatPyramid::isSupported(VkPhysicalDevice           physicalDevice,
+                                const FormatPyramidConfig& config,
+                                const char**               pReason)
+{
+  VkImageFormatProperties props;
+  if (config.auxFormat != VK_FORMAT_UNDEFINED
+      && vkGetPhysicalDeviceImageFormatProperties(
+             physicalDevice, config.auxFormat, VK_IMAGE_TYPE_2D,
+             VK_IMAGE_TILING_OPTIMAL, auxImageUsage(config), auxImageFlags(config),
+             &props) != VK_SUCCESS)
+  {
+    *pReason = "aux format not supported";
+    return false;
+  }
+  if (config.baseSamples != VK_SAMPLE_COUNT_1_BIT)
+  {
+    // nvvk::Context enables all supported core features.
+    VkPhysicalDeviceFeatures features;
+    vkGetPhysicalDeviceFeatures(physicalDevice, &features);
+    if (!features.shaderStorageImageMultisample)
+    {
+      *pReason = "shaderStorageImageMultisample not supported";
+      return false;
+    }
+    if (vkGetPhysicalDeviceImageFormatProperties(
+            physicalDevice, config.baseFormat, VK_IMAGE_TYPE_2D,
+            VK_IMAGE_TILING_OPTIMAL, baseImageUsage(config), 0, &props)
+            != VK_SUCCESS
+        || !(props.sampleCounts & config.baseSamples))
+    {
+      *pReason = "multisampled base format not supported";
+      return false;
+    }
+  }
+  return true;
+}
+
+FormatPyramid::FormatPyramid(VkDevice                   device,
+                             VkPhysicalDevice           physicalDevice,
+                             bool                       samplerFilterMinmax,
+                             const FormatPyramidConfig& config,
+                             uint32_t                   width,
+                             uint32_t                   height,
+                             const char*                pInputFilename,
+                             bool                       dumpPipelineStats)
+    : m_device(device)
+    , m_config(config)
+    , m_width(width)
+    , m_height(height)
+    , m_textureDescriptorContainer(device)
+    , m_storageDescriptorContainer(device)
+    , m_fillDescriptorContainer(device)
+{
+  m_allocator.init(device, physicalDevice);
+  bool hasBase  = config.baseFormat != VK_FORMAT_UNDEFINED;
+  bool hasAux   = config.auxFormat != VK_FORMAT_UNDEFINED;
+  bool hasPlane = config.planeFormat != VK_FORMAT_UNDEFINED;
+  bool multisampled = config.baseSamples != VK_SAMPLE_COUNT_1_BIT;
+  assert(!multisampled || config.baseFormat == VK_FORMAT_R16G16B16A16_SFLOAT);
+  m_hasStorageImages = true;
+  for (const FormatPyramidBuffer& buffer : config.buffers)
+  {
+    m_hasStorageImages &= !buffer.bytes || buffer.binding != 0;
+  }
+
+  // Calculate mip level layout, same as MipmapStorage.
+  uint64_t offset = 0;
+  while (true)
+  {
+    m_levelExtents.push_back({width, height});
+    m_levelOffsets.push_back(offset);
+    offset += uint64_t(width) * uint64_t(height);
+    if (width == 1 && height == 1) break;
+    width  =  width >> 1 | (width  == 1u);
+    height = height >> 1 | (height == 1u);
+  }
+  uint32_t levels = uint32_t(m_levelExtents.size());
+  assert(levels <= m_storageViews.size());
+
+  // Use the requested sampler reduction mode only if supported for
+  // all sampled formats.
+  if (config.samplerReductionMode != VK_SAMPLER_REDUCTION_MODE_WEIGHTED_AVERAGE
+      && samplerFilterMinmax)
+  {
+    VkFormatProperties props;
+    vkGetPhysicalDeviceFormatProperties(physicalDevice, config.format, &props);
+    m_usesSamplerReduction = (props.optimalTilingFeatures
+                              & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_MINMAX_BIT) != 0;
+    if (hasBase)
+    {
+      vkGetPhysicalDeviceFormatProperties(physicalDevice, config.baseFormat, &props);
+      m_usesSamplerReduction &= (props.optimalTilingFeatures
+                                 & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_MINMAX_BIT) != 0;
+    }
+  }
+
+  // Use linear filtering for bilinear 2x2 reduction only if supported.
+  if (config.linearFilter)
+  {
+    VkFormatProperties props;
+    vkGetPhysicalDeviceFormatProperties(physicalDevice, config.format, &props);
+    m_usesLinearFilter = (props.optimalTilingFeatures
+                          & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) != 0;
+  }
+
+  // Set up sampler. Linear filtering is only used together with
+  // min/max reduction (no VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT
+  // needed then) or if checked above; otherwise the shaders only use
+  // texelFetch.
+  VkSamplerReductionModeCreateInfo reductionInfo = {
+      VK_STRUCTURE_TYPE_SAMPLER_REDUCTION_MODE_CREATE_INFO, nullptr,
+      config.samplerReductionMode};
+  VkFilter filter = m_usesSamplerReduction || m_usesLinearFilter ?
+                        VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+  VkSamplerCreateInfo samplerInfo = {
+      VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+      m_usesSamplerReduction ? &reductionInfo : nullptr, 0,
+      filter, filter,
+      VK_SAMPLER_MIPMAP_MODE_NEAREST,
+      VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+      VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+      VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE};
+  samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+  NVVK_CHECK(vkCreateSampler(device, &samplerInfo, nullptr, &m_sampler));
+
+  // Create images and image views.
+  bool hasStorageFormat = config.storageFormat != VK_FORMAT_UNDEFINED;
+  VkImageCreateInfo imageInfo = {
+      VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO, nullptr,
+      hasStorageFormat ? VkImageCreateFlags(VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT
+                                            | VK_IMAGE_CREATE_EXTENDED_USAGE_BIT) :
+                         0,
+      VK_IMAGE_TYPE_2D, config.format, {m_width, m_height, 1},
+      levels, 1, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_TILING_OPTIMAL,
+      VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT
+          | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT,
+      VK_SHARING_MODE_EXCLUSIVE, 0, nullptr, VK_IMAGE_LAYOUT_UNDEFINED};
+  m_image = m_allocator.createImage(imageInfo);
+
+  VkImageViewCreateInfo viewInfo = {
+      VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO, nullptr, 0,
+      m_image.image, VK_IMAGE_VIEW_TYPE_2D, config.format, {},
+      {VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_REMAINING_MIP_LEVELS, 0, 1}};
+  NVVK_CHECK(vkCreateImageView(device, &viewInfo, nullptr, &m_samplerView));
+  if (hasStorageFormat)
+  {
+    viewInfo.format = config.storageFormat;
+  }
+  for (uint32_t level = 0; level < levels; ++level)
+  {
+    viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1};
+    NVVK_CHECK(vkCreateImageView(device, &viewInfo, nullptr,
+                                 &m_storageViews[level]));
+  }
+
+  if (hasAux)
+  {
+    imageInfo.flags  = auxImageFlags(config);
+    imageInfo.format = config.auxFormat;
+    imageInfo.usage  = auxImageUsage(config);
+    m_auxImage = m_allocator.createImage(imageInfo);
+
+    viewInfo.image  = m_auxImage.image;
+    if (config.auxSampled)
+    {
+      viewInfo.format           = config.auxFormat;
+      viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT,
+                                   0, VK_REMAINING_MIP_LEVELS, 0, 1};
+      NVVK_CHECK(vkCreateImageView(device, &viewInfo, nullptr,
+                                   &m_auxSamplerView));
+    }
+    viewInfo.format = config.auxStorageFormat != VK_FORMAT_UNDEFINED ?
+                          config.auxStorageFormat : config.auxFormat;
+    for (uint32_t level = 0; level < levels; ++level)
+    {
+      viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1};
+      NVVK_CHECK(vkCreateImageView(device, &viewInfo, nullptr,
+                                   &m_auxStorageViews[level]));
+    }
+  }
+
+  if (hasBase)
+  {
+    imageInfo.flags     = 0;
+    imageInfo.format    = config.baseFormat;
+    imageInfo.mipLevels = 1;
+    imageInfo.samples   = config.baseSamples;
+    imageInfo.usage     = baseImageUsage(config);
+    m_baseImage = m_allocator.createImage(imageInfo);
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+
+    viewInfo.image            = m_baseImage.image;
+    viewInfo.format           = config.baseFormat;
+    viewInfo.subresourceRange = {aspectFromFormat(config.baseFormat),
+                                 0, 1, 0, 1};
+    NVVK_CHECK(vkCreateImageView(device, &viewInfo, nullptr, &m_baseView));
+  }
+
+  if (hasPlane)
+  {
+    imageInfo.flags     = 0;
+    imageInfo.format    = config.planeFormat;
+    imageInfo.extent    = {(m_width + 1) / 2, (m_height + 1) / 2, 1};
+    imageInfo.mipLevels = 1;
+    imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    m_planeImage = m_allocator.createImage(imageInfo);
+
+    viewInfo.image            = m_planeImage.image;
+    viewInfo.format           = config.planeFormat;
+    viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    NVVK_CHECK(vkCreateImageView(device, &viewInfo, nullptr, &m_planeView));
+  }
+
+  // Set up descriptor sets (general layout images).
+  m_textureDescriptorContainer.addBinding(
+      0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1,
+      VK_SHADER_STAGE_COMPUTE_BIT, &m_sampler);
+  if (hasBase)
+  {
+    m_textureDescriptorContainer.addBinding(
+        1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1,
+        VK_SHADER_STAGE_COMPUTE_BIT, &m_sampler);
+  }
+  if (hasPlane)
+  {
+    m_textureDescriptorContainer.addBinding(
+        2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1,
+        VK_SHADER_STAGE_COMPUTE_BIT, &m_sampler);
+  }
+  if (config.auxSampled)
+  {
+    m_textureDescriptorContainer.addBinding(
+        3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1,
+        VK_SHADER_STAGE_COMPUTE_BIT, &m_sampler);
+  }
+  m_textureDescriptorContainer.initLayout();
+  m_textureDescriptorContainer.initPool(1);
+
+  if (m_hasStorageImages)
+  {
+    m_storageDescriptorContainer.addBinding(
+        0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, uint32_t(m_storageViews.size()),
+        VK_SHADER_STAGE_COMPUTE_BIT);
+  }
+  if (hasAux)
+  {
+    m_storageDescriptorContainer.addBinding(
+        1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, uint32_t(m_auxStorageViews.size()),
+        VK_SHADER_STAGE_COMPUTE_BIT);
+  }
+  for (const FormatPyramidBuffer& buffer : config.buffers)
+  {
+    if (buffer.bytes)
+    {
+      m_storageDescriptorContainer.addBinding(
+          buffer.binding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+          VK_SHADER_STAGE_COMPUTE_BIT);
+    }
+  }
+  m_storageDescriptorContainer.initLayout();
+  m_storageDescriptorContainer.initPool(1);
+
+  VkWriteDescriptorSet  write{};
+  VkDescriptorImageInfo descriptorInfo = {
+      VK_NULL_HANDLE, m_samplerView, VK_IMAGE_LAYOUT_GENERAL};
+  write = m_textureDescriptorContainer.makeWrite(0, 0, &descriptorInfo, 0);
+  vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+  if (hasBase)
+  {
+    descriptorInfo.imageView = m_baseView;
+    write = m_textureDescriptorContainer.makeWrite(0, 1, &descriptorInfo, 0);
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+  }
+  if (hasPlane)
+  {
+    descriptorInfo.imageView = m_planeView;
+    write = m_textureDescriptorContainer.makeWrite(0, 2, &descriptorInfo, 0);
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+  }
+  if (config.auxSampled)
+  {
+    descriptorInfo.imageView = m_auxSamplerView;
+    write = m_textureDescriptorContainer.makeWrite(0, 3, &descriptorInfo, 0);
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+  }
+  // Dummy data for excess mip levels, as in ScopedImage.
+  for (uint32_t i = 0; i < uint32_t(m_storageViews.size()); ++i)
+  {
+    if (m_hasStorageImages)
+    {
+      descriptorInfo.imageView = m_storageViews[i < levels ? i : levels - 1];
+      write = m_storageDescriptorContainer.makeWrite(0, 0, &descriptorInfo, i);
+      vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+    }
+    if (hasAux)
+    {
+      descriptorInfo.imageView = m_auxStorageViews[i < levels ? i : levels - 1];
+      write = m_storageDescriptorContainer.makeWrite(0, 1, &descriptorInfo, i);
+      vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+    }
+  }
+
+  // Set up the storage buffers, and the staging buffer regions (see
+  // FormatPyramidConfig) for the aux pyramid, plane, base level samples,
+  // and downloaded buffers.
+  VkDeviceSize stagingBytes = offset * config.texelSize;
+  if (hasAux)
+  {
+    uint32_t edge = config.auxBlockEdge;
+    stagingBytes  = formatPyramidStagingAlign(stagingBytes);
+    for (VkExtent2D extent : m_levelExtents)
+    {
+      m_auxStagingOffsets.push_back(stagingBytes);
+      stagingBytes += VkDeviceSize((extent.width + edge - 1) / edge)
+                      * ((extent.height + edge - 1) / edge) * config.auxTexelSize;
+    }
+  }
+  if (hasPlane)
+  {
+    m_planeStagingOffset = formatPyramidStagingAlign(stagingBytes);
+    stagingBytes = m_planeStagingOffset
+                   + VkDeviceSize((m_width + 1) / 2) * ((m_height + 1) / 2)
+                         * config.planeTexelSize;
+  }
+  VkDeviceSize baseSamplesBytes = 0;
+  if (multisampled)
+  {
+    m_baseSamplesStagingOffset = formatPyramidStorageBufferAlign(stagingBytes);
+    baseSamplesBytes = VkDeviceSize(m_width) * m_height * config.baseSamples
+                       * 8u;  // RGBA16F
+    stagingBytes = m_baseSamplesStagingOffset + baseSamplesBytes;
+  }
+  for (uint32_t i = 0; i < 2; ++i)
+  {
+    const FormatPyramidBuffer& buffer = config.buffers[i];
+    if (!buffer.bytes) continue;
+    VkDeviceSize       bytes      = buffer.bytes(m_width, m_height);
+    VkBufferCreateInfo bufferInfo = {
+        VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO, nullptr, 0, bytes,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+            | VK_BUFFER_USAGE_TRANSFER_DST_BIT};
+    m_buffers[i] = m_allocator.createBuffer(
+        bufferInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    VkDescriptorBufferInfo bufferDescriptorInfo = {
+        m_buffers[i].buffer, 0, VK_WHOLE_SIZE};
+    write = m_storageDescriptorContainer.makeWrite(
+        0, buffer.binding, &bufferDescriptorInfo, 0);
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+
+    if (buffer.download)
+    {
+      m_bufferStagingOffsets[i] = formatPyramidStagingAlign(stagingBytes);
+      stagingBytes              = m_bufferStagingOffsets[i] + bytes;
+    }
+  }
+
+  // Set up staging buffer and fill in the base level (samples).
+  VkBufferCreateInfo stagingBufferInfo = {
+      VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO, nullptr, 0, stagingBytes,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT};
+  if (multisampled)
+  {
+    stagingBufferInfo.usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+  }
+  m_stagingBuffer = m_allocator.createBuffer(
+      stagingBufferInfo, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+                             | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+  m_pStagingBufferMap = m_allocator.map(m_stagingBuffer);
+  config.fillBase(static_cast<char*>(m_pStagingBufferMap)
+                      + m_baseSamplesStagingOffset,
+                  m_width, m_height, pInputFilename);
+
+  // Set up the pipeline copying the samples to a multisampled base
+  // image: storage image at binding 0, samples at binding 1.
+  if (multisampled)
+  {
+    m_fillDescriptorContainer.addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1,
+                                         VK_SHADER_STAGE_COMPUTE_BIT);
+    m_fillDescriptorContainer.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+                                         VK_SHADER_STAGE_COMPUTE_BIT);
+    m_fillDescriptorContainer.initLayout();
+    m_fillDescriptorContainer.initPool(1);
+    VkDescriptorImageInfo  fillImageInfo  = {VK_NULL_HANDLE, m_baseView,
+                                             VK_IMAGE_LAYOUT_GENERAL};
+    VkDescriptorBufferInfo fillBufferInfo = {
+        m_stagingBuffer.buffer, m_baseSamplesStagingOffset, baseSamplesBytes};
+    VkWriteDescriptorSet fillWrites[] = {
+        m_fillDescriptorContainer.makeWrite(0, 0, &fillImageInfo, 0),
+        m_fillDescriptorContainer.makeWrite(0, 1, &fillBufferInfo, 0)};
+    vkUpdateDescriptorSets(device, 2, fillWrites, 0, nullptr);
+
+    VkDescriptorSetLayout fillSetLayout = m_fillDescriptorContainer.getLayout();
+    makeComputePipeline(device, "msaa_fill.comp.spv", dumpPipelineStats,
+                        1, &fillSetLayout, 0, nullptr, &m_fillPipeline,
+                        &m_fillLayout);
+  }
+
+  // Set up pipelines.
+  VkDescriptorSetLayout setLayouts[] = {
+      m_textureDescriptorContainer.getLayout(),
+      m_storageDescriptorContainer.getLayout()};
+  VkPushConstantRange pushConstantRange = {
+      VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t)};
+  VkPipelineLayoutCreateInfo layoutInfo = {
+      VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO, nullptr, 0,
+      2, setLayouts, 1, &pushConstantRange};
+  NVVK_CHECK(vkCreatePipelineLayout(device, &layoutInfo, nullptr, &m_layout));
+
+  std::string prepend = config.prepend;
+  if (config.samplerReductionMode != VK_SAMPLER_REDUCTION_MODE_WEIGHTED_AVERAGE)
+  {
+    prepend += m_usesSamplerReduction ? "#define USE_SAMPLER_REDUCTION 1\n" :
+                                        "#define USE_SAMPLER_REDUCTION 0\n";
+  }
+  if (config.linearFilter)
+  {
+    prepend += m_usesLinearFilter ? "#define USE_BILINEAR_SAMPLING 1\n" :
+                                    "#define USE_BILINEAR_SAMPLING 0\n";
+  }
+  if (config.f16Arithmetic)
+  {
+    // shaderFloat16 is required by main.cpp.
+    prepend += "#extension GL_EXT_shader_explicit_arithmetic_types : enable\n"
+               "#define F16_ARITHMETIC 1\n";
+  }
+  prepend += computeSubgroupSizePrepend();
+  // Both pipelines include e.g. depth_pyramid_preamble.glsl for
+  // depth_pyramid_fast_pipeline.comp.
+  std::string preamble = config.fastShaderFilename;
+  preamble = preamble.substr(preamble.find_last_of('/') + 1);
+  preamble = preamble.substr(0, preamble.find("_fast_pipeline.comp"))
+             + "_preamble.glsl";
+
+  // Compile them in parallel, each with its own ShaderModuleManager.
+  const char* filenames[] = {config.fastShaderFilename,
+                             config.generalShaderFilename,
+                             config.baseLevelShaderFilename};
+  const char* kinds[]     = {" fastPipeline", " generalPipeline",
+                             " baseLevelPipeline"};
+  VkPipeline* pipelines[] = {&m_fastPipeline, &m_generalPipeline,
+                             &m_baseLevelPipeline};
+  auto        humanName   = [&](uint32_t i) {
+    return std::string(config.label) + kinds[i];
+  };
+  computeCompileThreadPool().runOrdered(
+      config.baseLevelShaderFilename ? 3 : 2,
+      [&](uint32_t i) {
+        nvvk::ShaderModuleManager shaderModuleManager(device);
+        for (const auto& directory : searchPaths)
+        {
+          shaderModuleManager.addDirectory(directory);
+        }
+        shaderIncludeCache().registerIncludes(
+            shaderModuleManager, {preamble.c_str(), "nvpro_pyramid.glsl"});
+        auto id = shaderModuleManager.createShaderModule(
+            VK_SHADER_STAGE_COMPUTE_BIT, filenames[i], prepend,
+            nvvk::ShaderModuleManager::FILETYPE_GLSL);
+        VkShaderModule module = shaderModuleManager.get(id);
+        assert(module);
+        makeComputePipeline(device, module, dumpPipelineStats, m_layout,
+                            pipelines[i], humanName(i).c_str(), nullptr, true);
+      },
+      [&](uint32_t i) {
+        if (dumpPipelineStats)
+        {
+          nvvk::nvprintPipelineStats(device, *pipelines[i],
+                                     humanName(i).c_str(), false);
+        }
+      });
+}
+
+FormatPyramid::~FormatPyramid()
+{
+  vkDestroyPipeline(m_device, m_fastPipeline, nullptr);
+  vkDestroyPipeline(m_device, m_generalPipeline, nullptr);
+  vkDestroyPipeline(m_device, m_baseLevelPipeline, nullptr);
+  vkDestroyPipelineLayout(m_device, m_layout, nullptr);
+  if (m_fillPipeline)
+  {
+    vkDestroyPipeline(m_device, m_fillPipeline, nullptr);
+    vkDestroyPipelineLayout(m_device, m_fillLayout, nullptr);
+    m_fillDescriptorContainer.deinit();
+  }
+  m_textureDescriptorContainer.deinit();
+  m_storageDescriptorContainer.deinit();
+  for (VkImageView view : m_storageViews)
+  {
+    if (view) vkDestroyImageView(m_device, view, nullptr);
+  }
+  for (VkImageView view : m_auxStorageViews)
+  {
+    if (view) vkDestroyImageView(m_device, view, nullptr);
+  }
+  vkDestroyImageView(m_device, m_samplerView, nullptr);
+  vkDestroyImageView(m_device, m_baseView, nullptr);
+  vkDestroyImageView(m_device, m_planeView, nullptr);
+  vkDestroyImageView(m_device, m_auxSamplerView, nullptr);
+  vkDestroySampler(m_device, m_sampler, nullptr);
+  m_allocator.destroy(m_image);
+  if (m_baseImage.image)
+  {
+    m_allocator.destroy(m_baseImage);
+  }
+  if (m_auxImage.image)
+  {
+    m_allocator.destroy(m_auxImage);
+  }
+  if (m_planeImage.image)
+  {
+    m_allocator.destroy(m_planeImage);
+  }
+  for (nvvk::Buffer& buffer : m_buffers)
+  {
+    if (buffer.buffer) m_allocator.destroy(buffer);
+  }
+  m_allocator.destroy(m_stagingBuffer);
+  m_allocator.deinit();
+}
+
+void FormatPyramid::cmdUpload(VkCommandBuffer cmdBuf)
+{
+  VkImage uploadImage = m_baseImage.image ? m_baseImage.image : m_image.image;
+  VkImageAspectFlags uploadAspect = m_baseImage.image ?
+      aspectFromFormat(m_config.baseFormat) : VK_IMAGE_ASPECT_COLOR_BIT;
+
+  // Transition everything to transfer dst layout.
+  VkImageMemoryBarrier barriers[4] = {
+      {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER, nullptr,
+       0, VK_ACCESS_TRANSFER_WRITE_BIT,
+       VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+       0, 0, m_image.image,
+       {VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_REMAINING_MIP_LEVELS, 0, 1}},
+      {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER, nullptr,
+       0, VK_ACCESS_TRANSFER_WRITE_BIT,
+       VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+       0, 0, m_baseImage.image,
+       {uploadAspect, 0, 1, 0, 1}},
+      {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER, nullptr,
+       0, VK_ACCESS_TRANSFER_WRITE_BIT,
+       VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+       0, 0, m_auxImage.image,
+       {VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_REMAINING_MIP_LEVELS, 0, 1}},
+      {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER, nullptr,
+       0, VK_ACCESS_TRANSFER_WRITE_BIT,
+       VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+       0, 0, m_planeImage.image,
+       {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}}};
+  // Compact to the images that exist.
+  uint32_t barrierCount = 1;
+  if (m_baseImage.image) barriers[barrierCount++] = barriers[1];
+  if (m_auxImage.image) barriers[barrierCount++] = barriers[2];
+  if (m_planeImage.image) barriers[barrierCount++] = barriers[3];
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                       0, nullptr, 0, nullptr, barrierCount, barriers);
+
+  if (m_auxImage.image && m_config.auxBlockEdge == 1)
+  {
+    VkClearColorValue       zero{};
+    VkImageSubresourceRange range = {VK_IMAGE_ASPECT_COLOR_BIT,
+                                     0, VK_REMAINING_MIP_LEVELS, 0, 1};
+    vkCmdClearColorImage(cmdBuf, m_auxImage.image,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &zero, 1, &range);
+  }
+  for (const nvvk::Buffer& buffer : m_buffers)
+  {
+    if (buffer.buffer)
+    {
+      vkCmdFillBuffer(cmdBuf, buffer.buffer, 0, VK_WHOLE_SIZE, 0);
+    }
+  }
+
+  // Copy the base level (unless multisampled, see below) and plane.
+  VkBufferImageCopy region = {
+      0, 0, 0, {uploadAspect, 0, 0, 1},
+      {0, 0, 0}, {m_width, m_height, 1}};
+  if (!m_fillPipeline)
+  {
+    vkCmdCopyBufferToImage(cmdBuf, m_stagingBuffer.buffer, uploadImage,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+  }
+  if (m_planeImage.image)
+  {
+    region = {m_planeStagingOffset, 0, 0, {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+              {0, 0, 0}, {(m_width + 1) / 2, (m_height + 1) / 2, 1}};
+    vkCmdCopyBufferToImage(cmdBuf, m_stagingBuffer.buffer, m_planeImage.image,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+  }
+
+  // Transition to general layout for the compute shaders.
+  for (VkImageMemoryBarrier& barrier : barriers)
+  {
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT
+                          | VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout     = VK_IMAGE_LAYOUT_GENERAL;
+  }
+  VkMemoryBarrier fillBarrier = {
+      VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr,
+      VK_ACCESS_TRANSFER_WRITE_BIT,
+      VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT};
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                       1, &fillBarrier, 0, nullptr, barrierCount, barriers);
+
+  // Multisampled images cannot be copied to; write the samples with
+  // 8x8 workgroups instead.
+  if (m_fillPipeline)
+  {
+    VkDescriptorSet fillSet = m_fillDescriptorContainer.getSet(0);
+    vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_fillPipeline);
+    vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE,
+                            m_fillLayout, 0, 1, &fillSet, 0, nullptr);
+    vkCmdDispatch(cmdBuf, (m_width + 7) / 8, (m_height + 7) / 8, 1);
+    VkMemoryBarrier shaderBarrier = {
+        VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr,
+        VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT};
+    vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                         1, &shaderBarrier, 0, nullptr, 0, nullptr);
+  }
+}
+
+void FormatPyramid::cmdGenerate(VkCommandBuffer cmdBuf)
+{
+  VkDescriptorSet descriptorSets[] = {
+      m_textureDescriptorContainer.getSet(0),
+      m_storageDescriptorContainer.getSet(0)};
+  vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_layout,
+                          0, 2, descriptorSets, 0, nullptr);
+  NvproPyramidPipelines pipelines{m_generalPipeline, m_fastPipeline,
+                                  m_layout, 0};
+  if (m_baseLevelPipeline)
+  {
+    nvproCmdPyramidBc1Dispatch(cmdBuf, pipelines, m_baseLevelPipeline,
+                               m_width, m_height,
+                               uint32_t(m_levelExtents.size()));
+  }
+  else
+  {
+    nvproCmdPyramidDispatch(cmdBuf, pipelines, m_width, m_height,
+                            uint32_t(m_levelExtents.size()));
+  }
+}
+
+void FormatPyramid::cmdDownload(VkCommandBuffer cmdBuf)
+{
+  VkMemoryBarrier barrier = {
+      VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr,
+      VK_ACCESS_MEMORY_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT};
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                       1, &barrier, 0, nullptr, 0, nullptr);
+
+  // Level 0 is left as filled in by the config, unless resolved from a
+  // multisampled base image; levels 1+ are not written if a buffer
+  // replaces the storage images.
+  std::vector<VkBufferImageCopy> regions;
+  uint32_t downloadLevels =
+      m_hasStorageImages ? uint32_t(m_levelExtents.size()) : 1u;
+  for (uint32_t level = m_fillPipeline ? 0 : 1; level < downloadLevels; ++level)
+  {
+    VkExtent2D extent = m_levelExtents[level];
+    regions.push_back({m_levelOffsets[level] * m_config.texelSize, 0, 0,
+                       {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1},
+                       {0, 0, 0}, {extent.width, extent.height, 1}});
+  }
+  if (!regions.empty())
+  {
+    vkCmdCopyImageToBuffer(cmdBuf, m_image.image, VK_IMAGE_LAYOUT_GENERAL,
+                           m_stagingBuffer.buffer,
+                           uint32_t(regions.size()), regions.data());
+  }
+  if (m_auxImage.image)
+  {
+    regions.clear();
+    for (uint32_t level = 0; level < uint32_t(m_levelExtents.size()); ++level)
+    {
+      VkExtent2D extent = m_levelExtents[level];
+      regions.push_back({m_auxStagingOffsets[level], 0, 0,
+                         {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1},
+                         {0, 0, 0}, {extent.width, extent.height, 1}});
+    }
+    vkCmdCopyImageToBuffer(cmdBuf, m_auxImage.image, VK_IMAGE_LAYOUT_GENERAL,
+                           m_stagingBuffer.buffer,
+                           uint32_t(regions.size()), regions.data());
+  }
+  for (uint32_t i = 0; i < 2; ++i)
+  {
+    if (m_buffers[i].buffer && m_config.buffers[i].download)
+    {
+      VkBufferCopy region = {
+          0, m_bufferStagingOffsets[i],
+          m_config.buffers[i].bytes(m_width, m_height)};
+      vkCmdCopyBuffer(cmdBuf, m_buffers[i].buffer, m_stagingBuffer.buffer,
+                      1, &region);
+    }
+  }
+
+  VkBufferMemoryBarrier bufferBarrier = {
+      VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER, nullptr,
+      VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_HOST_READ_BIT,
+      0, 0, m_stagingBuffer.buffer, 0, VK_WHOLE_SIZE};
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_HOST_BIT, 0,
+                       0, nullptr, 1, &bufferBarrier, 0, nullptr);
+}
+
+double FormatPyramid::test() const
+{
+  return m_config.test(m_pStagingBufferMap, m_width, m_height);
+}
+
+VkDeviceSize FormatPyramid::mipLevelBytes() const
+{
+  if (!m_hasStorageImages)
+  {
+    VkDeviceSize bytes = 0;
+    for (const FormatPyramidBuffer& buffer : m_config.buffers)
+    {
+      if (buffer.bytes) bytes += buffer.bytes(m_width, m_height);
+    }
+    return bytes;
+  }
+  // The last level is 1x1.
+  uint64_t     texels   = m_levelOffsets.back() + 1u;
+  if (!m_fillPipeline) texels -= uint64_t(m_width) * m_height;
+  VkDeviceSize auxBytes = 0;
+  if (m_auxImage.image && m_auxStagingOffsets.size() > 1)
+  {
+    // Bytes of the last level, plus offset of the last from level 1.
+    auxBytes = m_config.auxTexelSize + m_auxStagingOffsets.back()
+               - m_auxStagingOffsets[1];
+  }
+  return texels * m_config.texelSize + auxBytes;
+}
+
+std::string benchmarkFormatPyramids(nvvk::Context&     ctx,
+                                    bool               enableTesting,
+                                    bool               dumpPipelineStats,
+                                    const std::string& hdrFilename)
+{
+  if (formatPyramidConfigCount == 0) return "";
+
+  VkDevice device      = ctx.m_device;
+  VkQueue  queue       = ctx.m_queueGCT;
+  auto     queueFamily = ctx.m_queueGCT.familyIndex;
+  bool     samplerFilterMinmax =
+      ctx.hasDeviceExtension(VK_EXT_SAMPLER_FILTER_MINMAX_EXTENSION_NAME);
+
+  // Typical render target sizes, plus an odd size for the NP2 kernel.
+  static const VkExtent2D sharedSizes[] = {
+      {1920, 1080}, {2560, 1440}, {3840, 2160}, {1023, 767}};
+
+  // Same as the sRGBA8 benchmark. IGNORES THE INITIAL BATCH.
+  constexpr size_t batchCount      = 256;  // Must be even.
+  constexpr double repetitionCount = 8;
+  static_assert(batchCount % 2 == 0, "need even batchCount");
+
+  VkCommandPool           cmdPool;
+  VkCommandPoolCreateInfo cmdPoolInfo = {
+      VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO, nullptr,
+      VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, queueFamily};
+  NVVK_CHECK(vkCreateCommandPool(device, &cmdPoolInfo, nullptr, &cmdPool));
+  VkCommandBuffer             cmdBuf;
+  VkCommandBufferAllocateInfo cmdBufAllocInfo = {
+      VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO, nullptr,
+      cmdPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1};
+  NVVK_CHECK(vkAllocateCommandBuffers(device, &cmdBufAllocInfo, &cmdBuf));
+  VkCommandBufferBeginInfo beginInfo = {
+      VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, nullptr,
+      VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, nullptr};
+  VkFence           fence;
+  VkFenceCreateInfo fenceInfo = {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+  NVVK_CHECK(vkCreateFence(device, &fenceInfo, nullptr, &fence));
+  VkSubmitInfo submitInfo = {
+      VK_STRUCTURE_TYPE_SUBMIT_INFO, nullptr,
+      0, nullptr, nullptr, 1, &cmdBuf, 0, nullptr};
+
+  Timestamps timestamps(ctx, queueFamily, uint32_t(2 * batchCount));
+  std::array<double, batchCount> batchTimes;
+
+  std::string result;
+  for (size_t configIdx = 0; configIdx < formatPyramidConfigCount; ++configIdx)
+  {
+    const FormatPyramidConfig& config = formatPyramidConfigs[configIdx];
+    const char*                pReason;
+    if (!FormatPyramid::isSupported(ctx.m_physicalDevice, config, &pReason))
+    {
+      fprintf(stderr, "%s: %s, skipped\n", config.label, pReason);
+      continue;
+    }
+    fprintf(stderr, "Benchmarking %s...\n", config.label);
+    result += std::string(result.empty() ? "" : ",\n")
+            + "\"" + config.label + "\": {\n";
+
+    std::vector<VkExtent2D> sizes(std::begin(sharedSizes), std::end(sharedSizes));
+    sizes.insert(sizes.end(), config.pExtraSizes,
+                 config.pExtraSizes + config.extraSizeCount);
+    size_t sizeCount = sizes.size();
+    for (size_t sizeIdx = 0; sizeIdx < sizeCount; ++sizeIdx)
+    {
+      VkExtent2D    size = sizes[sizeIdx];
+      FormatPyramid pyramid(device, ctx.m_physicalDevice, samplerFilterMinmax,
+                            config, size.width, size.height,
+                            hdrFilename.empty() ? nullptr : hdrFilename.c_str(),
+                            dumpPipelineStats && sizeIdx == 0);
+      if (sizeIdx == 0 && !pyramid.usesSamplerReduction()
+          && config.samplerReductionMode
+                 != VK_SAMPLER_REDUCTION_MODE_WEIGHTED_AVERAGE)
+      {
+        fprintf(stderr, "%s: sampler reduction mode not supported, "
+                        "falling back to texelFetch\n", config.label);
+      }
+      if (sizeIdx == 0 && config.linearFilter && !pyramid.usesLinearFilter())
+      {
+        fprintf(stderr, "%s: linear filtering not supported, "
+                        "falling back to texelFetch\n", config.label);
+      }
+
+      // Record all batches into one command buffer; timestamps
+      // bracket each batch of repetitions.
+      NVVK_CHECK(vkBeginCommandBuffer(cmdBuf, &beginInfo));
+      timestamps.cmdResetQueries(cmdBuf);
+      pyramid.cmdUpload(cmdBuf);
+      VkMemoryBarrier barrier = {
+          VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr,
+          VK_ACCESS_SHADER_WRITE_BIT,
+          VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT};
+      for (uint32_t batch = 0; batch < batchCount; ++batch)
+      {
+        timestamps.cmdWriteTimestamp(cmdBuf, 2 * batch);
+        for (int reps = 0; reps < repetitionCount; ++reps)
+        {
+          pyramid.cmdGenerate(cmdBuf);
+          vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                               VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                               1, &barrier, 0, nullptr, 0, nullptr);
+        }
+        timestamps.cmdWriteTimestamp(cmdBuf, 2 * batch + 1);
+      }
+      if (enableTesting)
+      {
+        pyramid.cmdDownload(cmdBuf);
+      }
+      NVVK_CHECK(vkEndCommandBuffer(cmdBuf));
+      NVVK_CHECK(vkQueueSubmit(queue, 1, &submitInfo, fence));
+      NVVK_CHECK(vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX));
+      NVVK_CHECK(vkResetFences(device, 1, &fence));
+      NVVK_CHECK(vkResetCommandBuffer(cmdBuf, 0));
+
+      // Find min, max, median. Ignore first batch as documented.
+      for (uint32_t batch = 0; batch < batchCount; ++batch)
+      {
+        batchTimes[batch] =
+            timestamps.subtractTimestampSeconds(2 * batch + 1, 2 * batch);
+      }
+      std::sort(batchTimes.begin() + 1, batchTimes.end());
+      double min_   = batchTimes[1]              / repetitionCount * 1e9;
+      double median = batchTimes[batchCount / 2] / repetitionCount * 1e9;
+      double max_   = batchTimes[batchCount - 1] / repetitionCount * 1e9;
+
+      char testResults[64] = "";
+      if (enableTesting)
+      {
+        snprintf(testResults, sizeof testResults, ", \"delta\":%g",
+                 pyramid.test());
+      }
+
+      // Same row format as the sRGBA8 benchmark, plus the bytes written
+      // per generation (e.g. to compare packed formats with RGBA16F).
+      char row[256];
+      char sizeName[32];
+      snprintf(sizeName, sizeof sizeName, "%ux%u", size.width, size.height);
+      int paddingChars = 18 - int(strlen(sizeName));
+      snprintf(row, sizeof row,
+               "  \"%s\":%.*s{\"median_ns\":%7.0f, \"min_ns\":%7.0f, "
+               "\"max_ns\":%7.0f, \"mip_bytes\":%llu%s}%c\n",
+               sizeName, paddingChars, "                  ",
+               median, min_, max_,
+               (unsigned long long)pyramid.mipLevelBytes(), testResults,
+               sizeIdx == sizeCount - 1 ? '}' : ',');
+      result += row;
+    }
+    result.pop_back();  // Newline
+  }
+
+  vkDestroyFence(device, fence, nullptr);
+  vkDestroyCommandPool(device, cmdPool, nullptr);
+  return result;
+}
@@ -0,0 +1,326 @@
+// Copyright 2021 NVIDIA CORPORATION
+// SPDX-License-Identifier: Apache-2.0
+#ifndef VK_COMPUTE_MIPMAPS_DEMO_FORMAT_PYRAMID_HPP_
+#define VK_COMPUTE_MIPMAPS_DEMO_FORMAT_PYRAMID_HPP_
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "nvvk/context_vk.hpp"
+#include "nvvk/descriptorsets_vk.hpp"
+#include "nvvk/memallocator_dedicated_vk.hpp"
+#include "nvvk/resourceallocator_vk.hpp"
+
+// Storage buffer bound at set=1 for a FormatPyramidConfig, e.g. a
+// scratch or result buffer written instead of the pyramid image.
+struct FormatPyramidBuffer
+{
+  // Size in bytes for the given base level size; null if unused.
+  VkDeviceSize (*bytes)(uint32_t width, uint32_t height);
+
+  // Binding at set=1. If 0, the buffer replaces the storage images:
+  // the pyramid image is then only sampled (e.g. a reduction that does
+  // not store the mip chain), and its levels 1+ are not downloaded.
+  uint32_t binding;
+
+  // If true, downloaded by cmdDownload for testing (see
+  // FormatPyramidConfig::test). Zero-filled on upload either way.
+  bool download;
+};
+
+// Description of an nvpro_pyramid configuration other than the
+// sRGBA8 one used by the rest of the demo, i.e. one of the other
+// preambles shipped in nvpro_pyramid/. These are only exercised by
+// the benchmark, using synthetic or user-provided input data (see
+// benchmarkFormatPyramids).
+//
+// The shaders must use the same interface as srgba8_mipmap_preamble.glsl:
+// the entire pyramid as texture at set=0, binding=0 and one storage
+// image per mip level at set=1, binding=0 (array of 16), except as
+// described by the optional members below.
+//
+// fillBase and test are passed the staging buffer, laid out as: the
+// pyramid (all mip levels packed in the same way as MipmapStorage),
+// then each of the following that exists, starting at the next
+// multiple of formatPyramidStagingAlignment bytes: the auxFormat
+// pyramid (same layout, in blocks if auxBlockEdge > 1), the
+// planeFormat image (tightly packed), the samples of a multisampled
+// base level (see baseSamples; at a multiple of
+// formatPyramidStorageBufferAlignment instead), and the downloaded
+// buffers (in order). See formatPyramidBytes for the size of each
+// pyramid.
+struct FormatPyramidConfig
+{
+  // Name used in the benchmark json.
+  const char* label;
+
+  // Compute shader files for the fast and general pipeline; these are
+  // compiled at startup with prepend inserted after #version.
+  const char* fastShaderFilename;
+  const char* generalShaderFilename;
+  const char* prepend;
+
+  // Format of the pyramid image, and its texel size in bytes.
+  VkFormat format;
+  uint32_t texelSize;
+
+  // If not VK_FORMAT_UNDEFINED, the base level is instead uploaded to
+  // a separate image of this format (e.g. a D32 depth buffer) and
+  // sampled at set=0, binding=1. Its texel size must be at most that of
+  // format (only the first width * height * its texel size bytes of the
+  // staging buffer are uploaded).
+  VkFormat baseFormat;
+
+  // If not VK_SAMPLER_REDUCTION_MODE_WEIGHTED_AVERAGE, the sampler(s)
+  // use this reduction mode and "#define USE_SAMPLER_REDUCTION 1" is
+  // prepended, if supported by the device (0 otherwise).
+  VkSamplerReductionMode samplerReductionMode;
+
+  // If true, the sampler uses linear filtering and
+  // "#define USE_BILINEAR_SAMPLING 1" is prepended, if the format
+  // supports it (0 otherwise). Not combined with samplerReductionMode.
+  bool linearFilter;
+
+  // If true, prepend "#define F16_ARITHMETIC 1" and enable
+  // GL_EXT_shader_explicit_arithmetic_types (shaderFloat16 feature).
+  bool f16Arithmetic;
+
+  // Fill the base level with input, tightly packed (or its samples, see
+  // baseSamples). pInputFilename is
+  // the optional user-provided input image (may be null; fill with
+  // synthetic data then), see benchmarkFormatPyramids.
+  void (*fillBase)(void* pTexels, uint32_t width, uint32_t height,
+                   const char* pInputFilename);
+
+  // Compare the given pyramid (the staging buffer, see above) with a
+  // CPU reference generated from its base level; return the worst difference.
+  double (*test)(const void* pLevels, uint32_t width, uint32_t height);
+
+  // If not VK_FORMAT_UNDEFINED, a second pyramid image of this format
+  // (texel size auxTexelSize) is bound as storage images at set=1,
+  // binding=1 (array of 16), e.g. for a roughness pyramid written in
+  // the same dispatch. All its levels are cleared to 0 on upload, and
+  // downloaded (including level 0) for testing.
+  VkFormat auxFormat    = VK_FORMAT_UNDEFINED;
+  uint32_t auxTexelSize = 0;
+
+  // If not VK_FORMAT_UNDEFINED, the storage images (set=1, binding=0)
+  // are views of this format instead, e.g. R32_UINT for formats that
+  // the shader packs manually; the image is then created with
+  // VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT and VK_IMAGE_CREATE_EXTENDED_USAGE_BIT.
+  VkFormat storageFormat = VK_FORMAT_UNDEFINED;
+
+  // Storage buffers (unused if bytes is null).
+  FormatPyramidBuffer buffers[2] = {};
+
+  // Base level sizes benchmarked in addition to the ones shared by all
+  // configs, e.g. to cover fast pipeline dispatches of 6 levels.
+  const VkExtent2D* pExtraSizes    = nullptr;
+  uint32_t          extraSizeCount = 0;
+
+  // As storageFormat, for the aux storage images (set=1, binding=1).
+  VkFormat auxStorageFormat = VK_FORMAT_UNDEFINED;
+
+  // If > 1, auxFormat is block-compressed with blocks of this many
+  // texels wide and high (auxTexelSize is then the block size in bytes),
+  // e.g. 4 for BC1 written through R32G32_UINT views (auxStorageFormat);
+  // the aux image is then also created with
+  // VK_IMAGE_CREATE_BLOCK_TEXEL_VIEW_COMPATIBLE_BIT, and not cleared on
+  // upload (the shaders must write all of it).
+  uint32_t auxBlockEdge = 1;
+
+  // If not null, compute shader compiled like the others, and recorded by
+  // cmdGenerate before the pyramid dispatches as by
+  // nvproCmdPyramidBc1Dispatch (one 8x8 workgroup per 32x32 texels of
+  // level 0), e.g. for work on level 0 that nvproPyramidMain does not do.
+  const char* baseLevelShaderFilename = nullptr;
+
+  // If not VK_FORMAT_UNDEFINED, a second input image of this format
+  // (texel size planeTexelSize) and of half the base level size (rounded
+  // up), e.g. the CbCr plane of an NV12 video frame, sampled at set=0,
+  // binding=2. Uploaded from the staging buffer along with the base level.
+  VkFormat planeFormat    = VK_FORMAT_UNDEFINED;
+  uint32_t planeTexelSize = 0;
+
+  // If true, the aux pyramid is also sampled (entire pyramid) at set=0,
+  // binding=3, e.g. for reading its levels back in later dispatches.
+  bool auxSampled = false;
+
+  // If not VK_SAMPLE_COUNT_1_BIT, the base image is multisampled with
+  // this many samples, e.g. a color target resolved by the shaders (which
+  // then write level 0 of the pyramid too; it is downloaded for testing).
+  // Multisampled images cannot be copied to, so fillBase writes the
+  // samples to their own staging buffer region instead, texel (x, y)
+  // sample s at (y * width + x) * samples + s, and shaders/msaa_fill.comp
+  // copies them to the base image on upload. baseFormat must be
+  // VK_FORMAT_R16G16B16A16_SFLOAT, and the device must support the
+  // shaderStorageImageMultisample feature.
+  VkSampleCountFlagBits baseSamples = VK_SAMPLE_COUNT_1_BIT;
+};
+
+// Regions of the staging buffer start at multiples of this many bytes.
+constexpr VkDeviceSize formatPyramidStagingAlignment = 16;
+
+inline VkDeviceSize formatPyramidStagingAlign(VkDeviceSize offset)
+{
+  return (offset + formatPyramidStagingAlignment - 1)
+         & ~(formatPyramidStagingAlignment - 1);
+}
+
+// Regions bound as storage buffers start at multiples of this many
+// bytes instead (the largest minStorageBufferOffsetAlignment allowed).
+constexpr VkDeviceSize formatPyramidStorageBufferAlignment = 256;
+
+inline VkDeviceSize formatPyramidStorageBufferAlign(VkDeviceSize offset)
+{
+  return (offset + formatPyramidStorageBufferAlignment - 1)
+         & ~(formatPyramidStorageBufferAlignment - 1);
+}
+
+// Size in bytes of a pyramid of the given base level size and texel
+// size in the staging buffer, i.e. of all its mip levels packed in the
+// same way as MipmapStorage. For block-compressed formats, texelSize is
+// the size of blocks of blockEdge x blockEdge texels (partial blocks at
+// the edges of each level included).
+inline VkDeviceSize formatPyramidBytes(uint32_t width, uint32_t height,
+                                       uint32_t texelSize,
+                                       uint32_t blockEdge = 1)
+{
+  VkDeviceSize texels = 0;
+  while (true)
+  {
+    texels += VkDeviceSize((width + blockEdge - 1) / blockEdge)
+              * ((height + blockEdge - 1) / blockEdge);
+    if (width == 1 && height == 1) break;
+    width  =  width >> 1 | (width  == 1u);
+    height = height >> 1 | (height == 1u);
+  }
+  return texels * texelSize;
+}
+
+extern const FormatPyramidConfig formatPyramidConfigs[];
+extern const size_t              formatPyramidConfigCount;
+
+// Image pyramid of one FormatPyramidConfig, with its staging buffer,
+// descriptors, and fast/general pipelines.
+class FormatPyramid
+{
+  // Borrowed
+  VkDevice                   m_device;
+  const FormatPyramidConfig& m_config;
+
+  nvvk::ResourceAllocatorDedicated m_allocator;
+
+  nvvk::Image  m_image{};
+  nvvk::Image  m_baseImage{};  // may be null, or multisampled
+  nvvk::Image  m_auxImage{};   // may be null
+  nvvk::Image  m_planeImage{}; // may be null
+  std::array<nvvk::Buffer, 2> m_buffers{};  // may be null
+  nvvk::Buffer m_stagingBuffer{};
+  void*        m_pStagingBufferMap{};
+
+  uint32_t m_width, m_height;
+
+  // Width/height and offset [texels] of each mip level in the staging
+  // buffer; byte offset of each aux pyramid level (if any), and of the
+  // downloaded buffers.
+  std::vector<VkExtent2D>     m_levelExtents;
+  std::vector<uint64_t>       m_levelOffsets;
+  std::vector<VkDeviceSize>   m_auxStagingOffsets;
+  VkDeviceSize                m_planeStagingOffset{};
+  VkDeviceSize                m_baseSamplesStagingOffset{};
+  std::array<VkDeviceSize, 2> m_bufferStagingOffsets{};
+
+  // Whether a buffer replaces the storage images, see FormatPyramidBuffer.
+  bool m_hasStorageImages{};
+
+  VkSampler                 m_sampler{};
+  VkImageView               m_samplerView{};
+  VkImageView               m_baseView{};
+  VkImageView               m_planeView{};
+  VkImageView               m_auxSamplerView{};
+  std::array<VkImageView, 16> m_storageViews{};
+  std::array<VkImageView, 16> m_auxStorageViews{};
+
+  // set=0: textures; set=1: storage images (+ aux storage images).
+  nvvk::DescriptorSetContainer m_textureDescriptorContainer;
+  nvvk::DescriptorSetContainer m_storageDescriptorContainer;
+
+  VkPipelineLayout m_layout{};
+  VkPipeline       m_fastPipeline{};
+  VkPipeline       m_generalPipeline{};
+  VkPipeline       m_baseLevelPipeline{};  // may be null
+
+  // Copies the samples from the staging buffer to a multisampled base
+  // image (shaders/msaa_fill.comp); null otherwise.
+  nvvk::DescriptorSetContainer m_fillDescriptorContainer;
+  VkPipelineLayout             m_fillLayout{};
+  VkPipeline                   m_fillPipeline{};
+
+  bool m_usesSamplerReduction{};
+  bool m_usesLinearFilter{};
+
+public:
+  // Allocates the image and staging buffer (base level filled in).
+  // samplerFilterMinmax: whether VK_EXT_sampler_filter_minmax is enabled.
+  FormatPyramid(VkDevice                   device,
+                VkPhysicalDevice           physicalDevice,
+                bool                       samplerFilterMinmax,
+                const FormatPyramidConfig& config,
+                uint32_t                   width,
+                uint32_t                   height,
+                const char*                pInputFilename,
+                bool                       dumpPipelineStats);
+
+  ~FormatPyramid();
+
+  FormatPyramid(FormatPyramid&&) = delete;
+
+  // Whether the images of the config can be created on the device;
+  // pReason is set to a description of what is missing otherwise.
+  static bool isSupported(VkPhysicalDevice           physicalDevice,
+                          const FormatPyramidConfig& config,
+                          const char**               pReason);
+
+  bool usesSamplerReduction() const { return m_usesSamplerReduction; }
+  bool usesLinearFilter() const { return m_usesLinearFilter; }
+
+  // Record commands to upload the base level (and plane) from the
+  // staging buffer, clear the aux pyramid and buffers, and transition
+  // all images to general layout; includes barriers. A multisampled
+  // base image is filled by m_fillPipeline instead.
+  void cmdUpload(VkCommandBuffer cmdBuf);
+
+  // Record commands to generate mip levels 1+. No barriers before or after.
+  void cmdGenerate(VkCommandBuffer cmdBuf);
+
+  // Record commands to download mip levels 1+ (0+ if the base image is
+  // multisampled; and the aux pyramid and buffers marked for download)
+  // to the staging buffer, including
+  // barriers before (all prior writes) and after (host read).
+  void cmdDownload(VkCommandBuffer cmdBuf);
+
+  // Compare the staging buffer contents with the CPU reference.
+  double test() const;
+
+  // Size in bytes of mip levels 1+ (written by each cmdGenerate; 0+ if
+  // the base image is multisampled), or of the storage buffers if they
+  // replace the storage images.
+  VkDeviceSize mipLevelBytes() const;
+};
+
+// Benchmark every formatPyramidConfigs entry at a few resolutions
+// (plus its pExtraSizes), using the same batching scheme as the sRGBA8
+// benchmark. Return the results formatted as json members,
+// "label": {"WxH": {...}, ...}, without trailing comma or newline; empty if there are no configs.
+// hdrFilename: optional .hdr input for the RGBA16F/RGBA32F configs
+// (tiled to each benchmark size); empty for synthetic input.
+std::string benchmarkFormatPyramids(nvvk::Context&     ctx,
+                                    bool               enableTesting,
+                                    bool               dumpPipelineStats,
+                                    const std::string& hdrFilename);
+
+#endif /* !VK_COMPUTE_MIPMAPS_DEMO_FORMAT_PYRAMID_HPP_ */
@@ -0,0 +1,1088 @@
+// Copyright 2021 NVIDIA CORPORATION
+// SPDX-License-Identifier: Apache-2.0
+
+// List of FormatPyramidConfig benchmarked in addition to the sRGBA8
+// pipeline alternatives, along with their synthetic input generators
+// and CPU reference comparisons.
+#include "format_pyramid.hpp"
+
+#include <algorithm>
+#include <math.h>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "stb_image.h"
+
+#include "mipmap_storage.hpp"
+#include "nvpro_pyramid_bc1.hpp"
+#include "nvpro_pyramid_luminance.hpp"
+
+// ************************************************************************
+// Hi-Z depth pyramids (depth_pyramid_preamble.glsl)
+
+// Simple hash for generating synthetic input deterministically.
+static uint32_t hashCell(uint32_t x, uint32_t y)
+{
+  uint32_t hash = x * 73856093u ^ y * 19349663u;
+  hash ^= hash >> 13;
+  hash *= 0x5bd1e995u;
+  hash ^= hash >> 15;
+  return hash;
+}
+
+// Synthetic depth buffer: receding floor, partly covered by boxes of
+// varying depth on a grid; written to the first of Channels floats per texel.
+template <uint32_t Channels>
+static void fillDepth(void* pTexels, uint32_t width, uint32_t height, const char*)
+{
+  float* pOut = static_cast<float*>(pTexels);
+  for (uint32_t y = 0; y < height; ++y)
+  {
+    for (uint32_t x = 0; x < width; ++x)
+    {
+      float    depth = 0.05f + 0.5f * (float(y) + 0.5f) / float(height);
+      uint32_t hash  = hashCell(x / 61u, y / 47u);
+      if ((hash & 3u) == 0u)
+      {
+        depth = 0.6f + float(hash >> 8 & 255u) * (0.35f / 255.f);
+      }
+      for (uint32_t c = 0; c < Channels; ++c)
+      {
+        pOut[c] = depth;
+      }
+      pOut += Channels;
+    }
+  }
+}
+
+template <uint32_t Channels, typename Generate>
+static double testFloatPyramid(const void* pLevels, uint32_t width,
+                               uint32_t height, Generate&& generate)
+{
+  MipmapStorage<float, Channels> expected(width, height);
+  memcpy(expected.levelData(0), pLevels, expected.getLevelByteSize(0));
+  generate(&expected);
+  return expected.compare(pLevels);
+}
+
+static double testDepthMin(const void* pLevels, uint32_t width, uint32_t height)
+{
+  return testFloatPyramid<1>(pLevels, width, height,
+                             [](MipmapStorage<float, 1>* pMips) {
+                               cpuGenerateDepthPyramid(pMips, false);
+                             });
+}
+
+static double testDepthMax(const void* pLevels, uint32_t width, uint32_t height)
+{
+  return testFloatPyramid<1>(pLevels, width, height,
+                             [](MipmapStorage<float, 1>* pMips) {
+                               cpuGenerateDepthPyramid(pMips, true);
+                             });
+}
+
+static double testDepthMinMax(const void* pLevels, uint32_t width, uint32_t height)
+{
+  return testFloatPyramid<2>(pLevels, width, height,
+                             cpuGenerateDepthPyramidMinMax);
+}
+
+#define DEPTH_PYRAMID_SHADERS                      \
+  "./nvpro_pyramid/depth_pyramid_fast_pipeline.comp", \
+  "./nvpro_pyramid/depth_pyramid_general_pipeline.comp"
+
+// ************************************************************************
+// HDR RGBA16F / RGBA32F mipmaps (rgba16f_mipmap_preamble.glsl)
+
+// IEEE half <-> float conversion (round to nearest even).
+static uint16_t halfFromFloat(float arg)
+{
+  uint32_t bits;
+  memcpy(&bits, &arg, sizeof bits);
+  uint32_t sign     = bits >> 16 & 0x8000u;
+  uint32_t absBits  = bits & 0x7FFFFFFFu;
+  if (absBits >= 0x7F800000u)  // Inf or NaN
+  {
+    return uint16_t(sign | 0x7C00u | (absBits > 0x7F800000u ? 0x200u : 0u));
+  }
+  if (absBits >= 0x477FF000u)  // Rounds to >= 65520: overflow to Inf
+  {
+    return uint16_t(sign | 0x7C00u);
+  }
+  if (absBits < 0x38800000u)  // Denormal half (or zero)
+  {
+    float    absArg  = fabsf(arg) * 16777216.0f;  // 2^24 = 1 / smallest denormal
+    uint32_t rounded = uint32_t(nearbyintf(absArg));
+    return uint16_t(sign | rounded);
+  }
+  uint32_t mantissa = absBits & 0x1FFFu;
+  uint32_t result   = (absBits - 0x38000000u) >> 13;
+  if (mantissa > 0x1000u || (mantissa == 0x1000u && (result & 1u))) ++result;
+  return uint16_t(sign | result);
+}
+
+static float floatFromHalf(uint16_t arg)
+{
+  uint32_t sign     = uint32_t(arg & 0x8000u) << 16;
+  uint32_t exponent = arg >> 10 & 0x1Fu;
+  uint32_t mantissa = arg & 0x3FFu;
+  float    result;
+  if (exponent == 0)
+  {
+    result = float(mantissa) * (1.0f / 16777216.0f);
+    return sign ? -result : result;
+  }
+  uint32_t bits = exponent == 31 ? sign | 0x7F800000u | mantissa << 13 :
+                                   sign | (exponent + 112u) << 23 | mantissa << 13;
+  memcpy(&result, &bits, sizeof result);
+  return result;
+}
+
+// Fill with the user's .hdr image (tiled), or a synthetic HDR pattern:
+// dim gradient plus a grid of small, very bright "light sources".
+template <bool Half>
+static void fillHdr(void* pTexels, uint32_t width, uint32_t height,
+                    const char* pInputFilename)
+{
+  // Cache the loaded image between calls (one per benchmark size).
+  static std::string             cachedFilename;
+  static std::unique_ptr<float[]> pCachedImage;
+  static int                     cachedWidth, cachedHeight;
+  if (pInputFilename && cachedFilename != pInputFilename)
+  {
+    int    channels;
+    float* pLoaded = stbi_loadf(pInputFilename, &cachedWidth, &cachedHeight,
+                                &channels, 4);
+    if (!pLoaded)
+    {
+      fprintf(stderr, "Could not load HDR image '%s': %s\n", pInputFilename,
+              stbi_failure_reason());
+      exit(1);
+    }
+    size_t floatCount = size_t(cachedWidth) * size_t(cachedHeight) * 4u;
+    pCachedImage.reset(new float[floatCount]);
+    memcpy(pCachedImage.get(), pLoaded, floatCount * sizeof(float));
+    stbi_image_free(pLoaded);
+    cachedFilename = pInputFilename;
+  }
+
+  for (uint32_t y = 0; y < height; ++y)
+  {
+    for (uint32_t x = 0; x < width; ++x)
+    {
+      float texel[4];
+      if (pInputFilename)
+      {
+        const float* pIn = &pCachedImage[(size_t(y % uint32_t(cachedHeight))
+                                              * uint32_t(cachedWidth)
+                                          + x % uint32_t(cachedWidth)) * 4u];
+        memcpy(texel, pIn, sizeof texel);
+      }
+      else
+      {
+        uint32_t hash  = hashCell(x / 13u, y / 11u);
+        float    light = (hash & 15u) == 0 && x % 13u < 3u && y % 11u < 3u ?
+                             float(hash >> 8 & 1023u) : 0.0f;
+        texel[0] = 0.25f * float(x) / float(width) + light;
+        texel[1] = 0.25f * float(y) / float(height) + 0.5f * light;
+        texel[2] = 0.0625f + 0.25f * light;
+        texel[3] = 1.0f;
+      }
+      size_t idx = (size_t(y) * width + x) * 4u;
+      for (uint32_t c = 0; c < 4; ++c)
+      {
+        if (Half) static_cast<uint16_t*>(pTexels)[idx + c] = halfFromFloat(texel[c]);
+        else      static_cast<float*>(pTexels)[idx + c]    = texel[c];
+      }
+    }
+  }
+}
+
+// Channel i (in texel order) of the RGBA16F/RGBA32F pyramid.
+template <bool Half>
+static float hdrChannel(const void* pLevels, size_t i)
+{
+  return Half ? floatFromHalf(static_cast<const uint16_t*>(pLevels)[i]) :
+                static_cast<const float*>(pLevels)[i];
+}
+
+// Compare the texels from firstTexel on with the generated CPU reference
+// (level 0 filled in); returns the worst relative difference (absolute
+// for values below 1).
+template <bool Half>
+static double compareHdr(const void* pLevels, MipmapStorage<float, 4>* pExpected,
+                         size_t firstTexel)
+{
+  using Texel    = std::array<float, 4>;
+  auto identity  = [](Texel texel) { return texel; };
+  auto roundHalf = [](Texel texel) {
+    for (float& f : texel) f = Half ? floatFromHalf(halfFromFloat(f)) : f;
+    return texel;
+  };
+  pExpected->generateMipmaps(identity, roundHalf);
+
+  double       worst      = 0.0;
+  size_t       texelCount = pExpected->getByteSize() / sizeof(Texel);
+  const Texel* pTexels    = pExpected->levelData(0);
+  for (size_t i = firstTexel; i < texelCount; ++i)
+  {
+    for (uint32_t c = 0; c < 4; ++c)
+    {
+      double e = pTexels[i][c], a = hdrChannel<Half>(pLevels, 4 * i + c);
+      worst    = std::max(worst, fabs(a - e) / std::max(1.0, fabs(e)));
+    }
+  }
+  return worst;
+}
+
+// Compare with the CPU reference generated from the base level.
+template <bool Half>
+static double testHdr(const void* pLevels, uint32_t width, uint32_t height)
+{
+  MipmapStorage<float, 4> expected(width, height);
+  size_t baseTexels = size_t(width) * height;
+  for (size_t i = 0; i < baseTexels; ++i)
+  {
+    for (uint32_t c = 0; c < 4; ++c)
+    {
+      expected.levelData(0)[i][c] = hdrChannel<Half>(pLevels, 4 * i + c);
+    }
+  }
+  return compareHdr<Half>(pLevels, &expected, baseTexels);
+}
+
+#define HDR_SHADERS                                      \
+  "./nvpro_pyramid/rgba16f_mipmap_fast_pipeline.comp", \
+  "./nvpro_pyramid/rgba16f_mipmap_general_pipeline.comp"
+
+// ************************************************************************
+// Packed HDR mipmaps (packed_hdr_mipmap_preamble.glsl), same input as
+// the RGBA16F configs (alpha dropped).
+
+enum class PackedHdr
+{
+  eR11G11B10,
+  eRgb9e5
+};
+
+// Unsigned float with a 5-bit exponent (as half) and the given number
+// of mantissa bits, rounded as in packHdr.
+static uint32_t ufloatFromFloat(float arg, uint32_t mantissaBits)
+{
+  float maxValue = mantissaBits == 6u ? 65024.0f : 64512.0f;
+  uint32_t halfBits = halfFromFloat(std::min(std::max(arg, 0.0f), maxValue));
+  uint32_t dropBits = 10u - mantissaBits;
+  uint32_t lsb      = halfBits >> dropBits & 1u;
+  return (halfBits + (1u << (dropBits - 1u)) - 1u + lsb) >> dropBits;
+}
+
+static float floatFromUfloat(uint32_t bits, uint32_t mantissaBits)
+{
+  return floatFromHalf(uint16_t(bits << (10u - mantissaBits)));
+}
+
+template <PackedHdr Format>
+static uint32_t packHdr(const float* rgb)
+{
+  if (Format == PackedHdr::eR11G11B10)
+  {
+    return ufloatFromFloat(rgb[0], 6) | ufloatFromFloat(rgb[1], 6) << 11
+           | ufloatFromFloat(rgb[2], 5) << 22;
+  }
+  float clamped[3];
+  for (int c = 0; c < 3; ++c)
+  {
+    clamped[c] = std::min(std::max(rgb[c], 0.0f), 65408.0f);
+  }
+  float maxc = std::max(clamped[0], std::max(clamped[1], clamped[2]));
+  int   floorLog2;
+  frexpf(maxc, &floorLog2);
+  floorLog2     = maxc == 0.0f ? -16 : floorLog2 - 1;
+  int expShared = std::max(-16, floorLog2) + 16;
+  if (floorf(ldexpf(maxc, 24 - expShared) + 0.5f) == 512.0f) ++expShared;
+  uint32_t result = uint32_t(expShared) << 27;
+  for (int c = 0; c < 3; ++c)
+  {
+    result |= uint32_t(floorf(ldexpf(clamped[c], 24 - expShared) + 0.5f)) << (9 * c);
+  }
+  return result;
+}
+
+template <PackedHdr Format>
+static std::array<float, 3> unpackHdr(uint32_t packed)
+{
+  if (Format == PackedHdr::eR11G11B10)
+  {
+    return {floatFromUfloat(packed & 0x7FFu, 6),
+            floatFromUfloat(packed >> 11 & 0x7FFu, 6),
+            floatFromUfloat(packed >> 22, 5)};
+  }
+  int exponent = int(packed >> 27) - 24;
+  return {ldexpf(float(packed & 0x1FFu), exponent),
+          ldexpf(float(packed >> 9 & 0x1FFu), exponent),
+          ldexpf(float(packed >> 18 & 0x1FFu), exponent)};
+}
+
+template <PackedHdr Format>
+static void fillPackedHdr(void* pTexels, uint32_t width, uint32_t height,
+                          const char* pInputFilename)
+{
+  std::vector<float> rgba(size_t(width) * height * 4u);
+  fillHdr<false>(rgba.data(), width, height, pInputFilename);
+  for (size_t i = 0; i < size_t(width) * height; ++i)
+  {
+    static_cast<uint32_t*>(pTexels)[i] = packHdr<Format>(&rgba[4 * i]);
+  }
+}
+
+// Compare with the CPU reference (quantized to the format at every
+// level); returns the worst relative difference (absolute below 1).
+template <PackedHdr Format>
+static double testPackedHdr(const void* pLevels, uint32_t width, uint32_t height)
+{
+  using Texel = std::array<float, 3>;
+  const uint32_t* pPacked = static_cast<const uint32_t*>(pLevels);
+  MipmapStorage<float, 3> expected(width, height);
+  size_t texelCount = expected.getByteSize() / sizeof(Texel);
+  for (size_t i = 0; i < size_t(width) * height; ++i)
+  {
+    expected.levelData(0)[i] = unpackHdr<Format>(pPacked[i]);
+  }
+  auto identity = [](Texel texel) { return texel; };
+  auto quantize = [](Texel texel) {
+    return unpackHdr<Format>(packHdr<Format>(texel.data()));
+  };
+  expected.generateMipmaps(identity, quantize);
+
+  double worst = 0.0;
+  for (size_t i = size_t(width) * height; i < texelCount; ++i)
+  {
+    Texel actual = unpackHdr<Format>(pPacked[i]);
+    for (uint32_t c = 0; c < 3; ++c)
+    {
+      double e = expected.levelData(0)[i][c], a = actual[c];
+      worst    = std::max(worst, fabs(a - e) / std::max(1.0, fabs(e)));
+    }
+  }
+  return worst;
+}
+
+#define PACKED_HDR_SHADERS                                  \
+  "./nvpro_pyramid/packed_hdr_mipmap_fast_pipeline.comp", \
+  "./nvpro_pyramid/packed_hdr_mipmap_general_pipeline.comp"
+
+// ************************************************************************
+// Normal maps with Toksvig roughness (normal_map_preamble.glsl)
+
+// Synthetic RG8 unorm tangent-space normal map: gentle large-scale
+// waves plus fine bumps, so that the averaged normals get shorter
+// (nonzero Toksvig variance) at lower mip levels.
+static void fillNormal(void* pTexels, uint32_t width, uint32_t height, const char*)
+{
+  uint8_t* pOut = static_cast<uint8_t*>(pTexels);
+  for (uint32_t y = 0; y < height; ++y)
+  {
+    for (uint32_t x = 0; x < width; ++x)
+    {
+      // Height field slopes.
+      float    dx   = 0.3f * sinf(float(x) * 0.02f);
+      float    dy   = 0.3f * cosf(float(y) * 0.03f);
+      uint32_t hash = hashCell(x / 3u, y / 3u);
+      dx += (float(hash & 255u) - 127.5f) * (1.5f / 255.f);
+      dy += (float(hash >> 8 & 255u) - 127.5f) * (1.5f / 255.f);
+      float rcpLen = 1.0f / sqrtf(dx * dx + dy * dy + 1.0f);
+      pOut[0] = uint8_t(nearbyintf((-dx * rcpLen * 0.5f + 0.5f) * 255.f));
+      pOut[1] = uint8_t(nearbyintf((-dy * rcpLen * 0.5f + 0.5f) * 255.f));
+      pOut += 2;
+    }
+  }
+}
+
+// CPU reference: mip levels are stored as (x, y, z, Toksvig variance),
+// with the same quantization as the GPU images (rg8, r16f).
+static std::array<float, 4> normalDecode(uint8_t x, uint8_t y)
+{
+  float nx = x * (2.f / 255.f) - 1.0f;
+  float ny = y * (2.f / 255.f) - 1.0f;
+  return {nx, ny, sqrtf(std::max(0.0f, 1.0f - nx * nx - ny * ny)), 0.0f};
+}
+
+static double testNormal(const void* pLevels, uint32_t width, uint32_t height)
+{
+  using Texel = std::array<float, 4>;
+  MipmapStorage<float, 4> expected(width, height);
+  size_t texelCount = expected.getByteSize() / sizeof(Texel);
+  const uint8_t*  pNormals   = static_cast<const uint8_t*>(pLevels);
+  const uint16_t* pVariances = reinterpret_cast<const uint16_t*>(
+      pNormals + formatPyramidStagingAlign(2 * texelCount));
+  for (size_t i = 0; i < size_t(width) * height; ++i)
+  {
+    expected.levelData(0)[i] = normalDecode(pNormals[2 * i], pNormals[2 * i + 1]);
+  }
+
+  // Load as unnormalized average (see normalLoad), i.e. the stored
+  // texel is already in "linear" space.
+  auto toAverage = [](Texel texel) {
+    float scale = 1.0f / (1.0f + texel[3]);
+    return Texel{texel[0] * scale, texel[1] * scale, texel[2] * scale, 0.0f};
+  };
+  auto fromAverage = [](Texel average) {
+    float len = sqrtf(average[0] * average[0] + average[1] * average[1]
+                      + average[2] * average[2]);
+    if (len < 1e-6f) return Texel{0.0f, 0.0f, 1.0f, 65504.0f};
+    auto quantize = [](float n) {
+      return uint8_t(nvmath::nv_clamp(nearbyintf((n * 0.5f + 0.5f) * 255.f),
+                                      0.0f, 255.0f));
+    };
+    Texel result = normalDecode(quantize(average[0] / len), quantize(average[1] / len));
+    result[3]    = floatFromHalf(halfFromFloat(
+        std::min(65504.0f, std::max(0.0f, (1.0f - len) / len))));
+    return result;
+  };
+  expected.generateMipmaps(toAverage, fromAverage);
+
+  // Worst difference of normal components (8-bit steps) and of the
+  // variance (relative, in percent).
+  double worst = 0.0;
+  for (size_t i = size_t(width) * height; i < texelCount; ++i)
+  {
+    const Texel& e = expected.levelData(0)[i];
+    for (uint32_t c = 0; c < 2; ++c)
+    {
+      double encoded = (e[c] + 1.0) * (255.0 / 2.0);
+      worst = std::max(worst, fabs(pNormals[2 * i + c] - encoded));
+    }
+    double variance = floatFromHalf(pVariances[i]);
+    worst = std::max(worst, 100.0 * fabs(variance - e[3]) / std::max(1.0, double(e[3])));
+  }
+  return worst;
+}
+
+#define NORMAL_MAP_SHADERS                            \
+  "./nvpro_pyramid/normal_map_fast_pipeline.comp", \
+  "./nvpro_pyramid/normal_map_general_pipeline.comp"
+
+// ************************************************************************
+// 1- and 2-channel unorm mipmaps (unorm_mipmap_preamble.glsl)
+
+// Synthetic mask (channel 0: blocky alpha-test-like mask with soft
+// edges) and height (channel 1: smooth waves) data. Channels past
+// UsedChannels are filled with 0, e.g. to benchmark R8 data padded to RGBA8.
+template <uint32_t Channels, uint32_t Bits, uint32_t UsedChannels = Channels>
+static void fillUnorm(void* pTexels, uint32_t width, uint32_t height, const char*)
+{
+  constexpr float maxValue = float((1u << Bits) - 1u);
+  for (uint32_t y = 0; y < height; ++y)
+  {
+    for (uint32_t x = 0; x < width; ++x)
+    {
+      float    value[2];
+      uint32_t hash = hashCell(x / 17u, y / 9u);
+      value[0] = (hash & 1u) ? 1.0f : float(x % 17u) * (1.0f / 16.0f) * float(hash >> 1 & 1u);
+      value[1] = 0.5f + 0.25f * sinf(float(x) * 0.05f) + 0.25f * cosf(float(y) * 0.07f);
+      for (uint32_t c = 0; c < Channels; ++c)
+      {
+        uint32_t encoded = c < UsedChannels && c < 2 ?
+                               uint32_t(nearbyintf(value[c] * maxValue)) : 0u;
+        size_t   idx     = (size_t(y) * width + x) * Channels + c;
+        if (Bits == 8) static_cast<uint8_t*>(pTexels)[idx]  = uint8_t(encoded);
+        else           static_cast<uint16_t*>(pTexels)[idx] = uint16_t(encoded);
+      }
+    }
+  }
+}
+
+// Compare with the CPU reference; returns the worst difference in
+// quantization steps.
+template <uint32_t Channels, uint32_t Bits>
+static double testUnorm(const void* pLevels, uint32_t width, uint32_t height)
+{
+  using Texel = std::array<float, Channels>;
+  constexpr float maxValue = float((1u << Bits) - 1u);
+  auto encoded = [pLevels](size_t i) -> float {
+    return Bits == 8 ? static_cast<const uint8_t*>(pLevels)[i] :
+                       static_cast<const uint16_t*>(pLevels)[i];
+  };
+
+  MipmapStorage<float, Channels> expected(width, height);
+  size_t texelCount = expected.getByteSize() / sizeof(Texel);
+  for (size_t i = 0; i < size_t(width) * height; ++i)
+  {
+    for (uint32_t c = 0; c < Channels; ++c)
+    {
+      expected.levelData(0)[i][c] = encoded(i * Channels + c) / maxValue;
+    }
+  }
+  auto identity = [](Texel texel) { return texel; };
+  auto quantize = [](Texel texel) {
+    for (float& f : texel)
+    {
+      f = nearbyintf(nvmath::nv_clamp(f, 0.0f, 1.0f) * maxValue) / maxValue;
+    }
+    return texel;
+  };
+  expected.generateMipmaps(identity, quantize);
+
+  double worst = 0.0;
+  for (size_t i = size_t(width) * height; i < texelCount; ++i)
+  {
+    for (uint32_t c = 0; c < Channels; ++c)
+    {
+      double e = expected.levelData(0)[i][c] * maxValue;
+      worst    = std::max(worst, fabs(encoded(i * Channels + c) - e));
+    }
+  }
+  return worst;
+}
+
+#define UNORM_SHADERS                                  \
+  "./nvpro_pyramid/unorm_mipmap_fast_pipeline.comp", \
+  "./nvpro_pyramid/unorm_mipmap_general_pipeline.comp"
+
+// ************************************************************************
+// Average log2 luminance (luminance_preamble.glsl), same input as the
+// RGBA16F configs; only the 1x1 result is stored (to a buffer).
+
+static VkDeviceSize luminanceResultBytes(uint32_t, uint32_t)
+{
+  return sizeof(float);
+}
+
+// Compare luminanceResult with the mean of the log2 luminance of the
+// base level; returns the absolute difference (in stops).
+static double testLuminance(const void* pLevels, uint32_t width, uint32_t height)
+{
+  const uint16_t* pTexels = static_cast<const uint16_t*>(pLevels);
+  double          sum     = 0.0;
+  for (size_t i = 0; i < size_t(width) * height; ++i)
+  {
+    double luminance = 0.2126 * floatFromHalf(pTexels[4 * i])
+                     + 0.7152 * floatFromHalf(pTexels[4 * i + 1])
+                     + 0.0722 * floatFromHalf(pTexels[4 * i + 2]);
+    sum += log2(std::max(luminance, 1.0 / 65536.0));
+  }
+  float result;
+  memcpy(&result,
+         static_cast<const char*>(pLevels)
+             + formatPyramidStagingAlign(formatPyramidBytes(width, height, 8)),
+         sizeof result);
+  return fabs(result - sum / (double(width) * height));
+}
+
+// Sizes where the fast pipeline fills 6 levels and hands off to the
+// fast (4096x2048) or general (1280x704) pipeline, and a tiny odd size.
+static const VkExtent2D luminanceSizes[] = {{4096, 2048}, {1280, 704}, {5, 3}};
+
+#define LUMINANCE_SHADERS                                \
+  "./nvpro_pyramid/luminance_fast_pipeline.comp", \
+  "./nvpro_pyramid/luminance_general_pipeline.comp"
+
+// ************************************************************************
+// sRGBA8 mipmaps encoded to BC1 (srgba8_bc1_preamble.glsl)
+
+// Synthetic sRGBA8 input: flat colored cells (exact in BC1 up to 5:6:5
+// quantization) over a smooth two-color gradient; opaque.
+static void fillSrgba8(void* pTexels, uint32_t width, uint32_t height, const char*)
+{
+  uint8_t* pOut = static_cast<uint8_t*>(pTexels);
+  for (uint32_t y = 0; y < height; ++y)
+  {
+    for (uint32_t x = 0; x < width; ++x)
+    {
+      uint32_t hash = hashCell(x / 23u, y / 19u);
+      if ((hash & 3u) == 0u)
+      {
+        pOut[0] = uint8_t(hash >> 8);
+        pOut[1] = uint8_t(hash >> 16);
+        pOut[2] = uint8_t(hash >> 24);
+      }
+      else
+      {
+        pOut[0] = uint8_t(255u * x / width);
+        pOut[1] = uint8_t(64u + 128u * y / height);
+        pOut[2] = uint8_t(255u - 255u * x / width);
+      }
+      pOut[3] = 255u;
+      pOut += 4;
+    }
+  }
+}
+
+static VkDeviceSize bc1CounterBytes(uint32_t width, uint32_t height)
+{
+  return nvproPyramidBc1CounterBytes(width, height);
+}
+
+// Decode a BC1 block (endpoints | indices << 32, as stored through the
+// R32G32_UINT views) to [0, 1] sRGB-encoded colors; texel (x, y) of the
+// block to decoded[4 * y + x].
+static void decodeBc1Block(uint64_t block, std::array<float, 3> decoded[16])
+{
+  uint32_t             endpoint[2] = {uint32_t(block & 0xFFFFu),
+                                      uint32_t(block >> 16 & 0xFFFFu)};
+  std::array<float, 3> palette[4];
+  for (int i = 0; i < 2; ++i)
+  {
+    palette[i] = {float(endpoint[i] >> 11) / 31.f,
+                  float(endpoint[i] >> 5 & 63u) / 63.f,
+                  float(endpoint[i] & 31u) / 31.f};
+  }
+  for (int c = 0; c < 3; ++c)
+  {
+    if (endpoint[0] > endpoint[1])
+    {
+      palette[2][c] = (2.f * palette[0][c] + palette[1][c]) / 3.f;
+      palette[3][c] = (palette[0][c] + 2.f * palette[1][c]) / 3.f;
+    }
+    else
+    {
+      palette[2][c] = 0.5f * (palette[0][c] + palette[1][c]);
+      palette[3][c] = 0.0f;
+    }
+  }
+  for (int i = 0; i < 16; ++i)
+  {
+    decoded[i] = palette[block >> (32 + 2 * i) & 3u];
+  }
+}
+
+// Decode the BC1 pyramid (all levels) and compare with the CPU
+// reference sRGBA8 pyramid. A bounding box encoder can be off by up to
+// the range of a channel within the block (for colors off the box
+// diagonal), so check that each texel is within that range, plus slack
+// for 5:6:5 endpoint rounding and for GPU/CPU mip level differences
+// of 1 step; returns the worst excess in 8-bit steps (0 if all are
+// within bounds).
+static double testBc1(const void* pLevels, uint32_t width, uint32_t height)
+{
+  MipmapStorage<uint8_t, 4> expected(width, height);
+  memcpy(expected.levelData(0), pLevels, expected.getLevelByteSize(0));
+  cpuGenerateMipmaps_sRGBA(&expected);
+
+  const double slack  = 0.5 / 31.0 + 3.0 / 255.0;
+  const char*  pBlock = static_cast<const char*>(pLevels)
+                       + formatPyramidStagingAlign(formatPyramidBytes(width, height, 4));
+  double       worst  = 0.0;
+  const auto&  sizes  = expected.getWidthHeight();
+  for (uint32_t level = 0; level < uint32_t(sizes.size()); ++level)
+  {
+    uint32_t levelWidth = sizes[level].x, levelHeight = sizes[level].y;
+    const std::array<uint8_t, 4>* pExpected = expected.levelData(level);
+    for (uint32_t by = 0; by < (levelHeight + 3u) / 4u; ++by)
+    {
+      for (uint32_t bx = 0; bx < (levelWidth + 3u) / 4u; ++bx)
+      {
+        uint64_t block;
+        memcpy(&block, pBlock, sizeof block);
+        pBlock += sizeof block;
+        std::array<float, 3> decoded[16];
+        decodeBc1Block(block, decoded);
+
+        // Texels of the block within the level.
+        uint32_t xCount = std::min(4u, levelWidth - 4u * bx);
+        uint32_t yCount = std::min(4u, levelHeight - 4u * by);
+        auto texel = [&](uint32_t x, uint32_t y) -> const std::array<uint8_t, 4>& {
+          return pExpected[size_t(4u * by + y) * levelWidth + 4u * bx + x];
+        };
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+          uint8_t lo = 255u, hi = 0u;
+          for (uint32_t y = 0; y < yCount; ++y)
+          {
+            for (uint32_t x = 0; x < xCount; ++x)
+            {
+              lo = std::min(lo, texel(x, y)[c]);
+              hi = std::max(hi, texel(x, y)[c]);
+            }
+          }
+          double bound = (hi - lo) / 255.0 + slack;
+          for (uint32_t y = 0; y < yCount; ++y)
+          {
+            for (uint32_t x = 0; x < xCount; ++x)
+            {
+              double error = fabs(decoded[4 * y + x][c] - texel(x, y)[c] / 255.0);
+              worst        = std::max(worst, (error - bound) * 255.0);
+            }
+          }
+        }
+      }
+    }
+  }
+  return worst;
+}
+
+#define BC1_SHADERS                                      \
+  "./nvpro_pyramid/srgba8_bc1_fast_pipeline.comp", \
+  "./nvpro_pyramid/srgba8_bc1_general_pipeline.comp"
+
+// ************************************************************************
+// NV12 video frame pyramids (nv12_preamble.glsl); the Y plane is the
+// base level (R8), the CbCr plane the half-size plane image (RG8).
+
+// Byte offset of the CbCr plane in the staging buffer: after the
+// pyramid, and after the chroma (aux) pyramid for separate planes.
+template <bool SeparatePlanes>
+static VkDeviceSize nv12ChromaPlaneOffset(uint32_t width, uint32_t height)
+{
+  VkDeviceSize offset =
+      formatPyramidStagingAlign(formatPyramidBytes(width, height, SeparatePlanes ? 1 : 4));
+  if (SeparatePlanes)
+  {
+    offset = formatPyramidStagingAlign(offset + formatPyramidBytes(width, height, 2));
+  }
+  return offset;
+}
+
+// Synthetic limited range frame: luma and chroma gradients, partly
+// covered by flat cells of random color.
+template <bool SeparatePlanes>
+static void fillNv12(void* pTexels, uint32_t width, uint32_t height, const char*)
+{
+  uint8_t* pLuma = static_cast<uint8_t*>(pTexels);
+  for (uint32_t y = 0; y < height; ++y)
+  {
+    for (uint32_t x = 0; x < width; ++x)
+    {
+      uint32_t hash = hashCell(x / 29u, y / 17u);
+      *pLuma++ = uint8_t((hash & 3u) == 0u ? 16u + (hash >> 8) % 220u :
+                                             16u + 219u * x / width);
+    }
+  }
+  uint8_t* pChroma = static_cast<uint8_t*>(pTexels)
+                   + nv12ChromaPlaneOffset<SeparatePlanes>(width, height);
+  uint32_t chromaWidth = (width + 1) / 2, chromaHeight = (height + 1) / 2;
+  for (uint32_t y = 0; y < chromaHeight; ++y)
+  {
+    for (uint32_t x = 0; x < chromaWidth; ++x)
+    {
+      uint32_t hash = hashCell(x / 7u, y / 5u);
+      bool     flat = (hash & 3u) == 0u;
+      *pChroma++ = uint8_t(flat ? 16u + (hash >> 8) % 225u :
+                                  16u + 224u * x / chromaWidth);
+      *pChroma++ = uint8_t(flat ? 16u + (hash >> 16) % 225u :
+                                  16u + 224u * y / chromaHeight);
+    }
+  }
+}
+
+// Same as rgbFromYcbcr in nv12_preamble.glsl (BT.709, limited range).
+static std::array<float, 3> nv12RgbFromYcbcr(std::array<float, 3> ycbcr)
+{
+  float y  = (ycbcr[0] - 16.f / 255.f) * (255.f / 219.f);
+  float cb = (ycbcr[1] - 128.f / 255.f) * (255.f / 224.f);
+  float cr = (ycbcr[2] - 128.f / 255.f) * (255.f / 224.f);
+  return {y + 1.5748f * cr, y - 0.187324f * cb - 0.468124f * cr, y + 1.8556f * cb};
+}
+
+// Compare the RGBA8 pyramid (converted from the planes), or the luma
+// and chroma pyramids (unconverted), with the CPU reference. Every luma
+// texel of level 0 uses the chroma texel covering it, as in the shaders;
+// returns the worst difference in 8-bit steps.
+template <bool SeparatePlanes>
+static double testNv12(const void* pLevels, uint32_t width, uint32_t height)
+{
+  using Texel = std::array<float, 3>;
+  const uint8_t* pBytes = static_cast<const uint8_t*>(pLevels);
+  const uint8_t* pChromaPlane =
+      pBytes + nv12ChromaPlaneOffset<SeparatePlanes>(width, height);
+  uint32_t chromaWidth = (width + 1) / 2;
+
+  MipmapStorage<float, 3> expected(width, height);
+  size_t texelCount = expected.getByteSize() / sizeof(Texel);
+  for (uint32_t y = 0; y < height; ++y)
+  {
+    for (uint32_t x = 0; x < width; ++x)
+    {
+      const uint8_t* pChroma = &pChromaPlane[2 * (size_t(y / 2) * chromaWidth + x / 2)];
+      Texel ycbcr = {pBytes[size_t(y) * width + x] / 255.f, pChroma[0] / 255.f,
+                     pChroma[1] / 255.f};
+      expected.levelData(0)[size_t(y) * width + x] =
+          SeparatePlanes ? ycbcr : nv12RgbFromYcbcr(ycbcr);
+    }
+  }
+  auto identity = [](Texel texel) { return texel; };
+  auto quantize = [](Texel texel) {
+    for (float& f : texel)
+    {
+      f = nearbyintf(nvmath::nv_clamp(f, 0.0f, 1.0f) * 255.f) / 255.f;
+    }
+    return texel;
+  };
+  expected.generateMipmaps(identity, quantize);
+
+  const uint8_t* pChromaLevels =
+      pBytes + formatPyramidStagingAlign(formatPyramidBytes(width, height, 1));
+  double worst = 0.0;
+  for (size_t i = size_t(width) * height; i < texelCount; ++i)
+  {
+    for (uint32_t c = 0; c < 3; ++c)
+    {
+      double actual = !SeparatePlanes ? pBytes[4 * i + c] :
+                      c == 0          ? pBytes[i] :
+                                        pChromaLevels[2 * i + c - 1];
+      worst = std::max(worst, fabs(actual - expected.levelData(0)[i][c] * 255.0));
+    }
+  }
+  return worst;
+}
+
+#define NV12_RGBA_SHADERS                              \
+  "./nvpro_pyramid/nv12_rgba_fast_pipeline.comp", \
+  "./nvpro_pyramid/nv12_rgba_general_pipeline.comp"
+#define NV12_PLANES_SHADERS                              \
+  "./nvpro_pyramid/nv12_planes_fast_pipeline.comp", \
+  "./nvpro_pyramid/nv12_planes_general_pipeline.comp"
+
+// ************************************************************************
+// MSAA resolve fused into the RGBA16F pyramid (msaa_resolve_preamble.glsl)
+
+constexpr uint32_t msaaSampleCount = 4;  // MSAA_SAMPLES default
+
+// Byte offset of the samples in the staging buffer (no aux pyramid or plane).
+static VkDeviceSize msaaSamplesOffset(uint32_t width, uint32_t height)
+{
+  return formatPyramidStorageBufferAlign(formatPyramidBytes(width, height, 8));
+}
+
+// Synthetic 4x multisampled HDR target: the fillHdr gradient, with
+// round "light sources" evaluated at each sample position (standard 4x
+// pattern), so that their edges differ between samples. fillBase is
+// passed the samples region; the input image is not used.
+static void fillMsaa(void* pSamples, uint32_t width, uint32_t height, const char*)
+{
+  static const float positions[msaaSampleCount][2] = {
+      {0.375f, 0.125f}, {0.875f, 0.375f}, {0.125f, 0.625f}, {0.625f, 0.875f}};
+  uint16_t* pOut = static_cast<uint16_t*>(pSamples);
+  for (uint32_t y = 0; y < height; ++y)
+  {
+    for (uint32_t x = 0; x < width; ++x)
+    {
+      for (uint32_t s = 0; s < msaaSampleCount; ++s)
+      {
+        float    px = float(x) + positions[s][0], py = float(y) + positions[s][1];
+        uint32_t hash = hashCell(x / 13u, y / 11u);
+        float    dx = px - float(x / 13u * 13u + 6u), dy = py - float(y / 11u * 11u + 5u);
+        float    light = (hash & 7u) == 0 && dx * dx + dy * dy < 10.f ?
+                             float(hash >> 8 & 1023u) : 0.0f;
+        float texel[4] = {0.25f * px / float(width) + light,
+                          0.25f * py / float(height) + 0.5f * light,
+                          0.0625f + 0.25f * light, 1.0f};
+        for (float f : texel) *pOut++ = halfFromFloat(f);
+      }
+    }
+  }
+}
+
+// Compare all levels, including the resolved level 0, with the
+// resolve-then-mip CPU reference: each texel of level 0 is the average
+// of its samples (in order, as msaaResolve) rounded to half.
+static double testMsaaResolve(const void* pLevels, uint32_t width, uint32_t height)
+{
+  const uint16_t* pSamples = reinterpret_cast<const uint16_t*>(
+      static_cast<const uint8_t*>(pLevels) + msaaSamplesOffset(width, height));
+  MipmapStorage<float, 4> expected(width, height);
+  for (size_t i = 0; i < size_t(width) * height; ++i)
+  {
+    for (uint32_t c = 0; c < 4; ++c)
+    {
+      float sum = 0.0f;
+      for (uint32_t s = 0; s < msaaSampleCount; ++s)
+      {
+        sum += floatFromHalf(pSamples[4 * (i * msaaSampleCount + s) + c]);
+      }
+      expected.levelData(0)[i][c] =
+          floatFromHalf(halfFromFloat(sum * (1.0f / msaaSampleCount)));
+    }
+  }
+  return compareHdr<true>(pLevels, &expected, 0);
+}
+
+#define MSAA_RESOLVE_SHADERS                                  \
+  "./nvpro_pyramid/msaa_resolve_fast_pipeline.comp", \
+  "./nvpro_pyramid/msaa_resolve_general_pipeline.comp"
+
+// ************************************************************************
+// RGBA16F Gaussian pyramid and its Laplacian bands (laplacian_preamble.glsl),
+// same input as the RGBA16F configs; the bands are the aux pyramid.
+
+// Compare the Gaussian pyramid as testHdr, and the bands with the CPU
+// reference computed from the CPU Gaussian pyramid. The shaders subtract
+// samples still in registers (not rounded to half), so band differences
+// are relative to the larger of the two subtracted samples (absolute
+// below 1); returns the worst difference of both.
+static double testLaplacian(const void* pLevels, uint32_t width, uint32_t height)
+{
+  MipmapStorage<float, 4> gauss(width, height);
+  size_t baseTexels = size_t(width) * height;
+  for (size_t i = 0; i < baseTexels; ++i)
+  {
+    for (uint32_t c = 0; c < 4; ++c)
+    {
+      gauss.levelData(0)[i][c] = hdrChannel<true>(pLevels, 4 * i + c);
+    }
+  }
+  double worst = compareHdr<true>(pLevels, &gauss, baseTexels);
+
+  MipmapStorage<float, 4> bands(width, height);
+  cpuGenerateLaplacianBands(gauss, &bands);
+  const void* pBandLevels = static_cast<const uint8_t*>(pLevels)
+      + formatPyramidStagingAlign(formatPyramidBytes(width, height, 8));
+  size_t texelCount = bands.getByteSize() / sizeof(std::array<float, 4>);
+  for (size_t i = 0; i < texelCount; ++i)
+  {
+    for (uint32_t c = 0; c < 4; ++c)
+    {
+      double fine = gauss.levelData(0)[i][c], e = bands.levelData(0)[i][c];
+      double a     = hdrChannel<true>(pBandLevels, 4 * i + c);
+      double scale = std::max(1.0, std::max(fabs(fine), fabs(fine - e)));
+      worst        = std::max(worst, fabs(a - e) / scale);
+    }
+  }
+  return worst;
+}
+
+// Sizes where the fast pipeline hands off to the fast (4096x2048) or
+// general (1280x704) pipeline, which emits the bands of the last level
+// of the fast dispatch, and small odd sizes (general pipeline only).
+static const VkExtent2D laplacianSizes[] = {
+    {4096, 2048}, {1280, 704}, {37, 23}, {5, 3}};
+
+#define LAPLACIAN_SHADERS                                  \
+  "./nvpro_pyramid/laplacian_fast_pipeline.comp", \
+  "./nvpro_pyramid/laplacian_general_pipeline.comp"
+
+// ************************************************************************
+const FormatPyramidConfig formatPyramidConfigs[] = {
+    {"hiz_min", DEPTH_PYRAMID_SHADERS,
+     "#define DEPTH_PYRAMID_MODE DEPTH_PYRAMID_MIN\n",
+     VK_FORMAT_R32_SFLOAT, 4, VK_FORMAT_UNDEFINED,
+     VK_SAMPLER_REDUCTION_MODE_MIN, false, false, fillDepth<1>, testDepthMin},
+    {"hiz_min_fetch", DEPTH_PYRAMID_SHADERS,
+     "#define DEPTH_PYRAMID_MODE DEPTH_PYRAMID_MIN\n",
+     VK_FORMAT_R32_SFLOAT, 4, VK_FORMAT_UNDEFINED,
+     VK_SAMPLER_REDUCTION_MODE_WEIGHTED_AVERAGE, false, false, fillDepth<1>,
+     testDepthMin},
+    {"hiz_min_d32", DEPTH_PYRAMID_SHADERS,
+     "#define DEPTH_PYRAMID_MODE DEPTH_PYRAMID_MIN\n"
+     "#define DEPTH_PYRAMID_SEPARATE_BASE 1\n",
+     VK_FORMAT_R32_SFLOAT, 4, VK_FORMAT_D32_SFLOAT,
+     VK_SAMPLER_REDUCTION_MODE_MIN, false, false, fillDepth<1>, testDepthMin},
+    {"hiz_max", DEPTH_PYRAMID_SHADERS,
+     "#define DEPTH_PYRAMID_MODE DEPTH_PYRAMID_MAX\n",
+     VK_FORMAT_R32_SFLOAT, 4, VK_FORMAT_UNDEFINED,
+     VK_SAMPLER_REDUCTION_MODE_MAX, false, false, fillDepth<1>, testDepthMax},
+    {"hiz_minmax", DEPTH_PYRAMID_SHADERS,
+     "#define DEPTH_PYRAMID_MODE DEPTH_PYRAMID_MINMAX\n",
+     VK_FORMAT_R32G32_SFLOAT, 8, VK_FORMAT_UNDEFINED,
+     VK_SAMPLER_REDUCTION_MODE_WEIGHTED_AVERAGE, false, false, fillDepth<2>,
+     testDepthMinMax},
+    {"hdr_rgba16f", HDR_SHADERS, "",
+     VK_FORMAT_R16G16B16A16_SFLOAT, 8, VK_FORMAT_UNDEFINED,
+     VK_SAMPLER_REDUCTION_MODE_WEIGHTED_AVERAGE, true, false, fillHdr<true>,
+     testHdr<true>},
+    {"hdr_rgba16f_f16math", HDR_SHADERS, "",
+     VK_FORMAT_R16G16B16A16_SFLOAT, 8, VK_FORMAT_UNDEFINED,
+     VK_SAMPLER_REDUCTION_MODE_WEIGHTED_AVERAGE, true, true, fillHdr<true>,
+     testHdr<true>},
+    {"hdr_rgba32f", HDR_SHADERS, "#define HDR_RGBA32F 1\n",
+     VK_FORMAT_R32G32B32A32_SFLOAT, 16, VK_FORMAT_UNDEFINED,
+     VK_SAMPLER_REDUCTION_MODE_WEIGHTED_AVERAGE, true, false, fillHdr<false>,
+     testHdr<false>},
+    // Half the bytes of hdr_rgba16f, written through R32_UINT views.
+    {"hdr_r11g11b10", PACKED_HDR_SHADERS,
+     "#define PACKED_HDR_FORMAT PACKED_HDR_R11G11B10\n",
+     VK_FORMAT_B10G11R11_UFLOAT_PACK32, 4, VK_FORMAT_UNDEFINED,
+     VK_SAMPLER_REDUCTION_MODE_WEIGHTED_AVERAGE, true, false,
+     fillPackedHdr<PackedHdr::eR11G11B10>,
+     testPackedHdr<PackedHdr::eR11G11B10>, VK_FORMAT_UNDEFINED, 0,
+     VK_FORMAT_R32_UINT},
+    {"hdr_rgb9e5", PACKED_HDR_SHADERS,
+     "#define PACKED_HDR_FORMAT PACKED_HDR_RGB9E5\n",
+     VK_FORMAT_E5B9G9R9_UFLOAT_PACK32, 4, VK_FORMAT_UNDEFINED,
+     VK_SAMPLER_REDUCTION_MODE_WEIGHTED_AVERAGE, true, false,
+     fillPackedHdr<PackedHdr::eRgb9e5>, testPackedHdr<PackedHdr::eRgb9e5>,
+     VK_FORMAT_UNDEFINED, 0, VK_FORMAT_R32_UINT},
+    {"normal_toksvig", NORMAL_MAP_SHADERS, "",
+     VK_FORMAT_R8G8_UNORM, 2, VK_FORMAT_UNDEFINED,
+     VK_SAMPLER_REDUCTION_MODE_WEIGHTED_AVERAGE, false, false, fillNormal,
+     testNormal, VK_FORMAT_R16_SFLOAT, 2},
+    {"unorm_r8", UNORM_SHADERS, "#define UNORM_CHANNELS 1\n",
+     VK_FORMAT_R8_UNORM, 1, VK_FORMAT_UNDEFINED,
+     VK_SAMPLER_REDUCTION_MODE_WEIGHTED_AVERAGE, true, false, fillUnorm<1, 8>,
+     testUnorm<1, 8>},
+    {"unorm_rg8", UNORM_SHADERS, "#define UNORM_CHANNELS 2\n",
+     VK_FORMAT_R8G8_UNORM, 2, VK_FORMAT_UNDEFINED,
+     VK_SAMPLER_REDUCTION_MODE_WEIGHTED_AVERAGE, true, false, fillUnorm<2, 8>,
+     testUnorm<2, 8>},
+    {"unorm_rg8_unpacked", UNORM_SHADERS,
+     "#define UNORM_CHANNELS 2\n#define UNORM_PACKED_SHARED 0\n",
+     VK_FORMAT_R8G8_UNORM, 2, VK_FORMAT_UNDEFINED,
+     VK_SAMPLER_REDUCTION_MODE_WEIGHTED_AVERAGE, true, false, fillUnorm<2, 8>,
+     testUnorm<2, 8>},
+    {"unorm_r16", UNORM_SHADERS,
+     "#define UNORM_CHANNELS 1\n#define UNORM_BITS 16\n",
+     VK_FORMAT_R16_UNORM, 2, VK_FORMAT_UNDEFINED,
+     VK_SAMPLER_REDUCTION_MODE_WEIGHTED_AVERAGE, true, false, fillUnorm<1, 16>,
+     testUnorm<1, 16>},
+    {"unorm_rg16", UNORM_SHADERS,
+     "#define UNORM_CHANNELS 2\n#define UNORM_BITS 16\n",
+     VK_FORMAT_R16G16_UNORM, 4, VK_FORMAT_UNDEFINED,
+     VK_SAMPLER_REDUCTION_MODE_WEIGHTED_AVERAGE, true, false, fillUnorm<2, 16>,
+     testUnorm<2, 16>},
+    // Baselines: the same R8 / RG8 data padded to RGBA8 (vec4 path).
+    {"unorm_r8_padded_rgba8", UNORM_SHADERS, "#define UNORM_CHANNELS 4\n",
+     VK_FORMAT_R8G8B8A8_UNORM, 4, VK_FORMAT_UNDEFINED,
+     VK_SAMPLER_REDUCTION_MODE_WEIGHTED_AVERAGE, true, false,
+     fillUnorm<4, 8, 1>, testUnorm<4, 8>},
+    {"unorm_rg8_padded_rgba8", UNORM_SHADERS, "#define UNORM_CHANNELS 4\n",
+     VK_FORMAT_R8G8B8A8_UNORM, 4, VK_FORMAT_UNDEFINED,
+     VK_SAMPLER_REDUCTION_MODE_WEIGHTED_AVERAGE, true, false,
+     fillUnorm<4, 8, 2>, testUnorm<4, 8>},
+    // mip_bytes is the scratch + result buffer size.
+    {"luminance", LUMINANCE_SHADERS, "",
+     VK_FORMAT_R16G16B16A16_SFLOAT, 8, VK_FORMAT_UNDEFINED,
+     VK_SAMPLER_REDUCTION_MODE_WEIGHTED_AVERAGE, false, false, fillHdr<true>,
+     testLuminance, VK_FORMAT_UNDEFINED, 0, VK_FORMAT_UNDEFINED,
+     {{nvproPyramidLuminanceScratchBytes, 0, false},
+      {luminanceResultBytes, 1, true}},
+     luminanceSizes, 3},
+    // mip_bytes counts all uncompressed levels 1+, though only the ones
+    // loaded by later dispatches or not encoded in registers are written.
+    {"bc1", BC1_SHADERS, "",
+     VK_FORMAT_R8G8B8A8_SRGB, 4, VK_FORMAT_UNDEFINED,
+     VK_SAMPLER_REDUCTION_MODE_WEIGHTED_AVERAGE, true, false, fillSrgba8,
+     testBc1, VK_FORMAT_BC1_RGB_SRGB_BLOCK, 8, VK_FORMAT_R8G8B8A8_UINT,
+     {{bc1CounterBytes, 2, false}}, nullptr, 0, VK_FORMAT_R32G32_UINT, 4,
+     "./nvpro_pyramid/srgba8_bc1_base_level.comp"},
+    {"nv12_rgba", NV12_RGBA_SHADERS, "",
+     VK_FORMAT_R8G8B8A8_UNORM, 4, VK_FORMAT_R8_UNORM,
+     VK_SAMPLER_REDUCTION_MODE_WEIGHTED_AVERAGE, true, false, fillNv12<false>,
+     testNv12<false>, VK_FORMAT_UNDEFINED, 0, VK_FORMAT_UNDEFINED, {},
+     nullptr, 0, VK_FORMAT_UNDEFINED, 1, nullptr, VK_FORMAT_R8G8_UNORM, 2},
+    {"nv12_planes", NV12_PLANES_SHADERS, "",
+     VK_FORMAT_R8_UNORM, 1, VK_FORMAT_R8_UNORM,
+     VK_SAMPLER_REDUCTION_MODE_WEIGHTED_AVERAGE, true, false, fillNv12<true>,
+     testNv12<true>, VK_FORMAT_R8G8_UNORM, 2, VK_FORMAT_UNDEFINED, {},
+     nullptr, 0, VK_FORMAT_UNDEFINED, 1, nullptr, VK_FORMAT_R8G8_UNORM, 2,
+     true},
+    // mip_bytes includes the resolved level 0.
+    {"msaa_resolve", MSAA_RESOLVE_SHADERS, "",
+     VK_FORMAT_R16G16B16A16_SFLOAT, 8, VK_FORMAT_R16G16B16A16_SFLOAT,
+     VK_SAMPLER_REDUCTION_MODE_WEIGHTED_AVERAGE, true, false, fillMsaa,
+     testMsaaResolve, VK_FORMAT_UNDEFINED, 0, VK_FORMAT_UNDEFINED, {},
+     nullptr, 0, VK_FORMAT_UNDEFINED, 1, nullptr, VK_FORMAT_UNDEFINED, 0,
+     false, VK_SAMPLE_COUNT_4_BIT},
+    // mip_bytes counts band levels 1+, though band level 0 is written
+    // and the last band level is not.
+    {"laplacian", LAPLACIAN_SHADERS, "",
+     VK_FORMAT_R16G16B16A16_SFLOAT, 8, VK_FORMAT_UNDEFINED,
+     VK_SAMPLER_REDUCTION_MODE_WEIGHTED_AVERAGE, false, false, fillHdr<true>,
+     testLaplacian, VK_FORMAT_R16G16B16A16_SFLOAT, 8, VK_FORMAT_UNDEFINED, {},
+     laplacianSizes, 4},
+};
+
+const size_t formatPyramidConfigCount =
+    sizeof(formatPyramidConfigs) / sizeof(formatPyramidConfigs[0]);
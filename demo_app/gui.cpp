@@ -303,6 +303,11 @@ void Gui::doVisualizationControls()
     ImGui::Checkbox("Animate [space]", &m_doStep);
   else
     ImGui::Text("Not showing animated image");
+  ImGui::Checkbox("Bloom [g]", &m_cam.doBloom);
+  if (m_cam.doBloom)
+  {
+    ImGui::SliderFloat("Bloom Intensity", &m_cam.bloomIntensity, 0.0f, 1.0f);
+  }
 }
 
 // Open a dialog box and record the image file that the user wants opened.
@@ -332,6 +337,10 @@ void Gui::doFramePerformanceControls(nvvk::ProfilerVK& vkProfiler)
   ImGui::Text("FPS: %.0f", m_displayedFPS);
   ImGui::Text("Max Frame Time: %7.4f ms", m_displayedFrameTime * 1000.);
   showCpuGpuTime(vkProfiler, "frame", "Frame");
+  if (m_cam.doBloom)
+  {
+    showCpuGpuTime(vkProfiler, "bloom", "Bloom");
+  }
   ImGui::Checkbox("vsync [v] (may reduce timing accuracy)", &m_vsync);
 }
 
@@ -564,7 +573,7 @@ void Gui::charCallbackImpl(unsigned chr)
       }
       break;
     case 'g':
-      m_doGaussianBlur = !m_doGaussianBlur;
+      m_cam.doBloom ^= 1;
       break;
     case 'G':
       m_doLogPerformance ^= 1;
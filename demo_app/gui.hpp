@@ -91,7 +91,6 @@ public:
   bool  m_vsync            = false;
   bool  m_doLogPerformance = false;
   bool  m_guiVisible       = true;
-  bool  m_doGaussianBlur   = true;
 
   int m_mipmapsGeneratedPerFrame = 1;
 
@@ -0,0 +1,227 @@
+// Copyright 2021 NVIDIA CORPORATION
+// SPDX-License-Identifier: Apache-2.0
+#include "instrument_report.hpp"
+
+#include <algorithm>
+#include <errno.h>
+#include <iterator>
+#include <map>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "stb_image_write.h"
+
+namespace {
+
+constexpr uint32_t histogramBins = 32;
+
+// Phases between consecutive NvproPyramidInstrumentEvent timestamps.
+constexpr uint32_t phaseCount = nvproPyramidInstrumentEventCount - 1u;
+const char* const  phaseNames[phaseCount] = {"load", "shuffle", "barrier",
+                                             "store"};
+
+uint64_t workgroupTicks(const NvproPyramidInstrumentRecord& record)
+{
+  uint64_t start = record.events[nvproPyramidInstrumentStart];
+  uint64_t end   = record.events[nvproPyramidInstrumentEnd];
+  return end > start ? end - start : 0u;  // Subgroup clocks may disagree.
+}
+
+uint64_t phaseTicks(const NvproPyramidInstrumentRecord& record, uint32_t phase)
+{
+  uint64_t begin = record.eventOrEarlier(phase);
+  uint64_t end   = record.eventOrEarlier(phase + 1u);
+  return end > begin ? end - begin : 0u;
+}
+
+// Statistics of the workgroups of one dispatch, sorted by workgroup.
+struct DispatchStats
+{
+  std::vector<const NvproPyramidInstrumentRecord*> workgroups;
+  uint64_t minTicks = UINT64_MAX, maxTicks = 0, spanTicks = 0;
+  double   meanTicks = 0, meanPhaseTicks[phaseCount] = {};
+  uint64_t binTicks                 = 1;
+  uint32_t histogram[histogramBins] = {};
+
+  void compute()
+  {
+    std::sort(workgroups.begin(), workgroups.end(),
+              [](auto* a, auto* b) { return a->workgroup < b->workgroup; });
+    uint64_t firstStart = UINT64_MAX, lastEnd = 0;
+    for (const NvproPyramidInstrumentRecord* pRecord : workgroups)
+    {
+      uint64_t ticks = workgroupTicks(*pRecord);
+      minTicks = std::min(minTicks, ticks);
+      maxTicks = std::max(maxTicks, ticks);
+      meanTicks += double(ticks);
+      for (uint32_t phase = 0; phase < phaseCount; ++phase)
+      {
+        meanPhaseTicks[phase] += double(phaseTicks(*pRecord, phase));
+      }
+      firstStart = std::min(firstStart, pRecord->events[nvproPyramidInstrumentStart]);
+      lastEnd    = std::max(lastEnd, pRecord->events[nvproPyramidInstrumentEnd]);
+    }
+    meanTicks /= double(workgroups.size());
+    for (double& phaseMean : meanPhaseTicks)
+    {
+      phaseMean /= double(workgroups.size());
+    }
+    spanTicks = lastEnd > firstStart ? lastEnd - firstStart : 0u;
+
+    binTicks = std::max<uint64_t>(
+        1u, (maxTicks - minTicks + histogramBins) / histogramBins);
+    for (const NvproPyramidInstrumentRecord* pRecord : workgroups)
+    {
+      uint64_t bin = (workgroupTicks(*pRecord) - minTicks) / binTicks;
+      ++histogram[std::min<uint64_t>(bin, histogramBins - 1u)];
+    }
+  }
+};
+
+bool writeJson(const std::map<uint32_t, DispatchStats>& dispatches,
+               uint32_t droppedWorkgroups, bool realtimeClock,
+               const char* pFilename)
+{
+  const char* fileAction = "opening";
+  FILE*       file       = fopen(pFilename, "w");
+  if (file == nullptr)
+  {
+    goto onFileError;
+  }
+  fileAction = "writing to";
+  int err;
+  err = fprintf(file, "{\n\"clock\": \"%s\", \"dropped_workgroups\": %u,\n"
+                "\"dispatches\": [\n",
+                realtimeClock ? "realtime" : "subgroup", droppedWorkgroups);
+  if (err < 0) goto onFileError;
+
+  for (auto it = dispatches.begin(); it != dispatches.end(); ++it)
+  {
+    const DispatchStats&                stats  = it->second;
+    const NvproPyramidInstrumentRecord& record = *stats.workgroups[0];
+    err = fprintf(file,
+                  "  {\"input_level\":%u, \"level_count\":%u, "
+                  "\"pipeline\":\"%s\", \"workgroups\":%zu,\n"
+                  "   \"min_ticks\":%llu, \"mean_ticks\":%.1f, "
+                  "\"max_ticks\":%llu, \"span_ticks\":%llu,\n"
+                  "   \"phase_mean_ticks\":{",
+                  record.inputLevel(), record.levelCount(),
+                  record.fastPipeline ? "fast" : "general",
+                  stats.workgroups.size(),
+                  (unsigned long long)stats.minTicks, stats.meanTicks,
+                  (unsigned long long)stats.maxTicks,
+                  (unsigned long long)stats.spanTicks);
+    if (err < 0) goto onFileError;
+    for (uint32_t phase = 0; phase < phaseCount; ++phase)
+    {
+      err = fprintf(file, "\"%s\":%.1f%s", phaseNames[phase],
+                    stats.meanPhaseTicks[phase],
+                    phase + 1u < phaseCount ? ", " : "},\n");
+      if (err < 0) goto onFileError;
+    }
+    err = fprintf(file, "   \"histogram_bin_ticks\":%llu, \"histogram\":[",
+                  (unsigned long long)stats.binTicks);
+    if (err < 0) goto onFileError;
+    for (uint32_t bin = 0; bin < histogramBins; ++bin)
+    {
+      err = fprintf(file, "%u%s", stats.histogram[bin],
+                    bin + 1u < histogramBins ? "," : "]}");
+      if (err < 0) goto onFileError;
+    }
+    err = fprintf(file, "%s\n", std::next(it) != dispatches.end() ? "," : "");
+    if (err < 0) goto onFileError;
+  }
+  err = fprintf(file, "]\n}\n");
+  if (err < 0) goto onFileError;
+
+  fileAction = "closing";
+  err = fclose(file);
+  if (err < 0) goto onFileError;
+  return true;
+
+onFileError:
+  fprintf(stderr, "Error %s '%s': %s (%i)\n", fileAction, pFilename,
+          strerror(errno), errno);
+  return false;
+}
+
+bool writeHeatmap(const std::map<uint32_t, DispatchStats>& dispatches,
+                  const char* pFilename)
+{
+  // Width fitting the largest dispatch in a square-ish block.
+  uint32_t maxWorkgroups = 1;
+  for (const auto& pair : dispatches)
+  {
+    maxWorkgroups =
+        std::max(maxWorkgroups, pair.second.workgroups.back()->workgroup + 1u);
+  }
+  uint32_t width = std::max(64u, uint32_t(ceil(sqrt(double(maxWorkgroups)))));
+
+  // Blocks of rows, separated by a gray row.
+  std::vector<uint8_t> pixels;
+  for (const auto& pair : dispatches)
+  {
+    const DispatchStats& stats = pair.second;
+    uint32_t workgroups = stats.workgroups.back()->workgroup + 1u;
+    uint32_t rows       = (workgroups + width - 1u) / width;
+    size_t   blockBegin = pixels.size();
+    pixels.resize(blockBegin + size_t(rows) * width * 3u, 0);
+    for (size_t i = blockBegin + 2u; i < pixels.size(); i += 3u)
+    {
+      pixels[i] = 128;  // Missing workgroups
+    }
+
+    double range = double(std::max<uint64_t>(1u, stats.maxTicks - stats.minTicks));
+    for (const NvproPyramidInstrumentRecord* pRecord : stats.workgroups)
+    {
+      // "Hot" color map: black, red, yellow, white.
+      double   t = double(workgroupTicks(*pRecord) - stats.minTicks) / range;
+      uint8_t* pPixel = &pixels[blockBegin + size_t(pRecord->workgroup) * 3u];
+      for (int c = 0; c < 3; ++c)
+      {
+        pPixel[c] = uint8_t(std::min(std::max(t * 3.0 - c, 0.0), 1.0) * 255.0);
+      }
+    }
+    pixels.resize(pixels.size() + width * 3u, 64);
+  }
+
+  if (!stbi_write_png(pFilename, int(width), int(pixels.size() / (width * 3u)),
+                      3, pixels.data(), int(width * 3u)))
+  {
+    fprintf(stderr, "Error writing to '%s'\n", pFilename);
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool writeInstrumentReport(
+    const std::vector<NvproPyramidInstrumentRecord>& records,
+    uint32_t                                         droppedWorkgroups,
+    bool                                             realtimeClock,
+    const char*                                      pJsonFilename,
+    const char*                                      pPngFilename)
+{
+  // The push constant identifies the dispatch (input level first).
+  std::map<uint32_t, DispatchStats> dispatches;
+  for (const NvproPyramidInstrumentRecord& record : records)
+  {
+    dispatches[record.pushConstant].workgroups.push_back(&record);
+  }
+  for (auto& pair : dispatches)
+  {
+    pair.second.compute();
+  }
+
+  if (droppedWorkgroups != 0)
+  {
+    fprintf(stderr, "Instrument buffer full, %u workgroups not recorded\n",
+            droppedWorkgroups);
+  }
+  bool jsonOk = writeJson(dispatches, droppedWorkgroups, realtimeClock,
+                          pJsonFilename);
+  bool pngOk  = dispatches.empty() || writeHeatmap(dispatches, pPngFilename);
+  return jsonOk && pngOk;
+}
@@ -0,0 +1,33 @@
+// Copyright 2021 NVIDIA CORPORATION
+// SPDX-License-Identifier: Apache-2.0
+#ifndef VK_COMPUTE_MIPMAPS_DEMO_INSTRUMENT_REPORT_HPP_
+#define VK_COMPUTE_MIPMAPS_DEMO_INSTRUMENT_REPORT_HPP_
+
+#include <vector>
+
+#include "nvpro_pyramid_instrument.hpp"
+
+// Write a report of the workgroup timestamps recorded by the
+// NVPRO_PYRAMID_INSTRUMENT pipelines for one mipmap generation.
+//
+// pJsonFilename: for each dispatch (in input level order), the
+// workgroup count, the min/mean/max workgroup duration, the time from
+// the first workgroup start to the last workgroup end, the mean time
+// spent in each phase (load, shuffle, shared barrier, store; between
+// the NvproPyramidInstrumentEvent timestamps), and a 32-bin histogram
+// of workgroup durations. All times are in clock ticks.
+//
+// pPngFilename: heatmap of workgroup durations; one block of rows per
+// dispatch, with one pixel per workgroup in gl_WorkGroupID order (row
+// major), colored from black (fastest in the dispatch) to white
+// (slowest). Missing workgroups are blue.
+//
+// Returns false (after printing the error) on file errors.
+bool writeInstrumentReport(
+    const std::vector<NvproPyramidInstrumentRecord>& records,
+    uint32_t                                         droppedWorkgroups,
+    bool                                             realtimeClock,
+    const char*                                      pJsonFilename,
+    const char*                                      pPngFilename);
+
+#endif
@@ -24,21 +24,33 @@ Julia::Julia(VkDevice         device,
   // Set up color texture.
   m_scopedImage.reallocImage(textureWidth, textureHeight);
 
-  // Set up compute pipeline.
-  uint32_t              pcSize = uint32_t(sizeof(JuliaPushConstant));
-  VkPushConstantRange   range  = {VK_SHADER_STAGE_COMPUTE_BIT, 0, pcSize};
-  VkDescriptorSetLayout descriptorLayout =
-      m_scopedImage.getStorageDescriptorSetLayout();
-  makeComputePipeline(m_device, "julia.comp.spv", dumpPipelineStats,
-                      1, &descriptorLayout, 1, &range,
-                      &m_pipeline, &m_pipelineLayout);
+  // Set up the pyramid pipelines (julia_pyramid_preamble.glsl): the
+  // nvpro_pyramid push constant, followed by JuliaPushConstant.
+  uint32_t pcSize = uint32_t(sizeof(uint32_t) + sizeof(JuliaPushConstant));
+  VkPushConstantRange   range = {VK_SHADER_STAGE_COMPUTE_BIT, 0, pcSize};
+  VkDescriptorSetLayout descriptorLayouts[] = {
+      m_scopedImage.getTextureDescriptorSetLayout(),
+      m_scopedImage.getStorageDescriptorSetLayout()};
+  VkPipelineLayoutCreateInfo layoutInfo = {
+      VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO, nullptr, 0,
+      2, descriptorLayouts, 1, &range};
+  NVVK_CHECK(vkCreatePipelineLayout(m_device, &layoutInfo, nullptr,
+                                    &m_pipelines.layout));
+  const char* filenames[] = {"julia_general_pipeline.comp.spv",
+                             "julia_fast_pipeline.comp.spv"};
+  VkPipeline* pipelines[] = {&m_pipelines.generalPipeline,
+                             &m_pipelines.fastPipeline};
+  makeComputePipelines(m_device, 2, filenames, dumpPipelineStats,
+                       m_pipelines.layout, pipelines);
+  m_pipelines.pushConstantOffset = 0;
 }
 
 Julia::~Julia()
 {
   // Destroy pipelines.
-  vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
-  vkDestroyPipeline(m_device, m_pipeline, nullptr);
+  vkDestroyPipelineLayout(m_device, m_pipelines.layout, nullptr);
+  vkDestroyPipeline(m_device, m_pipelines.generalPipeline, nullptr);
+  vkDestroyPipeline(m_device, m_pipelines.fastPipeline, nullptr);
 }
 
 void Julia::resize(uint32_t x, uint32_t y)
@@ -88,17 +100,21 @@ void Julia::cmdFillColorTexture(VkCommandBuffer cmdBuf)
                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
                        0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
 
-  // Bind pipeline, push constant, and descriptors.
-  vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
-  VkDescriptorSet descriptorSet = m_scopedImage.getStorageDescriptorSet();
-  vkCmdPushConstants(cmdBuf, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT,
-                     0, sizeof(m_pushConstant), &m_pushConstant);
+  // Bind push constant (after the one set by nvproCmdPyramidDispatch)
+  // and descriptors.
+  VkDescriptorSet descriptorSets[] = {
+      m_scopedImage.getTextureDescriptorSet(),
+      m_scopedImage.getStorageDescriptorSet()};
+  vkCmdPushConstants(cmdBuf, m_pipelines.layout, VK_SHADER_STAGE_COMPUTE_BIT,
+                     sizeof(uint32_t), sizeof(m_pushConstant),
+                     &m_pushConstant);
   vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE,
-                          m_pipelineLayout, 0, 1, &descriptorSet,
+                          m_pipelines.layout, 0, 2, descriptorSets,
                           0, nullptr);
-  // Fill the image.
-  vkCmdDispatch(cmdBuf, (m_scopedImage.getImageWidth() + 15) / 16,
-                (m_scopedImage.getImageHeight() + 15) / 16, 1);
+  // Fill the image and its mip levels.
+  nvproCmdPyramidDispatch(cmdBuf, m_pipelines, m_scopedImage.getImageWidth(),
+                          m_scopedImage.getImageHeight(),
+                          m_scopedImage.getLevelCount());
 
   // Pipeline barrier.
   VkMemoryBarrier barrier = {
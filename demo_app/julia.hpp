@@ -7,6 +7,7 @@
 
 #include <array>
 #include "nvvk/resourceallocator_vk.hpp"
+#include "nvpro_pyramid_dispatch.hpp"
 #include "scoped_image.hpp"
 
 #include "shaders/julia.h"
@@ -23,9 +24,9 @@ class Julia
   // Color texture stored inside.
   ScopedImage      m_scopedImage;
 
-  // Compute Pipeline.
-  VkPipelineLayout m_pipelineLayout;
-  VkPipeline       m_pipeline;
+  // nvpro_pyramid pipelines generating the color texture and its mip
+  // levels (julia_*_pipeline.comp).
+  NvproPyramidPipelines m_pipelines;
 
   // Push Constant (host copy)
   JuliaPushConstant m_pushConstant;
@@ -56,11 +57,12 @@ public:
   // maxIterations: optional, maximum iterations to be performed per sample by shader
   void update(double dt, int maxIterations = 0);
 
-  // Record a command that fills the color texture image with data
-  // from the simulation state. Inserts barriers to synchronize read
-  // access on the same queue to the color texture image. Only writes
-  // to the base mip level, but all levels are transitioned to general
-  // layout.
+  // Record commands that fill the color texture image with data
+  // from the simulation state, and generate all its mip levels in the
+  // same dispatches (the base level is computed in registers, never
+  // loaded). Inserts barriers to synchronize read access on the same
+  // queue to the color texture image. All levels are transitioned to
+  // general layout.
   void cmdFillColorTexture(VkCommandBuffer cmdBuf);
 
   // Get the ScopedImage holding the color texture data.
@@ -0,0 +1,41 @@
+#####################################################################################
+# Script run (cmake -P) by the lavapipe_subgroup_size_* tests, see
+# CMakeLists.txt: run the DEMO benchmark with -test and -subgroup-size
+# SUBGROUP_SIZE, writing the json to OUTPUT, and fail if the demo fails
+# or if any "delta" in the json (sRGBA8 pipeline alternatives and
+# format pyramids alike) is above THRESHOLD.
+#
+foreach(VAR DEMO SUBGROUP_SIZE OUTPUT THRESHOLD)
+  if(NOT DEFINED ${VAR})
+    message(FATAL_ERROR "lavapipe_test.cmake: ${VAR} not defined")
+  endif()
+endforeach()
+
+file(REMOVE ${OUTPUT})
+execute_process(
+    COMMAND ${DEMO} -benchmark ${OUTPUT} -test -subgroup-size ${SUBGROUP_SIZE}
+    RESULT_VARIABLE RESULT)
+if(NOT RESULT EQUAL 0)
+  message(FATAL_ERROR "${DEMO} failed (${RESULT}) with subgroup size ${SUBGROUP_SIZE}")
+endif()
+
+# One benchmark row per line, e.g.
+#   "default":  {"median_ns": 123, ..., "delta":0},
+file(STRINGS ${OUTPUT} ROWS REGEX "\"delta\":")
+if(NOT ROWS)
+  message(FATAL_ERROR "No test results in ${OUTPUT}")
+endif()
+set(FAILED_COUNT 0)
+foreach(ROW IN LISTS ROWS)
+  string(REGEX REPLACE ".*\"delta\":([-+0-9.eE]+).*" "\\1" DELTA "${ROW}")
+  if(DELTA GREATER THRESHOLD)
+    message(STATUS "delta ${DELTA} above ${THRESHOLD}: ${ROW}")
+    math(EXPR FAILED_COUNT "${FAILED_COUNT} + 1")
+  endif()
+endforeach()
+list(LENGTH ROWS ROW_COUNT)
+if(FAILED_COUNT GREATER 0)
+  message(FATAL_ERROR "${FAILED_COUNT} of ${ROW_COUNT} results above ${THRESHOLD} "
+                      "with subgroup size ${SUBGROUP_SIZE}")
+endif()
+message(STATUS "${ROW_COUNT} results at most ${THRESHOLD} with subgroup size ${SUBGROUP_SIZE}")
@@ -15,7 +15,9 @@
 #include "nvvk/error_vk.hpp"
 
 #include "app_args.hpp"
+#include "make_compute_pipeline.hpp"
 #include "mipmaps_app.hpp"
+#include "pipeline_alternative.hpp"
 
 int main(int argc, char** argv)
 {
@@ -56,16 +58,14 @@ int main(int argc, char** argv)
     deviceInfo.addDeviceExtension(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
   }
 
-  // Pipeline stats flag requires extension.
+  // Pipeline stats flag requires extension; otherwise optional, for
+  // the statistics in the benchmark json.
   VkPhysicalDevicePipelineExecutablePropertiesFeaturesKHR pipelinePropertyFeatures =
       {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PIPELINE_EXECUTABLE_PROPERTIES_FEATURES_KHR};
-  if (args.dumpPipelineStats)
-  {
-    deviceInfo.addDeviceExtension(
-        VK_KHR_PIPELINE_EXECUTABLE_PROPERTIES_EXTENSION_NAME,
-        false,
-        &pipelinePropertyFeatures);
-  }
+  deviceInfo.addDeviceExtension(
+      VK_KHR_PIPELINE_EXECUTABLE_PROPERTIES_EXTENSION_NAME,
+      !args.dumpPipelineStats,
+      &pipelinePropertyFeatures);
 
   // Also need half floats.
   VkPhysicalDeviceShaderFloat16Int8Features shaderFloat16Features = {
@@ -76,6 +76,29 @@ int main(int argc, char** argv)
       false,
       &shaderFloat16Features);
 
+  // Optional, for min/max sampler reduction in depth pyramid benchmarks.
+  deviceInfo.addDeviceExtension(VK_EXT_SAMPLER_FILTER_MINMAX_EXTENSION_NAME, true);
+
+  // Optional, for choosing the compute shader subgroup size.
+  VkPhysicalDeviceSubgroupSizeControlFeaturesEXT subgroupSizeControlFeatures = {
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_SIZE_CONTROL_FEATURES_EXT};
+  deviceInfo.addDeviceExtension(
+      VK_EXT_SUBGROUP_SIZE_CONTROL_EXTENSION_NAME,
+      true,
+      &subgroupSizeControlFeatures);
+
+  // Optional, for reporting pipeline cache hits.
+  deviceInfo.addDeviceExtension(
+      VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME, true);
+
+  // Optional, for the -instrument workgroup timestamps.
+  VkPhysicalDeviceShaderClockFeaturesKHR shaderClockFeatures = {
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_CLOCK_FEATURES_KHR};
+  deviceInfo.addDeviceExtension(
+      VK_KHR_SHADER_CLOCK_EXTENSION_NAME,
+      true,
+      &shaderClockFeatures);
+
   ctx.init(deviceInfo);
   ctx.ignoreDebugMessage(1303270965); // Bogus "general layout" perf warning.
 
@@ -86,17 +109,32 @@ int main(int argc, char** argv)
       VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2, &subgroupProperties};
   vkGetPhysicalDeviceProperties2(ctx.m_physicalDevice, &physicalDeviceProperties);
 
-  if (subgroupProperties.subgroupSize < 16)
+  // Fix the subgroup size of compute pipelines, if possible.
+  uint32_t subgroupSize = chooseComputeSubgroupSize(
+      ctx.m_physicalDevice,
+      ctx.hasDeviceExtension(VK_EXT_SUBGROUP_SIZE_CONTROL_EXTENSION_NAME)
+          && subgroupSizeControlFeatures.subgroupSizeControl,
+      args.subgroupSize);
+
+  if (subgroupSize == 0)
+  {
+    fprintf(stderr, "Cannot require compute subgroup size %u.\n",
+            args.subgroupSize);
+    return 1;
+  }
+  else if (subgroupSize < 4)
   {
-    fprintf(stderr, "Expected subgroup size at least 16.\n");
+    fprintf(stderr, "Expected subgroup size at least 4.\n");
     return 1;
   }
-  else if (subgroupProperties.subgroupSize != 32)
+  else if (subgroupSize != 32)
   {
+    int disabledCount = disableExtrasFastPipelines(subgroupSize);
     fprintf(stderr, "\x1b[35m\x1b[1mWARNING:\x1b[0m "
-                    "Only tested with subgroup size 32, not %u.\nI /expect/ "
-                    "it to work anyway, notify dakeley@nvidia.com if not.\n",
-                    subgroupProperties.subgroupSize);
+                    "Mostly tested with subgroup size 32, not %u.\n"
+                    "%d pipeline alternatives use their general pipeline "
+                    "instead of an extras/ fast pipeline.\n",
+                    subgroupSize, disabledCount);
   }
   #define NEED_BIT(var, bit) \
   if (!(var & bit)) \
@@ -107,6 +145,24 @@ int main(int argc, char** argv)
   NEED_BIT(subgroupProperties.supportedStages, VK_SHADER_STAGE_COMPUTE_BIT);
   NEED_BIT(subgroupProperties.supportedOperations, VK_SUBGROUP_FEATURE_SHUFFLE_BIT);
   #undef NEED_BIT
+  if (!(subgroupProperties.supportedOperations & VK_SUBGROUP_FEATURE_CLUSTERED_BIT))
+  {
+    int disabledCount = disableClusteredFastPipelines();
+    fprintf(stderr, "\x1b[35m\x1b[1mWARNING:\x1b[0m "
+                    "Missing VK_SUBGROUP_FEATURE_CLUSTERED_BIT.\n"
+                    "%d pipeline alternatives use their general pipeline "
+                    "instead of the clustered fast pipeline.\n",
+                    disabledCount);
+  }
+
+  // Reuse the compute pipelines compiled by earlier runs.
+  computePipelineFeedbackEnabled() =
+      ctx.hasDeviceExtension(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME);
+  if (!args.pipelineCacheFilename.empty())
+  {
+    loadComputePipelineCache(ctx, ctx.m_physicalDevice,
+                             args.pipelineCacheFilename);
+  }
 
   // Query needed feature for pipeline stats.
   if (args.dumpPipelineStats && !pipelinePropertyFeatures.pipelineExecutableInfo)
@@ -116,6 +172,15 @@ int main(int argc, char** argv)
             "needed for -stats flag\n");
     return 1;
   }
+  if (pipelinePropertyFeatures.pipelineExecutableInfo)
+  {
+    // Internal representations can be large; only with -stats.
+    computePipelineCaptureFlags() =
+        VK_PIPELINE_CREATE_CAPTURE_STATISTICS_BIT_KHR
+        | (args.dumpPipelineStats ?
+               VK_PIPELINE_CREATE_CAPTURE_INTERNAL_REPRESENTATIONS_BIT_KHR :
+               0);
+  }
 
   // Query half float feature.
   if (!shaderFloat16Features.shaderFloat16)
@@ -138,6 +203,11 @@ int main(int argc, char** argv)
 
   // Start the main loop.
   mipmapsApp(ctx, pWindow, surface, args);
+  if (!args.pipelineCacheFilename.empty())
+  {
+    saveComputePipelineCache(ctx, ctx.m_physicalDevice,
+                             args.pipelineCacheFilename);
+  }
 
   // At this point, FrameManager's destructor in mainLoop ensures all
   // pending commands are complete. So, we can clean up the surface,
@@ -2,34 +2,128 @@
 // SPDX-License-Identifier: Apache-2.0
 #include "mipmap_pipelines.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <map>
+#include <mutex>
+#include <set>
+#include <stdio.h>
+#include <string.h>
 #include <thread>
+#include <tuple>
+#include <vector>
 
 #include "nvh/container_utils.hpp"
+#include "nvh/fileoperations.hpp"
 #include "nvvk/shadermodulemanager_vk.hpp"
 
 #include "make_compute_pipeline.hpp"
+#include "nvpro_pyramid_coverage.hpp"
 #include "nvpro_pyramid_dispatch.hpp"
 #include "nvpro_pyramid_dispatch_alternative.hpp"
+#include "nvpro_pyramid_instrument.hpp"
 #include "scoped_image.hpp"
+#include "shader_include_cache.hpp"
 
 class ComputeMipmapPipelinesImpl : public ComputeMipmapPipelines
 {
   // Borrowed
   VkDevice m_device{};
 
+  bool m_dumpPipelineStats = false;
+
   // Managed by us.
   VkPipelineLayout          m_layout{};
 
+  // Small zero-initialized storage buffer (set=2, binding=0) for pipeline
+  // alternatives that need global scratch memory, e.g. the work counters
+  // of the persistent-threads general pipeline. Followed by the alpha
+  // coverage histograms (set=2, binding=1). The workgroup timestamps of
+  // the instrumented pipelines (set=2, binding=2) are in their own
+  // buffers and sets (m_instrumentBuffers); binding 2 of this set is
+  // never written.
+  static constexpr VkDeviceSize    s_scratchBufferSize = 256;
+  static constexpr VkDeviceSize    s_histogramOffset   = s_scratchBufferSize;
+  static constexpr VkDeviceSize    s_bufferSize =
+      s_histogramOffset + nvproPyramidCoverageHistogramBytes;
+  nvvk::ResourceAllocatorDedicated m_allocator;
+  nvvk::Buffer                     m_scratchBuffer{};
+  nvvk::DescriptorSetContainer     m_scratchDescriptorContainer;
+
+  // VK_KHR_shader_clock support, for instrumentBit pipelines.
+  bool m_subgroupClockSupported = false;
+  bool m_realtimeClockSupported = false;
+
+  // Timestamp buffer of the instrumented pipelines, and a copy of the
+  // scratch descriptor set with binding 2 pointing to it, as updating
+  // the shared set would invalidate the pending commands using it. When
+  // an image needs a larger buffer, a new one is added; the old ones may
+  // also still be in use, so all are destroyed along with this object.
+  // The last one is current.
+  struct InstrumentBuffer
+  {
+    nvvk::Buffer     buffer{};
+    VkDeviceSize     bytes = 0;
+    VkDescriptorPool pool{};
+    VkDescriptorSet  set{};
+  };
+  std::vector<InstrumentBuffer> m_instrumentBuffers;
+
+  // Alpha coverage histogram and scale pipelines (alphaCoverageBit).
+  NvproPyramidCoveragePipelines m_coveragePipelines{};
+
+  // Buffer mode pipelines, with their own layout (staging buffer at
+  // set=0; push constants: nvpro_pyramid's, then base width/height).
+  NvproPyramidPipelines m_bufferPipelines{};
+
+  // Pipeline alternative directory name + config bits (shader macros)
+  // + specialization constants (py2 only).
+  using PipelineKey = std::tuple<std::string, uint32_t, Py2Config>;
+
   // General-case (NP2) shaders, testing multiple candidates.
-  // Map pipeline alternative name + config bits to pipeline object.
-  std::map<std::pair<std::string, uint32_t>, VkPipeline> m_generalPipelineMap;
+  // Map pipeline key to pipeline object.
+  std::map<PipelineKey, VkPipeline> m_generalPipelineMap;
 
   // Special case 2x2 reduction shaders, testing many candidates; same mapping.
-  std::map<std::pair<std::string, uint32_t>, VkPipeline> m_fastPipelineMap;
+  std::map<PipelineKey, VkPipeline> m_fastPipelineMap;
 
   using PipelineMapPair = decltype(m_fastPipelineMap)::value_type;
 
+  // Pipelines are created on first use (getPipeline), or earlier by the
+  // optional pre-warm thread on computeCompileThreadPool(). The mutex
+  // guards the pipeline maps and the set of entries whose pipeline is
+  // being created (outside the lock); the value of such an entry may
+  // only be accessed by the thread creating it.
+  std::mutex                       m_pipelineMutex;
+  std::condition_variable          m_pipelineCreated;
+  std::set<const PipelineMapPair*> m_pipelinesInProgress;
+  std::mutex                       m_coverageMutex;
+  std::thread                      m_prewarmThread;
+  std::atomic<bool>                m_stopPrewarm{false};
+
+  // Pipelines of one group (see groupEntries) for the pre-warm thread,
+  // and those of them that it created.
+  struct PrewarmJob
+  {
+    bool                          isFastPipeline;
+    std::vector<PipelineMapPair*> group, created;
+  };
+
+  // Config bits that select post-passes instead of shader macros;
+  // masked out of pipeline map keys so they do not cause recompiles.
+  static uint32_t pipelineConfigBits(uint32_t configBits)
+  {
+    return configBits & ~PipelineAlternativeDescriptionConfig::alphaCoverageBit;
+  }
+
+  static PipelineKey pipelineKey(const PipelineAlternativeDescription& description)
+  {
+    return {description.basePipelineName.empty() ? description.name :
+                                                   description.basePipelineName,
+            pipelineConfigBits(description.configBits), description.py2Config};
+  }
+
   // Initialize a key-value pair in the fast/general pipeline map, but
   // do not actually add the pipeline yet.
   template <bool IsFastPipeline>
@@ -51,38 +145,64 @@ class ComputeMipmapPipelinesImpl : public ComputeMipmapPipelines
     }
 
     auto& pipelineMap = IsFastPipeline ? m_fastPipelineMap : m_generalPipelineMap;
-    pipelineMap[{dirname, description.configBits}] = VK_NULL_HANDLE;
+    pipelineMap[pipelineKey(description)] = VK_NULL_HANDLE;
   }
 
-  // Compile the pipeline value in a pipeline key-value pair.
+  // Name of the spv file compiled at build time for the given
+  // pipeline key, without specialization constants. Fast pipelines
+  // are also keyed by the required subgroup size, if any, as
+  // pipelinePrepend defines NVPRO_PYRAMID_MIN_SUBGROUP_SIZE for them.
+  // Change demo_app/CMakeLists.txt if changed.
   template <bool IsFastPipeline>
-  void compilePipelineEntry(PipelineMapPair* pPair, bool dumpPipelineStats)
+  static std::string prebuiltSpvFilename(const std::string& dirname,
+                                         uint32_t           configBits)
   {
-    const auto& dirname    = pPair->first.first;
-    const auto& configBits = pPair->first.second;
-    VkPipeline* pPipeline  = &pPair->second;
-
-    // Set up shader module compiler and include path.
-    nvvk::ShaderModuleManager shaderModuleManager(m_device);
-    if (dirname != "default")
+    std::string filename =
+        std::string(IsFastPipeline ? "srgba8_fast_" : "srgba8_general_")
+        + dirname + "_" + std::to_string(configBits);
+    uint32_t subgroupSize = computeRequiredSubgroupSize();
+    if (IsFastPipeline && subgroupSize != 0)
     {
-      // Add directories with the wanted pipeline alternative glsl file.
-      const auto& alternativeDirectories =
-          IsFastPipeline ? getFastPipelineAlternativeDirectories(dirname) :
-                           getGeneralPipelineAlternativeDirectories(dirname);
-      for (const auto& directory : alternativeDirectories)
-      {
-        shaderModuleManager.addDirectory(directory);
-      }
+      filename += "_sg" + std::to_string(subgroupSize);
     }
+    return filename + ".comp.spv";
+  }
 
-    // Add other directories.
-    for (const auto& directory : searchPaths)
+  // Load the shader module compiled at build time for the given
+  // directory name and config bits, or return VK_NULL_HANDLE if it was
+  // not built (e.g. PIPELINE_ALTERNATIVES changed, or a fast pipeline
+  // for a required subgroup size other than 32) or depends on device
+  // features: instrumentBit (clock type).
+  template <bool IsFastPipeline>
+  VkShaderModule loadPrebuiltShaderModule(const std::string& dirname,
+                                          uint32_t           configBits)
+  {
+    if (configBits & PipelineAlternativeDescriptionConfig::instrumentBit)
     {
-      shaderModuleManager.addDirectory(directory);
-
+      return VK_NULL_HANDLE;
     }
 
+    std::string shaderCode = nvh::loadFile(
+        prebuiltSpvFilename<IsFastPipeline>(dirname, configBits), true,
+        searchPaths, false);
+    if (shaderCode.empty()) return VK_NULL_HANDLE;
+
+    VkShaderModuleCreateInfo moduleCreateInfo{
+        VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO, nullptr, 0,
+        shaderCode.size(), (const uint32_t*)shaderCode.data()};
+    VkShaderModule module;
+    NVVK_CHECK(vkCreateShaderModule(m_device, &moduleCreateInfo, nullptr,
+                                    &module));
+    return module;
+  }
+
+  // Macros prepended to srgba8_mipmap_{fast,general}_pipeline.comp
+  // for the given directory name and config bits. Change
+  // demo_app/CMakeLists.txt if changed.
+  template <bool IsFastPipeline>
+  std::string pipelinePrepend(const std::string& dirname,
+                              uint32_t           configBits) const
+  {
     // Add undocumented macro to include alternative implementation if not
     // using the default one.
     std::string prepend = "";
@@ -108,32 +228,324 @@ class ComputeMipmapPipelinesImpl : public ComputeMipmapPipelines
     {
       prepend += "#define USE_BILINEAR_SAMPLING 0\n";
     }
+    if (configBits & lanczosBit)
+    {
+      prepend += "#define WIDE_KERNEL WIDE_KERNEL_LANCZOS\n";
+    }
+    if (configBits & kaiserBit)
+    {
+      prepend += "#define WIDE_KERNEL WIDE_KERNEL_KAISER\n";
+    }
+    if (configBits & bilinearNp2Bit)
+    {
+      prepend += "#define BILINEAR_NP2 1\n";
+    }
+    if (configBits & instrumentBit)
+    {
+      prepend += m_realtimeClockSupported ?
+          "#extension GL_EXT_shader_realtime_clock : enable\n"
+          "#define INSTRUMENT_REALTIME 1\n" :
+          "#extension GL_ARB_shader_clock : enable\n";
+      prepend += "#define INSTRUMENT 1\n";
+    }
+
+    // Only created if clustered operations are supported (main.cpp).
+    if (IsFastPipeline && dirname == "clustered")
+    {
+      prepend += "#extension GL_KHR_shader_subgroup_clustered : enable\n";
+    }
+    // Only used by the fast pipeline, so general pipelines need no
+    // spv per subgroup size.
+    if (IsFastPipeline)
+    {
+      prepend += computeSubgroupSizePrepend();
+    }
+    return prepend;
+  }
+
+  static std::string pipelineHumanName(bool               isFastPipeline,
+                                       const PipelineKey& key)
+  {
+    PipelineAlternativeDescription description{
+        std::get<0>(key), "", std::get<1>(key), std::get<2>(key)};
+    return (isFastPipeline ? "srgba8 fastPipeline " : "srgba8 generalPipeline ")
+           + description.toString();
+  }
+
+  // Create the pipeline values of the given pipeline key-value pairs,
+  // which must share the same directory name and config bits, i.e. the
+  // same shader module; they differ only in specialization constants.
+  // Uses the spv built for them if any, else compiles the glsl now.
+  template <bool IsFastPipeline>
+  void compilePipelineEntries(const std::vector<PipelineMapPair*>& pairs,
+                              bool dumpPipelineStats,
+                              bool deferStatsPrint = false)
+  {
+    const auto& dirname    = std::get<0>(pairs[0]->first);
+    const auto& configBits = std::get<1>(pairs[0]->first);
+
+    nvvk::ShaderModuleManager shaderModuleManager(m_device);
+    VkShaderModule            prebuiltModule =
+        loadPrebuiltShaderModule<IsFastPipeline>(dirname, configBits);
+    VkShaderModule module = prebuiltModule;
+    if (module == VK_NULL_HANDLE)
+    {
+      // Set up shader module compiler and include path.
+      if (dirname != "default")
+      {
+        // Add directories with the wanted pipeline alternative glsl file.
+        const auto& alternativeDirectories =
+            IsFastPipeline ? getFastPipelineAlternativeDirectories(dirname) :
+                             getGeneralPipelineAlternativeDirectories(dirname);
+        for (const auto& directory : alternativeDirectories)
+        {
+          shaderModuleManager.addDirectory(directory);
+        }
+      }
+
+      // Add other directories.
+      for (const auto& directory : searchPaths)
+      {
+        shaderModuleManager.addDirectory(directory);
+      }
+      shaderIncludeCache().registerIncludes(
+          shaderModuleManager,
+          {"srgba8_mipmap_preamble.glsl", "nvpro_pyramid.glsl"});
+
+      auto id = shaderModuleManager.createShaderModule(
+          VK_SHADER_STAGE_COMPUTE_BIT,
+          IsFastPipeline ? "./nvpro_pyramid/srgba8_mipmap_fast_pipeline.comp" :
+                           "./nvpro_pyramid/srgba8_mipmap_general_pipeline.comp",
+          pipelinePrepend<IsFastPipeline>(dirname, configBits),
+          nvvk::ShaderModuleManager::FILETYPE_GLSL);
+      module = shaderModuleManager.get(id);
+      assert(module);
+    }
 
-    auto id = shaderModuleManager.createShaderModule(
-        VK_SHADER_STAGE_COMPUTE_BIT,
-        IsFastPipeline ? "./nvpro_pyramid/srgba8_mipmap_fast_pipeline.comp" :
-                         "./nvpro_pyramid/srgba8_mipmap_general_pipeline.comp",
-        prepend, nvvk::ShaderModuleManager::FILETYPE_GLSL);
-    VkShaderModule module = shaderModuleManager.get(id);
-    assert(module);
-
-    PipelineAlternativeDescription description{dirname, "", configBits};
-    std::string humanName =
-        (IsFastPipeline ? "srgba8 fastPipeline " : "srgba8 generalPipeline ")
-        + description.toString();
-    makeComputePipeline(m_device, module, dumpPipelineStats, m_layout,
-                        pPipeline, humanName.c_str());
+    for (PipelineMapPair* pPair : pairs)
+    {
+      const Py2Config& py2Config = std::get<2>(pPair->first);
+      std::string      humanName = pipelineHumanName(IsFastPipeline, pPair->first);
+
+      // py2 workgroup size (constant_id 0, in threads) and tile size.
+      uint32_t specData[] = {py2Config.warps * 32u, py2Config.tileWidth,
+                             py2Config.tileHeight};
+      VkSpecializationMapEntry specEntries[] = {
+          {0, 0, sizeof(uint32_t)},
+          {1, sizeof(uint32_t), sizeof(uint32_t)},
+          {2, 2 * sizeof(uint32_t), sizeof(uint32_t)}};
+      VkSpecializationInfo specInfo = {arraySize(specEntries), specEntries,
+                                       sizeof specData, specData};
+      makeComputePipeline(m_device, module, dumpPipelineStats, m_layout,
+                          &pPair->second, humanName.c_str(),
+                          py2Config.warps != 0 ? &specInfo : nullptr,
+                          deferStatsPrint);
+    }
+
+    if (prebuiltModule != VK_NULL_HANDLE)
+    {
+      vkDestroyShaderModule(m_device, prebuiltModule, nullptr);
+    }
+  }
+
+  // Look up the pipeline for the given description, creating it now if
+  // this is its first use (or waiting for the pre-warm thread to).
+  template <bool IsFastPipeline>
+  VkPipeline getPipeline(const PipelineAlternativeDescription& description)
+  {
+    auto& pipelineMap = IsFastPipeline ? m_fastPipelineMap : m_generalPipelineMap;
+    std::unique_lock<std::mutex> lock(m_pipelineMutex);
+    PipelineMapPair& pair =
+        *pipelineMap.emplace(pipelineKey(description), VK_NULL_HANDLE).first;
+    m_pipelineCreated.wait(
+        lock, [&] { return m_pipelinesInProgress.count(&pair) == 0; });
+    if (pair.second == VK_NULL_HANDLE)
+    {
+      m_pipelinesInProgress.insert(&pair);
+      lock.unlock();
+      compilePipelineEntries<IsFastPipeline>({&pair}, m_dumpPipelineStats);
+      lock.lock();
+      m_pipelinesInProgress.erase(&pair);
+      m_pipelineCreated.notify_all();
+    }
+    return pair.second;
+  }
+
+  // Group entries that only differ in specialization constants (adjacent
+  // in the map), so each shader module is loaded once.
+  static std::vector<std::vector<PipelineMapPair*>> groupEntries(
+      std::map<PipelineKey, VkPipeline>& pipelineMap)
+  {
+    std::vector<std::vector<PipelineMapPair*>> groups;
+    for (PipelineMapPair& entry : pipelineMap)
+    {
+      if (groups.empty()
+          || std::get<0>(groups.back()[0]->first) != std::get<0>(entry.first)
+          || std::get<1>(groups.back()[0]->first) != std::get<1>(entry.first))
+      {
+        groups.emplace_back();
+      }
+      groups.back().push_back(&entry);
+    }
+    return groups;
+  }
+
+  // Create the pipelines of the job's group that are neither created
+  // nor being created by getPipeline, recording them in job.created.
+  void runPrewarmJob(PrewarmJob& job)
+  {
+    if (m_stopPrewarm) return;
+    {
+      std::lock_guard<std::mutex> lock(m_pipelineMutex);
+      for (PipelineMapPair* pPair : job.group)
+      {
+        if (m_pipelinesInProgress.count(pPair) == 0
+            && pPair->second == VK_NULL_HANDLE)
+        {
+          m_pipelinesInProgress.insert(pPair);
+          job.created.push_back(pPair);
+        }
+      }
+    }
+    if (job.created.empty()) return;
+
+    if (job.isFastPipeline)
+      compilePipelineEntries<true>(job.created, m_dumpPipelineStats, true);
+    else
+      compilePipelineEntries<false>(job.created, m_dumpPipelineStats, true);
+
+    std::lock_guard<std::mutex> lock(m_pipelineMutex);
+    for (PipelineMapPair* pPair : job.created)
+    {
+      m_pipelinesInProgress.erase(pPair);
+    }
+    m_pipelineCreated.notify_all();
+  }
+
+  // Create the alpha coverage histogram (pass 0) or scale (pass 1)
+  // pipeline from its build-time spv.
+  void compileCoveragePipeline(int pass, bool dumpPipelineStats)
+  {
+    // Built with NVPRO_PYRAMID_COVERAGE_PASS defined as pass (see
+    // demo_app/CMakeLists.txt).
+    std::string filename =
+        "srgba8_coverage_" + std::to_string(pass) + ".comp.spv";
+    makeComputePipeline(m_device, filename.c_str(), dumpPipelineStats, m_layout,
+                        pass == 0 ? &m_coveragePipelines.histogramPipeline :
+                                    &m_coveragePipelines.scalePipeline);
+  }
+
+  // Compile the alpha coverage pipelines if this is their first use.
+  void compileCoveragePipelinesIfMissing()
+  {
+    std::lock_guard<std::mutex> lock(m_coverageMutex);
+    if (m_coveragePipelines.histogramPipeline == VK_NULL_HANDLE)
+    {
+      compileCoveragePipeline(0, m_dumpPipelineStats);
+    }
+    if (m_coveragePipelines.scalePipeline == VK_NULL_HANDLE)
+    {
+      compileCoveragePipeline(1, m_dumpPipelineStats);
+    }
+  }
+
+  // Body of the pre-warm thread: create all pipelines of the pipeline
+  // alternatives not used yet, one job per group on the compile thread
+  // pool, so that switching between them in the GUI does not stall.
+  // Statistics are printed in group order.
+  void prewarm(std::vector<PrewarmJob> jobs)
+  {
+    auto startTime = std::chrono::steady_clock::now();
+    computeCompileThreadPool().runOrdered(
+        uint32_t(jobs.size()), [&](uint32_t i) { runPrewarmJob(jobs[i]); },
+        [&](uint32_t i) {
+          if (!m_dumpPipelineStats) return;
+          for (const PipelineMapPair* pPair : jobs[i].created)
+          {
+            std::string humanName =
+                pipelineHumanName(jobs[i].isFastPipeline, pPair->first);
+            nvvk::nvprintPipelineStats(m_device, pPair->second,
+                                       humanName.c_str(), false);
+          }
+        });
+    if (m_stopPrewarm) return;
+    compileCoveragePipelinesIfMissing();
+
+    uint32_t created = 0;
+    for (const PrewarmJob& job : jobs)
+    {
+      created += uint32_t(job.created.size());
+    }
+    double ms = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - startTime).count();
+    fprintf(stderr,
+            "Pre-warmed %u srgba8 mipmap pipelines in %.1f ms (%u threads)\n",
+            created, ms, computeCompileThreadPool().threadCount());
   }
 
 public:
   ComputeMipmapPipelinesImpl(VkDevice           device,
+                             VkPhysicalDevice   physicalDevice,
                              const ScopedImage& image,
-                             bool               dumpPipelineStats)
+                             bool               dumpPipelineStats,
+                             bool               prewarmPipelines)
       : m_device(device)
+      , m_dumpPipelineStats(dumpPipelineStats)
+      , m_scratchDescriptorContainer(device)
   {
+    auto     startTime      = std::chrono::steady_clock::now();
+    auto&    feedback       = computePipelineFeedback();
+    uint32_t startPipelines = feedback.pipelines, startHits = feedback.cacheHits;
+    uint64_t startHitNs     = feedback.hitNanoseconds;
+    uint64_t startMissNs    = feedback.missNanoseconds;
+
+    // All supported features are enabled (main.cpp).
+    VkPhysicalDeviceShaderClockFeaturesKHR clockFeatures = {
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_CLOCK_FEATURES_KHR};
+    VkPhysicalDeviceFeatures2 features = {
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &clockFeatures};
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+    m_subgroupClockSupported = clockFeatures.shaderSubgroupClock;
+    m_realtimeClockSupported = clockFeatures.shaderDeviceClock;
+
+    // For the workgroup count of the persistent-threads general pipeline.
+    initDeviceResidentThreads(physicalDevice);
+
+    // Set up the scratch buffer, zero-initialized, and its descriptor.
+    m_allocator.init(device, physicalDevice);
+    VkBufferCreateInfo scratchBufferInfo = {
+        VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO, nullptr, 0,
+        s_bufferSize,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT};
+    m_scratchBuffer = m_allocator.createBuffer(
+        scratchBufferInfo, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+                               | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+    memset(m_allocator.map(m_scratchBuffer), 0, s_bufferSize);
+    m_allocator.unmap(m_scratchBuffer);
+
+    m_scratchDescriptorContainer.addBinding(
+        0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT);
+    m_scratchDescriptorContainer.addBinding(
+        1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT);
+    m_scratchDescriptorContainer.addBinding(
+        2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT);
+    m_scratchDescriptorContainer.initLayout();
+    m_scratchDescriptorContainer.initPool(1);
+    VkDescriptorBufferInfo scratchInfo = {m_scratchBuffer.buffer, 0,
+                                          s_scratchBufferSize};
+    VkDescriptorBufferInfo histogramInfo = {m_scratchBuffer.buffer,
+                                            s_histogramOffset,
+                                            nvproPyramidCoverageHistogramBytes};
+    VkWriteDescriptorSet writes[] = {
+        m_scratchDescriptorContainer.makeWrite(0, 0, &scratchInfo),
+        m_scratchDescriptorContainer.makeWrite(0, 1, &histogramInfo)};
+    vkUpdateDescriptorSets(device, arraySize(writes), writes, 0, nullptr);
+
     // Set up pipeline layout inputs.
-    VkDescriptorSetLayout setLayouts[] = {image.getTextureDescriptorSetLayout(),
-                                          image.getStorageDescriptorSetLayout()};
+    VkDescriptorSetLayout setLayouts[] = {
+        image.getTextureDescriptorSetLayout(),
+        image.getStorageDescriptorSetLayout(),
+        m_scratchDescriptorContainer.getLayout()};
     VkPushConstantRange pushConstantRange = {
         VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t) };
 
@@ -144,42 +556,66 @@ public:
     NVVK_CHECK(vkCreatePipelineLayout(
         device, &pipelineLayoutInfo, nullptr, &m_layout));
 
-    // Gather all the compute shaders descriptions that have to be compiled.
+    // Gather the keys of all pipelines, but create them only on first
+    // use (getPipeline), or in the background if requested, so that
+    // startup time does not depend on the number of alternatives.
     for (int i = 0; i < pipelineAlternativeCount; ++i)
     {
       const PipelineAlternative& alt = pipelineAlternatives[i];
       addNullPipelineEntry<false>(alt.generalAlternative);
       addNullPipelineEntry<true>(alt.fastAlternative);
     }
+    m_coveragePipelines.layout = m_layout;
 
-    // Use threads to compile them, except if we're dumping stats.
-    std::vector<std::thread> threads;
-    for (PipelineMapPair& entry : m_generalPipelineMap)
-    {
-      auto lambda = [&] { compilePipelineEntry<false>(&entry, dumpPipelineStats); };
-      if (dumpPipelineStats)
-        lambda();
-      else
-        threads.emplace_back(std::move(lambda));
-    }
-    for (PipelineMapPair& entry : m_fastPipelineMap)
+    // Buffer mode pipelines; no alternatives, so use the built spv.
+    VkDescriptorSetLayout bufferSetLayout = image.getBufferDescriptorSetLayout();
+    pushConstantRange.size = 3 * sizeof(uint32_t);
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts    = &bufferSetLayout;
+    NVVK_CHECK(vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr,
+                                      &m_bufferPipelines.layout));
+    const char* bufferFilenames[] = {"srgba8_buffer_general_pipeline.comp.spv",
+                                     "srgba8_buffer_fast_pipeline.comp.spv"};
+    VkPipeline* bufferPipelines[] = {&m_bufferPipelines.generalPipeline,
+                                     &m_bufferPipelines.fastPipeline};
+    makeComputePipelines(device, 2, bufferFilenames, dumpPipelineStats,
+                         m_bufferPipelines.layout, bufferPipelines);
+
+    // Report how much the pipeline cache helped.
+    double ms = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - startTime).count();
+    fprintf(stderr, "Created srgba8 mipmap pipelines in %.1f ms", ms);
+    if (feedback.pipelines != startPipelines)
     {
-      auto lambda = [&] { compilePipelineEntry<true>(&entry, dumpPipelineStats); };
-      if (dumpPipelineStats)
-        lambda();
-      else
-        threads.emplace_back(std::move(lambda));
+      fprintf(stderr,
+              " (%u of %u from pipeline cache; creating hits took %.1f ms,"
+              " misses %.1f ms)",
+              feedback.cacheHits - startHits, feedback.pipelines - startPipelines,
+              (feedback.hitNanoseconds - startHitNs) * 1e-6,
+              (feedback.missNanoseconds - startMissNs) * 1e-6);
     }
+    fprintf(stderr, "\n");
 
-    // Wait.
-    for (std::thread& thread : threads)
+    if (prewarmPipelines)
     {
-      thread.join();
+      std::vector<PrewarmJob> jobs;
+      for (auto& group : groupEntries(m_generalPipelineMap))
+      {
+        jobs.push_back({false, std::move(group), {}});
+      }
+      for (auto& group : groupEntries(m_fastPipelineMap))
+      {
+        jobs.push_back({true, std::move(group), {}});
+      }
+      m_prewarmThread = std::thread(&ComputeMipmapPipelinesImpl::prewarm,
+                                    this, std::move(jobs));
     }
   }
 
   ~ComputeMipmapPipelinesImpl()
   {
+    m_stopPrewarm = true;
+    if (m_prewarmThread.joinable()) m_prewarmThread.join();
     vkDestroyPipelineLayout(m_device, m_layout, nullptr);
     for (auto pair : m_generalPipelineMap)
     {
@@ -189,6 +625,19 @@ public:
     {
       vkDestroyPipeline(m_device, pair.second, nullptr);
     }
+    vkDestroyPipeline(m_device, m_coveragePipelines.histogramPipeline, nullptr);
+    vkDestroyPipeline(m_device, m_coveragePipelines.scalePipeline, nullptr);
+    vkDestroyPipeline(m_device, m_bufferPipelines.generalPipeline, nullptr);
+    vkDestroyPipeline(m_device, m_bufferPipelines.fastPipeline, nullptr);
+    vkDestroyPipelineLayout(m_device, m_bufferPipelines.layout, nullptr);
+    m_scratchDescriptorContainer.deinit();
+    m_allocator.destroy(m_scratchBuffer);
+    for (InstrumentBuffer& instrument : m_instrumentBuffers)
+    {
+      vkDestroyDescriptorPool(m_device, instrument.pool, nullptr);
+      m_allocator.destroy(instrument.buffer);
+    }
+    m_allocator.deinit();
   }
 
   // Record a command to generate mipmaps for the specified image
@@ -200,6 +649,17 @@ public:
                        const ScopedImage&         imageToMipmap,
                        const PipelineAlternative& alternative) override
   {
+    cmdBindGenerate(cmdBuf, imageToMipmap, alternative,
+                    m_scratchDescriptorContainer.getSet(0));
+  }
+
+  // Same, binding the given scratch descriptor set (set=2) for pipeline
+  // alternatives.
+  void cmdBindGenerate(VkCommandBuffer            cmdBuf,
+                       const ScopedImage&         imageToMipmap,
+                       const PipelineAlternative& alternative,
+                       VkDescriptorSet            scratchSet)
+  {
 #ifdef USE_DEBUG_UTILS
     VkDebugUtilsLabelEXT labelInfo = {VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT,
                                       nullptr, "mipmap_generation"};
@@ -212,7 +672,8 @@ public:
                             || alternative.generalAlternative.configBits != 0;
     if (usingAlternative)
     {
-      cmdBindGenerateAlternative(cmdBuf, imageToMipmap, alternative);
+      cmdBindGenerateAlternative(cmdBuf, imageToMipmap, alternative,
+                                 scratchSet);
     }
     else
     {
@@ -236,8 +697,8 @@ public:
                             0, arraySize(descriptorSets), descriptorSets,
                             0, nullptr);
     NvproPyramidPipelines pipelines;
-    pipelines.generalPipeline = m_generalPipelineMap.at({"default", 0});
-    pipelines.fastPipeline       = m_fastPipelineMap.at({"default", 0});
+    pipelines.generalPipeline    = getPipeline<false>({});
+    pipelines.fastPipeline       = getPipeline<true>({});
     pipelines.layout             = m_layout;
     pipelines.pushConstantOffset = 0;
     nvproCmdPyramidDispatch(cmdBuf, pipelines,
@@ -251,18 +712,168 @@ public:
                          0, nullptr, 0, nullptr);
   }
 
+  void cmdGenerateStaging(VkCommandBuffer    cmdBuf,
+                          const ScopedImage& stagedImage) override
+  {
+    uint32_t baseSize[2] = {stagedImage.getStagedWidth(),
+                            stagedImage.getStagedHeight()};
+    VkDescriptorSet descriptorSet = stagedImage.getBufferDescriptorSet();
+    vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE,
+                            m_bufferPipelines.layout, 0, 1, &descriptorSet,
+                            0, nullptr);
+    vkCmdPushConstants(cmdBuf, m_bufferPipelines.layout,
+                       VK_SHADER_STAGE_COMPUTE_BIT, sizeof(uint32_t),
+                       sizeof baseSize, baseSize);
+    stagedImage.cmdStagingBufferBarrierBefore(cmdBuf);
+    nvproCmdPyramidDispatch(cmdBuf, m_bufferPipelines, baseSize[0],
+                            baseSize[1]);
+    stagedImage.cmdStagingBufferBarrierAfter(cmdBuf);
+  }
+
+  bool cmdBindGenerateInstrumented(
+      VkCommandBuffer            cmdBuf,
+      const ScopedImage&         imageToMipmap,
+      const PipelineAlternative& alternative) override
+  {
+    using namespace PipelineAlternativeDescriptionConfig;
+    if (!m_subgroupClockSupported && !m_realtimeClockSupported) return false;
+
+    PipelineAlternative instrumented = alternative;
+    if (instrumented.fastAlternative.name != "none")
+    {
+      instrumented.fastAlternative.configBits |= instrumentBit;
+    }
+    if (instrumented.generalAlternative.name != "blit")
+    {
+      instrumented.generalAlternative.configBits |= instrumentBit;
+    }
+
+    // Add a larger timestamp buffer if needed (see m_instrumentBuffers);
+    // nothing used by pending commands is updated or destroyed.
+    VkDeviceSize bytes = nvproPyramidInstrumentBytes(
+        nvproPyramidInstrumentMaxWorkgroups(imageToMipmap.getImageWidth(),
+                                            imageToMipmap.getImageHeight(),
+                                            imageToMipmap.getLevelCount()));
+    if (m_instrumentBuffers.empty() || bytes > m_instrumentBuffers.back().bytes)
+    {
+      InstrumentBuffer   added;
+      VkBufferCreateInfo bufferInfo = {
+          VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO, nullptr, 0, bytes,
+          VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT};
+      added.buffer = m_allocator.createBuffer(
+          bufferInfo, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+                          | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+      added.bytes = bytes;
+      added.pool  = m_scratchDescriptorContainer.getBindings().createPool(m_device);
+      added.set   = nvvk::allocateDescriptorSet(
+          m_device, added.pool, m_scratchDescriptorContainer.getLayout());
+
+      // Bindings 0 and 1 from the shared set, 2 the new buffer.
+      VkCopyDescriptorSet copy = {
+          VK_STRUCTURE_TYPE_COPY_DESCRIPTOR_SET, nullptr,
+          m_scratchDescriptorContainer.getSet(0), 0, 0, added.set, 0, 0, 2};
+      VkDescriptorBufferInfo instrumentInfo = {added.buffer.buffer, 0, bytes};
+      VkWriteDescriptorSet   write =
+          m_scratchDescriptorContainer.getBindings().makeWrite(
+              added.set, 2, &instrumentInfo);
+      vkUpdateDescriptorSets(m_device, 1, &write, 1, &copy);
+      m_instrumentBuffers.push_back(added);
+    }
+    const InstrumentBuffer& instrument = m_instrumentBuffers.back();
+
+    nvproCmdPyramidInstrumentReset(cmdBuf, instrument.buffer.buffer, 0);
+    cmdBindGenerate(cmdBuf, imageToMipmap, instrumented, instrument.set);
+
+    // For reading back on the host.
+    VkBufferMemoryBarrier hostBarrier = {
+        VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER, nullptr,
+        VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_HOST_READ_BIT,
+        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+        instrument.buffer.buffer, 0, instrument.bytes};
+    vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_HOST_BIT, 0,
+                         0, nullptr, 1, &hostBarrier, 0, nullptr);
+    return true;
+  }
+
+  uint32_t getInstrumentRecords(
+      std::vector<NvproPyramidInstrumentRecord>* pRecords) override
+  {
+    pRecords->clear();
+    if (m_instrumentBuffers.empty()) return 0;
+    InstrumentBuffer& instrument = m_instrumentBuffers.back();
+    uint32_t          dropped    = nvproPyramidInstrumentDecode(
+        m_allocator.map(instrument.buffer), instrument.bytes, pRecords);
+    m_allocator.unmap(instrument.buffer);
+    return dropped;
+  }
+
+  bool instrumentUsesRealtimeClock() const override
+  {
+    return m_realtimeClockSupported;
+  }
+
+  NvproPyramidPipelines getPipelines(
+      const PipelineAlternative& alternative) override
+  {
+    NvproPyramidPipelines pipelines{};
+    pipelines.layout = m_layout;
+    if (alternative.fastAlternative.name != "none")
+    {
+      pipelines.fastPipeline = getPipeline<true>(alternative.fastAlternative);
+    }
+    if (alternative.generalAlternative.name != "blit")
+    {
+      pipelines.generalPipeline =
+          getPipeline<false>(alternative.generalAlternative);
+    }
+    return pipelines;
+  }
+
+  // Whether the pipeline alternative accesses the scratch set (set=2):
+  // the persistent-threads general pipeline's work counters, the alpha
+  // coverage histograms, or the instrumented pipelines' timestamps.
+  static bool usesScratchBuffers(const PipelineAlternative& alternative)
+  {
+    using namespace PipelineAlternativeDescriptionConfig;
+    const PipelineAlternativeDescription& general = alternative.generalAlternative;
+    const std::string& generalDirname =
+        general.basePipelineName.empty() ? general.name : general.basePipelineName;
+    uint32_t configBits =
+        general.configBits | alternative.fastAlternative.configBits;
+    return generalDirname == "persistent"
+           || (configBits & (alphaCoverageBit | instrumentBit)) != 0;
+  }
+
   // This is NOT typical usage of nvpro_pyramid; see above for that.
   void cmdBindGenerateAlternative(VkCommandBuffer            cmdBuf,
                                   const ScopedImage&         imageToMipmap,
-                                  const PipelineAlternative& alternative)
+                                  const PipelineAlternative& alternative,
+                                  VkDescriptorSet            scratchSet)
   {
     VkDescriptorSet descriptorSets[] = {
         imageToMipmap.getTextureDescriptorSet(),
-        imageToMipmap.getStorageDescriptorSet()};
+        imageToMipmap.getStorageDescriptorSet(), scratchSet};
     vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_layout,
                             0, arraySize(descriptorSets), descriptorSets,
                             0, nullptr);
 
+    // Make scratch buffer writes (e.g. counter resets) of any earlier
+    // mipmap generation visible; the usual barriers between
+    // generations only protect the image.
+    if (usesScratchBuffers(alternative))
+    {
+      VkBufferMemoryBarrier scratchBarrier = {
+          VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER, nullptr,
+          VK_ACCESS_SHADER_WRITE_BIT,
+          VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+          VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+          m_scratchBuffer.buffer, 0, s_bufferSize};
+      vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                           0, nullptr, 1, &scratchBarrier, 0, nullptr);
+    }
+
     VkMemoryBarrier endBarrier = {
         VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr,
         VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_MEMORY_READ_BIT };
@@ -276,14 +887,7 @@ public:
     nvpro_pyramid_dispatcher_t fastDispatcher = nullptr;
     if (alternative.fastAlternative.name != "none")
     {
-      const std::pair<std::string, uint32_t> key = {
-          alternative.fastAlternative.basePipelineName.empty() ?
-              alternative.fastAlternative.name :
-              alternative.fastAlternative.basePipelineName,
-          alternative.fastAlternative.configBits};
-      auto pipelineIter = m_fastPipelineMap.find(key);
-      assert(pipelineIter != m_fastPipelineMap.end());
-      pipelines.fastPipeline = pipelineIter->second;
+      pipelines.fastPipeline = getPipeline<true>(alternative.fastAlternative);
 
       fastDispatcher = getFastDispatcher(alternative.fastAlternative.name);
       if (fastDispatcher == nullptr)
@@ -295,14 +899,8 @@ public:
     if (alternative.generalAlternative.name != "blit")
     {
       // Same for the general pipeline, unless using blits.
-      const std::pair<std::string, uint32_t> key = {
-          alternative.generalAlternative.basePipelineName.empty() ?
-              alternative.generalAlternative.name :
-              alternative.generalAlternative.basePipelineName,
-          alternative.generalAlternative.configBits};
-      auto pipelineIter = m_generalPipelineMap.find(key);
-      assert(pipelineIter != m_generalPipelineMap.end());
-      pipelines.generalPipeline = pipelineIter->second;
+      pipelines.generalPipeline =
+          getPipeline<false>(alternative.generalAlternative);
 
       nvpro_pyramid_dispatcher_t generalDispatcher =
           getGeneralDispatcher(alternative.generalAlternative.name);
@@ -415,15 +1013,41 @@ public:
             0, 1, &betweenBarrier, 0, nullptr, 0, nullptr);
       }
     }
+
+    // Rescale alpha to preserve alpha test coverage, if requested.
+    if (alternative.generalAlternative.configBits
+        & PipelineAlternativeDescriptionConfig::alphaCoverageBit)
+    {
+      if (barrierBeforePipelineStage != VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT)
+      {
+        // nvproCmdPyramidCoverageDispatch only waits for compute writes.
+        vkCmdPipelineBarrier(cmdBuf, barrierBeforePipelineStage,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                             1, &endBarrier, 0, nullptr, 0, nullptr);
+        barrierBeforePipelineStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        endBarrier.srcAccessMask   = VK_ACCESS_SHADER_WRITE_BIT;
+      }
+      compileCoveragePipelinesIfMissing();
+      nvproCmdPyramidCoverageDispatch(
+          cmdBuf, m_coveragePipelines, m_scratchBuffer.buffer,
+          s_histogramOffset,
+          PipelineAlternativeDescriptionConfig::alphaCoverageCutoff,
+          imageToMipmap.getImageWidth(), imageToMipmap.getImageHeight(),
+          imageToMipmap.getLevelCount());
+    }
+
     vkCmdPipelineBarrier(cmdBuf, barrierBeforePipelineStage,
                          VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
                          1, &endBarrier, 0, nullptr, 0, nullptr);
   }
 };
 
-ComputeMipmapPipelines* ComputeMipmapPipelines::make(VkDevice           device,
+ComputeMipmapPipelines* ComputeMipmapPipelines::make(VkDevice device,
+                                                     VkPhysicalDevice physicalDevice,
                                                      const ScopedImage& image,
-                                                     bool dumpPipelineStats)
+                                                     bool dumpPipelineStats,
+                                                     bool prewarmPipelines)
 {
-  return new ComputeMipmapPipelinesImpl(device, image, dumpPipelineStats);
+  return new ComputeMipmapPipelinesImpl(device, physicalDevice, image,
+                                        dumpPipelineStats, prewarmPipelines);
 }
@@ -5,8 +5,12 @@
 
 #include "pipeline_alternative.hpp"
 
+#include <vector>
 #include <vulkan/vulkan.h>
 
+#include "nvpro_pyramid_dispatch.hpp"
+#include "nvpro_pyramid_instrument.hpp"
+
 class ScopedImage;
 struct PipelineAlternative;
 
@@ -30,8 +34,50 @@ public:
                                const ScopedImage&         imageToMipmap,
                                const PipelineAlternative& alternative) = 0;
 
-  static ComputeMipmapPipelines*
-  make(VkDevice device, const ScopedImage& image, bool dumpPipelineStats);
+  // Record commands to generate mipmaps directly in the staging buffer
+  // of the specified image ("buffer mode", srgba8_buffer_preamble.glsl),
+  // from the base level staged there, so that they can be read on the
+  // host without an image download. Includes barriers before (host
+  // writes) and after (host reads). The image itself is not used.
+  virtual void cmdGenerateStaging(VkCommandBuffer    cmdBuf,
+                                  const ScopedImage& stagedImage) = 0;
+
+  // Same as cmdBindGenerate, but with the pipelines compiled with
+  // NVPRO_PYRAMID_INSTRUMENT (instrumentBit, compiled on first use),
+  // recording workgroup timestamps; resets the timestamp buffer first.
+  // Returns false (recording nothing) if the device does not support
+  // shader clocks. Earlier commands, instrumented or not, may still be
+  // pending: a timestamp buffer too small for the image is replaced, not
+  // updated in place.
+  virtual bool cmdBindGenerateInstrumented(
+      VkCommandBuffer            cmdBuf,
+      const ScopedImage&         imageToMipmap,
+      const PipelineAlternative& alternative) = 0;
+
+  // Decode the timestamps of the last recorded (and completed)
+  // cmdBindGenerateInstrumented; returns the number of workgroups that
+  // did not fit in the buffer.
+  virtual uint32_t getInstrumentRecords(
+      std::vector<NvproPyramidInstrumentRecord>* pRecords) = 0;
+
+  // Whether the instrumented pipelines use the device realtime clock
+  // instead of subgroup clocks.
+  virtual bool instrumentUsesRealtimeClock() const = 0;
+
+  // Fast and general pipelines used by cmdBindGenerate for the named
+  // pipeline alternatives (creating them if needed), e.g. to query
+  // their executable statistics. VK_NULL_HANDLE for "none" and "blit".
+  virtual NvproPyramidPipelines getPipelines(
+      const PipelineAlternative& alternative) = 0;
+
+  // Pipelines are created on first use by the above commands, from the
+  // spv built for each pipeline alternative when available. If
+  // prewarmPipelines, a background thread creates all of them early.
+  static ComputeMipmapPipelines* make(VkDevice           device,
+                                      VkPhysicalDevice   physicalDevice,
+                                      const ScopedImage& image,
+                                      bool               dumpPipelineStats,
+                                      bool               prewarmPipelines);
 };
 
 #endif
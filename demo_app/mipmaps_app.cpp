@@ -40,11 +40,15 @@
 #include "nvpro_pyramid_dispatch_alternative.hpp"
 
 #include "app_args.hpp"
+#include "bloom.hpp"
 #include "drawing.hpp"
+#include "format_pyramid.hpp"
 #include "julia.hpp"
 #include "mipmap_pipelines.hpp"
 #include "gui.hpp"
+#include "instrument_report.hpp"
 #include "pipeline_alternative.hpp"
+#include "pipeline_stats_json.hpp"
 
 // GLSL polyglots
 #include "shaders/camera_transforms.h"
@@ -73,6 +77,9 @@ public:
   Julia       m_julia;
   double      m_lastUpdateTime;
 
+  // Bloom of the drawn image, resized to match it as needed.
+  Bloom m_bloom;
+
   // Pipelines.
   std::unique_ptr<ComputeMipmapPipelines> m_pComputeMipmapPipelines;
 
@@ -113,14 +120,23 @@ public:
                 args.animationTextureWidth,
                 args.animationTextureHeight)
       , m_lastUpdateTime(glfwGetTime())
+      , m_bloom(ctx,
+                ctx.m_physicalDevice,
+                m_loadedImage.getTextureDescriptorSetLayout(),
+                args.dumpPipelineStats,
+                args.animationTextureWidth,
+                args.animationTextureHeight)
       , m_pComputeMipmapPipelines(
             ComputeMipmapPipelines::make(ctx,
+                                         ctx.m_physicalDevice,
                                          m_loadedImage,
-                                         args.dumpPipelineStats))
+                                         args.dumpPipelineStats,
+                                         args.prewarmPipelines))
       , m_swapImagePipeline(ctx,
                             ctx.m_physicalDevice,
                             m_swapRenderPass,
-                            m_loadedImage.getTextureDescriptorSetLayout())
+                            m_loadedImage.getTextureDescriptorSetLayout(),
+                            m_bloom.getTextureDescriptorSetLayout())
       , m_vkProfiler(nullptr)
       , m_frameManager(ctx,
                        surface,
@@ -140,6 +156,10 @@ public:
       m_gui.cmdInit(cmdBuf, window, ctx, m_frameManager, m_swapRenderPass, 0);
     }
 
+    // CPU reference kernel matching the pipeline alternative used.
+    int     inputWideKernel          = wideKernelNone;
+    uint8_t inputAlphaCoverageCutoff = 0;
+    bool    instrumented             = false;
     if (!args.inputFilename.empty())
     {
       // Pipeline alternative used for generating mipmaps.
@@ -164,30 +184,55 @@ public:
                                true);
       m_loadedImage.cmdReallocUploadImage(cmdBuf, VK_IMAGE_LAYOUT_GENERAL);
 
-      // Clear mipmaps and generate using the requested pipeline.
-      VkMemoryBarrier clearBarrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr,
-                                      VK_ACCESS_TRANSFER_WRITE_BIT,
-                                      VK_ACCESS_SHADER_WRITE_BIT};
-      VkImageSubresourceRange clearRange = {VK_IMAGE_ASPECT_COLOR_BIT, 1,
-                                            VK_REMAINING_MIP_LEVELS, 0, 1};
-      vkCmdClearColorImage(cmdBuf, m_loadedImage.getImage(),
-                           VK_IMAGE_LAYOUT_GENERAL,
-                           m_loadedImage.getPMagenta(), 1, &clearRange);
-      vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
-                           1, &clearBarrier, 0, nullptr, 0, nullptr);
-
-      m_pComputeMipmapPipelines->cmdBindGenerate(cmdBuf, m_loadedImage,
-                                                 *pPipelineAlternative);
-      VkMemoryBarrier downloadBarrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER,
-                                         nullptr, VK_ACCESS_SHADER_WRITE_BIT,
-                                         VK_ACCESS_MEMORY_READ_BIT};
-      vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                           VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0,
-                           1, &downloadBarrier, 0, nullptr, 0, nullptr);
-
-      // Download mipmaps.
-      m_loadedImage.cmdDownloadImage(cmdBuf, VK_IMAGE_LAYOUT_GENERAL);
+      if (args.bufferOutput)
+      {
+        // Generate mipmaps in the staging buffer itself; the image's
+        // mipmaps are generated every frame for drawing anyway.
+        m_pComputeMipmapPipelines->cmdGenerateStaging(cmdBuf, m_loadedImage);
+      }
+      else
+      {
+        // Clear mipmaps and generate using the requested pipeline.
+        VkMemoryBarrier clearBarrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER, nullptr,
+                                        VK_ACCESS_TRANSFER_WRITE_BIT,
+                                        VK_ACCESS_SHADER_WRITE_BIT};
+        VkImageSubresourceRange clearRange = {VK_IMAGE_ASPECT_COLOR_BIT, 1,
+                                              VK_REMAINING_MIP_LEVELS, 0, 1};
+        vkCmdClearColorImage(cmdBuf, m_loadedImage.getImage(),
+                             VK_IMAGE_LAYOUT_GENERAL,
+                             m_loadedImage.getPMagenta(), 1, &clearRange);
+        vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                             1, &clearBarrier, 0, nullptr, 0, nullptr);
+
+        if (!args.instrumentPrefix.empty())
+        {
+          instrumented = m_pComputeMipmapPipelines->cmdBindGenerateInstrumented(
+              cmdBuf, m_loadedImage, *pPipelineAlternative);
+          if (!instrumented)
+          {
+            fprintf(stderr, "No shader clock support; ignoring -instrument\n");
+          }
+        }
+        if (!instrumented)
+        {
+          m_pComputeMipmapPipelines->cmdBindGenerate(cmdBuf, m_loadedImage,
+                                                     *pPipelineAlternative);
+        }
+        inputWideKernel = wideKernelFromConfigBits(
+            pPipelineAlternative->generalAlternative.configBits);
+        inputAlphaCoverageCutoff = alphaCoverageCutoffFromConfigBits(
+            pPipelineAlternative->generalAlternative.configBits);
+        VkMemoryBarrier downloadBarrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                                           nullptr, VK_ACCESS_SHADER_WRITE_BIT,
+                                           VK_ACCESS_MEMORY_READ_BIT};
+        vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0,
+                             1, &downloadBarrier, 0, nullptr, 0, nullptr);
+
+        // Download mipmaps.
+        m_loadedImage.cmdDownloadImage(cmdBuf, VK_IMAGE_LAYOUT_GENERAL);
+      }
       m_loadedImageFilename = args.inputFilename;
     }
 
@@ -200,14 +245,31 @@ public:
     vkQueueWaitIdle(m_frameManager.getQueue());
     vkFreeCommandBuffers(m_context, m_frameManager.getCommandPool(), 1, &cmdBuf);
 
+    // Write the workgroup timestamp report if requested.
+    if (instrumented)
+    {
+      std::vector<NvproPyramidInstrumentRecord> records;
+      uint32_t dropped = m_pComputeMipmapPipelines->getInstrumentRecords(&records);
+      std::string jsonFilename = args.instrumentPrefix + ".json";
+      std::string pngFilename  = args.instrumentPrefix + ".png";
+      fprintf(stderr, "Writing workgroup timestamps to '%s' and '%s'...\n",
+              jsonFilename.c_str(), pngFilename.c_str());
+      writeInstrumentReport(
+          records, dropped,
+          m_pComputeMipmapPipelines->instrumentUsesRealtimeClock(),
+          jsonFilename.c_str(), pngFilename.c_str());
+    }
+
     // Test mipmap correctness and store images on separate thread.
     if (!args.inputFilename.empty())
     {
       if (args.test)
       {
         auto pMips = m_loadedImage.copyFromStaging();
-        m_testThread = std::thread([pMips = std::move(pMips)] {
-          printf("%s\n", testMipmaps(*pMips).c_str());
+        m_testThread = std::thread([pMips = std::move(pMips), inputWideKernel,
+                                    inputAlphaCoverageCutoff] {
+          printf("%s\n", testMipmaps(*pMips, inputWideKernel,
+                                     inputAlphaCoverageCutoff).c_str());
         });
       }
       if (!args.outputFilename.empty())
@@ -336,6 +398,24 @@ public:
           pipelineAlternatives[m_gui.m_alternativeIdxSetting]);
     }
 
+    // Bloom the base level, resizing the bloom images if needed.
+    if (m_bloom.getWidth() != imageToMipmap.getImageWidth()
+        || m_bloom.getHeight() != imageToMipmap.getImageHeight())
+    {
+      vkQueueWaitIdle(m_frameManager.getQueue());
+      m_bloom.resize(imageToMipmap.getImageWidth(),
+                     imageToMipmap.getImageHeight());
+    }
+    if (m_gui.m_cam.doBloom)
+    {
+      auto scopedSection = m_vkProfiler.timeRecurring("bloom", primaryCmdBuf);
+      m_bloom.cmdBloom(primaryCmdBuf, imageToMipmap.getTextureDescriptorSet());
+    }
+    else
+    {
+      m_bloom.cmdClearIfNeeded(primaryCmdBuf);
+    }
+
     // Clamp explicit lod level.
     auto& lod              = m_gui.m_cam.explicitLod;
     m_gui.m_maxExplicitLod = float(imageToMipmap.getLevelCount()) - 1.0f;
@@ -403,6 +483,7 @@ public:
                                     swapImagePushConstant,
                                     cameraTransforms,
                                     baseColorSampler,
+                                    m_bloom.getTextureDescriptorSet(),
                                     m_frameManager.evenOdd());
     // Draw GUI
     ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), primaryCmdBuf);
@@ -447,9 +528,16 @@ public:
         {
           m_testThread.join();
         }
-        m_testThread = std::thread([pMips = std::move(pMips)] {
-          printf("%s\n", testMipmaps(*pMips).c_str());
-        });
+        uint32_t configBits = pipelineAlternatives[m_gui.m_alternativeIdxSetting]
+                                  .generalAlternative.configBits;
+        int     wideKernel = wideKernelFromConfigBits(configBits);
+        uint8_t alphaCoverageCutoff =
+            alphaCoverageCutoffFromConfigBits(configBits);
+        m_testThread = std::thread(
+            [pMips = std::move(pMips), wideKernel, alphaCoverageCutoff] {
+              printf("%s\n", testMipmaps(*pMips, wideKernel,
+                                         alphaCoverageCutoff).c_str());
+            });
         printf("Test beginning...\n");
       }
 
@@ -593,18 +681,35 @@ public:
     std::swap(fence,  prevFence);
 
     // If testing is enabled, generate expected mipmaps for each image
-    // in the background.
+    // in the background, in [CPU reference][test image index] order;
+    // only for the references (see cpuReferenceFromConfigBits) used by
+    // some pipeline alternative.
     std::unique_ptr<MipmapStorage<uint8_t, 4>>
-                expectedResults[imageNameArraySize];
-    std::thread expectedResultThreads[imageNameArraySize];
+                expectedResults[cpuReferenceCount][imageNameArraySize];
+    std::thread expectedResultThreads[cpuReferenceCount][imageNameArraySize];
     if (enableTesting)
     {
-      for (size_t i = 0; i < imageNameArraySize; ++i)
+      uint32_t referenceConfigBits[cpuReferenceCount] = {};
+      bool     referenceUsed[cpuReferenceCount]       = {};
+      for (int i = 0; i < pipelineAlternativeCount; ++i)
+      {
+        uint32_t configBits = pipelineAlternatives[i].generalAlternative.configBits;
+        int      k          = cpuReferenceFromConfigBits(configBits);
+        referenceConfigBits[k] = configBits;
+        referenceUsed[k]       = true;
+      }
+      for (int k = 0; k < cpuReferenceCount; ++k)
       {
-        const ScopedImage& srcImage = *images[i];
-        expectedResults[i] = srcImage.copyFromStaging();
-        expectedResultThreads[i] =
-            std::thread(cpuGenerateMipmaps_sRGBA, expectedResults[i].get());
+        if (!referenceUsed[k]) continue;
+        for (size_t i = 0; i < imageNameArraySize; ++i)
+        {
+          const ScopedImage& srcImage = *images[i];
+          expectedResults[k][i] = srcImage.copyFromStaging();
+          expectedResultThreads[k][i] = std::thread(
+              cpuGenerateMipmaps_sRGBA, expectedResults[k][i].get(),
+              wideKernelFromConfigBits(referenceConfigBits[k]),
+              alphaCoverageCutoffFromConfigBits(referenceConfigBits[k]));
+        }
       }
     }
 
@@ -701,12 +806,21 @@ public:
             NVVK_CHECK(vkWaitForFences(device, 1, &prevFence, 0, UINT64_MAX));
             if (pipelineAlternative == 0)
             {
-              expectedResultThreads[imageIdx].join();
+              for (auto& referenceThreads : expectedResultThreads)
+              {
+                if (referenceThreads[imageIdx].joinable())
+                {
+                  referenceThreads[imageIdx].join();
+                }
+              }
             }
+            int reference = cpuReferenceFromConfigBits(
+                pipelineAlternatives[pipelineAlternative]
+                    .generalAlternative.configBits);
             imageCompareThreads[imageIdx] = std::thread(
                 [pImage    = images[imageIdx].get(),
                  pOutput   = &worstDeltaArray[pipelineAlternative][imageIdx],
-                 pExpected = expectedResults[imageIdx].get()] {
+                 pExpected = expectedResults[reference][imageIdx].get()] {
                   auto pMips = pImage->copyFromStaging();
                   *pOutput   = pMips->compare(*pExpected);
                 });
@@ -736,6 +850,55 @@ public:
     }
     assert(queryIdx == timestampCount);
 
+    // Benchmark the other pyramid formats too; appended to the json.
+    std::string formatPyramidJson = benchmarkFormatPyramids(
+        m_context, enableTesting, m_args.dumpPipelineStats, m_args.hdrFilename);
+
+    // Executable statistics of each pipeline alternative, if captured
+    // (see computePipelineCaptureFlags), written next to its times so
+    // that timing changes can be related to register/shared memory use
+    // and code changes; the internal representations (-stats only) get
+    // their own top-level entry as they are large.
+    std::vector<std::string> pipelineStatsStrings(pipelineAlternativeCount);
+    std::string              internalRepresentationsJson;
+    for (int i = 0; i < pipelineAlternativeCount; ++i)
+    {
+      NvproPyramidPipelines pipelines =
+          m_pComputeMipmapPipelines->getPipelines(pipelineAlternatives[i]);
+      std::string fastStats = pipelineStatisticsJson(device, pipelines.fastPipeline);
+      std::string generalStats =
+          pipelineStatisticsJson(device, pipelines.generalPipeline);
+      if (!fastStats.empty())
+      {
+        pipelineStatsStrings[i] += ", \"fast_stats\":" + fastStats;
+      }
+      if (!generalStats.empty())
+      {
+        pipelineStatsStrings[i] += ", \"general_stats\":" + generalStats;
+      }
+
+      std::string fastIR =
+          pipelineInternalRepresentationsJson(device, pipelines.fastPipeline);
+      std::string generalIR =
+          pipelineInternalRepresentationsJson(device, pipelines.generalPipeline);
+      if (fastIR.empty() && generalIR.empty()) continue;
+      internalRepresentationsJson +=
+          std::string(internalRepresentationsJson.empty() ? "" : ",\n")
+          + "  \"" + pipelineAlternatives[i].label + "\": {"
+          + (fastIR.empty() ? "" : "\"fast\":" + fastIR)
+          + (fastIR.empty() || generalIR.empty() ? "" : ",\n   ")
+          + (generalIR.empty() ? "" : "\"general\":" + generalIR) + "}";
+    }
+
+    // Top-level entries after the per-image ones.
+    std::string trailingJson = formatPyramidJson;
+    if (!internalRepresentationsJson.empty())
+    {
+      trailingJson += std::string(trailingJson.empty() ? "" : ",\n")
+                      + "\"pipeline_internal_representations\": {\n"
+                      + internalRepresentationsJson + "\n}";
+    }
+
     // Calculate and print out the info.
     fprintf(stderr, "Writing benchmark json to '%s'...\n", pOutputFilename);
     const char* fileAction = "opening";
@@ -784,8 +947,8 @@ public:
         // The formatted output is nicer-looking than this weird format string.
         const char* format =
           "  \"%s\":" // pipeline name
-          "%.*s{\"median_ns\":%7.0f, \"min_ns\":%7.0f, \"max_ns\":%7.0f%s}%c\n";
-        // padding          median              min            max  test result  trailing comma/}
+          "%.*s{\"median_ns\":%7.0f, \"min_ns\":%7.0f, \"max_ns\":%7.0f%s%s}%c\n";
+        // padding          median              min            max  test result  stats  trailing comma/}
         const char* name =
             pipelineAlternatives[pipelineAlternative].label;
         size_t   nameLen = strlen(name);
@@ -795,14 +958,21 @@ public:
         err = fprintf(file, format, name,
                       paddingChars, "                  ",
                       median, min_, max_, testResultsString.c_str(),
+                      pipelineStatsStrings[pipelineAlternative].c_str(),
                       isLastRow ? '}' : ',');
         if (err < 0) goto onFileError;
       }
 
-      bool isLastImage = imageIdx == images.size() - 1;
+      bool isLastImage = imageIdx == images.size() - 1
+                      && trailingJson.empty();
       err = fprintf(file, "%c\n", isLastImage ? '}' : ',');
       if (err < 0) goto onFileError;
     }
+    if (!trailingJson.empty())
+    {
+      err = fprintf(file, "%s\n}\n", trailingJson.c_str());
+      if (err < 0) goto onFileError;
+    }
 
     // Clean up stuff when done.
     vkQueueWaitIdle(queue);
@@ -5,7 +5,10 @@
 
 #include "nvpro_pyramid_dispatch_alternative.hpp"
 
+#include <algorithm>
+#include <string.h>
 #include <unordered_map>
+#include <vector>
 
 using DispatcherMap =
     std::unordered_map<std::string, nvpro_pyramid_dispatcher_t>;
@@ -58,6 +61,70 @@ NvproPyramidGeneralDispatcherAdder::NvproPyramidGeneralDispatcherAdder(
 
 NVPRO_PYRAMID_ADD_GENERAL_DISPATCHER(default, nvproPyramidDefaultGeneralDispatcher)
 
+// Resident threads of the device, 0 if unknown.
+static uint32_t deviceResidentThreads = 0;
+
+void initDeviceResidentThreads(VkPhysicalDevice physicalDevice)
+{
+  uint32_t extensionCount = 0;
+  vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr,
+                                       &extensionCount, nullptr);
+  std::vector<VkExtensionProperties> extensions(extensionCount);
+  vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr,
+                                       &extensionCount, extensions.data());
+  auto hasExtension = [&](const char* pName) {
+    return std::any_of(extensions.begin(), extensions.end(),
+                       [pName](const VkExtensionProperties& extension) {
+                         return strcmp(extension.extensionName, pName) == 0;
+                       });
+  };
+
+  // Chain only the properties of supported extensions.
+  VkPhysicalDeviceShaderSMBuiltinsPropertiesNV smProperties = {
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_SM_BUILTINS_PROPERTIES_NV};
+  VkPhysicalDeviceShaderCorePropertiesAMD coreProperties = {
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_CORE_PROPERTIES_AMD};
+  VkPhysicalDeviceProperties2 properties = {
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2};
+  bool hasSmBuiltins = hasExtension(VK_NV_SHADER_SM_BUILTINS_EXTENSION_NAME);
+  bool hasCoreProperties =
+      hasExtension(VK_AMD_SHADER_CORE_PROPERTIES_EXTENSION_NAME);
+  if (hasSmBuiltins)
+  {
+    smProperties.pNext = properties.pNext;
+    properties.pNext   = &smProperties;
+  }
+  if (hasCoreProperties)
+  {
+    coreProperties.pNext = properties.pNext;
+    properties.pNext     = &coreProperties;
+  }
+  vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+
+  deviceResidentThreads = 0;
+  if (hasSmBuiltins)
+  {
+    deviceResidentThreads =
+        smProperties.shaderSMCount * smProperties.shaderWarpsPerSM * 32u;
+  }
+  else if (hasCoreProperties)
+  {
+    deviceResidentThreads =
+        coreProperties.shaderEngineCount
+        * coreProperties.shaderArraysPerEngineCount
+        * coreProperties.computeUnitsPerShaderArray
+        * coreProperties.simdPerComputeUnit
+        * coreProperties.wavefrontsPerSimd * coreProperties.wavefrontSize;
+  }
+}
+
+uint32_t getDeviceFillingWorkgroupCount(uint32_t threadsPerWorkgroup,
+                                        uint32_t defaultCount)
+{
+  uint32_t count = deviceResidentThreads / threadsPerWorkgroup;
+  return count == 0 ? defaultCount : count;
+}
+
 // For testing, dispatcher that does not do anything (but pretends it did).
 static uint32_t nullDispatcher(VkCommandBuffer,
                                VkPipelineLayout,
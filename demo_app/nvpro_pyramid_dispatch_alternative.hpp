@@ -33,4 +33,15 @@ struct NvproPyramidGeneralDispatcherAdder
   static NvproPyramidGeneralDispatcherAdder NvproPyramidGeneralDispatcherAdder_##name \
   {#name, dispatcher};
 
+// Call after device creation: estimate how many threads the device
+// keeps resident at once (VK_NV_shader_sm_builtins or
+// VK_AMD_shader_core_properties), for getDeviceFillingWorkgroupCount.
+void initDeviceResidentThreads(VkPhysicalDevice physicalDevice);
+
+// About enough workgroups of the given size to fill the device, e.g.
+// for persistent-threads dispatchers; defaultCount if the device could
+// not tell (not initialized, or neither extension supported).
+uint32_t getDeviceFillingWorkgroupCount(uint32_t threadsPerWorkgroup,
+                                        uint32_t defaultCount);
+
 #endif
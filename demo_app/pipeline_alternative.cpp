@@ -21,6 +21,7 @@ PipelineAlternative pipelineAlternatives[] = {
     {"levels_1_5", {}, {"levels_1_5", "default"}},
     {"levels_1_6", {}, {"levels_1_6", "default"}},
     {"workgroup1024", {}, {"workgroup1024", "workgroup1024"}},
+    {"clustered", {}, {"clustered"}},
 
 /* Testing alternative configuration macros e.g. no hardware samplers */
     {"srgbShared",
@@ -30,6 +31,10 @@ PipelineAlternative pipelineAlternatives[] = {
     {"f16Shared", {"default", "", f16SharedBit}, {"default", "", f16SharedBit}},
     {"f16SharedGeneral", {"default", "", f16SharedBit}, {}},
     {"noBilinear", {}, {"default", "", noBilinearBit}},
+    {"lanczos", {"default", "", lanczosBit}, {"none"}},
+    {"kaiser", {"default", "", kaiserBit}, {"none"}},
+    {"alphaCoverage", {"default", "", alphaCoverageBit}, {}},
+    {"bilinearNp2", {"default", "", bilinearNp2Bit}, {}},
 #endif
 
 #if PIPELINE_ALTERNATIVES >= 3
@@ -40,6 +45,9 @@ PipelineAlternative pipelineAlternatives[] = {
     {"general2max1", {"general2max1", "general2"}, {}},
     {"general2s", {"general2s"}, {}},
     {"general2smax1", {"general2smax1", "general2s"}, {}},
+    {"persistent", {"persistent"}, {}},
+    {"persistent256", {"persistent256", "persistent"}, {}},
+    {"persistent1024", {"persistent1024", "persistent"}, {}},
 
 /* Testing more alternative fast pipelines. */
     {"quad3", {}, {"quad3"}},
@@ -52,7 +60,12 @@ PipelineAlternative pipelineAlternatives[] = {
     {"maybequadmin1", {}, {"maybequadmin1", "maybequad"}},
 
 /* Testing a lot of different workgroup and tile sizes. */
+#define NVPRO_PYRAMID_PY2(warps, tileWidth, tileHeight) \
+    {"py2_" #warps "_" #tileWidth "_" #tileHeight, \
+     {"py2_" #warps "_" #tileWidth "_" #tileHeight, "py2", 0, \
+      {warps, tileWidth, tileHeight}}},
      #include "py2_pipeline_alternatives.inc"
+#undef NVPRO_PYRAMID_PY2
 
 /* Incorrect pipelines, for testing purposes */
     {"null", {"null", "default"}, {"null", "default"}},
@@ -66,3 +79,38 @@ PipelineAlternative pipelineAlternatives[] = {
 
 const int pipelineAlternativeCount =
     sizeof(pipelineAlternatives) / sizeof(pipelineAlternatives[0]);
+
+int disableExtrasFastPipelines(uint32_t subgroupSize)
+{
+  if (subgroupSize == 32) return 0;
+  int disabledCount = 0;
+  for (int i = 0; i < pipelineAlternativeCount; ++i)
+  {
+    PipelineAlternativeDescription& fast = pipelineAlternatives[i].fastAlternative;
+    const std::string& dirname =
+        fast.basePipelineName.empty() ? fast.name : fast.basePipelineName;
+    if (dirname != "default" && dirname != "none")
+    {
+      fast = {"none"};
+      ++disabledCount;
+    }
+  }
+  return disabledCount;
+}
+
+int disableClusteredFastPipelines()
+{
+  int disabledCount = 0;
+  for (int i = 0; i < pipelineAlternativeCount; ++i)
+  {
+    PipelineAlternativeDescription& fast = pipelineAlternatives[i].fastAlternative;
+    const std::string& dirname =
+        fast.basePipelineName.empty() ? fast.name : fast.basePipelineName;
+    if (dirname == "clustered")
+    {
+      fast = {"none"};
+      ++disabledCount;
+    }
+  }
+  return disabledCount;
+}
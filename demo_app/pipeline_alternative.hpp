@@ -6,6 +6,8 @@
 #include <stdint.h>
 #include <string>
 
+#include "mipmap_storage.hpp"
+
 // Struct used to identify "pipeline alternatives", i.e. tested
 // alternate mipmap compute algorithms.
 //
@@ -20,11 +22,29 @@
 // default: don't use an alternative (use what is defined for to the lib user)
 // none:    don't use a pipeline at all (only valid for fastAlternative)
 // blit:    use blits instead of compute (only valid for generalAlternative)
+//
+// py2Config is only used by the "py2" general pipeline, whose
+// workgroup and tile sizes are specialization constants; each config is
+// its own py2_W_X_Y alternative name (based on "py2"), which selects the
+// matching dispatcher (see py2_pipeline_alternatives.inc).
+struct Py2Config
+{
+  uint32_t warps = 0, tileWidth = 0, tileHeight = 0;
+
+  bool operator<(const Py2Config& o) const
+  {
+    return warps != o.warps ? warps < o.warps :
+           tileWidth != o.tileWidth ? tileWidth < o.tileWidth :
+                                      tileHeight < o.tileHeight;
+  }
+};
+
 struct PipelineAlternativeDescription
 {
   std::string name             = "default";
   std::string basePipelineName = "";
   uint32_t    configBits       = 0;
+  Py2Config   py2Config        = {};
 
   inline std::string toString() const;
 };
@@ -37,9 +57,17 @@ struct PipelineAlternative
 
 namespace PipelineAlternativeDescriptionConfig
 {
-constexpr uint32_t srgbSharedBit = 1;
-constexpr uint32_t f16SharedBit  = 2;
-constexpr uint32_t noBilinearBit = 4;
+constexpr uint32_t srgbSharedBit    = 1;
+constexpr uint32_t f16SharedBit     = 2;
+constexpr uint32_t noBilinearBit    = 4;
+constexpr uint32_t lanczosBit       = 8;   // General pipeline only
+constexpr uint32_t kaiserBit        = 16;  // General pipeline only
+constexpr uint32_t alphaCoverageBit = 32;  // General pipeline only
+constexpr uint32_t instrumentBit    = 64;  // See cmdBindGenerateInstrumented
+constexpr uint32_t bilinearNp2Bit   = 128; // General pipeline only
+
+// Alpha test cutoff (out of 255) preserved if alphaCoverageBit is set.
+constexpr uint8_t alphaCoverageCutoff = 128;
 };
 
 inline std::string PipelineAlternativeDescription::toString() const
@@ -49,9 +77,59 @@ inline std::string PipelineAlternativeDescription::toString() const
   if (configBits & srgbSharedBit) result += " srgbSharedBit";
   if (configBits & f16SharedBit) result += " f16SharedBit";
   if (configBits & noBilinearBit) result += " noBilinearBit";
+  if (configBits & lanczosBit) result += " lanczosBit";
+  if (configBits & kaiserBit) result += " kaiserBit";
+  if (configBits & alphaCoverageBit) result += " alphaCoverageBit";
+  if (configBits & instrumentBit) result += " instrumentBit";
+  if (configBits & bilinearNp2Bit) result += " bilinearNp2Bit";
+  if (py2Config.warps != 0)
+  {
+    result += " " + std::to_string(py2Config.warps) + "_"
+              + std::to_string(py2Config.tileWidth) + "_"
+              + std::to_string(py2Config.tileHeight);
+  }
   return result;
 }
 
+// Return the wide kernel (wideKernelNone, wideKernelLanczos, or
+// wideKernelKaiser in mipmap_storage.hpp) selected by the config bits
+// of the alternative's general pipeline; needed to pick the CPU reference.
+inline int wideKernelFromConfigBits(uint32_t configBits)
+{
+  using namespace PipelineAlternativeDescriptionConfig;
+  return configBits & lanczosBit ? wideKernelLanczos :
+         configBits & kaiserBit  ? wideKernelKaiser :
+                                   wideKernelNone;
+}
+
+// Return the alpha coverage cutoff (0 if none) to pass to the CPU
+// reference, as selected by the config bits of the general pipeline.
+inline uint8_t alphaCoverageCutoffFromConfigBits(uint32_t configBits)
+{
+  using namespace PipelineAlternativeDescriptionConfig;
+  return configBits & alphaCoverageBit ? alphaCoverageCutoff : 0;
+}
+
+// Index of the CPU reference (wide kernel x alpha coverage) needed to
+// test an alternative's general pipeline, in [0, cpuReferenceCount):
+// the wide kernel, plus cpuReferenceAlphaCoverage if alpha coverage is
+// preserved.
+enum CpuReference : int
+{
+  cpuReferenceBox           = wideKernelNone,
+  cpuReferenceLanczos       = wideKernelLanczos,
+  cpuReferenceKaiser        = wideKernelKaiser,
+  cpuReferenceAlphaCoverage = wideKernelKaiser + 1,
+  cpuReferenceCount         = 2 * cpuReferenceAlphaCoverage
+};
+
+inline int cpuReferenceFromConfigBits(uint32_t configBits)
+{
+  return wideKernelFromConfigBits(configBits)
+         + (alphaCoverageCutoffFromConfigBits(configBits) != 0 ?
+                cpuReferenceAlphaCoverage : 0);
+}
+
 // List of pipeline alternatives compiled into the application.
 // 0th and 1st must be the nvpro_pyramid default shader and blit, respectively.
 extern PipelineAlternative pipelineAlternatives[];
@@ -59,4 +137,15 @@ extern const int           pipelineAlternativeCount;
 constexpr int              defaultPipelineAlternativeIdx = 0;
 constexpr int              blitPipelineAlternativeIdx    = 1;
 
+// The fast pipelines in extras/fast_pipelines may assume subgroup size
+// 32; unless that is the compute subgroup size, replace them with
+// "none" (general pipeline only) in pipelineAlternatives, before the
+// pipelines are created. Returns the number of alternatives changed.
+int disableExtrasFastPipelines(uint32_t subgroupSize);
+
+// Likewise replace the "clustered" fast pipelines; for devices without
+// VK_SUBGROUP_FEATURE_CLUSTERED_BIT, so that their rows time the general
+// pipeline rather than some silent substitute for clustered operations.
+int disableClusteredFastPipelines();
+
 #endif /* !VK_COMPUTE_MIPMAPS_DEMO_PIPELINE_ALTERNATIVE_HPP_ */
@@ -0,0 +1,162 @@
+// Copyright 2021 NVIDIA CORPORATION
+// SPDX-License-Identifier: Apache-2.0
+#include "pipeline_stats_json.hpp"
+
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+
+#include "make_compute_pipeline.hpp"
+
+namespace {
+
+// Quoted JSON string.
+std::string jsonString(const char* pText)
+{
+  std::string result = "\"";
+  for (const char* p = pText; *p != '\0'; ++p)
+  {
+    unsigned char c = static_cast<unsigned char>(*p);
+    switch (c)
+    {
+      case '"': result += "\\\""; break;
+      case '\\': result += "\\\\"; break;
+      case '\n': result += "\\n"; break;
+      case '\r': result += "\\r"; break;
+      case '\t': result += "\\t"; break;
+      default:
+        if (c < 0x20)
+        {
+          char escape[8];
+          snprintf(escape, sizeof escape, "\\u%04x", c);
+          result += escape;
+        }
+        else
+        {
+          result += char(c);
+        }
+    }
+  }
+  return result + "\"";
+}
+
+// Executables of the pipeline; empty unless it was created with the
+// given capture flag.
+std::vector<VkPipelineExecutablePropertiesKHR> getExecutables(
+    VkDevice              device,
+    VkPipeline            pipeline,
+    VkPipelineCreateFlags neededCaptureFlag)
+{
+  std::vector<VkPipelineExecutablePropertiesKHR> executables;
+  if (pipeline == VK_NULL_HANDLE
+      || (computePipelineCaptureFlags() & neededCaptureFlag) == 0)
+  {
+    return executables;
+  }
+  VkPipelineInfoKHR pipelineInfo = {VK_STRUCTURE_TYPE_PIPELINE_INFO_KHR,
+                                    nullptr, pipeline};
+  uint32_t          count        = 0;
+  NVVK_CHECK(vkGetPipelineExecutablePropertiesKHR(device, &pipelineInfo,
+                                                  &count, nullptr));
+  executables.resize(count, {VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_PROPERTIES_KHR});
+  NVVK_CHECK(vkGetPipelineExecutablePropertiesKHR(device, &pipelineInfo,
+                                                  &count, executables.data()));
+  executables.resize(count);
+  return executables;
+}
+
+}  // namespace
+
+std::string pipelineStatisticsJson(VkDevice device, VkPipeline pipeline)
+{
+  auto executables = getExecutables(
+      device, pipeline, VK_PIPELINE_CREATE_CAPTURE_STATISTICS_BIT_KHR);
+  std::string result;
+  for (uint32_t e = 0; e < uint32_t(executables.size()); ++e)
+  {
+    VkPipelineExecutableInfoKHR executableInfo = {
+        VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_INFO_KHR, nullptr, pipeline, e};
+    uint32_t count = 0;
+    NVVK_CHECK(vkGetPipelineExecutableStatisticsKHR(device, &executableInfo,
+                                                    &count, nullptr));
+    std::vector<VkPipelineExecutableStatisticKHR> statistics(
+        count, {VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_STATISTIC_KHR});
+    NVVK_CHECK(vkGetPipelineExecutableStatisticsKHR(
+        device, &executableInfo, &count, statistics.data()));
+    statistics.resize(count);
+
+    std::string prefix = executables.size() > 1 ?
+                             std::string(executables[e].name) + "/" : "";
+    for (const VkPipelineExecutableStatisticKHR& statistic : statistics)
+    {
+      char value[32];
+      switch (statistic.format)
+      {
+        case VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_BOOL32_KHR:
+          snprintf(value, sizeof value, "%s",
+                   statistic.value.b32 ? "true" : "false");
+          break;
+        case VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_INT64_KHR:
+          snprintf(value, sizeof value, "%lld",
+                   (long long)statistic.value.i64);
+          break;
+        case VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_UINT64_KHR:
+          snprintf(value, sizeof value, "%llu",
+                   (unsigned long long)statistic.value.u64);
+          break;
+        case VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_FLOAT64_KHR:
+          if (isfinite(statistic.value.f64))
+            snprintf(value, sizeof value, "%.17g", statistic.value.f64);
+          else
+            snprintf(value, sizeof value, "null");
+          break;
+        default:
+          continue;
+      }
+      result += std::string(result.empty() ? "{" : ", ")
+                + jsonString((prefix + statistic.name).c_str()) + ":" + value;
+    }
+  }
+  return result.empty() ? result : result + "}";
+}
+
+std::string pipelineInternalRepresentationsJson(VkDevice   device,
+                                                VkPipeline pipeline)
+{
+  auto executables = getExecutables(
+      device, pipeline,
+      VK_PIPELINE_CREATE_CAPTURE_INTERNAL_REPRESENTATIONS_BIT_KHR);
+  std::string result;
+  for (uint32_t e = 0; e < uint32_t(executables.size()); ++e)
+  {
+    VkPipelineExecutableInfoKHR executableInfo = {
+        VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_INFO_KHR, nullptr, pipeline, e};
+    uint32_t count = 0;
+    NVVK_CHECK(vkGetPipelineExecutableInternalRepresentationsKHR(
+        device, &executableInfo, &count, nullptr));
+    std::vector<VkPipelineExecutableInternalRepresentationKHR> representations(
+        count, {VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_INTERNAL_REPRESENTATION_KHR});
+    // First query the data sizes, then the data.
+    NVVK_CHECK(vkGetPipelineExecutableInternalRepresentationsKHR(
+        device, &executableInfo, &count, representations.data()));
+    representations.resize(count);
+    std::vector<std::vector<char>> data(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+      data[i].resize(representations[i].dataSize + 1u, '\0');
+      representations[i].pData = data[i].data();
+    }
+    NVVK_CHECK(vkGetPipelineExecutableInternalRepresentationsKHR(
+        device, &executableInfo, &count, representations.data()));
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+      if (!representations[i].isText) continue;  // Binary, skip.
+      std::string key = std::string(executables[e].name) + "/"
+                        + representations[i].name;
+      result += std::string(result.empty() ? "{" : ",\n ")
+                + jsonString(key.c_str()) + ":" + jsonString(data[i].data());
+    }
+  }
+  return result.empty() ? result : result + "}";
+}
@@ -0,0 +1,27 @@
+// Copyright 2021 NVIDIA CORPORATION
+// SPDX-License-Identifier: Apache-2.0
+#ifndef VK_COMPUTE_MIPMAPS_DEMO_PIPELINE_STATS_JSON_HPP_
+#define VK_COMPUTE_MIPMAPS_DEMO_PIPELINE_STATS_JSON_HPP_
+
+#include <string>
+#include <vulkan/vulkan.h>
+
+// JSON export of the VK_KHR_pipeline_executable_properties data of
+// pipelines created with the computePipelineCaptureFlags()
+// (make_compute_pipeline.hpp), for the benchmark json.
+
+// Statistics (register count, shared memory, spills, instruction
+// counts... whatever the driver reports) of the pipeline, as a JSON
+// object mapping statistic names to numbers (booleans for BOOL32
+// statistics). The names are prefixed with the executable name if the
+// pipeline has more than one executable. Empty string if none were
+// captured, or for VK_NULL_HANDLE.
+std::string pipelineStatisticsJson(VkDevice device, VkPipeline pipeline);
+
+// Textual internal representations (e.g. IR, assembly) of the
+// pipeline, as a JSON object mapping "executable name/representation
+// name" to strings. Empty string if none were captured.
+std::string pipelineInternalRepresentationsJson(VkDevice   device,
+                                                VkPipeline pipeline);
+
+#endif
@@ -0,0 +1,62 @@
+// Copyright 2021 NVIDIA CORPORATION
+// SPDX-License-Identifier: Apache-2.0
+#ifndef NVPRO_SAMPLES_VK_COMPUTE_MIPMAPS_SHADER_INCLUDE_CACHE_HPP_
+#define NVPRO_SAMPLES_VK_COMPUTE_MIPMAPS_SHADER_INCLUDE_CACHE_HPP_
+
+#include <initializer_list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "nvh/fileoperations.hpp"
+#include "nvvk/shadermodulemanager_vk.hpp"
+
+#include "search_paths.hpp"
+
+// Contents of the nvpro_pyramid library files included by the glsl
+// compiled at runtime (nvpro_pyramid.glsl and the preambles), loaded
+// from disk once and shared by the ShaderModuleManager of each compile
+// job, instead of each manager reading them again. Thread safe.
+class ShaderIncludeCache
+{
+  std::mutex m_mutex;
+
+  // Include name -> (file found, contents).
+  std::map<std::string, std::pair<std::string, std::string>> m_includes;
+
+public:
+  // Register the cached contents of the named nvpro_pyramid/ files as
+  // includes of the given manager, loading them on first use.
+  void registerIncludes(nvvk::ShaderModuleManager&         manager,
+                        std::initializer_list<const char*> names)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const char* pName : names)
+    {
+      auto it = m_includes.find(pName);
+      if (it == m_includes.end())
+      {
+        std::string filenameFound;
+        std::string content =
+            nvh::loadFile(std::string("nvpro_pyramid/") + pName, false,
+                          searchPaths, filenameFound, true);
+        it = m_includes.emplace(pName, std::make_pair(filenameFound, content))
+                 .first;
+      }
+      // Not found: leave it to the manager's search (and error report).
+      if (!it->second.second.empty())
+      {
+        manager.registerInclude(pName, it->second.first, it->second.second);
+      }
+    }
+  }
+};
+
+inline ShaderIncludeCache& shaderIncludeCache()
+{
+  static ShaderIncludeCache cache;
+  return cache;
+}
+
+#endif
@@ -0,0 +1,5 @@
+
+#include "nvpro_pyramid_dispatch_alternative.hpp"
+
+// Same tiles and workgroups as the default fast pipeline.
+NVPRO_PYRAMID_ADD_FAST_DISPATCHER(clustered, nvproPyramidDefaultFastDispatcher<4>)
@@ -0,0 +1,202 @@
+// Variant of the default fast pipeline (same tiles, teams, and
+// dispatcher) that computes the 2x2 and 4x4 reductions across the
+// threads of a team with clustered subgroup operations instead of
+// NVPRO_PYRAMID_SHUFFLE_XOR chains: the 4 or 16 samples of the lower
+// level are summed with subgroupClusteredAdd and scaled. This is only
+// valid because the demo's NVPRO_PYRAMID_REDUCE4 is a plain average
+// (the average of a 4x4 block equals the average of its 2x2
+// averages), so this is not a general replacement. Subgroup size must
+// be at least 16.
+//
+// Requires VK_SUBGROUP_FEATURE_CLUSTERED_BIT; the demo enables
+// GL_KHR_shader_subgroup_clustered for this pipeline, and falls back
+// to the general pipeline only (disableClusteredFastPipelines) on
+// devices without it, rather than timing some other reduction under
+// this name.
+
+layout(local_size_x = 256) in;
+
+// Same as the default fast pipeline; see diagrams there.
+shared NVPRO_PYRAMID_TYPE sharedTile_[16];
+
+// Average of in_ over each aligned cluster of lanes_ (4 or 16)
+// consecutive invocations; the result is the same in all of them.
+// Must be called in uniform control flow.
+NVPRO_PYRAMID_TYPE clusterAverage_(NVPRO_PYRAMID_TYPE in_, uint lanes_)
+{
+  if (lanes_ == 4u)
+  {
+    return subgroupClusteredAdd(in_, 4u) * 0.25;
+  }
+  return subgroupClusteredAdd(in_, 16u) * (1.0 / 16.0);
+}
+
+// Same interface as handleTile_ of the default fast pipeline, except
+// that levelCount_ == 4 requires sharedMemoryWrite_ (as it does in
+// practice there).
+void handleTile_(ivec2 srcTileOffset_, int inputLevel_, uint levelCount_,
+                 bool tileValid_, bool sharedMemoryWrite_,
+                 uint sharedMemoryIdx_)
+{
+  NVPRO_PYRAMID_TYPE sample00_, sample01_, sample10_, sample11_, out_;
+  int   dstLevel_ = inputLevel_ + 1;
+  ivec2 dstSubTile_;
+
+  uint teamMask_  = levelCount_ >= 3 ? 15 : levelCount_ == 2 ? 3 : 0;
+  uint idxInTeam_ = gl_LocalInvocationIndex & teamMask_;
+
+  if (levelCount_ == 4)
+  {
+    // Each thread reduces a 4x4 sub-tile of the input to a 2x2 sub-tile
+    // of inputLevel_ + 1 and its 1 sample of inputLevel_ + 2.
+    uint  xOffset_    = (idxInTeam_ & 1) << 2 | (idxInTeam_ & 4) << 1;
+    uint  yOffset_    = (idxInTeam_ & 2) << 1 | (idxInTeam_ & 8);
+    ivec2 srcSubTile_ = srcTileOffset_ + ivec2(xOffset_, yOffset_);
+    dstSubTile_       = srcSubTile_ >> 1;
+    if (tileValid_)
+    {
+      NVPRO_PYRAMID_LOAD_REDUCE4(srcSubTile_, inputLevel_, sample00_);
+      NVPRO_PYRAMID_STORE(dstSubTile_, dstLevel_, sample00_);
+      NVPRO_PYRAMID_LOAD_REDUCE4((srcSubTile_ + ivec2(0, 2)), inputLevel_, sample01_);
+      NVPRO_PYRAMID_STORE((dstSubTile_ + ivec2(0, 1)), dstLevel_, sample01_);
+      NVPRO_PYRAMID_LOAD_REDUCE4((srcSubTile_ + ivec2(2, 0)), inputLevel_, sample10_);
+      NVPRO_PYRAMID_STORE((dstSubTile_ + ivec2(1, 0)), dstLevel_, sample10_);
+      NVPRO_PYRAMID_LOAD_REDUCE4((srcSubTile_ + ivec2(2, 2)), inputLevel_, sample11_);
+      NVPRO_PYRAMID_STORE((dstSubTile_ + ivec2(1, 1)), dstLevel_, sample11_);
+      NVPRO_PYRAMID_REDUCE4(sample00_, sample01_, sample10_, sample11_, out_);
+    }
+    dstLevel_++;
+    dstSubTile_ >>= 1;
+    if (tileValid_)
+    {
+      NVPRO_PYRAMID_STORE(dstSubTile_, dstLevel_, out_);
+    }
+  }
+  else
+  {
+    // Each thread reduces a 2x2 sub-tile of the input.
+    uint  xOffset_    = (idxInTeam_ & 1) << 1 | (idxInTeam_ & 4);
+    uint  yOffset_    = (idxInTeam_ & 2) | (idxInTeam_ & 8) >> 1;
+    ivec2 srcSubTile_ = srcTileOffset_ + ivec2(xOffset_, yOffset_);
+    dstSubTile_       = srcSubTile_ >> 1;
+    if (tileValid_)
+    {
+      NVPRO_PYRAMID_LOAD_REDUCE4(srcSubTile_, inputLevel_, out_);
+      NVPRO_PYRAMID_STORE(dstSubTile_, dstLevel_, out_);
+    }
+  }
+
+  if (!sharedMemoryWrite_ && levelCount_ == 1) return;
+
+  // Both remaining levels directly from this thread's sample, so the
+  // two clustered reductions are independent of each other.
+  NVPRO_PYRAMID_TYPE quad_ = clusterAverage_(out_, 4u);
+  dstLevel_++;
+  dstSubTile_ >>= 1;
+  if (tileValid_ && 0 == (gl_LocalInvocationIndex & 3))
+  {
+    NVPRO_PYRAMID_STORE(dstSubTile_, dstLevel_, quad_);
+  }
+
+  if (!sharedMemoryWrite_ && levelCount_ == 2) return;
+
+  NVPRO_PYRAMID_TYPE team_ = clusterAverage_(out_, 16u);
+  dstLevel_++;
+  dstSubTile_ >>= 1;
+  if (tileValid_ && 0 == (gl_LocalInvocationIndex & 15))
+  {
+    NVPRO_PYRAMID_STORE(dstSubTile_, dstLevel_, team_);
+    if (sharedMemoryWrite_)
+    {
+      sharedTile_[sharedMemoryIdx_] = team_;
+    }
+  }
+}
+
+void nvproPyramidMain()
+{
+  // Same tile assignment as the default fast pipeline.
+  int   levelCount_      = NVPRO_PYRAMID_LEVEL_COUNT_;
+  int   inputLevel_      = NVPRO_PYRAMID_INPUT_LEVEL_;
+  ivec2 srcImageSize_    = NVPRO_PYRAMID_LEVEL_SIZE(inputLevel_);
+  uint  horizontalTiles_ = uint(srcImageSize_.x) >> levelCount_;
+  uint  verticalTiles_   = uint(srcImageSize_.y) >> levelCount_;
+  uint  teamSizeLog2_    = min(8u, levelCount_ * 2u - 2u);
+  uint  tileIndex_       = gl_GlobalInvocationID.x >> teamSizeLog2_;
+  uint  horizontalIndex_ = tileIndex_ % horizontalTiles_;
+  uint  verticalIndex_   = tileIndex_ / horizontalTiles_;
+  ivec2 tileOffset_ = ivec2(horizontalIndex_, verticalIndex_) << levelCount_;
+  bool  tileValid_  = verticalIndex_ < verticalTiles_;
+
+  if (levelCount_ <= 3)
+  {
+    handleTile_(tileOffset_, inputLevel_, levelCount_, tileValid_, false, 0);
+    return;
+  }
+
+  int   subLevelCount_ = levelCount_ == 6 ? 4 : 3;
+  int   subTeamMask_   = levelCount_ == 4 ? 3 : 15;
+  int   subTeamIdx_    = int(gl_GlobalInvocationID.x >> 4) & subTeamMask_;
+  ivec2 subTeamOffset_;
+  subTeamOffset_.x = (subTeamIdx_ & 1) << 3 | (subTeamIdx_ & 4) << 2;
+  subTeamOffset_.y = (subTeamIdx_ & 2) << 2 | (subTeamIdx_ & 8) << 1;
+  if (subLevelCount_ == 4)
+  {
+    subTeamOffset_ <<= 1;
+  }
+  uint sharedMemoryIndex_ = (gl_GlobalInvocationID.x >> 4u) & 15u;
+
+  handleTile_(tileOffset_ + subTeamOffset_, inputLevel_, subLevelCount_,
+              tileValid_, true, sharedMemoryIndex_);
+
+  inputLevel_ += subLevelCount_;
+  levelCount_ -= subLevelCount_;
+  barrier();
+
+  // Remaining 1 or 2 levels, by the first 4 threads (one cluster).
+  if (gl_LocalInvocationIndex < 4)
+  {
+    NVPRO_PYRAMID_TYPE in00_, in01_, in10_, in11_, out_;
+    uint smemOffset_ = gl_LocalInvocationIndex * 4u;
+    if (levelCount_ == 1)
+    {
+      tileIndex_       = gl_WorkGroupID.x * 4 + gl_LocalInvocationIndex;
+      horizontalIndex_ = tileIndex_ % horizontalTiles_;
+      verticalIndex_   = tileIndex_ / horizontalTiles_;
+      if (verticalIndex_ < verticalTiles_)
+      {
+        in00_ = sharedTile_[smemOffset_ + 0u];
+        in10_ = sharedTile_[smemOffset_ + 1u];
+        in01_ = sharedTile_[smemOffset_ + 2u];
+        in11_ = sharedTile_[smemOffset_ + 3u];
+        NVPRO_PYRAMID_REDUCE4(in00_, in01_, in10_, in11_, out_);
+        NVPRO_PYRAMID_STORE(ivec2(horizontalIndex_, verticalIndex_),
+                            (inputLevel_ + 1), out_);
+      }
+    }
+    else  // levelCount_ == 2, uniform for the 4 threads.
+    {
+      tileIndex_       = gl_WorkGroupID.x;
+      horizontalIndex_ = tileIndex_ % horizontalTiles_;
+      verticalIndex_   = tileIndex_ / horizontalTiles_;
+      tileOffset_      = ivec2(horizontalIndex_, verticalIndex_);
+      if (verticalIndex_ < verticalTiles_)
+      {
+        in00_ = sharedTile_[smemOffset_ + 0u];
+        in10_ = sharedTile_[smemOffset_ + 1u];
+        in01_ = sharedTile_[smemOffset_ + 2u];
+        in11_ = sharedTile_[smemOffset_ + 3u];
+        NVPRO_PYRAMID_REDUCE4(in00_, in01_, in10_, in11_, out_);
+        ivec2 threadOffset_ = ivec2(gl_LocalInvocationIndex & 1,
+                                    (gl_LocalInvocationIndex & 2) >> 1);
+        NVPRO_PYRAMID_STORE((tileOffset_ * 2 + threadOffset_),
+                            (inputLevel_ + 1), out_);
+        out_ = clusterAverage_(out_, 4u);
+        if (gl_LocalInvocationIndex == 0u)
+        {
+          NVPRO_PYRAMID_STORE(tileOffset_, (inputLevel_ + 2), out_);
+        }
+      }
+    }
+  }
+}
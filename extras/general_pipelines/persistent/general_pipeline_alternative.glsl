@@ -1,8 +1,25 @@
-// General-case shader for generating 1 or 2 levels of the mip pyramid.
-// When generating 1 level, each workgroup handles up to 128 samples of the
-// output mip level. When generating 2 levels, each workgroup handles
-// a 8x8 tile of the last (2nd) output mip level, generating up to
-// 17x17 samples of the intermediate (1st) output mip level along the way.
+// Persistent-threads variant of the general-case shader for generating
+// 1 or 2 levels of the mip pyramid.
+//
+// Generating 1 level is unchanged: each workgroup handles up to 128
+// samples of the output mip level.
+//
+// When generating 2 levels, the work is still cut into 8x8 tiles of
+// the last (2nd) output mip level, but instead of launching one
+// workgroup per tile, the dispatcher launches a limited number of
+// workgroups (typically about enough to fill the device; this is the
+// occupancy tuning knob, see persistent.cpp). Each workgroup loops,
+// pulling the next tile from a global atomic work counter, until all
+// tiles are handled. Tiles are handed out in vertical strips a few
+// tiles wide, so that consecutively-handled tiles are neighbours and
+// the input halo they share is likely still in cache.
+//
+// The work counters live in the storage buffer at set=2, binding=0;
+// it must be zero-initialized before first use. The counters are
+// reset by the last workgroup to finish, so no host-side reset is
+// needed between dispatches; however, successive dispatches that
+// share the same input level must be separated by a barrier that
+// makes these shader writes visible.
 //
 // Dispatch with y, z = 1
 layout(local_size_x = 4 * 32) in;
@@ -279,6 +296,40 @@ void fillLastTile_(ivec2 dstTileCoord_, bool boundsCheck_)
 
 
 
+
+
+
+// Counters used for handing out tiles. There is one pair of counters
+// per input level, so that dispatches of the same pyramid never share
+// counters. Counter [2*level] is the index of the next tile to hand
+// out; counter [2*level+1] counts the workgroups that are done.
+layout(set=2, binding=0) coherent buffer NvproPyramidPersistentCounters_
+{
+  uint persistentCounters_[32];
+};
+
+// Tile index handed out to this workgroup, broadcast from thread 0.
+shared uint sharedWorkIdx_;
+
+// Width, in tiles, of the vertical strips in which tiles are handed out.
+#define NVPRO_PYRAMID_PERSISTENT_STRIP_WIDTH_ 4u
+
+// Convert the linear work index to the 2D index of the tile to handle.
+// Tiles are visited row-by-row within vertical strips
+// NVPRO_PYRAMID_PERSISTENT_STRIP_WIDTH_ tiles wide (the final strip may
+// be narrower), and strip-by-strip from left to right.
+ivec2 tileIdxFromWorkIdx_(uint workIdx_, ivec2 tileCount_)
+{
+  uint stripWidth_      = NVPRO_PYRAMID_PERSISTENT_STRIP_WIDTH_;
+  uint stripTiles_      = stripWidth_ * uint(tileCount_.y);
+  uint stripIdx_        = workIdx_ / stripTiles_;
+  uint idxInStrip_      = workIdx_ % stripTiles_;
+  uint stripLeft_       = stripIdx_ * stripWidth_;
+  uint thisStripWidth_  = min(stripWidth_, uint(tileCount_.x) - stripLeft_);
+  return ivec2(stripLeft_ + idxInStrip_ % thisStripWidth_,
+               idxInStrip_ / thisStripWidth_);
+}
+
 void nvproPyramidMain()
 {
   int inputLevel_ = int(NVPRO_PYRAMID_INPUT_LEVEL_);
@@ -300,41 +351,60 @@ void nvproPyramidMain()
   }
   else  // Handling two levels.
   {
-    // Assign a 8x8 tile of mip level inputLevel_ + 2 to this workgroup.
+    // Count the 8x8 tiles of mip level inputLevel_ + 2.
     int   level2_     = inputLevel_ + 2;
     ivec2 level2Size_ = NVPRO_PYRAMID_LEVEL_SIZE(level2_);
     ivec2 tileCount_;
-    tileCount_.x   = int(uint(level2Size_.x + 7) / 8u);
-    tileCount_.y   = int(uint(level2Size_.y + 7) / 8u);
-    ivec2 tileIdx_ = ivec2(gl_WorkGroupID.x % uint(tileCount_.x),
-                           gl_WorkGroupID.x / uint(tileCount_.x));
-    uint localIdx_ = gl_LocalInvocationIndex;
-
-    // Determine if bounds checking is needed; this is only the case
-    // for tiles at the right or bottom fringe that might be cut off
-    // by the image border. Note that later, I use if statements rather
-    // than passing boundsCheck_ directly to convince the compiler
-    // to inline everything.
-    bool boundsCheck_ = tileIdx_.x >= tileCount_.x - 1 ||
-                        tileIdx_.y >= tileCount_.y - 1;
+    tileCount_.x    = int(uint(level2Size_.x + 7) / 8u);
+    tileCount_.y    = int(uint(level2Size_.y + 7) / 8u);
+    uint totalTiles_ = uint(tileCount_.x) * uint(tileCount_.y);
+    uint counterIdx_ = 2u * uint(inputLevel_);
+    uint localIdx_   = gl_LocalInvocationIndex;
 
-    if (boundsCheck_)
+    while (true)
     {
-      // Compute the tile in level inputLevel_ + 1 that's needed to
-      // compute the above 8x8 tile.
-      fillIntermediateTile_(tileIdx_ * 2 * ivec2(8, 8), true);
+      // Grab the next tile. The loop exit condition is read from
+      // shared memory, so it is uniform across the workgroup.
+      if (localIdx_ == 0u)
+      {
+        sharedWorkIdx_ = atomicAdd(persistentCounters_[counterIdx_], 1u);
+      }
       barrier();
+      uint workIdx_ = sharedWorkIdx_;
+      if (workIdx_ >= totalTiles_) break;
+      ivec2 tileIdx_ = tileIdxFromWorkIdx_(workIdx_, tileCount_);
+
+      // Same as the default general pipeline, see nvpro_pyramid.glsl.
+      bool boundsCheck_ = tileIdx_.x >= tileCount_.x - 1 ||
+                          tileIdx_.y >= tileCount_.y - 1;
+      if (boundsCheck_)
+      {
+        fillIntermediateTile_(tileIdx_ * 2 * ivec2(8, 8), true);
+        barrier();
+        fillLastTile_(tileIdx_ * ivec2(8, 8), true);
+      }
+      else
+      {
+        fillIntermediateTile_(tileIdx_ * 2 * ivec2(8, 8), false);
+        barrier();
+        fillLastTile_(tileIdx_ * ivec2(8, 8), false);
+      }
 
-      // Compute the inputLevel_ + 2 tile of size 8x8, loading
-      // inupts from shared memory.
-      fillLastTile_(tileIdx_ * ivec2(8, 8), true);
+      // Wait for sharedLevel_ and sharedWorkIdx_ to be free for re-use.
+      barrier();
     }
-    else
+
+    // The last workgroup to finish resets the counters for the next
+    // dispatch. Every workgroup has already done its final (failing)
+    // fetch from the work counter by this point.
+    if (localIdx_ == 0u)
     {
-      // Same with no bounds checking.
-      fillIntermediateTile_(tileIdx_ * 2 * ivec2(8, 8), false);
-      barrier();
-      fillLastTile_(tileIdx_ * ivec2(8, 8), false);
+      uint finished_ = atomicAdd(persistentCounters_[counterIdx_ + 1u], 1u);
+      if (finished_ == gl_NumWorkGroups.x - 1u)
+      {
+        atomicExchange(persistentCounters_[counterIdx_], 0u);
+        atomicExchange(persistentCounters_[counterIdx_ + 1u], 0u);
+      }
     }
   }
 }
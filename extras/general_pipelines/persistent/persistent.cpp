@@ -0,0 +1,58 @@
+#include "nvpro_pyramid_dispatch_alternative.hpp"
+
+// Dispatcher for the persistent-threads general pipeline.
+// PersistentWorkgroups is the occupancy tuning knob: the maximum
+// number of workgroups launched when generating 2 levels. Aim for
+// (number of SMs) * (resident workgroups per SM); beyond that, extra
+// workgroups just wait for a free slot like in the default pipeline.
+// 0 uses about enough workgroups to fill the device, as far as it tells
+// (getDeviceFillingWorkgroupCount), else 512.
+template <uint32_t PersistentWorkgroups>
+static uint32_t persistent_dispatch(VkCommandBuffer          cmdBuf,
+                                    VkPipelineLayout         layout,
+                                    uint32_t                 pushConstantOffset,
+                                    VkPipeline               pipelineIfNeeded,
+                                    const NvproPyramidState& state)
+{
+  constexpr uint32_t MaxLevels = 2, Warps = 4, TileWidth = 8, TileHeight = 8;
+
+  if (pipelineIfNeeded)
+  {
+    vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE,
+                      pipelineIfNeeded);
+  }
+  uint32_t levels =
+      state.remainingLevels >= MaxLevels ? MaxLevels : state.remainingLevels;
+  uint32_t srcLevel = state.currentLevel;
+  uint32_t pc       = srcLevel << nvproPyramidInputLevelShift | levels;
+  vkCmdPushConstants(cmdBuf, layout, VK_SHADER_STAGE_COMPUTE_BIT,
+                     pushConstantOffset, sizeof pc, &pc);
+  uint32_t dstWidth  = state.currentX >> levels;
+  dstWidth           = dstWidth ? dstWidth : 1u;
+  uint32_t dstHeight = state.currentY >> levels;
+  dstHeight          = dstHeight ? dstHeight : 1u;
+
+  if (levels == 1u)
+  {
+    // Each thread writes one sample.
+    uint32_t samples = dstWidth * dstHeight;
+    uint32_t threads = Warps * 32u;
+    vkCmdDispatch(cmdBuf, (samples + (threads - 1u)) / threads, 1u, 1u);
+  }
+  else
+  {
+    // Workgroups loop over tiles; no need for more workgroups than tiles.
+    uint32_t horizontalTiles = (dstWidth + (TileWidth - 1)) / TileWidth;
+    uint32_t verticalTiles   = (dstHeight + (TileHeight - 1)) / TileHeight;
+    uint32_t tiles           = horizontalTiles * verticalTiles;
+    uint32_t workgroups      = PersistentWorkgroups != 0 ?
+                                   PersistentWorkgroups :
+                                   getDeviceFillingWorkgroupCount(Warps * 32u, 512u);
+    vkCmdDispatch(cmdBuf, tiles < workgroups ? tiles : workgroups, 1u, 1u);
+  }
+  return levels;
+}
+
+NVPRO_PYRAMID_ADD_GENERAL_DISPATCHER(persistent, persistent_dispatch<0>)
+NVPRO_PYRAMID_ADD_GENERAL_DISPATCHER(persistent256, persistent_dispatch<256>)
+NVPRO_PYRAMID_ADD_GENERAL_DISPATCHER(persistent1024, persistent_dispatch<1024>)
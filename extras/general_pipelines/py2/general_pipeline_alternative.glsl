@@ -1,16 +1,27 @@
-// General-case shader for generating 1 or 2 levels of the mip pyramid.
-// When generating 1 level, each workgroup handles up to 320 samples of the
-// output mip level. When generating 2 levels, each workgroup handles
-// a 20x20 tile of the last (2nd) output mip level, generating up to
-// 41x41 samples of the intermediate (1st) output mip level along the way.
+// General-case shader for generating 1 or 2 levels of the mip pyramid,
+// with the workgroup and tile size chosen by specialization constants
+// (formerly generated as one py2_W_X_Y shader per configuration).
+// When generating 1 level, each workgroup handles up to py2Threads_ samples
+// of the output mip level. When generating 2 levels, each workgroup
+// handles a py2TileWidth_ x py2TileHeight_ tile of the last (2nd) output
+// mip level, generating up to (2 * py2TileWidth_ + 1) x (2 * py2TileHeight_ + 1)
+// samples of the intermediate (1st) output mip level along the way.
+//
+// Specialization constants (see Py2Config; must match the dispatcher):
+//   0: threads per workgroup (32 * warps)
+//   1: tile width, 2: tile height; 2 * tile + 1 must not exceed the threads.
 //
 // Dispatch with y, z = 1
-layout(local_size_x = 10 * 32) in;
+layout(local_size_x_id = 0) in;
+layout(constant_id = 1) const int py2TileWidth_  = 8;
+layout(constant_id = 2) const int py2TileHeight_ = 8;
+const int py2Threads_ = int(gl_WorkGroupSize.x);
 
 // When generating 2 levels, the results of generating the intermediate
 // level (first level generated) are cached here; this is the input tile
-// needed to generate the 20x20 tile of the second level generated.
-shared NVPRO_PYRAMID_SHARED_TYPE sharedLevel_[41][41]; // [y][x]
+// needed to generate the tile of the second level generated.
+shared NVPRO_PYRAMID_SHARED_TYPE
+    sharedLevel_[py2TileHeight_ * 2 + 1][py2TileWidth_ * 2 + 1]; // [y][x]
 
 ivec2 kernelSizeFromInputSize_(ivec2 inputSize_)
 {
@@ -130,6 +141,36 @@ loadSample_(ivec2 srcCoord_, int srcLevel_, bool loadFromShared_)
 
 
 
+// Split filling a width_ x height_ tile among the workgroup's threads,
+// as columns (a tall sliding window) or rows (a wide sliding window),
+// whichever keeps more threads busy. Each thread handles the
+// iterations_ samples at initThreadOffset_ + i * step_.
+// With constant tile sizes, this all folds to constants.
+void fillTileVars_(int width_, int height_, out ivec2 initThreadOffset_,
+                   out ivec2 step_, out int iterations_)
+{
+  int localIdx_         = int(gl_LocalInvocationIndex);
+  int candidateColumns_ = py2Threads_ / height_;
+  int candidateRows_    = py2Threads_ / width_;
+
+  if (candidateColumns_ * height_ > candidateRows_ * width_)
+  {
+    initThreadOffset_ = ivec2(localIdx_ / height_, localIdx_ % height_);
+    step_             = ivec2(candidateColumns_, 0);
+    iterations_       = width_ / candidateColumns_;
+    if (localIdx_ < (width_ % candidateColumns_) * height_) ++iterations_;
+    if (localIdx_ >= candidateColumns_ * height_) iterations_ = 0;
+  }
+  else
+  {
+    initThreadOffset_ = ivec2(localIdx_ % width_, localIdx_ / width_);
+    step_             = ivec2(0, candidateRows_);
+    iterations_       = height_ / candidateRows_;
+    if (localIdx_ < (height_ % candidateRows_) * width_) ++iterations_;
+    if (localIdx_ >= candidateRows_ * width_) iterations_ = 0;
+  }
+}
+
 // Compute and write out (to the 1st mip level generated) the samples
 // at coordinates
 //     initDstCoord_,
@@ -182,15 +223,14 @@ void intermediateLevelLoop_(ivec2 initDstCoord_,
 // Function for the workgroup that handles filling the intermediate level
 // (caching it in shared memory as well).
 //
-// We need somewhere from 40x40 to 41x41 samples, depending
-// on what the kernel size for the 2nd mip level generation will be.
+// We need somewhere from (2 * tile) to (2 * tile + 1) samples in each
+// dimension, depending on what the kernel size for the 2nd mip level
+// generation will be.
 //
 // dstTileCoord_ : upper left coordinate of the tile to generate.
 // boundsCheck_  : whether to skip samples that are out-of-bounds.
 void fillIntermediateTile_(ivec2 dstTileCoord_, bool boundsCheck_)
 {
-  uint localIdx_ = int(gl_LocalInvocationIndex);
-
   ivec2 initThreadOffset_;
   ivec2 step_;
   int   iterations_;
@@ -199,38 +239,31 @@ void fillIntermediateTile_(ivec2 dstTileCoord_, bool boundsCheck_)
       NVPRO_PYRAMID_LEVEL_SIZE((int(NVPRO_PYRAMID_INPUT_LEVEL_) + 1));
   ivec2 futureKernelSize_ = kernelSizeFromInputSize_(dstImageSize_);
 
+  // Branch per kernel size so each case folds to constants.
   if (futureKernelSize_.x == 3)
   {
     if (futureKernelSize_.y == 3)
     {
-      // Fill in 5 41x7 steps and 1 41x6 step (33 idle threads)
-      initThreadOffset_ = ivec2(localIdx_ % 41u, localIdx_ / 41u);
-      step_             = ivec2(0, 7);
-      iterations_       = localIdx_ >= 7 * 41 ? 0 : localIdx_ < 6 * 41 ? 6 : 5;
+      fillTileVars_(py2TileWidth_ * 2 + 1, py2TileHeight_ * 2 + 1,
+                    initThreadOffset_, step_, iterations_);
     }
     else  // Future 3x[2,1] kernel
     {
-      // Fill in 5 8x40 steps and 1 1x40 step
-      initThreadOffset_ = ivec2(localIdx_ / 40u, localIdx_ % 40u);
-      step_             = ivec2(8, 0);
-      iterations_       = localIdx_ < 1 * 40 ? 6 : 5;
+      fillTileVars_(py2TileWidth_ * 2 + 1, py2TileHeight_ * 2,
+                    initThreadOffset_, step_, iterations_);
     }
   }
   else
   {
     if (futureKernelSize_.y == 3)
     {
-      // Fill in 5 40x8 steps and 1 40x1 step
-      initThreadOffset_ = ivec2(localIdx_ % 40u, localIdx_ / 40u);
-      step_             = ivec2(0, 8);
-      iterations_       = localIdx_ < 1 * 40 ? 6 : 5;
+      fillTileVars_(py2TileWidth_ * 2, py2TileHeight_ * 2 + 1,
+                    initThreadOffset_, step_, iterations_);
     }
     else
     {
-      // Fill in 5 40x8 steps
-      initThreadOffset_ = ivec2(localIdx_ % 40u, localIdx_ / 40u);
-      step_             = ivec2(0, 8);
-      iterations_       = 5;
+      fillTileVars_(py2TileWidth_ * 2, py2TileHeight_ * 2,
+                    initThreadOffset_, step_, iterations_);
     }
   }
 
@@ -240,7 +273,7 @@ void fillIntermediateTile_(ivec2 dstTileCoord_, bool boundsCheck_)
 
 
 
- // Compute and write out (to the 2nd mip level generated) the samples
+// Compute and write out (to the 2nd mip level generated) the samples
 // at coordinates
 //     initDstCoord_,
 //     initDstCoord_ + step_, ...
@@ -284,22 +317,19 @@ void lastLevelLoop_(ivec2 initSharedSrcCoord_,
 
 // Function for the workgroup that handles filling the last level tile
 // (2nd level after the original input level), using as input the
-// tile in shared memory.
+// tile in shared memory. Tiles larger than the workgroup take more
+// than one iteration per thread.
 //
 // dstTileCoord_ : upper left coordinate of the tile to generate.
 // boundsCheck_  : whether to skip samples that are out-of-bounds.
 void fillLastTile_(ivec2 dstTileCoord_, bool boundsCheck_)
 {
-  uint localIdx_ = int(gl_LocalInvocationIndex);
-
   ivec2 initThreadOffset_;
   ivec2 step_;
   int   iterations_;
 
-  // Fill in 1 20x16 steps and 1 20x4 step
-  initThreadOffset_ = ivec2(localIdx_ % 20u, localIdx_ / 20u);
-  step_             = ivec2(0, 16);
-  iterations_       = localIdx_ < 4 * 20 ? 2 : 1;
+  fillTileVars_(py2TileWidth_, py2TileHeight_,
+                initThreadOffset_, step_, iterations_);
 
   lastLevelLoop_(initThreadOffset_ * 2, dstTileCoord_ + initThreadOffset_,
                  step_, iterations_, boundsCheck_);
@@ -328,12 +358,13 @@ void nvproPyramidMain()
   }
   else  // Handling two levels.
   {
-    // Assign a 20x20 tile of mip level inputLevel_ + 2 to this workgroup.
+    // Assign a tile of mip level inputLevel_ + 2 to this workgroup.
     int   level2_     = inputLevel_ + 2;
     ivec2 level2Size_ = NVPRO_PYRAMID_LEVEL_SIZE(level2_);
+    ivec2 tileSize_   = ivec2(py2TileWidth_, py2TileHeight_);
     ivec2 tileCount_;
-    tileCount_.x   = int(uint(level2Size_.x + 19) / 20u);
-    tileCount_.y   = int(uint(level2Size_.y + 19) / 20u);
+    tileCount_.x   = int(uint(level2Size_.x + tileSize_.x - 1) / uint(tileSize_.x));
+    tileCount_.y   = int(uint(level2Size_.y + tileSize_.y - 1) / uint(tileSize_.y));
     ivec2 tileIdx_ = ivec2(gl_WorkGroupID.x % uint(tileCount_.x),
                            gl_WorkGroupID.x / uint(tileCount_.x));
     uint localIdx_ = gl_LocalInvocationIndex;
@@ -349,20 +380,20 @@ void nvproPyramidMain()
     if (boundsCheck_)
     {
       // Compute the tile in level inputLevel_ + 1 that's needed to
-      // compute the above 20x20 tile.
-      fillIntermediateTile_(tileIdx_ * 2 * ivec2(20, 20), true);
+      // compute the above tile.
+      fillIntermediateTile_(tileIdx_ * 2 * tileSize_, true);
       barrier();
 
-      // Compute the inputLevel_ + 2 tile of size 20x20, loading
+      // Compute the inputLevel_ + 2 tile, loading
       // inupts from shared memory.
-      fillLastTile_(tileIdx_ * ivec2(20, 20), true);
+      fillLastTile_(tileIdx_ * tileSize_, true);
     }
     else
     {
       // Same with no bounds checking.
-      fillIntermediateTile_(tileIdx_ * 2 * ivec2(20, 20), false);
+      fillIntermediateTile_(tileIdx_ * 2 * tileSize_, false);
       barrier();
-      fillLastTile_(tileIdx_ * ivec2(20, 20), false);
+      fillLastTile_(tileIdx_ * tileSize_, false);
     }
   }
 }
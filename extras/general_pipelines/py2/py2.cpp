@@ -1,21 +1,24 @@
-#ifndef VK_COMPUTE_MIPMAPS_PY2_DISPATCH_IMPL_
-#define VK_COMPUTE_MIPMAPS_PY2_DISPATCH_IMPL_
+#include "nvpro_pyramid_dispatch_alternative.hpp"
 
-template <uint32_t Warps, uint32_t TileWidth, uint32_t TileHeight, uint32_t MaxLevels = 2>
-inline uint32_t py2_dispatch_impl(VkCommandBuffer          cmdBuf,
-                                  VkPipelineLayout         layout,
-                                  uint32_t                 pushConstantOffset,
-                                  VkPipeline               pipelineIfNeeded,
-                                  const NvproPyramidState& state)
+// Dispatcher for the specialization constant py2 general pipeline; one
+// instance per configuration, matching the specialization constants
+// (Py2Config) of the py2_Warps_TileWidth_TileHeight alternative.
+template <uint32_t Warps, uint32_t TileWidth, uint32_t TileHeight>
+static uint32_t py2_dispatch(VkCommandBuffer          cmdBuf,
+                             VkPipelineLayout         layout,
+                             uint32_t                 pushConstantOffset,
+                             VkPipeline               pipelineIfNeeded,
+                             const NvproPyramidState& state)
 {
+  static_assert(Warps != 0 && TileWidth != 0 && TileHeight != 0,
+                "empty py2 workgroup or tile");
+
   if (pipelineIfNeeded)
   {
     vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE,
                       pipelineIfNeeded);
   }
-  static_assert(MaxLevels <= 2u && MaxLevels != 0, "can do 1 or 2 levels");
-  uint32_t levels =
-      state.remainingLevels >= MaxLevels ? MaxLevels : state.remainingLevels;
+  uint32_t levels   = state.remainingLevels >= 2u ? 2u : state.remainingLevels;
   uint32_t srcLevel = state.currentLevel;
   uint32_t pc       = srcLevel << nvproPyramidInputLevelShift | levels;
   vkCmdPushConstants(cmdBuf, layout, VK_SHADER_STAGE_COMPUTE_BIT,
@@ -42,4 +45,9 @@ inline uint32_t py2_dispatch_impl(VkCommandBuffer          cmdBuf,
   return levels;
 }
 
-#endif
+#define NVPRO_PYRAMID_PY2(warps, tileWidth, tileHeight) \
+  NVPRO_PYRAMID_ADD_GENERAL_DISPATCHER( \
+      py2_##warps##_##tileWidth##_##tileHeight, \
+      (py2_dispatch<warps, tileWidth, tileHeight>))
+#include "py2_pipeline_alternatives.inc"
+#undef NVPRO_PYRAMID_PY2
@@ -1,6 +0,0 @@
-#include "nvpro_pyramid_dispatch_alternative.hpp"
-
-#include "../py2_dispatch_impl.hpp"
-
-NVPRO_PYRAMID_ADD_GENERAL_DISPATCHER(py2_10_12_12,
-                                     (py2_dispatch_impl<10, 12, 12>))
@@ -1,499 +0,0 @@
-#! /usr/bin/env python3
-# Script for generating a general_pipeline_alternative.glsl that
-# handles filling two mip levels, for the given warps-per-workgroup
-# and 2nd level mipmap tile size per workgroup.
-# Hard to explain, but hopefully the output is more sensible.
-from sys import argv, exit, stderr
-import os
-from pathlib import Path
-
-os.chdir(os.path.split(__file__)[0])
-
-try:
-    warps = int(argv[1])
-    threads = warps * 32
-    tile_2_x = int(argv[2])
-    tile_2_y = int(argv[3])
-    tile_1_x = tile_2_x * 2 + 1
-    tile_1_y = tile_2_y * 2 + 1
-    name = f"py2_{warps}_{tile_2_x}_{tile_2_y}"
-    if tile_2_x != tile_2_y:
-        print("Warning: not tested for non-square tiles, probably buggy.",
-              file=stderr)
-except Exception as e:
-    print(e)
-    print("args: [warps] [tile x] [tile y]")
-    exit(1)
-
-from pathlib import Path
-Path(f"./{name}").mkdir(parents=True, exist_ok=True)
-general_pipeline_alternative_file = open(
-    f"./{name}/general_pipeline_alternative.glsl", 'w', encoding='utf-8')
-dispatcher_file = open(
-    f"./{name}/{name}.cpp", 'w', encoding='utf-8')
-
-
-def fill_tile_vars(width, height, indentation):
-    spaces = " " * indentation
-    candidate_columns = threads // height
-    candidate_rows = threads // width
-
-    # Candidate 1: fill horizontally (imagine a tall sliding window)
-    if candidate_columns * height > candidate_rows * width:
-        initThreadOffset = "ivec2(localIdx_ / %iu, localIdx_ %% %iu)" % (height, height)
-        step = "ivec2(%i, 0)" % candidate_columns
-        base_iterations = width // candidate_columns
-        remainder_columns = width % candidate_columns
-        comment_text = f"Fill in {base_iterations} {candidate_columns}x{height} steps"
-
-        iterations = str(base_iterations)
-        if remainder_columns != 0:
-            comment_text += f" and 1 {remainder_columns}x{height} step"
-            iterations = f"localIdx_ < {remainder_columns} * {height} ? {base_iterations + 1} : {iterations}"
-        if candidate_columns * height != threads:
-            idle_threads = threads - candidate_columns * height
-            comment_text += f" ({idle_threads} idle threads)"
-            iterations = f"localIdx_ >= {candidate_columns} * {height} ? 0 : {iterations}"
-
-    # Candidate 2: fill vertically (imagine a wide sliding window)
-    else:
-        initThreadOffset = "ivec2(localIdx_ %% %iu, localIdx_ / %iu)" % (width, width)
-        step = "ivec2(0, %i)" % candidate_rows
-        base_iterations = height // candidate_rows
-        remainder_rows = height % candidate_rows
-        comment_text = f"Fill in {base_iterations} {width}x{candidate_rows} steps"
-
-        iterations = str(base_iterations)
-        if remainder_rows != 0:
-            comment_text += f" and 1 {width}x{remainder_rows} step"
-            iterations = f"localIdx_ < {remainder_rows} * {width} ? {base_iterations + 1} : {iterations}"
-        if candidate_rows * width != threads:
-            idle_threads = threads - candidate_rows * width
-            comment_text += f" ({idle_threads} idle threads)"
-            iterations = f"localIdx_ >= {candidate_rows} * {width} ? 0 : {iterations}"
-
-    return f"""\
-{spaces}// {comment_text}
-{spaces}initThreadOffset_ = {initThreadOffset};
-{spaces}step_             = {step};
-{spaces}iterations_       = {iterations};"""
-
-source_code = f"""\
-// General-case shader for generating 1 or 2 levels of the mip pyramid.
-// When generating 1 level, each workgroup handles up to {threads} samples of the
-// output mip level. When generating 2 levels, each workgroup handles
-// a {tile_2_x}x{tile_2_y} tile of the last (2nd) output mip level, generating up to
-// {tile_1_x}x{tile_1_y} samples of the intermediate (1st) output mip level along the way.
-//
-// Dispatch with y, z = 1
-layout(local_size_x = {warps} * 32) in;
-
-// When generating 2 levels, the results of generating the intermediate
-// level (first level generated) are cached here; this is the input tile
-// needed to generate the {tile_2_x}x{tile_2_y} tile of the second level generated.
-shared NVPRO_PYRAMID_SHARED_TYPE sharedLevel_[{tile_1_y}][{tile_1_x}]; // [y][x]
-
-ivec2 kernelSizeFromInputSize_(ivec2 inputSize_)
-{{
-  return ivec2(inputSize_.x == 1 ? 1 : (2 | (inputSize_.x & 1)),
-               inputSize_.y == 1 ? 1 : (2 | (inputSize_.y & 1)));
-}}
-
-NVPRO_PYRAMID_TYPE
-loadSample_(ivec2 srcCoord_, int srcLevel_, bool loadFromShared_);
-
-// Handle loading and reducing a rectangle of size kernelSize_
-// with the given upper-left coordinate srcCoord_. Samples read from
-// mip level srcLevel_ if !loadFromShared_, sharedLevel_ otherwise.
-//
-// kernelSize_ must range from 1x1 to 3x3.
-//
-// Once computed, the sample is written to the given coordinate of the
-// specified destination mip level, and returned. The destination
-// image size is needed to compute the kernel weights.
-NVPRO_PYRAMID_TYPE reduceStoreSample_(ivec2 srcCoord_, int srcLevel_,
-                                      bool  loadFromShared_,
-                                      ivec2 kernelSize_,
-                                      ivec2 dstImageSize_,
-                                      ivec2 dstCoord_, int dstLevel_)
-{{
-  bool  lfs_ = loadFromShared_;
-  float n_   = dstImageSize_.y;
-  float rcp_ = 1.0f / (2 * n_ + 1);
-  float w0_  = rcp_ * (n_ - dstCoord_.y);
-  float w1_  = rcp_ * n_;
-  float w2_  = 1.0f - w0_ - w1_;
-
-  NVPRO_PYRAMID_TYPE v0_, v1_, v2_, h0_, h1_, h2_, out_;
-
-  // Reduce vertically up to 3 times (depending on kernel horizontal size)
-  switch (kernelSize_.x)
-  {{
-    case 3:
-      switch (kernelSize_.y)
-      {{
-        case 3: v2_ = loadSample_(srcCoord_ + ivec2(2, 2), srcLevel_, lfs_);
-        case 2: v1_ = loadSample_(srcCoord_ + ivec2(2, 1), srcLevel_, lfs_);
-        case 1: v0_ = loadSample_(srcCoord_ + ivec2(2, 0), srcLevel_, lfs_);
-      }}
-      switch (kernelSize_.y)
-      {{
-        case 3: NVPRO_PYRAMID_REDUCE(w0_, v0_, w1_, v1_, w2_, v2_, h2_); break;
-        case 2: NVPRO_PYRAMID_REDUCE2(v0_, v1_, h2_); break;
-        case 1: h2_ = v0_; break;
-      }}
-      // fallthru
-    case 2:
-      switch (kernelSize_.y)
-      {{
-        case 3: v2_ = loadSample_(srcCoord_ + ivec2(1, 2), srcLevel_, lfs_);
-        case 2: v1_ = loadSample_(srcCoord_ + ivec2(1, 1), srcLevel_, lfs_);
-        case 1: v0_ = loadSample_(srcCoord_ + ivec2(1, 0), srcLevel_, lfs_);
-      }}
-      switch (kernelSize_.y)
-      {{
-        case 3: NVPRO_PYRAMID_REDUCE(w0_, v0_, w1_, v1_, w2_, v2_, h1_); break;
-        case 2: NVPRO_PYRAMID_REDUCE2(v0_, v1_, h1_); break;
-        case 1: h1_ = v0_; break;
-      }}
-    case 1:
-      switch (kernelSize_.y)
-      {{
-        case 3: v2_ = loadSample_(srcCoord_ + ivec2(0, 2), srcLevel_, lfs_);
-        case 2: v1_ = loadSample_(srcCoord_ + ivec2(0, 1), srcLevel_, lfs_);
-        case 1: v0_ = loadSample_(srcCoord_ + ivec2(0, 0), srcLevel_, lfs_);
-      }}
-      switch (kernelSize_.y)
-      {{
-        case 3: NVPRO_PYRAMID_REDUCE(w0_, v0_, w1_, v1_, w2_, v2_, h0_); break;
-        case 2: NVPRO_PYRAMID_REDUCE2(v0_, v1_, h0_); break;
-        case 1: h0_ = v0_; break;
-      }}
-  }}
-
-  // Reduce up to 3 samples horizontally.
-  switch (kernelSize_.x)
-  {{
-    case 3:
-      n_   = dstImageSize_.x;
-      rcp_ = 1.0f / (2 * n_ + 1);
-      w0_  = rcp_ * (n_ - dstCoord_.x);
-      w1_  = rcp_ * n_;
-      w2_  = 1.0f - w0_ - w1_;
-      NVPRO_PYRAMID_REDUCE(w0_, h0_, w1_, h1_, w2_, h2_, out_);
-      break;
-    case 2:
-      NVPRO_PYRAMID_REDUCE2(h0_, h1_, out_);
-      break;
-    case 1:
-      out_ = h0_;
-  }}
-
-  // Write out sample.
-  NVPRO_PYRAMID_STORE(dstCoord_, dstLevel_, out_);
-  return out_;
-}}
-
-NVPRO_PYRAMID_TYPE
-loadSample_(ivec2 srcCoord_, int srcLevel_, bool loadFromShared_)
-{{
-  NVPRO_PYRAMID_TYPE loaded_;
-  if (loadFromShared_)
-  {{
-    NVPRO_PYRAMID_SHARED_LOAD((sharedLevel_[srcCoord_.y][srcCoord_.x]), loaded_);
-  }}
-  else
-  {{
-    NVPRO_PYRAMID_LOAD(srcCoord_, srcLevel_, loaded_);
-  }}
-  return loaded_;
-}}
-
-
-
-// Compute and write out (to the 1st mip level generated) the samples
-// at coordinates
-//     initDstCoord_,
-//     initDstCoord_ + step_, ...
-//     initDstCoord_ + (iterations_-1) * step_
-// and cache them at in the sharedLevel_ tile at coordinates
-//     initSharedCoord_,
-//     initSharedCoord_ + step_, ...
-//     initSharedCoord_ + (iterations_-1) * step_
-// If boundsCheck_ is true, skip coordinates that are out of bounds.
-void intermediateLevelLoop_(ivec2 initDstCoord_,
-                            ivec2 initSharedCoord_,
-                            ivec2 step_,
-                            int   iterations_,
-                            bool  boundsCheck_)
-{{
-  ivec2 dstCoord_     = initDstCoord_;
-  ivec2 sharedCoord_  = initSharedCoord_;
-  int   srcLevel_     = int(NVPRO_PYRAMID_INPUT_LEVEL_);
-  int   dstLevel_     = srcLevel_ + 1;
-  ivec2 srcImageSize_ = NVPRO_PYRAMID_LEVEL_SIZE(srcLevel_);
-  ivec2 dstImageSize_ = NVPRO_PYRAMID_LEVEL_SIZE(dstLevel_);
-  ivec2 kernelSize_   = kernelSizeFromInputSize_(srcImageSize_);
-
-  for (int i_ = 0; i_ < iterations_; ++i_)
-  {{
-    ivec2 srcCoord_ = dstCoord_ * 2;
-
-    // Optional bounds check.
-    if (boundsCheck_)
-    {{
-      if (uint(dstCoord_.x) >= uint(dstImageSize_.x)) continue;
-      if (uint(dstCoord_.y) >= uint(dstImageSize_.y)) continue;
-    }}
-
-    bool loadFromShared_ = false;
-    NVPRO_PYRAMID_TYPE sample_ =
-        reduceStoreSample_(srcCoord_, srcLevel_, loadFromShared_, kernelSize_,
-                           dstImageSize_, dstCoord_, dstLevel_);
-
-    // Above function handles writing to the actual output; manually
-    // cache into shared memory here.
-    NVPRO_PYRAMID_SHARED_STORE((sharedLevel_[sharedCoord_.y][sharedCoord_.x]),
-                               sample_);
-    dstCoord_ += step_;
-    sharedCoord_ += step_;
-  }}
-}}
-
-// Function for the workgroup that handles filling the intermediate level
-// (caching it in shared memory as well).
-//
-// We need somewhere from {tile_1_x - 1}x{tile_1_y - 1} to {tile_1_x}x{tile_1_y} samples, depending
-// on what the kernel size for the 2nd mip level generation will be.
-//
-// dstTileCoord_ : upper left coordinate of the tile to generate.
-// boundsCheck_  : whether to skip samples that are out-of-bounds.
-void fillIntermediateTile_(ivec2 dstTileCoord_, bool boundsCheck_)
-{{
-  uint localIdx_ = int(gl_LocalInvocationIndex);
-
-  ivec2 initThreadOffset_;
-  ivec2 step_;
-  int   iterations_;
-
-  ivec2 dstImageSize_ =
-      NVPRO_PYRAMID_LEVEL_SIZE((int(NVPRO_PYRAMID_INPUT_LEVEL_) + 1));
-  ivec2 futureKernelSize_ = kernelSizeFromInputSize_(dstImageSize_);
-
-  if (futureKernelSize_.x == 3)
-  {{
-    if (futureKernelSize_.y == 3)
-    {{
-{fill_tile_vars(tile_1_x, tile_1_y, indentation = 6)}
-    }}
-    else  // Future 3x[2,1] kernel
-    {{
-{fill_tile_vars(tile_1_x, tile_1_y - 1, indentation = 6)}
-    }}
-  }}
-  else
-  {{
-    if (futureKernelSize_.y == 3)
-    {{
-{fill_tile_vars(tile_1_x - 1, tile_1_y, indentation = 6)}
-    }}
-    else
-    {{
-{fill_tile_vars(tile_1_x - 1, tile_1_y - 1, indentation = 6)}
-    }}
-  }}
-
-  intermediateLevelLoop_(dstTileCoord_ + initThreadOffset_, initThreadOffset_,
-                         step_, iterations_, boundsCheck_);
-}}
-
-
-
-"""
-
-lastLevelLoop_source = f""" \
-// Compute and write out (to the 2nd mip level generated) the samples
-// at coordinates
-//     initDstCoord_,
-//     initDstCoord_ + step_, ...
-//     initDstCoord_ + (iterations_-1) * step_
-// using as inputs the 1x1 to 3x3 tiles of shared memory at coordinates
-//     initSharedSrcCoord_,
-//     initSharedSrcCoord_ + 2 * step_, ...
-//     initSharedSrcCoord_ + (iterations_-1) * 2 * step_
-// If boundsCheck_ is true, skip coordinates that are out of bounds.
-void lastLevelLoop_(ivec2 initSharedSrcCoord_,
-                    ivec2 initDstCoord_,
-                    ivec2 step_,
-                    int   iterations_,
-                    bool  boundsCheck_)
-{{
-  ivec2 dstCoord_     = initDstCoord_;
-  ivec2 srcCoord_     = initSharedSrcCoord_;
-  int   dstLevel_     = int(NVPRO_PYRAMID_INPUT_LEVEL_ + 2);
-  ivec2 srcImageSize_ = NVPRO_PYRAMID_LEVEL_SIZE((dstLevel_ - 1));
-  ivec2 dstImageSize_ = NVPRO_PYRAMID_LEVEL_SIZE(dstLevel_);
-  ivec2 kernelSize_   = kernelSizeFromInputSize_(srcImageSize_);
-
-  for (int i_ = 0; i_ < iterations_; ++i_)
-  {{
-    // Optional bounds check.
-    if (boundsCheck_)
-    {{
-      if (uint(dstCoord_.x) >= uint(dstImageSize_.x)) continue;
-      if (uint(dstCoord_.y) >= uint(dstImageSize_.y)) continue;
-    }}
-
-    bool loadFromShared_ = true;
-    reduceStoreSample_(srcCoord_, 0, loadFromShared_, kernelSize_,
-                       dstImageSize_, dstCoord_, dstLevel_);
-    dstCoord_ += step_;
-    srcCoord_ += 2 * step_;
-  }}
-}}
-
-
-
-// Function for the workgroup that handles filling the last level tile
-// (2nd level after the original input level), using as input the
-// tile in shared memory.
-//
-// dstTileCoord_ : upper left coordinate of the tile to generate.
-// boundsCheck_  : whether to skip samples that are out-of-bounds.
-void fillLastTile_(ivec2 dstTileCoord_, bool boundsCheck_)
-{{
-  uint localIdx_ = int(gl_LocalInvocationIndex);
-
-  ivec2 initThreadOffset_;
-  ivec2 step_;
-  int   iterations_;
-
-{fill_tile_vars(tile_2_x, tile_2_y, indentation = 2)}
-
-  lastLevelLoop_(initThreadOffset_ * 2, dstTileCoord_ + initThreadOffset_,
-                 step_, iterations_, boundsCheck_);
-}}
-"""
-
-no_lastLevelLoop_source = f"""\
-// Function for the workgroup that handles filling the last level tile
-// (2nd level after the original input level), using as input the
-// tile in shared memory.
-//
-// dstTileCoord_ : upper left coordinate of the tile to generate.
-// boundsCheck_  : whether to skip samples that are out-of-bounds.
-void fillLastTile_(ivec2 dstTileCoord_, bool boundsCheck_)
-{{
-  uint localIdx_ = gl_LocalInvocationIndex;
-
-  if (localIdx_ < {tile_2_x} * {tile_2_y})
-  {{
-    ivec2 threadOffset_ = ivec2(localIdx_ % {tile_2_x}u, localIdx_ / {tile_2_x}u);
-    int   srcLevel_     = int(NVPRO_PYRAMID_INPUT_LEVEL_) + 1;
-    int   dstLevel_     = int(NVPRO_PYRAMID_INPUT_LEVEL_) + 2;
-    ivec2 srcImageSize_ = NVPRO_PYRAMID_LEVEL_SIZE(srcLevel_);
-    ivec2 dstImageSize_ = NVPRO_PYRAMID_LEVEL_SIZE(dstLevel_);
-
-    ivec2 srcSharedCoord_ = threadOffset_ * 2;
-    bool loadFromShared_  = true;
-    ivec2 kernelSize_     = kernelSizeFromInputSize_(srcImageSize_);
-    ivec2 dstCoord_       = threadOffset_ + dstTileCoord_;
-
-    bool inBounds_ = true;
-    if (boundsCheck_)
-    {{
-      inBounds_ = (uint(dstCoord_.x) < uint(dstImageSize_.x))
-                  && (uint(dstCoord_.y) < uint(dstImageSize_.y));
-    }}
-    if (inBounds_)
-    {{
-      reduceStoreSample_(srcSharedCoord_, 0, loadFromShared_, kernelSize_,
-                         dstImageSize_, dstCoord_, dstLevel_);
-    }}
-  }}
-}}
-"""
-
-if tile_2_x * tile_2_y > threads:
-    source_code += lastLevelLoop_source
-else:
-    source_code += no_lastLevelLoop_source
-
-
-
-source_code += f"""\
-
-
-
-void nvproPyramidMain()
-{{
-  int inputLevel_ = int(NVPRO_PYRAMID_INPUT_LEVEL_);
-
-  if (NVPRO_PYRAMID_LEVEL_COUNT_ == 1u)
-  {{
-    ivec2 kernelSize_ =
-        kernelSizeFromInputSize_(NVPRO_PYRAMID_LEVEL_SIZE(inputLevel_));
-    ivec2 dstImageSize_ = NVPRO_PYRAMID_LEVEL_SIZE((inputLevel_ + 1));
-    ivec2 dstCoord_     = ivec2(int(gl_GlobalInvocationID.x) % dstImageSize_.x,
-                                int(gl_GlobalInvocationID.x) / dstImageSize_.x);
-    ivec2 srcCoord_ = dstCoord_ * 2;
-
-    if (dstCoord_.y < dstImageSize_.y)
-    {{
-      reduceStoreSample_(srcCoord_, inputLevel_, false, kernelSize_,
-                         dstImageSize_, dstCoord_, inputLevel_ + 1);
-    }}
-  }}
-  else  // Handling two levels.
-  {{
-    // Assign a {tile_2_x}x{tile_2_y} tile of mip level inputLevel_ + 2 to this workgroup.
-    int   level2_     = inputLevel_ + 2;
-    ivec2 level2Size_ = NVPRO_PYRAMID_LEVEL_SIZE(level2_);
-    ivec2 tileCount_;
-    tileCount_.x   = int(uint(level2Size_.x + {tile_2_x - 1}) / {tile_2_x}u);
-    tileCount_.y   = int(uint(level2Size_.y + {tile_2_y - 1}) / {tile_2_y}u);
-    ivec2 tileIdx_ = ivec2(gl_WorkGroupID.x % uint(tileCount_.x),
-                           gl_WorkGroupID.x / uint(tileCount_.x));
-    uint localIdx_ = gl_LocalInvocationIndex;
-
-    // Determine if bounds checking is needed; this is only the case
-    // for tiles at the right or bottom fringe that might be cut off
-    // by the image border. Note that later, I use if statements rather
-    // than passing boundsCheck_ directly to convince the compiler
-    // to inline everything.
-    bool boundsCheck_ = tileIdx_.x >= tileCount_.x - 1 ||
-                        tileIdx_.y >= tileCount_.y - 1;
-
-    if (boundsCheck_)
-    {{
-      // Compute the tile in level inputLevel_ + 1 that's needed to
-      // compute the above {tile_2_x}x{tile_2_y} tile.
-      fillIntermediateTile_(tileIdx_ * 2 * ivec2({tile_2_x}, {tile_2_y}), true);
-      barrier();
-
-      // Compute the inputLevel_ + 2 tile of size {tile_2_x}x{tile_2_y}, loading
-      // inupts from shared memory.
-      fillLastTile_(tileIdx_ * ivec2({tile_2_x}, {tile_2_y}), true);
-    }}
-    else
-    {{
-      // Same with no bounds checking.
-      fillIntermediateTile_(tileIdx_ * 2 * ivec2({tile_2_x}, {tile_2_y}), false);
-      barrier();
-      fillLastTile_(tileIdx_ * ivec2({tile_2_x}, {tile_2_y}), false);
-    }}
-  }}
-}}
-"""
-
-general_pipeline_alternative_file.write(source_code)
-
-
-dispatcher_file.write(f"""\
-#include "nvpro_pyramid_dispatch_alternative.hpp"
-
-#include "../py2_dispatch_impl.hpp"
-
-NVPRO_PYRAMID_ADD_GENERAL_DISPATCHER(py2_{warps}_{tile_2_x}_{tile_2_y},
-                                     (py2_dispatch_impl<{warps}, {tile_2_x}, {tile_2_y}>))
-""")
@@ -0,0 +1,114 @@
+// Copyright 2021 NVIDIA CORPORATION
+// SPDX-License-Identifier: Apache-2.0
+#ifndef NVPRO_SAMPLES_VK_COMPUTE_MIPMAPS_COMPILE_THREAD_POOL_HPP_
+#define NVPRO_SAMPLES_VK_COMPUTE_MIPMAPS_COMPILE_THREAD_POOL_HPP_
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of worker threads for shader compilation and
+// pipeline creation, so that compile sites do not each spawn (and
+// oversubscribe the CPU with) their own threads.
+class CompileThreadPool
+{
+  std::mutex                        m_mutex;
+  std::condition_variable           m_jobAvailable;
+  std::deque<std::function<void()>> m_jobs;
+  std::vector<std::thread>          m_threads;
+  bool                              m_stop = false;
+
+  void workerLoop()
+  {
+    while (1)
+    {
+      std::function<void()> job;
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_jobAvailable.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+        if (m_jobs.empty()) return;  // Stopping.
+        job = std::move(m_jobs.front());
+        m_jobs.pop_front();
+      }
+      job();
+    }
+  }
+
+public:
+  explicit CompileThreadPool(uint32_t threadCount)
+  {
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+      m_threads.emplace_back(&CompileThreadPool::workerLoop, this);
+    }
+  }
+
+  ~CompileThreadPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_jobAvailable.notify_all();
+    for (std::thread& thread : m_threads)
+    {
+      thread.join();
+    }
+  }
+
+  CompileThreadPool(const CompileThreadPool&) = delete;
+  CompileThreadPool& operator=(const CompileThreadPool&) = delete;
+
+  uint32_t threadCount() const { return uint32_t(m_threads.size()); }
+
+  // Run work(i) for i in [0, count) on the worker threads, and
+  // complete(i) (optional) on the calling thread in increasing i
+  // order, each as soon as work(0) ... work(i) are done, e.g. to print
+  // results deterministically. Returns when all are complete. Must not
+  // be called from a job (the workers could all end up waiting).
+  void runOrdered(uint32_t                             count,
+                  const std::function<void(uint32_t)>& work,
+                  const std::function<void(uint32_t)>& complete = nullptr)
+  {
+    std::mutex              doneMutex;
+    std::condition_variable doneCondition;
+    std::vector<char>       done(count, 0);
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      for (uint32_t i = 0; i < count; ++i)
+      {
+        m_jobs.emplace_back([&, i] {
+          work(i);
+          std::lock_guard<std::mutex> doneLock(doneMutex);
+          done[i] = 1;
+          doneCondition.notify_all();
+        });
+      }
+    }
+    m_jobAvailable.notify_all();
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+      {
+        std::unique_lock<std::mutex> doneLock(doneMutex);
+        doneCondition.wait(doneLock, [&] { return done[i] != 0; });
+      }
+      if (complete) complete(i);
+    }
+  }
+};
+
+// Pool shared by all compile sites, sized to the hardware concurrency.
+inline CompileThreadPool& computeCompileThreadPool()
+{
+  static CompileThreadPool pool(
+      std::max(1u, std::thread::hardware_concurrency()));
+  return pool;
+}
+
+#endif
@@ -3,20 +3,254 @@
 #ifndef NVPRO_SAMPLES_VK_COMPUTE_MIPMAPS_MAKE_COMPUTE_PIPELINE_HPP_
 #define NVPRO_SAMPLES_VK_COMPUTE_MIPMAPS_MAKE_COMPUTE_PIPELINE_HPP_
 
+#include <algorithm>
+#include <atomic>
+#include <stdio.h>
+#include <string.h>
+#include <string>
 #include <vulkan/vulkan.h>
 #include "nvh/fileoperations.hpp"
 #include "nvvk/error_vk.hpp"
 #include "nvvk/pipeline_vk.hpp"
+#include "compile_thread_pool.hpp"
 #include "search_paths.hpp"
 
+// Subgroup size required (VK_EXT_subgroup_size_control) for all
+// compute pipelines created below; 0 (default) leaves the choice to
+// the implementation. Set by chooseComputeSubgroupSize.
+inline uint32_t& computeRequiredSubgroupSize()
+{
+  static uint32_t requiredSubgroupSize = 0;
+  return requiredSubgroupSize;
+}
+
+// Call after device creation. If VK_EXT_subgroup_size_control was
+// enabled with the subgroupSizeControl feature (pass true), require the
+// supported subgroup size nearest to 32 (the most tested size for
+// nvpro_pyramid's fast pipeline) for compute pipelines, raised if
+// needed so that 1024-thread workgroups fit in maxComputeWorkgroupSubgroups.
+// If requestedSize is nonzero, require that size instead (e.g. to test
+// other sizes); it must be a supported power of 2 with room for
+// 1024-thread workgroups, or be the default subgroup size.
+// Returns the subgroup size the compute pipelines will use, or 0 if
+// requestedSize cannot be used.
+inline uint32_t chooseComputeSubgroupSize(VkPhysicalDevice physicalDevice,
+                                          bool subgroupSizeControlEnabled,
+                                          uint32_t requestedSize = 0)
+{
+  VkPhysicalDeviceSubgroupSizeControlPropertiesEXT sizeControlProperties = {
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_SIZE_CONTROL_PROPERTIES_EXT};
+  VkPhysicalDeviceSubgroupProperties subgroupProperties = {
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES,
+      subgroupSizeControlEnabled ? &sizeControlProperties : nullptr};
+  VkPhysicalDeviceProperties2 physicalDeviceProperties = {
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2, &subgroupProperties};
+  vkGetPhysicalDeviceProperties2(physicalDevice, &physicalDeviceProperties);
+
+  computeRequiredSubgroupSize() = 0;
+  if (!subgroupSizeControlEnabled
+      || !(sizeControlProperties.requiredSubgroupSizeStages
+           & VK_SHADER_STAGE_COMPUTE_BIT))
+  {
+    return requestedSize == 0 || requestedSize == subgroupProperties.subgroupSize ?
+               subgroupProperties.subgroupSize :
+               0;
+  }
+
+  uint32_t minSize = sizeControlProperties.minSubgroupSize;
+  uint32_t maxSize = sizeControlProperties.maxSubgroupSize;
+  uint32_t maxSubgroups =
+      std::max(1u, sizeControlProperties.maxComputeWorkgroupSubgroups);
+  uint32_t size = std::min(std::max(32u, minSize), maxSize);
+  while (size < maxSize && size * maxSubgroups < 1024u)
+  {
+    size *= 2u;
+  }
+  if (requestedSize != 0)
+  {
+    if (requestedSize < minSize || requestedSize > maxSize
+        || (requestedSize & (requestedSize - 1u)) != 0
+        || requestedSize * maxSubgroups < 1024u)
+    {
+      return 0;
+    }
+    size = requestedSize;
+  }
+  computeRequiredSubgroupSize() = size;
+  return size;
+}
+
+// Macro definitions to prepend to nvpro_pyramid shaders compiled at run
+// time, telling them the smallest subgroup size they may run with
+// (NVPRO_PYRAMID_MIN_SUBGROUP_SIZE), if fixed by computeRequiredSubgroupSize().
+inline std::string computeSubgroupSizePrepend()
+{
+  uint32_t size = computeRequiredSubgroupSize();
+  return size == 0 ? std::string() :
+                     "#define NVPRO_PYRAMID_MIN_SUBGROUP_SIZE "
+                         + std::to_string(size) + "\n";
+}
+
+// Pipeline cache used for all compute pipelines created below, or
+// VK_NULL_HANDLE. Set by loadComputePipelineCache. Not externally
+// synchronized, so pipelines may be created on several threads at once.
+inline VkPipelineCache& computePipelineCache()
+{
+  static VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+  return pipelineCache;
+}
+
+// Pipeline creation statistics (VK_EXT_pipeline_creation_feedback),
+// accumulated by makeComputePipeline if computePipelineFeedbackEnabled().
+struct ComputePipelineFeedback
+{
+  std::atomic<uint32_t> pipelines{0}, cacheHits{0};
+  std::atomic<uint64_t> hitNanoseconds{0}, missNanoseconds{0};
+};
+
+inline ComputePipelineFeedback& computePipelineFeedback()
+{
+  static ComputePipelineFeedback feedback;
+  return feedback;
+}
+
+// Set after device creation if VK_EXT_pipeline_creation_feedback is enabled.
+inline bool& computePipelineFeedbackEnabled()
+{
+  static bool enabled = false;
+  return enabled;
+}
+
+// VK_KHR_pipeline_executable_properties capture flags added to all
+// compute pipelines created below (besides statistics if
+// dumpPipelineStats), so that their statistics (and internal
+// representations) can be queried later. Set after device creation.
+inline VkPipelineCreateFlags& computePipelineCaptureFlags()
+{
+  static VkPipelineCreateFlags flags = 0;
+  return flags;
+}
+
+// Header of the pipeline cache file, followed by the pipeline cache
+// data. The data is only used if the header matches the device; the
+// driver checks its own header too, but a mismatched cache is best not
+// handed to it at all.
+struct ComputePipelineCacheFileHeader
+{
+  uint32_t magic;
+  uint32_t dataSize;
+  uint32_t vendorID, deviceID, driverVersion;
+  uint8_t  deviceUUID[VK_UUID_SIZE];
+  uint8_t  pipelineCacheUUID[VK_UUID_SIZE];
+};
+
+inline ComputePipelineCacheFileHeader computePipelineCacheFileHeader(
+    VkPhysicalDevice physicalDevice,
+    uint32_t         dataSize)
+{
+  VkPhysicalDeviceIDProperties idProperties = {
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES};
+  VkPhysicalDeviceProperties2 properties = {
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2, &idProperties};
+  vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+
+  ComputePipelineCacheFileHeader header = {};
+  header.magic         = 0x4350564e;  // "NVPC"
+  header.dataSize      = dataSize;
+  header.vendorID      = properties.properties.vendorID;
+  header.deviceID      = properties.properties.deviceID;
+  header.driverVersion = properties.properties.driverVersion;
+  memcpy(header.deviceUUID, idProperties.deviceUUID, VK_UUID_SIZE);
+  memcpy(header.pipelineCacheUUID, properties.properties.pipelineCacheUUID,
+         VK_UUID_SIZE);
+  return header;
+}
+
+// Create computePipelineCache(), initialized with the data saved to the
+// named file by saveComputePipelineCache if it is for the same device
+// and driver version.
+inline void loadComputePipelineCache(VkDevice           device,
+                                     VkPhysicalDevice   physicalDevice,
+                                     const std::string& filename)
+{
+  assert(computePipelineCache() == VK_NULL_HANDLE);
+  std::string fileData = nvh::loadFile(filename, true);
+
+  VkPipelineCacheCreateInfo cacheInfo = {
+      VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+  ComputePipelineCacheFileHeader header;
+  if (fileData.size() >= sizeof header)
+  {
+    memcpy(&header, fileData.data(), sizeof header);
+    ComputePipelineCacheFileHeader expected =
+        computePipelineCacheFileHeader(physicalDevice, header.dataSize);
+    if (memcmp(&header, &expected, sizeof header) == 0
+        && fileData.size() == sizeof header + header.dataSize)
+    {
+      cacheInfo.initialDataSize = header.dataSize;
+      cacheInfo.pInitialData    = fileData.data() + sizeof header;
+    }
+    else
+    {
+      fprintf(stderr, "Ignoring pipeline cache '%s' of another device or driver\n",
+              filename.c_str());
+    }
+  }
+  NVVK_CHECK(vkCreatePipelineCache(device, &cacheInfo, nullptr,
+                                   &computePipelineCache()));
+}
+
+// Save the data of computePipelineCache() to the named file, and
+// destroy it. No pipelines may be under construction.
+inline void saveComputePipelineCache(VkDevice           device,
+                                     VkPhysicalDevice   physicalDevice,
+                                     const std::string& filename)
+{
+  VkPipelineCache& pipelineCache = computePipelineCache();
+  if (pipelineCache == VK_NULL_HANDLE) return;
+
+  size_t dataSize = 0;
+  NVVK_CHECK(vkGetPipelineCacheData(device, pipelineCache, &dataSize, nullptr));
+  std::string fileData(sizeof(ComputePipelineCacheFileHeader) + dataSize, '\0');
+  NVVK_CHECK(vkGetPipelineCacheData(
+      device, pipelineCache, &dataSize,
+      &fileData[sizeof(ComputePipelineCacheFileHeader)]));
+  fileData.resize(sizeof(ComputePipelineCacheFileHeader) + dataSize);
+  ComputePipelineCacheFileHeader header =
+      computePipelineCacheFileHeader(physicalDevice, uint32_t(dataSize));
+  memcpy(&fileData[0], &header, sizeof header);
+
+  FILE* file    = fopen(filename.c_str(), "wb");
+  bool  written = false;
+  if (file != nullptr)
+  {
+    written = fwrite(fileData.data(), 1, fileData.size(), file) == fileData.size();
+    // Close even if the write failed; fclose also flushes.
+    written = fclose(file) == 0 && written;
+  }
+  if (!written)
+  {
+    fprintf(stderr, "Could not write pipeline cache '%s'\n", filename.c_str());
+  }
+
+  vkDestroyPipelineCache(device, pipelineCache, nullptr);
+  pipelineCache = VK_NULL_HANDLE;
+}
+
 // Create a compute pipeline from the given pipeline layout and
 // compute shader module. "main" is the entrypoint function.
+// pSpecializationInfo (optional) sets the shader's specialization constants.
+// If deferStatsPrint, dumpPipelineStats only captures the statistics,
+// for the caller to print later (e.g. in order, after creating
+// pipelines on computeCompileThreadPool()).
 inline void makeComputePipeline(VkDevice         device,
                                 VkShaderModule   shaderModule,
                                 bool             dumpPipelineStats,
                                 VkPipelineLayout layout,
                                 VkPipeline*      outPipeline,
-                                const char* pShaderName = "<generated shader>")
+                                const char* pShaderName = "<generated shader>",
+                                const VkSpecializationInfo* pSpecializationInfo = nullptr,
+                                bool deferStatsPrint = false)
 {
   // Shader module must then get packaged into a <shader stage>
   // This is just an ordinary struct, not a Vulkan object.
@@ -27,7 +261,17 @@ inline void makeComputePipeline(VkDevice         device,
     VK_SHADER_STAGE_COMPUTE_BIT,      // * Type of shader (compute shader)
     shaderModule,                     // * Shader module
     "main",                           // * Name of function to call
-    nullptr };                        // * I don't use this
+    pSpecializationInfo };            // * Specialization constants, if any
+
+  // Optionally fix the subgroup size (see chooseComputeSubgroupSize).
+  VkPipelineShaderStageRequiredSubgroupSizeCreateInfoEXT subgroupSizeInfo {
+    VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_REQUIRED_SUBGROUP_SIZE_CREATE_INFO_EXT,
+    nullptr,
+    computeRequiredSubgroupSize() };
+  if (subgroupSizeInfo.requiredSubgroupSize != 0)
+  {
+    stageInfo.pNext = &subgroupSizeInfo;
+  }
 
   // Create the compute pipeline. Note that the create struct is
   // typed for different pipeline types (compute, rasterization, ray
@@ -38,19 +282,49 @@ inline void makeComputePipeline(VkDevice         device,
     0,
     stageInfo,                // * The compute shader to use
     layout,                   // * Pipeline Layout
-    VK_NULL_HANDLE, 0 };      // * Unused advanced feature (pipeline caching)
+    VK_NULL_HANDLE, 0 };      // * Unused advanced feature (pipeline derivatives)
   if (dumpPipelineStats)
   {
     pipelineInfo.flags |= VK_PIPELINE_CREATE_CAPTURE_STATISTICS_BIT_KHR;
   }
+  pipelineInfo.flags |= computePipelineCaptureFlags();
+
+  // Optionally find out whether the pipeline cache had the pipeline.
+  VkPipelineCreationFeedbackEXT pipelineFeedback = {}, stageFeedback = {};
+  VkPipelineCreationFeedbackCreateInfoEXT feedbackInfo {
+    VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT,
+    nullptr,
+    &pipelineFeedback,
+    1, &stageFeedback };
+  if (computePipelineFeedbackEnabled())
+  {
+    pipelineInfo.pNext = &feedbackInfo;
+  }
+
   NVVK_CHECK(vkCreateComputePipelines(
     device,
-    VK_NULL_HANDLE,           // * Unused (pipeline caching)
+    computePipelineCache(),   // * Pipeline cache, or VK_NULL_HANDLE
     1, &pipelineInfo,         // * Array of pipelines to create
     nullptr,                  // * Default host memory allocator
     outPipeline));            // * Pipeline output (array)
 
-  if (dumpPipelineStats)
+  if (pipelineFeedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT_EXT)
+  {
+    ComputePipelineFeedback& feedback = computePipelineFeedback();
+    ++feedback.pipelines;
+    if (pipelineFeedback.flags
+        & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT_EXT)
+    {
+      ++feedback.cacheHits;
+      feedback.hitNanoseconds += pipelineFeedback.duration;
+    }
+    else
+    {
+      feedback.missNanoseconds += pipelineFeedback.duration;
+    }
+  }
+
+  if (dumpPipelineStats && !deferStatsPrint)
   {
     nvvk::nvprintPipelineStats(device, *outPipeline, pShaderName, false);
   }
@@ -65,7 +339,8 @@ inline void makeComputePipeline(VkDevice         device,
                                 const char*      pFilename,
                                 bool             dumpPipelineStats,
                                 VkPipelineLayout layout,
-                                VkPipeline*      outPipeline)
+                                VkPipeline*      outPipeline,
+                                bool             deferStatsPrint = false)
 {
   // Compile SPV shader into a shader module.
   std::string shaderCode = nvh::loadFile(
@@ -85,12 +360,39 @@ inline void makeComputePipeline(VkDevice         device,
     device, &moduleCreateInfo, nullptr, &shaderModule));
 
   makeComputePipeline(device, shaderModule, dumpPipelineStats, layout,
-                      outPipeline, pFilename);
+                      outPipeline, pFilename, nullptr, deferStatsPrint);
 
   vkDestroyShaderModule(device, shaderModule, nullptr);
 }
 
 
+// Create count compute pipelines with the given pipeline layout, the
+// ith with SPIR-V code loaded from ppFilenames[i] into *ppOutPipelines[i],
+// in parallel on computeCompileThreadPool(). Statistics are printed in
+// array order.
+inline void makeComputePipelines(VkDevice           device,
+                                 uint32_t           count,
+                                 const char* const* ppFilenames,
+                                 bool               dumpPipelineStats,
+                                 VkPipelineLayout   layout,
+                                 VkPipeline* const* ppOutPipelines)
+{
+  computeCompileThreadPool().runOrdered(
+      count,
+      [&](uint32_t i) {
+        makeComputePipeline(device, ppFilenames[i], dumpPipelineStats, layout,
+                            ppOutPipelines[i], true);
+      },
+      [&](uint32_t i) {
+        if (dumpPipelineStats)
+        {
+          nvvk::nvprintPipelineStats(device, *ppOutPipelines[i],
+                                     ppFilenames[i], false);
+        }
+      });
+}
+
+
 // Create a compute pipeline and layout from the given
 // descriptor/push constant info and with SPIR-V code loaded from
 // the named file. "main" is the entrypoint function.
@@ -10,6 +10,7 @@
 
 #include <array>
 #include <cassert>
+#include <math.h>
 #include <stdint.h>
 #include <string.h>
 #include <vector>
@@ -18,6 +19,62 @@
 
 #include "shaders/srgb.h"
 
+// Wide separable kernels (NVPRO_PYRAMID_WIDE_KERNEL); must match
+// WIDE_KERNEL in srgba8_mipmap_preamble.glsl.
+constexpr int      wideKernelNone    = 0;
+constexpr int      wideKernelLanczos = 1;
+constexpr int      wideKernelKaiser  = 2;
+constexpr uint32_t wideKernelRadius  = 4;
+
+// Unnormalized weight of a tap at distance d, in output texels.
+inline float wideKernelWeight(int kernel, float d)
+{
+  auto sinc = [](float x) {
+    const float pi = 3.14159265f;
+    return fabsf(x) < 1e-5f ? 1.0f : sinf(pi * x) / (pi * x);
+  };
+  auto besselI0 = [](float x) {
+    float sum = 1.0f, term = 1.0f, halfX2 = 0.25f * x * x;
+    for (int k = 1; k < 12; ++k)
+    {
+      term *= halfX2 / float(k * k);
+      sum += term;
+    }
+    return sum;
+  };
+  float t = d * 0.5f;
+  if (fabsf(t) >= 1.0f) return 0.0f;
+  switch (kernel)
+  {
+    case wideKernelLanczos:
+      return sinc(d) * sinc(t);
+    case wideKernelKaiser:
+      return sinc(d) * besselI0(4.0f * sqrtf(1.0f - t * t)) / besselI0(4.0f);
+    default:
+      assert(!"Unknown wide kernel");
+      return 0.0f;
+  }
+}
+
+// Index of the first of the 2 * radius input taps of output sample x
+// (may be negative); see wideFirstTap_ in nvpro_pyramid.glsl.
+inline int32_t wideKernelFirstTap(uint32_t x, uint32_t srcSize,
+                                  uint32_t dstSize, uint32_t radius)
+{
+  uint32_t num = (2 * x + 1) * srcSize + dstSize;
+  return int32_t(num / (2 * dstSize)) - int32_t(radius);
+}
+
+// Distance from input tap to the center of output sample x, in output texels.
+inline float wideKernelDistance(int32_t tap, uint32_t x, uint32_t srcSize,
+                                uint32_t dstSize)
+{
+  int32_t j   = tap - 2 * int32_t(x);
+  int32_t num = 2 * int32_t(x) * (2 * int32_t(dstSize) - int32_t(srcSize))
+              + (2 * j + 1) * int32_t(dstSize) - int32_t(srcSize);
+  return float(num) / float(2 * srcSize);
+}
+
 template <typename T=uint8_t, uint32_t Channels=4>
 class MipmapStorage
 {
@@ -235,6 +292,118 @@ public:
     }
   }
 
+  // Fill in mip levels 1+ using data from mip level 0, by folding
+  // every texel in the footprint of each output texel (2x2 to 3x3,
+  // same footprint as generateMipmaps) with the given function
+  // reduce(Texel& accumulator, const Texel& input). Unweighted; for
+  // min/max pyramids and similar conservative reductions.
+  template <typename Reduce>
+  void reduceMipmaps(Reduce&& reduce)
+  {
+    assert(!m_data.empty());
+    for (uint32_t level = 1; level < m_levelOffsets.size(); ++level)
+    {
+      auto srcDim = m_widthHeight[level - 1];
+      auto dstDim = m_widthHeight[level];
+      const Texel* pSrcLevel = levelData(level - 1);
+      Texel*       pDstLevel = levelData(level);
+
+      // Footprint size per axis: 2 for even, 3 for odd, 1 if size 1.
+      uint32_t kernelX = srcDim.x == 1 ? 1 : 2 + (srcDim.x & 1);
+      uint32_t kernelY = srcDim.y == 1 ? 1 : 2 + (srcDim.y & 1);
+
+      for (uint32_t y = 0; y < dstDim.y; ++y)
+      {
+        for (uint32_t x = 0; x < dstDim.x; ++x)
+        {
+          Texel result = pSrcLevel[2*x + srcDim.x * (2*y)];
+          for (uint32_t dy = 0; dy < kernelY; ++dy)
+          {
+            for (uint32_t dx = 0; dx < kernelX; ++dx)
+            {
+              reduce(result, pSrcLevel[(2*x+dx) + srcDim.x * (2*y+dy)]);
+            }
+          }
+          pDstLevel[dstDim.x*y + x] = result;
+        }
+      }
+    }
+  }
+
+  // Like generateMipmaps, but with a separable kernel of 2 * radius
+  // taps per axis given by wideKernelWeight; taps are clamped to the
+  // edge of the input level.
+  template <typename ToLinear, typename FromLinear>
+  void generateMipmapsWide(ToLinear&&   toLinear,
+                           FromLinear&& fromLinear,
+                           int          kernel,
+                           uint32_t     radius = wideKernelRadius)
+  {
+    assert(!m_data.empty());
+    using Sample = std::array<float, Channels>;
+    std::vector<Sample> rowFiltered;
+    std::vector<float>  weights(2 * radius);
+
+    // Fill weights for output sample x, return first tap.
+    auto computeWeights = [&](uint32_t x, uint32_t srcSize, uint32_t dstSize) {
+      int32_t first = wideKernelFirstTap(x, srcSize, dstSize, radius);
+      float   sum   = 0.0f;
+      for (uint32_t t = 0; t < 2 * radius; ++t)
+      {
+        weights[t] = wideKernelWeight(
+            kernel, wideKernelDistance(first + int32_t(t), x, srcSize, dstSize));
+        sum += weights[t];
+      }
+      for (float& w : weights) w /= sum;
+      return first;
+    };
+    auto clampTap = [](int32_t tap, uint32_t size) {
+      return tap < 0 ? 0u : uint32_t(tap) >= size ? size - 1 : uint32_t(tap);
+    };
+
+    for (uint32_t level = 1; level < m_levelOffsets.size(); ++level)
+    {
+      auto         srcDim    = m_widthHeight[level - 1];
+      auto         dstDim    = m_widthHeight[level];
+      const Texel* pSrcLevel = levelData(level - 1);
+      Texel*       pDstLevel = levelData(level);
+
+      // Horizontal pass: srcDim.y rows of dstDim.x samples.
+      rowFiltered.assign(size_t(dstDim.x) * srcDim.y, Sample{});
+      for (uint32_t x = 0; x < dstDim.x; ++x)
+      {
+        int32_t first = computeWeights(x, srcDim.x, dstDim.x);
+        for (uint32_t y = 0; y < srcDim.y; ++y)
+        {
+          Sample& out = rowFiltered[size_t(dstDim.x) * y + x];
+          for (uint32_t t = 0; t < 2 * radius; ++t)
+          {
+            uint32_t tap = clampTap(first + int32_t(t), srcDim.x);
+            Sample   in  = toLinear(pSrcLevel[size_t(srcDim.x) * y + tap]);
+            for (uint32_t c = 0; c < Channels; ++c) out[c] += in[c] * weights[t];
+          }
+        }
+      }
+
+      // Vertical pass.
+      for (uint32_t y = 0; y < dstDim.y; ++y)
+      {
+        int32_t first = computeWeights(y, srcDim.y, dstDim.y);
+        for (uint32_t x = 0; x < dstDim.x; ++x)
+        {
+          Sample result{};
+          for (uint32_t t = 0; t < 2 * radius; ++t)
+          {
+            uint32_t      tap = clampTap(first + int32_t(t), srcDim.y);
+            const Sample& in  = rowFiltered[size_t(dstDim.x) * tap + x];
+            for (uint32_t c = 0; c < Channels; ++c) result[c] += in[c] * weights[t];
+          }
+          pDstLevel[dstDim.x * y + x] = fromLinear(result);
+        }
+      }
+    }
+  }
+
 private:
   template <bool SrcWidthEven, bool SrcHeightEven, typename ToLinear, typename FromLinear>
   void generateLevel(ToLinear&& toLinear, FromLinear&& fromLinear, uint32_t level)
@@ -380,7 +549,69 @@ private:
   }
 };
 
-inline void cpuGenerateMipmaps_sRGBA(MipmapStorage<uint8_t, 4>* pMips)
+// Rescale the alpha of mip levels 1+ so that the fraction of texels
+// with alpha >= alphaCutoff matches level 0 (alpha-tested textures).
+// Must match nvpro_pyramid_coverage.glsl: for each level, find the
+// largest threshold t in [1, 255] whose coverage is at least that of
+// level 0, then map alpha so that texels pass iff alpha >= t.
+inline void cpuPreserveAlphaCoverage(MipmapStorage<uint8_t, 4>* pMips,
+                                     uint8_t                    alphaCutoff)
+{
+  assert(alphaCutoff != 0);
+  const auto& widthHeight = pMips->getWidthHeight();
+  uint64_t    baseTexels  = uint64_t(widthHeight[0].x) * widthHeight[0].y;
+  uint64_t    basePassing = 0;
+  for (uint64_t i = 0; i < baseTexels; ++i)
+  {
+    basePassing += pMips->levelData(0)[i][3] >= alphaCutoff;
+  }
+
+  for (uint32_t level = 1; level < widthHeight.size(); ++level)
+  {
+    std::array<uint8_t, 4>* pLevel = pMips->levelData(level);
+    uint64_t texels = uint64_t(widthHeight[level].x) * widthHeight[level].y;
+
+    // Suffix sums of the alpha histogram: passing[i] = texels with alpha >= i.
+    uint64_t passing[257] = {};
+    for (uint64_t i = 0; i < texels; ++i)
+    {
+      passing[pLevel[i][3]]++;
+    }
+    for (int i = 254; i >= 0; --i)
+    {
+      passing[i] += passing[i + 1];
+    }
+
+    uint32_t threshold = 1;
+    for (uint32_t i = 255; i >= 2; --i)
+    {
+      if (passing[i] * baseTexels >= basePassing * texels)
+      {
+        threshold = i;
+        break;
+      }
+    }
+    if (threshold == alphaCutoff) continue;
+
+    for (uint64_t i = 0; i < texels; ++i)
+    {
+      uint32_t alpha  = pLevel[i][3];
+      uint32_t scaled = (alpha * alphaCutoff + threshold / 2u) / threshold;
+      scaled = alpha >= threshold ?
+                   (scaled < alphaCutoff ? alphaCutoff : scaled > 255u ? 255u : scaled) :
+                   (scaled < alphaCutoff - 1u ? scaled : alphaCutoff - 1u);
+      pLevel[i][3] = uint8_t(scaled);
+    }
+  }
+}
+
+// wideKernel: wideKernelNone (default box / NP2 kernel) or one of the
+// wide separable kernels.
+// alphaCoverageCutoff: if nonzero, preserve alpha test coverage for
+// this cutoff afterwards (see cpuPreserveAlphaCoverage).
+inline void cpuGenerateMipmaps_sRGBA(MipmapStorage<uint8_t, 4>* pMips,
+                                     int     wideKernel          = wideKernelNone,
+                                     uint8_t alphaCoverageCutoff = 0)
 {
   auto toLinear = [] (std::array<uint8_t, 4> texel) -> std::array<float, 4>
   {
@@ -394,20 +625,105 @@ inline void cpuGenerateMipmaps_sRGBA(MipmapStorage<uint8_t, 4>* pMips)
              uint8_t(srgbFromLinear(linear[1])),
              uint8_t(srgbFromLinear(linear[2])), alpha };
   };
-  auto x = pMips->getWidthHeight()[0].x;
-  auto y = pMips->getWidthHeight()[0].y;
-  pMips->generateMipmaps(toLinear, fromLinear);
+  if (wideKernel != wideKernelNone)
+  {
+    pMips->generateMipmapsWide(toLinear, fromLinear, wideKernel);
+  }
+  else
+  {
+    pMips->generateMipmaps(toLinear, fromLinear);
+  }
+  if (alphaCoverageCutoff != 0)
+  {
+    cpuPreserveAlphaCoverage(pMips, alphaCoverageCutoff);
+  }
+}
+
+// Generate a min (or max) hierarchical depth pyramid from level 0.
+inline void cpuGenerateDepthPyramid(MipmapStorage<float, 1>* pMips, bool isMax)
+{
+  if (isMax)
+  {
+    pMips->reduceMipmaps([] (std::array<float, 1>& acc, std::array<float, 1> in)
+    {
+      acc[0] = acc[0] > in[0] ? acc[0] : in[0];
+    });
+  }
+  else
+  {
+    pMips->reduceMipmaps([] (std::array<float, 1>& acc, std::array<float, 1> in)
+    {
+      acc[0] = acc[0] < in[0] ? acc[0] : in[0];
+    });
+  }
+}
+
+// Generate a combined min (red) / max (green) hierarchical depth
+// pyramid; only the red channel of level 0 is used (and the green
+// channel of level 0 is overwritten with it).
+inline void cpuGenerateDepthPyramidMinMax(MipmapStorage<float, 2>* pMips)
+{
+  auto dim = pMips->getWidthHeight()[0];
+  std::array<float, 2>* pBase = pMips->levelData(0);
+  for (size_t i = 0; i < size_t(dim.x) * dim.y; ++i)
+  {
+    pBase[i][1] = pBase[i][0];
+  }
+  pMips->reduceMipmaps([] (std::array<float, 2>& acc, std::array<float, 2> in)
+  {
+    acc[0] = acc[0] < in[0] ? acc[0] : in[0];
+    acc[1] = acc[1] > in[1] ? acc[1] : in[1];
+  });
+}
+
+// Fill pBands (same size) with the band-pass (Laplacian) pyramid of the
+// given Gaussian pyramid (all levels filled in): band level n is level n
+// minus level n + 1 upsampled with nearest filtering, texel
+// min(coord / 2, size - 1), as NVPRO_PYRAMID_STORE_BAND in
+// nvpro_pyramid.glsl. The last band level is set to 0; the last
+// Gaussian level is the residual.
+template <uint32_t Channels>
+inline void cpuGenerateLaplacianBands(const MipmapStorage<float, Channels>& gauss,
+                                      MipmapStorage<float, Channels>* pBands)
+{
+  const auto& dims = gauss.getWidthHeight();
+  assert(pBands->getWidthHeight().size() == dims.size());
+  uint32_t lastLevel = uint32_t(dims.size() - 1);
+  for (uint32_t level = 0; level < lastLevel; ++level)
+  {
+    auto fineDim = dims[level], coarseDim = dims[level + 1];
+    const std::array<float, Channels>* pFine   = gauss.levelData(level);
+    const std::array<float, Channels>* pCoarse = gauss.levelData(level + 1);
+    std::array<float, Channels>*       pBand   = pBands->levelData(level);
+    for (uint32_t y = 0; y < fineDim.y; ++y)
+    {
+      uint32_t coarseY = y / 2 < coarseDim.y ? y / 2 : coarseDim.y - 1;
+      for (uint32_t x = 0; x < fineDim.x; ++x)
+      {
+        uint32_t coarseX = x / 2 < coarseDim.x ? x / 2 : coarseDim.x - 1;
+        const auto& fine   = pFine[y * fineDim.x + x];
+        const auto& coarse = pCoarse[coarseY * coarseDim.x + coarseX];
+        for (uint32_t c = 0; c < Channels; ++c)
+        {
+          pBand[y * fineDim.x + x][c] = fine[c] - coarse[c];
+        }
+      }
+    }
+  }
+  *pBands->levelData(lastLevel) = {};
 }
 
 // Compare contents of the given mipmap pyramid with CPU-generated mipmap.
 // Return human-readable info about worst difference.
-inline std::string testMipmaps(const MipmapStorage<uint8_t, 4>& input)
+inline std::string testMipmaps(const MipmapStorage<uint8_t, 4>& input,
+                               int     wideKernel          = wideKernelNone,
+                               uint8_t alphaCoverageCutoff = 0)
 {
   auto x = input.getWidthHeight()[0].x;
   auto y = input.getWidthHeight()[0].y;
   MipmapStorage<uint8_t, 4> expected(x, y);
   memcpy(expected.levelData(0), input.levelData(0), input.getLevelByteSize(0));
-  cpuGenerateMipmaps_sRGBA(&expected);
+  cpuGenerateMipmaps_sRGBA(&expected, wideKernel, alphaCoverageCutoff);
 
   nvmath::vec3ui worstCoordinate;
   uint32_t       worstChannel;
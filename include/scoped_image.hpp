@@ -28,6 +28,9 @@
 // * Vulkan Staging Buffer
 // * Vulkan Image
 // * Descriptors for accessing the image as sampler and storage image.
+// * Descriptor for accessing the staging buffer as storage buffer; in
+//   this "buffer mode", mipmaps are generated directly in the staging
+//   buffer (srgba8_buffer_preamble.glsl), without using the image.
 //
 // The storage image samplers show the underlying 8-bit integers
 // instead of sRGB, as sRGB images can't be bound as storage images
@@ -75,6 +78,10 @@ class ScopedImage
   // Load and store raw 8-bit unsigned red/green/blue/alpha values.
   nvvk::DescriptorSetContainer m_storageDescriptorContainer;
 
+  // 1 descriptor, for binding the whole staging buffer as storage
+  // buffer (binding=0). Texels are packed as in MipmapStorage.
+  nvvk::DescriptorSetContainer m_bufferDescriptorContainer;
+
   // For debug purposes.
   VkClearColorValue m_magenta;
 
@@ -84,6 +91,7 @@ public:
       : m_device(device)
       , m_textureDescriptorContainer(device)
       , m_storageDescriptorContainer(device)
+      , m_bufferDescriptorContainer(device)
   {
     m_allocator.init(device, physicalDevice);
 
@@ -120,6 +128,11 @@ public:
         VK_SHADER_STAGE_ALL);
     m_storageDescriptorContainer.initLayout();
     m_storageDescriptorContainer.initPool(1);
+
+    m_bufferDescriptorContainer.addBinding(
+        0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_ALL);
+    m_bufferDescriptorContainer.initLayout();
+    m_bufferDescriptorContainer.initPool(1);
   }
 
   ScopedImage(ScopedImage&&) = delete;
@@ -152,6 +165,17 @@ public:
     return m_storageDescriptorContainer.getSet(0);
   }
 
+  VkDescriptorSetLayout getBufferDescriptorSetLayout() const
+  {
+    return m_bufferDescriptorContainer.getLayout();
+  }
+
+  // Only valid once the staging buffer is allocated (resizeStaging).
+  VkDescriptorSet getBufferDescriptorSet() const
+  {
+    return m_bufferDescriptorContainer.getSet(0);
+  }
+
   // Helper for image barrier boilerplate
   void cmdImageBarrier(VkCommandBuffer cmdBuf,
                        VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage,
@@ -190,11 +214,18 @@ public:
     VkBufferCreateInfo stagingBufferInfo = {
       VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO, nullptr, 0,
       m_pCpuMipmap->getByteSize(),
-      VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT};
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+          | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT};
     m_stagingBufferDedicated = m_allocator.createBuffer(
         stagingBufferInfo, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
                                | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
     m_pStagingBufferMap = m_allocator.map(m_stagingBufferDedicated);
+
+    VkDescriptorBufferInfo bufferInfo = {m_stagingBufferDedicated.buffer, 0,
+                                         VK_WHOLE_SIZE};
+    VkWriteDescriptorSet write =
+        m_bufferDescriptorContainer.makeWrite(0, 0, &bufferInfo);
+    vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
   }
 
   // Load named image file's contents to staging buffer.
@@ -454,6 +485,35 @@ public:
         0, 0, nullptr, 1, &bufferBarrier, 0, nullptr);
   }
 
+  // Record barriers around generating mipmaps directly in the staging
+  // buffer (buffer mode): before, for prior host writes (stageImage) and
+  // shader accesses to be visible to compute shaders; after, for the
+  // compute shader writes to be visible to host reads (copyFromStaging),
+  // replacing cmdDownloadImage.
+  void cmdStagingBufferBarrierBefore(VkCommandBuffer cmdBuf) const
+  {
+    VkBufferMemoryBarrier bufferBarrier = {
+      VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER, nullptr,
+      VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+      VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+      0, 0, m_stagingBufferDedicated.buffer, 0, VK_WHOLE_SIZE };
+    vkCmdPipelineBarrier(cmdBuf,
+        VK_PIPELINE_STAGE_HOST_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0, 0, nullptr, 1, &bufferBarrier, 0, nullptr);
+  }
+
+  void cmdStagingBufferBarrierAfter(VkCommandBuffer cmdBuf) const
+  {
+    VkBufferMemoryBarrier bufferBarrier = {
+      VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER, nullptr,
+      VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_HOST_READ_BIT,
+      0, 0, m_stagingBufferDedicated.buffer, 0, VK_WHOLE_SIZE };
+    vkCmdPipelineBarrier(cmdBuf,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+        0, 0, nullptr, 1, &bufferBarrier, 0, nullptr);
+  }
+
   // Copy and return data from staging buffer; optionally skip 0th level.
   std::unique_ptr<MipmapStorage<uint8_t, 4>> copyFromStaging(bool skip0 = false) const
   {
@@ -243,6 +243,11 @@ int main(int argc, char** argv)
   nvvk::ContextCreateInfo deviceInfo;
   deviceInfo.apiMajor = 1;
   deviceInfo.apiMinor = 1;
+  // Optional, for choosing the compute shader subgroup size.
+  VkPhysicalDeviceSubgroupSizeControlFeaturesEXT subgroupSizeControlFeatures = {
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_SIZE_CONTROL_FEATURES_EXT};
+  deviceInfo.addDeviceExtension(VK_EXT_SUBGROUP_SIZE_CONTROL_EXTENSION_NAME,
+                                true, &subgroupSizeControlFeatures);
   ctx.init(deviceInfo);
   ctx.ignoreDebugMessage(1303270965);  // Bogus "general layout" perf warning.
 
@@ -255,23 +260,23 @@ int main(int argc, char** argv)
       VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2, &subgroupProperties};
   vkGetPhysicalDeviceProperties2(ctx.m_physicalDevice, &physicalDeviceProperties);
 
+  // Fix the subgroup size of the pipelines, if possible (subgroupSize
+  // is otherwise the size they run with).
+  subgroupProperties.subgroupSize = chooseComputeSubgroupSize(
+      ctx.m_physicalDevice,
+      ctx.hasDeviceExtension(VK_EXT_SUBGROUP_SIZE_CONTROL_EXTENSION_NAME)
+          && subgroupSizeControlFeatures.subgroupSizeControl);
+
   if (config.forceDisableFastPipeline)
   {
     fprintf(stderr, "Debug: faking missing subgroup features\n");
     subgroupProperties = {};
   }
-  if (subgroupProperties.subgroupSize < 16)
+  if (subgroupProperties.subgroupSize < 4)
   {
-    fprintf(stderr, "fastPipeline not usable: subgroupSize < 16\n");
+    fprintf(stderr, "fastPipeline not usable: subgroupSize < 4\n");
     config.canUseFastPipeline = false;
   }
-  else if (subgroupProperties.subgroupSize != 32)
-  {
-    fprintf(stderr, "\x1b[35m\x1b[1mWARNING:\x1b[0m "
-                    "Only tested with subgroup size 32, not %u.\nI /expect/ "
-                    "it to work anyway, notify dakeley@nvidia.com if not.\n",
-                    subgroupProperties.subgroupSize);
-  }
   if (!(subgroupProperties.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT))
   {
     fprintf(stderr, "fastPipeline not usable: no compute subgroups\n");
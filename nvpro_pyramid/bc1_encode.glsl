@@ -0,0 +1,72 @@
+// Copyright 2021 NVIDIA CORPORATION
+// SPDX-License-Identifier: Apache-2.0
+
+// Fast BC1 (opaque, 4-color mode) block encoding helpers, split up so
+// that a block can be encoded either by one thread holding all 16
+// texels, or cooperatively by the threads holding its parts (see
+// srgba8_bc1_preamble.glsl):
+//
+// 1. Find the color bounding box [lo, hi] of the block.
+// 2. bc1Endpoints: quantize the inset box corners to the 5:6:5 endpoints.
+// 3. bc1Index: for each texel, pick the nearest of the 4 palette
+//    colors along the endpoint axis, and combine the 2-bit indices
+//    (texel (x, y) of the block at bit 2 * (4 * y + x)).
+//
+// Colors are in the [0, 1] space that the BC1 format interpolates in,
+// i.e. sRGB-encoded values for the _SRGB_BLOCK formats. The encoded
+// block is uvec2(endpoints, indices), as stored into an R32G32_UINT
+// view of the compressed image (one view texel per block).
+
+// Quantize the bounding box [lo, hi] (inset by 1/16 of its size, as
+// usual for bounding-box encoders) to the endpoints color0 = max,
+// color1 = min corner. Return them packed as color0 | color1 << 16,
+// and the colors they decode to in color0_/color1_. Since color0 >=
+// color1 per channel, the block always uses 4-color mode, except if
+// they are equal; then bc1Index returns index 0 for every texel.
+uint bc1Endpoints(vec3 lo, vec3 hi, out vec3 color0_, out vec3 color1_)
+{
+  const vec3 scale = vec3(31, 63, 31);
+  vec3       inset = (hi - lo) * (1.0 / 16.0);
+  uvec3      q0    = uvec3(round(clamp(hi - inset, 0.0, 1.0) * scale));
+  uvec3      q1    = uvec3(round(clamp(lo + inset, 0.0, 1.0) * scale));
+  color0_          = vec3(q0) / scale;
+  color1_          = vec3(q1) / scale;
+  uint c0          = q0.r << 11 | q0.g << 5 | q0.b;
+  uint c1          = q1.r << 11 | q1.g << 5 | q1.b;
+  return c0 | c1 << 16;
+}
+
+// Palette index of color, given the decoded endpoints.
+uint bc1Index(vec3 color, vec3 color0, vec3 color1)
+{
+  vec3  axis    = color1 - color0;
+  float length2 = dot(axis, axis);
+  if (length2 == 0.0)
+  {
+    return 0u;
+  }
+  // Steps 0...3 from color0 to color1; palette order is
+  // color0, color1, 2/3 color0 + 1/3 color1, 1/3 color0 + 2/3 color1.
+  float t    = clamp(dot(color - color0, axis) / length2, 0.0, 1.0);
+  uint  step = uint(t * 3.0 + 0.5);
+  return step == 0u ? 0u : step == 3u ? 1u : step + 1u;
+}
+
+// Encode a whole block; texels[4 * y + x] is texel (x, y).
+uvec2 bc1EncodeBlock(vec3 texels[16])
+{
+  vec3 lo = texels[0], hi = texels[0];
+  for (int i = 1; i < 16; ++i)
+  {
+    lo = min(lo, texels[i]);
+    hi = max(hi, texels[i]);
+  }
+  vec3 color0, color1;
+  uint endpoints = bc1Endpoints(lo, hi, color0, color1);
+  uint indices   = 0u;
+  for (int i = 0; i < 16; ++i)
+  {
+    indices |= bc1Index(texels[i], color0, color1) << (2 * i);
+  }
+  return uvec2(endpoints, indices);
+}
@@ -0,0 +1,84 @@
+// Copyright 2021 NVIDIA CORPORATION
+// SPDX-License-Identifier: Apache-2.0
+
+// Defines the pipeline interface and macros for nvproPyramidMain for
+// the downsample half of a bloom chain; EXCEPT that
+// NVPRO_PYRAMID_IS_FAST_PIPELINE is not defined. The upsample half is
+// bloom_upsample.comp, and nvproCmdPyramidBloomDispatch in
+// nvpro_pyramid_bloom.hpp records both.
+//
+// Bloom level 0 is the scene texture, read from a separate texture
+// (only level 0 used); bloom level n > 0 is stored in level n - 1 of
+// the half-size "down" pyramid image, so no full-size scratch image is
+// needed. The level 0 load applies the brightness threshold and the
+// Karis weight 1 / (1 + luma), and levels > 0 store the weighted color
+// (rgb * w, w). As the reduction is then linear, each downsampled texel
+// is the Karis average of its input texels regardless of how the
+// levels are split into dispatches; divide rgb by alpha to recover it.
+//
+// This replaces the usual 13-tap downsample filter: the 2x2 box (3x3
+// for odd sizes) of nvproPyramidMain is what allows fusing several
+// levels per dispatch, and the tent upsample provides the wide kernel.
+//
+// Configuration macros:
+//
+//   * BLOOM_THRESHOLD, BLOOM_KNEE
+// Scene colors with max component below BLOOM_THRESHOLD - BLOOM_KNEE
+// do not bloom; the contribution fades in quadratically over the
+// knee. Defaults 0.8 and 0.2, for LDR input.
+
+#ifndef BLOOM_THRESHOLD
+#define BLOOM_THRESHOLD 0.8
+#endif
+#ifndef BLOOM_KNEE
+#define BLOOM_KNEE 0.2
+#endif
+
+// ************************************************************************
+// Input: scene texture (level 0 only).
+layout(set=0, binding=0) uniform sampler2D bloomSceneTex;
+// Output: downsampled bloom levels; imageMipLevels[n] is bloom level n + 1.
+layout(set=1, binding=0, rgba16f) uniform writeonly image2D imageMipLevels[16];
+// Input: same texture, texture level n is bloom level n + 1.
+layout(set=1, binding=1) uniform sampler2D bloomDownTex;
+
+// ************************************************************************
+// Mandatory macros, except NVPRO_PYRAMID_IS_FAST_PIPELINE
+#define NVPRO_PYRAMID_TYPE vec4
+
+vec4 bloomLoad(ivec2 coord, int level)
+{
+  if (level != 0) return texelFetch(bloomDownTex, coord, level - 1);
+
+  // Soft-knee threshold, then Karis weight.
+  vec3  rgb        = texelFetch(bloomSceneTex, coord, 0).rgb;
+  float brightness = max(rgb.r, max(rgb.g, rgb.b));
+  float soft       = clamp(brightness - BLOOM_THRESHOLD + BLOOM_KNEE,
+                           0.0, 2.0 * BLOOM_KNEE);
+  soft             = soft * soft / (4.0 * BLOOM_KNEE + 1e-4);
+  rgb *= max(soft, brightness - BLOOM_THRESHOLD) / max(brightness, 1e-4);
+  float w = 1.0 / (1.0 + dot(rgb, vec3(0.2126, 0.7152, 0.0722)));
+  return vec4(rgb * w, w);
+}
+#define NVPRO_PYRAMID_LOAD(coord, level, out_) out_ = bloomLoad(coord, level)
+
+#define NVPRO_PYRAMID_REDUCE(a0, v0, a1, v1, a2, v2, out_) \
+  out_ = a0 * v0 + a1 * v1 + a2 * v2
+
+#define NVPRO_PYRAMID_STORE(coord, level, in_) \
+  imageStore(imageMipLevels[level - 1], coord, in_)
+
+ivec2 levelSize(int level)
+{
+  return level == 0 ? textureSize(bloomSceneTex, 0)
+                    : imageSize(imageMipLevels[level - 1]);
+}
+#define NVPRO_PYRAMID_LEVEL_SIZE levelSize
+
+// ************************************************************************
+// Optional macros. No NVPRO_PYRAMID_LOAD_REDUCE4: the threshold and
+// weight are nonlinear, so bilinear sampling can't reduce level 0.
+#define NVPRO_PYRAMID_REDUCE2(v0, v1, out_) out_ = 0.5 * (v0 + v1)
+
+#define NVPRO_PYRAMID_REDUCE4(v00, v01, v10, v11, out_) \
+  out_ = 0.25 * ((v00 + v01) + (v10 + v11))
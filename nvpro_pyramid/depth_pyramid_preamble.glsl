@@ -0,0 +1,141 @@
+// Copyright 2021 NVIDIA CORPORATION
+// SPDX-License-Identifier: Apache-2.0
+
+// Defines the pipeline interface and macros for nvproPyramidMain for
+// a hierarchical depth buffer (Hi-Z) generation shader, as used for
+// occlusion culling; EXCEPT that NVPRO_PYRAMID_IS_FAST_PIPELINE is
+// not defined.
+//
+// Configuration macros:
+//
+//   * DEPTH_PYRAMID_MODE
+// DEPTH_PYRAMID_MIN (default), DEPTH_PYRAMID_MAX, or DEPTH_PYRAMID_MINMAX.
+// The first two write an R32F pyramid; DEPTH_PYRAMID_MINMAX writes the
+// min depth to red and the max depth to green of an RG32F pyramid.
+//
+//   * DEPTH_PYRAMID_SEPARATE_BASE
+// If nonzero, mip level 0 is read from a separate texture (typically
+// the D32 depth buffer itself, which can't be bound as storage image),
+// and level 0 of the pyramid image is never accessed.
+//
+//   * USE_SAMPLER_REDUCTION
+// If nonzero, the texture sampler(s) must have been created with
+// VK_SAMPLER_REDUCTION_MODE_MIN (DEPTH_PYRAMID_MIN) or _MAX
+// (DEPTH_PYRAMID_MAX), linear filtering, and nearest mipmap mode; the
+// fast pipeline then loads and reduces 2x2 texel squares with a
+// single sample. Not supported for DEPTH_PYRAMID_MINMAX.
+//
+// Unlike the color preambles, the reduction ignores the kernel
+// weights: every texel covered by the (up to 3x3) footprint of an
+// output texel contributes to its min/max. This is what makes the
+// pyramid conservative for odd-size levels, as the weights of the
+// edge texels of the 3x3 kernel are small but never zero.
+
+#define DEPTH_PYRAMID_MIN 0
+#define DEPTH_PYRAMID_MAX 1
+#define DEPTH_PYRAMID_MINMAX 2
+
+#ifndef DEPTH_PYRAMID_MODE
+#define DEPTH_PYRAMID_MODE DEPTH_PYRAMID_MIN
+#endif
+
+#if DEPTH_PYRAMID_MODE == DEPTH_PYRAMID_MINMAX && defined(USE_SAMPLER_REDUCTION) && USE_SAMPLER_REDUCTION
+#error "USE_SAMPLER_REDUCTION not supported for DEPTH_PYRAMID_MINMAX"
+#endif
+
+// ************************************************************************
+// Input: Entire pyramid texture; use nearest mipmap mode.
+layout(set=0, binding=0) uniform sampler2D depthTex;
+#if defined(DEPTH_PYRAMID_SEPARATE_BASE) && DEPTH_PYRAMID_SEPARATE_BASE
+// Input: base depth texture (level 0 only), e.g. D32 depth buffer.
+layout(set=0, binding=1) uniform sampler2D depthBaseTex;
+#endif
+// Output: Same texture, imageMipLevels[n] refers to mip level n.
+#if DEPTH_PYRAMID_MODE == DEPTH_PYRAMID_MINMAX
+layout(set=1, binding=0, rg32f) uniform writeonly image2D imageMipLevels[16];
+#else
+layout(set=1, binding=0, r32f) uniform writeonly image2D imageMipLevels[16];
+#endif
+
+// ************************************************************************
+// Mandatory macros, except NVPRO_PYRAMID_IS_FAST_PIPELINE
+#if DEPTH_PYRAMID_MODE == DEPTH_PYRAMID_MINMAX
+  #define NVPRO_PYRAMID_TYPE vec2
+
+  // The base level stores one depth, used as both the min and max.
+  vec2 depthMinMaxFetch(ivec2 coord, int level)
+  {
+  #if defined(DEPTH_PYRAMID_SEPARATE_BASE) && DEPTH_PYRAMID_SEPARATE_BASE
+    if (level == 0) return texelFetch(depthBaseTex, coord, 0).rr;
+  #else
+    if (level == 0) return texelFetch(depthTex, coord, 0).rr;
+  #endif
+    return texelFetch(depthTex, coord, level).rg;
+  }
+  #define NVPRO_PYRAMID_LOAD(coord, level, out_) \
+    out_ = depthMinMaxFetch(coord, level)
+
+  #define DEPTH_PYRAMID_REDUCE2_(v0, v1) \
+    vec2(min(v0.x, v1.x), max(v0.y, v1.y))
+#else
+  #define NVPRO_PYRAMID_TYPE float
+
+  float depthFetch(ivec2 coord, int level)
+  {
+  #if defined(DEPTH_PYRAMID_SEPARATE_BASE) && DEPTH_PYRAMID_SEPARATE_BASE
+    if (level == 0) return texelFetch(depthBaseTex, coord, 0).r;
+  #endif
+    return texelFetch(depthTex, coord, level).r;
+  }
+  #define NVPRO_PYRAMID_LOAD(coord, level, out_) \
+    out_ = depthFetch(coord, level)
+
+  #if DEPTH_PYRAMID_MODE == DEPTH_PYRAMID_MAX
+    #define DEPTH_PYRAMID_REDUCE2_(v0, v1) max(v0, v1)
+  #else
+    #define DEPTH_PYRAMID_REDUCE2_(v0, v1) min(v0, v1)
+  #endif
+#endif
+
+// Weights ignored, see top of file.
+#define NVPRO_PYRAMID_REDUCE(a0, v0, a1, v1, a2, v2, out_) \
+  out_ = DEPTH_PYRAMID_REDUCE2_(DEPTH_PYRAMID_REDUCE2_(v0, v1), v2)
+
+#if DEPTH_PYRAMID_MODE == DEPTH_PYRAMID_MINMAX
+  #define NVPRO_PYRAMID_STORE(coord, level, in_) \
+    imageStore(imageMipLevels[level], coord, vec4(in_, 0, 0))
+#else
+  #define NVPRO_PYRAMID_STORE(coord, level, in_) \
+    imageStore(imageMipLevels[level], coord, vec4(in_, 0, 0, 0))
+#endif
+
+ivec2 levelSize(int level) { return imageSize(imageMipLevels[level]); }
+#define NVPRO_PYRAMID_LEVEL_SIZE levelSize
+
+// ************************************************************************
+// Optional macros (including recommended NVPRO_PYRAMID_LOAD_REDUCE4)
+#define NVPRO_PYRAMID_REDUCE2(v0, v1, out_) out_ = DEPTH_PYRAMID_REDUCE2_(v0, v1)
+
+#define NVPRO_PYRAMID_REDUCE4(v00, v01, v10, v11, out_) \
+  out_ = DEPTH_PYRAMID_REDUCE2_(DEPTH_PYRAMID_REDUCE2_(v00, v01), \
+                                DEPTH_PYRAMID_REDUCE2_(v10, v11))
+
+#if defined(USE_SAMPLER_REDUCTION) && USE_SAMPLER_REDUCTION
+  void loadReduce4(in ivec2 srcTexelCoord, in int srcLevel, out float out_)
+  {
+    // Sample in the exact center of the 4 texels we want (see
+    // srgba8_mipmap_preamble.glsl); the min/max reduction sampler
+    // returns the min/max of the 4 texels instead of their average.
+    vec2 normCoord = (vec2(srcTexelCoord) + vec2(1))
+                   / vec2(imageSize(imageMipLevels[srcLevel]));
+  #if defined(DEPTH_PYRAMID_SEPARATE_BASE) && DEPTH_PYRAMID_SEPARATE_BASE
+    if (srcLevel == 0)
+    {
+      out_ = textureLod(depthBaseTex, normCoord, 0).r;
+      return;
+    }
+  #endif
+    out_ = textureLod(depthTex, normCoord, srcLevel).r;
+  }
+  #define NVPRO_PYRAMID_LOAD_REDUCE4 loadReduce4
+#endif
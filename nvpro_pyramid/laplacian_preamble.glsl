@@ -0,0 +1,54 @@
+// Copyright 2021 NVIDIA CORPORATION
+// SPDX-License-Identifier: Apache-2.0
+
+// Defines the pipeline interface and macros for nvproPyramidMain for
+// generating a linear RGBA16F Gaussian pyramid and, in the same
+// dispatches, its Laplacian (band-pass) pyramid, e.g. for multi-band
+// blending or detail-preserving tone mapping; EXCEPT that
+// NVPRO_PYRAMID_IS_FAST_PIPELINE is not defined.
+//
+// Band level n is Gaussian level n minus Gaussian level n + 1,
+// upsampled with nearest filtering (texel min(coord / 2, size - 1), see
+// NVPRO_PYRAMID_STORE_BAND), so that the Gaussian level is rebuilt
+// exactly by adding the band to the upsampled next level. Band levels
+// 0 to levels - 2 are written; the last Gaussian level is the residual.
+// Nearest is deliberate: a bilinear or tent expand would need the
+// coarser neighbors, which are not in the thread's registers.
+//
+// The input level of each dispatch is loaded texel by texel (its bands
+// need every texel), so there is no NVPRO_PYRAMID_LOAD_REDUCE4.
+
+// ************************************************************************
+// Input: Entire Gaussian pyramid (level 0 filled in).
+layout(set=0, binding=0) uniform sampler2D gaussTex;
+// Output: Same texture, imageMipLevels[n] refers to mip level n.
+layout(set=1, binding=0, rgba16f) uniform writeonly image2D imageMipLevels[16];
+// Output: Band pyramid, same size and mip levels as the Gaussian one
+// (its last level is not written).
+layout(set=1, binding=1, rgba16f) uniform writeonly image2D bandMipLevels[16];
+
+// ************************************************************************
+// Mandatory macros, except NVPRO_PYRAMID_IS_FAST_PIPELINE
+#define NVPRO_PYRAMID_TYPE vec4
+
+#define NVPRO_PYRAMID_LOAD(coord, level, out_) \
+  out_ = texelFetch(gaussTex, coord, level)
+
+#define NVPRO_PYRAMID_REDUCE(a0, v0, a1, v1, a2, v2, out_) \
+   out_ = a0 * v0 + a1 * v1 + a2 * v2
+
+#define NVPRO_PYRAMID_STORE(coord, level, in_) \
+  imageStore(imageMipLevels[level], coord, in_)
+
+ivec2 levelSize(int level) { return imageSize(imageMipLevels[level]); }
+#define NVPRO_PYRAMID_LEVEL_SIZE levelSize
+
+// ************************************************************************
+// Optional macros
+#define NVPRO_PYRAMID_REDUCE2(v0, v1, out_) out_ = 0.5 * (v0 + v1)
+
+#define NVPRO_PYRAMID_REDUCE4(v00, v01, v10, v11, out_) \
+  out_ = 0.25 * ((v00 + v01) + (v10 + v11))
+
+#define NVPRO_PYRAMID_STORE_BAND(coord, level, in_, coarse_) \
+  imageStore(bandMipLevels[level], coord, in_ - coarse_)
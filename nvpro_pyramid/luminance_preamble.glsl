@@ -0,0 +1,110 @@
+// Copyright 2021 NVIDIA CORPORATION
+// SPDX-License-Identifier: Apache-2.0
+
+// Defines the pipeline interface and macros for nvproPyramidMain for
+// reducing an image to its average log2 luminance (e.g. for
+// auto-exposure); EXCEPT that NVPRO_PYRAMID_IS_FAST_PIPELINE is not defined.
+//
+// No mip chain is stored: NVPRO_PYRAMID_SKIP_INTERMEDIATE_STORE is
+// set, so only the last level of each dispatch is stored, into a
+// scratch buffer holding one float per texel for the levels that may
+// be handed off to the next dispatch, packed coarsest first (see
+// nvproPyramidLuminanceScratchBytes in nvpro_pyramid_luminance.hpp).
+// The final 1x1 level goes to the result buffer instead. The source
+// image is thus read once, and only the small hand-off levels are
+// written and read again.
+//
+// Dispatch with nvproCmdPyramidDispatch, mipLevels = 0 (the full chain
+// down to 1x1); with the default dispatchers, every dispatch fills at
+// least 2 levels unless it reaches the final level, so level 1 is never
+// handed off and needs no scratch space. The source image must be
+// larger than 1x1.
+//
+// The 3x3 kernel used for odd sizes weights every input texel equally
+// in total, so the result is the exact average for any image size.
+//
+// Configuration macros:
+//
+//   * LUMINANCE_MIN
+// Luminance is clamped to at least this before taking log2 (default
+// 2^-16), so that black texels don't make the average -infinity.
+
+#ifndef LUMINANCE_MIN
+#define LUMINANCE_MIN (1.0 / 65536.0)
+#endif
+
+#define NVPRO_PYRAMID_SKIP_INTERMEDIATE_STORE 1
+
+// ************************************************************************
+// Input: source image (level 0 only); color texture, luminance in rgb.
+layout(set=0, binding=0) uniform sampler2D luminanceSrcTex;
+// Scratch buffer for levels handed off between dispatches.
+layout(set=1, binding=0) buffer LuminanceScratchBuffer
+{
+  float luminanceScratch[];
+};
+// Output: average log2 luminance of the source image.
+layout(set=1, binding=1) buffer LuminanceResultBuffer
+{
+  float luminanceResult;
+};
+
+// ************************************************************************
+// Mandatory macros, except NVPRO_PYRAMID_IS_FAST_PIPELINE
+#define NVPRO_PYRAMID_TYPE float
+
+// Level sizes follow the base size, as in nvproCmdPyramidDispatch.
+ivec2 levelSize(int level)
+{
+  return max(textureSize(luminanceSrcTex, 0) >> level, ivec2(1));
+}
+#define NVPRO_PYRAMID_LEVEL_SIZE levelSize
+
+// Offset of the given level within the scratch buffer; coarser
+// levels, excluding the final 1x1 level, come first.
+uint luminanceScratchOffset(int level)
+{
+  uint offset = 0u;
+  for (ivec2 size = levelSize(++level); size != ivec2(1); size = levelSize(++level))
+  {
+    offset += uint(size.x * size.y);
+  }
+  return offset;
+}
+
+float luminanceLoad(ivec2 coord, int level)
+{
+  if (level == 0)
+  {
+    vec3 rgb = texelFetch(luminanceSrcTex, coord, 0).rgb;
+    return log2(max(dot(rgb, vec3(0.2126, 0.7152, 0.0722)), LUMINANCE_MIN));
+  }
+  uint index = luminanceScratchOffset(level) + uint(coord.y * levelSize(level).x + coord.x);
+  return luminanceScratch[index];
+}
+#define NVPRO_PYRAMID_LOAD(coord, level, out_) out_ = luminanceLoad(coord, level)
+
+#define NVPRO_PYRAMID_REDUCE(a0, v0, a1, v1, a2, v2, out_) \
+  out_ = a0 * v0 + a1 * v1 + a2 * v2
+
+void luminanceStore(ivec2 coord, int level, float in_)
+{
+  ivec2 size = levelSize(level);
+  if (size == ivec2(1))
+  {
+    luminanceResult = in_;
+  }
+  else
+  {
+    luminanceScratch[luminanceScratchOffset(level) + uint(coord.y * size.x + coord.x)] = in_;
+  }
+}
+#define NVPRO_PYRAMID_STORE(coord, level, in_) luminanceStore(coord, level, in_)
+
+// ************************************************************************
+// Optional macros. No NVPRO_PYRAMID_LOAD_REDUCE4: log2 is nonlinear, so
+// bilinear sampling can't reduce level 0.
+#define NVPRO_PYRAMID_REDUCE2(v0, v1, out_) out_ = 0.5 * (v0 + v1)
+
+#define NVPRO_PYRAMID_REDUCE4(v00, v01, v10, v11, out_) \
+  out_ = 0.25 * ((v00 + v01) + (v10 + v11))
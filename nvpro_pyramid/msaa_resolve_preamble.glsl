@@ -0,0 +1,115 @@
+// Copyright 2021 NVIDIA CORPORATION
+// SPDX-License-Identifier: Apache-2.0
+
+// Defines the pipeline interface and macros for nvproPyramidMain for
+// generating a linear (HDR) RGBA16F pyramid directly from a
+// multisampled color target, resolving it on the fly; EXCEPT that
+// NVPRO_PYRAMID_IS_FAST_PIPELINE is not defined. This replaces a
+// separate resolve pass, and the read of the full-resolution resolved
+// image that would follow.
+//
+// Level 0 of the pyramid (same size as the multisampled image) is never
+// read. Loads from level 0 average the samples of the multisampled image
+// instead (box resolve) and, if MSAA_STORE_BASE is nonzero, also store
+// the resolved texel to level 0. In the fast pipeline, each level 0
+// texel is loaded exactly once; in the general pipeline (odd sizes),
+// texels on the edge of 3x3 kernels may be resolved and stored more
+// than once, with the same value.
+//
+// Configuration macros:
+//
+//   * MSAA_SAMPLES
+// Sample count of the multisampled image (default 4).
+//
+//   * MSAA_STORE_BASE
+// If nonzero (default), write the resolved image to level 0; if zero,
+// only levels 1+ are written (e.g. when only the blurred levels are
+// needed, as for bloom or SSR).
+//
+//   * USE_BILINEAR_SAMPLING
+// If zero, do not use the sampler to reduce 2x2 texel squares of levels
+// 1+ (see NVPRO_PYRAMID_LOAD_REDUCE4). Otherwise, the pyramid sampler
+// must use linear filtering.
+
+#ifndef MSAA_SAMPLES
+#define MSAA_SAMPLES 4
+#endif
+#ifndef MSAA_STORE_BASE
+#define MSAA_STORE_BASE 1
+#endif
+
+// ************************************************************************
+// Input: Entire pyramid texture with bilinear filtering (nearest mipmap
+//        mode); levels 1+ are read.
+layout(set=0, binding=0) uniform sampler2D pyramidTex;
+// Input: The multisampled image to resolve, MSAA_SAMPLES samples.
+layout(set=0, binding=1) uniform sampler2DMS msaaTex;
+// Output: Pyramid texture, imageMipLevels[n] refers to mip level n.
+layout(set=1, binding=0, rgba16f) uniform writeonly image2D imageMipLevels[16];
+
+// ************************************************************************
+// Resolve the given texel of the multisampled image, storing it to
+// level 0 of the pyramid if MSAA_STORE_BASE is nonzero.
+vec4 msaaResolve(ivec2 coord)
+{
+  vec4 sum = vec4(0);
+  for (int s = 0; s < MSAA_SAMPLES; ++s)
+  {
+    sum += texelFetch(msaaTex, coord, s);
+  }
+  vec4 resolved = sum * (1.0 / MSAA_SAMPLES);
+#if MSAA_STORE_BASE
+  imageStore(imageMipLevels[0], coord, resolved);
+#endif
+  return resolved;
+}
+
+// ************************************************************************
+// Mandatory macros, except NVPRO_PYRAMID_IS_FAST_PIPELINE
+#define NVPRO_PYRAMID_TYPE vec4
+
+vec4 msaaLoad(ivec2 coord, int level)
+{
+  if (level == 0) return msaaResolve(coord);
+  return texelFetch(pyramidTex, coord, level);
+}
+#define NVPRO_PYRAMID_LOAD(coord, level, out_) out_ = msaaLoad(coord, level)
+
+#define NVPRO_PYRAMID_REDUCE(a0, v0, a1, v1, a2, v2, out_) \
+   out_ = a0 * v0 + a1 * v1 + a2 * v2
+
+#define NVPRO_PYRAMID_STORE(coord, level, in_) \
+  imageStore(imageMipLevels[level], coord, in_)
+
+ivec2 levelSize(int level) { return imageSize(imageMipLevels[level]); }
+#define NVPRO_PYRAMID_LEVEL_SIZE levelSize
+
+// ************************************************************************
+// Optional macros (including recommended NVPRO_PYRAMID_LOAD_REDUCE4)
+#define NVPRO_PYRAMID_REDUCE2(v0, v1, out_) out_ = 0.5 * (v0 + v1)
+
+#define NVPRO_PYRAMID_REDUCE4(v00, v01, v10, v11, out_) \
+  out_ = 0.25 * ((v00 + v01) + (v10 + v11))
+
+// Always defined, for the level 0 resolve; levels 1+ use the sampler
+// to reduce the 2x2 square unless USE_BILINEAR_SAMPLING is zero.
+void loadReduce4(in ivec2 srcTexelCoord, in int srcLevel, out vec4 out_)
+{
+#if !defined(USE_BILINEAR_SAMPLING) || USE_BILINEAR_SAMPLING
+  if (srcLevel != 0)
+  {
+    // Sample in the exact center of the 4 texels we want (see
+    // srgba8_mipmap_preamble.glsl).
+    vec2 normCoord = (vec2(srcTexelCoord) + vec2(1))
+                   / vec2(imageSize(imageMipLevels[srcLevel]));
+    out_ = textureLod(pyramidTex, normCoord, srcLevel);
+    return;
+  }
+#endif
+  vec4 v00 = msaaLoad(srcTexelCoord, srcLevel);
+  vec4 v01 = msaaLoad(srcTexelCoord + ivec2(0, 1), srcLevel);
+  vec4 v10 = msaaLoad(srcTexelCoord + ivec2(1, 0), srcLevel);
+  vec4 v11 = msaaLoad(srcTexelCoord + ivec2(1, 1), srcLevel);
+  NVPRO_PYRAMID_REDUCE4(v00, v01, v10, v11, out_);
+}
+#define NVPRO_PYRAMID_LOAD_REDUCE4 loadReduce4
@@ -0,0 +1,90 @@
+// Copyright 2021 NVIDIA CORPORATION
+// SPDX-License-Identifier: Apache-2.0
+
+// Defines the pipeline interface and macros for nvproPyramidMain for
+// tangent-space normal map mipmap generation; EXCEPT that
+// NVPRO_PYRAMID_IS_FAST_PIPELINE is not defined.
+//
+// Normals are stored as 2 channels (x, y; z is reconstructed as
+// sqrt(1 - x^2 - y^2)), as in RG8 or BC5 normal maps. The kernel
+// averages the unnormalized vectors; NVPRO_PYRAMID_STORE renormalizes
+// them for the normal map, and writes the Toksvig variance derived
+// from the length of the average |Na|, (1 - |Na|) / |Na|, to a second
+// (roughness) image pyramid in the same dispatch. This replaces the
+// separate roughness pass over every mip level.
+//
+// NVPRO_PYRAMID_LOAD reconstructs the unnormalized average from both
+// images (|Na| = 1 / (1 + variance)) so that the result does not depend
+// on how the levels are split between dispatches (besides quantization).
+// Level 0 of the roughness pyramid is not accessed (unit input normals).
+//
+// Configuration macros:
+//
+//   * NORMAL_MAP_SNORM
+// If nonzero, the normal map is rg8_snorm (components in [-1, 1]);
+// otherwise rg8 unorm, with components encoded as 0.5 * n + 0.5.
+
+// ************************************************************************
+// Input: Entire normal map texture; use nearest mipmap mode.
+layout(set=0, binding=0) uniform sampler2D normalTex;
+// Output: Same texture, imageMipLevels[n] refers to mip level n.
+#if defined(NORMAL_MAP_SNORM) && NORMAL_MAP_SNORM
+layout(set=1, binding=0, rg8_snorm) uniform writeonly image2D imageMipLevels[16];
+#else
+layout(set=1, binding=0, rg8) uniform writeonly image2D imageMipLevels[16];
+#endif
+// Input/Output: Toksvig variance pyramid, same mip levels as normalTex.
+layout(set=1, binding=1, r16f) uniform image2D imageRoughnessLevels[16];
+
+// ************************************************************************
+// Mandatory macros, except NVPRO_PYRAMID_IS_FAST_PIPELINE
+#define NVPRO_PYRAMID_TYPE vec3
+
+vec3 normalDecode(vec2 encoded)
+{
+#if defined(NORMAL_MAP_SNORM) && NORMAL_MAP_SNORM
+  vec2 xy = encoded;
+#else
+  vec2 xy = encoded * 2.0 - 1.0;
+#endif
+  return vec3(xy, sqrt(max(0.0, 1.0 - dot(xy, xy))));
+}
+
+vec3 normalLoad(ivec2 coord, int level)
+{
+  vec3 normal = normalDecode(texelFetch(normalTex, coord, level).rg);
+  if (level == 0) return normal;
+  float variance = imageLoad(imageRoughnessLevels[level], coord).r;
+  return normal * (1.0 / (1.0 + variance));
+}
+#define NVPRO_PYRAMID_LOAD(coord, level, out_) out_ = normalLoad(coord, level)
+
+#define NVPRO_PYRAMID_REDUCE(a0, v0, a1, v1, a2, v2, out_) \
+   out_ = a0 * v0 + a1 * v1 + a2 * v2
+
+void normalStore(ivec2 coord, int level, vec3 average)
+{
+  // Normals facing opposite directions may cancel out; pick +z then.
+  float len      = length(average);
+  vec3  normal   = len < 1e-6 ? vec3(0, 0, 1) : average / len;
+  float variance = len < 1e-6 ? 65504.0 : min(65504.0, (1.0 - len) / len);
+#if defined(NORMAL_MAP_SNORM) && NORMAL_MAP_SNORM
+  imageStore(imageMipLevels[level], coord, vec4(normal.xy, 0, 0));
+#else
+  imageStore(imageMipLevels[level], coord, vec4(normal.xy * 0.5 + 0.5, 0, 0));
+#endif
+  imageStore(imageRoughnessLevels[level], coord, vec4(max(0.0, variance)));
+}
+#define NVPRO_PYRAMID_STORE(coord, level, in_) normalStore(coord, level, in_)
+
+ivec2 levelSize(int level) { return imageSize(imageMipLevels[level]); }
+#define NVPRO_PYRAMID_LEVEL_SIZE levelSize
+
+// ************************************************************************
+// Optional macros
+// No NVPRO_PYRAMID_LOAD_REDUCE4: bilinear filtering would average the
+// encoded x, y but not the reconstructed z.
+#define NVPRO_PYRAMID_REDUCE2(v0, v1, out_) out_ = 0.5 * (v0 + v1)
+
+#define NVPRO_PYRAMID_REDUCE4(v00, v01, v10, v11, out_) \
+  out_ = 0.25 * ((v00 + v01) + (v10 + v11))
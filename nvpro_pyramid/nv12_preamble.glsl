@@ -0,0 +1,177 @@
+// Copyright 2021 NVIDIA CORPORATION
+// SPDX-License-Identifier: Apache-2.0
+
+// Defines the pipeline interface and macros for nvproPyramidMain for
+// generating a pyramid from an NV12 (YUV 4:2:0) video frame, read
+// directly from its Y and CbCr planes; EXCEPT that
+// NVPRO_PYRAMID_IS_FAST_PIPELINE is not defined. This replaces a
+// separate NV12 -> RGBA conversion pass and its full-resolution
+// intermediate image: level 0 of the output pyramid is never accessed.
+//
+// The Y plane is full resolution (R8_UNORM, or a plane view of a
+// G8_B8R8_2PLANE_420_UNORM image); the CbCr plane is ceil(width / 2) x
+// ceil(height / 2) (R8G8_UNORM). Every luma texel uses the chroma texel
+// covering it (coord / 2), also in the odd-size 3-texel kernels, where
+// the 3 luma texels of a row or column may straddle 2 chroma texels;
+// the 2x2 squares of the even-size kernels always share one.
+//
+// Samples are filtered as stored (gamma-encoded, as the RGBA8 pyramid
+// of the converted frame would be). The YCbCr -> RGB conversion is
+// affine, so converting before or after averaging gives the same result.
+//
+// Configuration macros:
+//
+//   * NV12_SEPARATE_PLANES
+// If zero (default), write an RGBA8 pyramid: level n+1 at set=1,
+// binding=0, read back at set=0, binding=0 by later dispatches. If
+// nonzero, instead write a luma (R8) pyramid at set=1, binding=0
+// (set=0, binding=0 for reads) and a chroma (R8G8) pyramid of the same
+// size and mip levels at set=1, binding=1 (set=0, binding=3 for reads),
+// without color conversion. The chroma pyramid is at luma resolution,
+// so its level n+1 doubles as the 4:2:0 chroma of luma level n (exactly
+// for even sizes).
+//
+//   * NV12_MATRIX
+// NV12_MATRIX_BT709 (default) or NV12_MATRIX_BT601; only used for the
+// RGBA pyramid.
+//
+//   * NV12_FULL_RANGE
+// If zero (default), Y and CbCr use limited ("video") range; only used
+// for the RGBA pyramid.
+//
+//   * USE_BILINEAR_SAMPLING
+// If zero, do not use the sampler to reduce 2x2 texel squares (see
+// NVPRO_PYRAMID_LOAD_REDUCE4). Otherwise, the luma and pyramid samplers
+// must use linear filtering; chroma is always fetched.
+
+#define NV12_MATRIX_BT709 0
+#define NV12_MATRIX_BT601 1
+
+#ifndef NV12_SEPARATE_PLANES
+#define NV12_SEPARATE_PLANES 0
+#endif
+#ifndef NV12_MATRIX
+#define NV12_MATRIX NV12_MATRIX_BT709
+#endif
+#ifndef NV12_FULL_RANGE
+#define NV12_FULL_RANGE 0
+#endif
+
+// ************************************************************************
+// Input: Y and CbCr planes of the frame (level 0 only).
+layout(set=0, binding=1) uniform sampler2D lumaPlaneTex;
+layout(set=0, binding=2) uniform sampler2D chromaPlaneTex;
+#if NV12_SEPARATE_PLANES
+// Input: Entire luma and chroma pyramids (levels 1+ are read).
+layout(set=0, binding=0) uniform sampler2D lumaTex;
+layout(set=0, binding=3) uniform sampler2D chromaTex;
+// Output: Same textures, imageMipLevels[n] / chromaMipLevels[n] refer
+//         to mip level n.
+layout(set=1, binding=0, r8) uniform writeonly image2D imageMipLevels[16];
+layout(set=1, binding=1, rg8) uniform writeonly image2D chromaMipLevels[16];
+#else
+// Input: Entire RGBA8 pyramid (levels 1+ are read).
+layout(set=0, binding=0) uniform sampler2D rgbaTex;
+// Output: Same texture, imageMipLevels[n] refers to mip level n.
+layout(set=1, binding=0, rgba8) uniform writeonly image2D imageMipLevels[16];
+#endif
+
+// ************************************************************************
+// Color conversion
+#if !NV12_SEPARATE_PLANES
+  vec3 rgbFromYcbcr(vec3 ycbcr)
+  {
+  #if NV12_FULL_RANGE
+    float y  = ycbcr.x;
+    vec2  cc = ycbcr.yz - 128. / 255.;
+  #else
+    float y  = (ycbcr.x - 16. / 255.) * (255. / 219.);
+    vec2  cc = (ycbcr.yz - 128. / 255.) * (255. / 224.);
+  #endif
+  #if NV12_MATRIX == NV12_MATRIX_BT601
+    return vec3(y + 1.402 * cc.y, y - 0.344136 * cc.x - 0.714136 * cc.y,
+                y + 1.772 * cc.x);
+  #else
+    return vec3(y + 1.5748 * cc.y, y - 0.187324 * cc.x - 0.468124 * cc.y,
+                y + 1.8556 * cc.x);
+  #endif
+  }
+#endif
+
+// Y, Cb, Cr of the given texel of level 0.
+vec3 nv12PlaneFetch(ivec2 coord)
+{
+  return vec3(texelFetch(lumaPlaneTex, coord, 0).r,
+              texelFetch(chromaPlaneTex, coord >> 1, 0).rg);
+}
+
+// ************************************************************************
+// Mandatory macros, except NVPRO_PYRAMID_IS_FAST_PIPELINE
+#define NVPRO_PYRAMID_TYPE vec3
+
+vec3 nv12Load(ivec2 coord, int level)
+{
+#if NV12_SEPARATE_PLANES
+  if (level == 0) return nv12PlaneFetch(coord);
+  return vec3(texelFetch(lumaTex, coord, level).r,
+              texelFetch(chromaTex, coord, level).rg);
+#else
+  if (level == 0) return rgbFromYcbcr(nv12PlaneFetch(coord));
+  return texelFetch(rgbaTex, coord, level).rgb;
+#endif
+}
+#define NVPRO_PYRAMID_LOAD(coord, level, out_) out_ = nv12Load(coord, level)
+
+#define NVPRO_PYRAMID_REDUCE(a0, v0, a1, v1, a2, v2, out_) \
+   out_ = a0 * v0 + a1 * v1 + a2 * v2
+
+void nv12Store(ivec2 coord, int level, vec3 in_)
+{
+#if NV12_SEPARATE_PLANES
+  imageStore(imageMipLevels[level], coord, vec4(in_.x, 0, 0, 0));
+  imageStore(chromaMipLevels[level], coord, vec4(in_.yz, 0, 0));
+#else
+  imageStore(imageMipLevels[level], coord, vec4(in_, 1));
+#endif
+}
+#define NVPRO_PYRAMID_STORE(coord, level, in_) nv12Store(coord, level, in_)
+
+ivec2 levelSize(int level) { return imageSize(imageMipLevels[level]); }
+#define NVPRO_PYRAMID_LEVEL_SIZE levelSize
+
+// ************************************************************************
+// Optional macros (including recommended NVPRO_PYRAMID_LOAD_REDUCE4)
+#define NVPRO_PYRAMID_REDUCE2(v0, v1, out_) out_ = 0.5 * (v0 + v1)
+
+#define NVPRO_PYRAMID_REDUCE4(v00, v01, v10, v11, out_) \
+  out_ = 0.25 * ((v00 + v01) + (v10 + v11))
+
+#if !defined(USE_BILINEAR_SAMPLING) || USE_BILINEAR_SAMPLING
+  void loadReduce4(in ivec2 srcTexelCoord, in int srcLevel, out vec3 out_)
+  {
+    // Sample in the exact center of the 4 texels we want (see
+    // srgba8_mipmap_preamble.glsl).
+    vec2 normCoord = (vec2(srcTexelCoord) + vec2(1))
+                   / vec2(imageSize(imageMipLevels[srcLevel]));
+    if (srcLevel == 0)
+    {
+      // srcTexelCoord is even here (fast pipeline), so the 4 luma
+      // texels share the chroma texel at srcTexelCoord / 2.
+      vec3 ycbcr = vec3(textureLod(lumaPlaneTex, normCoord, 0).r,
+                        texelFetch(chromaPlaneTex, srcTexelCoord >> 1, 0).rg);
+  #if NV12_SEPARATE_PLANES
+      out_ = ycbcr;
+  #else
+      out_ = rgbFromYcbcr(ycbcr);
+  #endif
+      return;
+    }
+  #if NV12_SEPARATE_PLANES
+    out_ = vec3(textureLod(lumaTex, normCoord, srcLevel).r,
+                textureLod(chromaTex, normCoord, srcLevel).rg);
+  #else
+    out_ = textureLod(rgbaTex, normCoord, srcLevel).rgb;
+  #endif
+  }
+  #define NVPRO_PYRAMID_LOAD_REDUCE4 loadReduce4
+#endif
@@ -57,9 +57,17 @@
 //
 // NvproPyramidPipelines::fastPipeline requires these three abilities:
 // #extension GL_KHR_shader_subgroup_shuffle : enable
-// VkPhysicalDeviceSubgroupProperties::subgroupSize >= 16
+// VkPhysicalDeviceSubgroupProperties::subgroupSize >= 4
 // VkPhysicalDeviceSubgroupProperties::supportedOperations & VK_SUBGROUP_FEATURE_SHUFFLE_BIT
 //
+// Subgroup sizes 4 to 64 (powers of 2) are supported; the subgroup size
+// must be the same for all subgroups of a workgroup (i.e. do not create
+// the pipeline with VK_PIPELINE_SHADER_STAGE_CREATE_ALLOW_VARYING_SUBGROUP_SIZE_BIT).
+// Below 16, one of the shuffle stages goes through shared memory
+// instead, so if VK_EXT_subgroup_size_control is available, prefer
+// creating the pipeline with a required subgroup size of 16 to 64
+// (32 is the most tested), and defining NVPRO_PYRAMID_MIN_SUBGROUP_SIZE.
+//
 //         The following macros are optional:
 //
 //   * NVPRO_PYRAMID_PUSH_CONSTANT
@@ -88,11 +96,126 @@
 //   * do speed comparisons without defining NVPRO_PYRAMID_LOAD_REDUCE4!!! *
 //   ***********************************************************************
 //
+//   * NVPRO_PYRAMID_LOAD_BILINEAR(srcPos : vec2, srcLevel : int, out_)
+// Load the bilinear interpolation of mip level srcLevel at srcPos,
+// given in texels (the center of texel (x, y) is at (x + 0.5, y + 0.5)),
+// and write it to out_; typically textureLod with a linear filtering
+// sampler, at srcPos / levelSize. If defined, the general pipeline
+// loads each 1x1 to 3x3 kernel footprint from the input level with 1
+// to 4 of these instead of 1 to 9 NVPRO_PYRAMID_LOAD: the first 2 taps
+// of a 3-tap axis are merged into one bilinear tap with adjusted
+// position, plus one tap on the 3rd texel (weights combined with
+// NVPRO_PYRAMID_REDUCE, a2 = 0). Samplers usually interpolate with
+// limited (e.g. 8-bit) weight precision, so the odd-size kernel
+// weights are only approximated; the 2x2 kernel is exact.
+// This macro is only used when NVPRO_PYRAMID_IS_FAST_PIPELINE == 0,
+// and not with NVPRO_PYRAMID_WIDE_KERNEL.
+//
 //   * NVPRO_PYRAMID_SHUFFLE_XOR(in_, mask_)
 // Conceptually identical to subgroupShuffleXor(in_, mask_)
 // Advanced feature, only needed for potential edge cases.
 // This macro is only used when NVPRO_PYRAMID_IS_FAST_PIPELINE != 0
 //
+//   * NVPRO_PYRAMID_MIN_SUBGROUP_SIZE
+// Smallest gl_SubgroupSize the pipeline may run with; default 4. If
+// the pipeline is created with a required subgroup size of 16 or more,
+// define this to that size to compile out the shared memory fallback
+// for small subgroups (sharedQuads_).
+// This macro is only used when NVPRO_PYRAMID_IS_FAST_PIPELINE != 0
+//
+//   * NVPRO_PYRAMID_SKIP_INTERMEDIATE_STORE
+// If nonzero, NVPRO_PYRAMID_STORE is only used for the last level
+// filled by each dispatch, i.e. the level loaded by the next dispatch
+// (or the final level); the other levels only exist in registers and
+// shared memory. Useful for reductions where only the final level is
+// wanted, e.g. luminance_preamble.glsl. The pipeline alternatives
+// compiled into the demo (extras/) ignore this.
+//
+//   * NVPRO_PYRAMID_STORE_4X4(coord : ivec2, level : int, laneStride : uint,
+//                             in00, in10, in01, in11)
+// If defined, used instead of NVPRO_PYRAMID_STORE for the levels
+// where 4 subgroup invocations together hold whole 4x4-aligned blocks,
+// e.g. for encoding block-compressed formats in registers. Each of the
+// 4 invocations gl_SubgroupInvocationID ^ (k * laneStride), k in 0...3,
+// holds a 2x2 quad of the block: inNM is the sample at coord + (N, M).
+// laneStride is 1 or 4; if 4, only invocations with
+// (gl_SubgroupInvocationID & 3) == 0 hold a valid quad, the others
+// hold the same samples in a different order and should be ignored.
+// laneStride 4 is only used if gl_SubgroupSize >= 16; with smaller
+// subgroups, those levels are stored with NVPRO_PYRAMID_STORE instead.
+// Called in uniform control flow for each aligned group of
+// 4 * laneStride invocations; the other levels still use
+// NVPRO_PYRAMID_STORE, and the last level of each dispatch is never
+// stored this way. level is dynamically uniform.
+// This macro is only used when NVPRO_PYRAMID_IS_FAST_PIPELINE != 0
+//
+//   * NVPRO_PYRAMID_WIDE_KERNEL(d : float)
+//   * NVPRO_PYRAMID_WIDE_KERNEL_RADIUS
+// If defined, replace the 2x2 box / 3x3 NP2 kernel with a wide
+// separable kernel (e.g. windowed sinc) with 2 * RADIUS taps per axis,
+// centered on the output texel's footprint. NVPRO_PYRAMID_WIDE_KERNEL
+// must give the (unnormalized) weight of a tap at distance d from the
+// output texel center, measured in output texels; taps outside the
+// input level are clamped to the edge. Weights are normalized, and
+// applied with NVPRO_PYRAMID_REDUCE (a2 may be 0).
+// Only supported by the general pipeline: do not create the fast
+// pipeline (NvproPyramidPipelines::fastPipeline = VK_NULL_HANDLE).
+// RADIUS must be at least 2. Uses (8 * RADIUS + 44) * (2 * RADIUS + 15)
+// shared memory samples (NVPRO_PYRAMID_SHARED_TYPE), e.g. 28 KiB of
+// vec4 for RADIUS 4 (8 taps).
+//
+//   * NVPRO_PYRAMID_GENERATE(coord : ivec2, out_)
+// If defined, level 0 is never loaded: each of its samples that the
+// first dispatch needs is computed by this macro instead of
+// NVPRO_PYRAMID_LOAD / NVPRO_PYRAMID_LOAD_REDUCE4 (which are still
+// used for levels 1+), e.g. a procedural texture. The macro may also
+// store the sample to level 0 as a side effect, so that the whole
+// pyramid is produced without a separate pass writing level 0. The
+// fast pipeline generates each texel of level 0 exactly once; the
+// general pipeline generates the texels shared by neighboring 3x3 (or
+// NVPRO_PYRAMID_WIDE_KERNEL) footprints more than once, so stores
+// must not depend on which invocation makes them.
+// NVPRO_PYRAMID_LOAD_BILINEAR is not used for level 0. The pipeline
+// alternatives compiled into the demo (extras/) ignore this.
+//
+//   * NVPRO_PYRAMID_STORE_BAND(coord : ivec2, level : int, in_, coarse_)
+// If defined, also emit a band-pass (Laplacian) pyramid: called once
+// for each texel of every level except the last one of the pyramid,
+// with in_ the sample of the given texel of the given level and
+// coarse_ the sample of level + 1 that it upsamples from, texel
+// min(coord / 2, levelSize(level + 1) - 1) (nearest upsampling, so
+// level = band + upsampled level + 1 reconstructs exactly). Typically
+// stores in_ - coarse_ to a second image; the last level of the
+// Gaussian pyramid is the residual. Called while coarse_ is still in
+// registers: at each reduction of the fast pipeline (the input level
+// is then loaded texel by texel with NVPRO_PYRAMID_LOAD instead of
+// NVPRO_PYRAMID_LOAD_REDUCE4, which is thus required), and after each
+// output sample of the general pipeline, which reloads the input
+// texels mapping to it (cache or shared memory hits). The bands of
+// the last level of each dispatch are emitted by the next dispatch,
+// which loads it. level is dynamically uniform. Not supported with
+// NVPRO_PYRAMID_WIDE_KERNEL; the pipeline alternatives compiled into
+// the demo (extras/) ignore this.
+//
+//   * NVPRO_PYRAMID_INSTRUMENT
+// If defined, the name of a uint array in a storage buffer that
+// receives per-workgroup timestamps, for profiling the schedule (e.g.
+// load imbalance between workgroups); see
+// nvpro_pyramid_instrument.hpp for its layout and for decoding it.
+// Uses clock2x32ARB (you must enable GL_ARB_shader_clock), or
+// clockRealtime2x32EXT (GL_EXT_shader_realtime_clock) if
+// NVPRO_PYRAMID_INSTRUMENT_REALTIME is defined as nonzero; prefer the
+// latter, as subgroup clocks are only comparable within a subgroup.
+// Each workgroup records its start (before nvproPyramidMain does
+// anything), its end (when its last invocation finishes), and, for the
+// default pipelines, when its first invocation finishes loading the
+// input level (and storing the first output level), finishes the
+// subgroup shuffle levels, and passes the shared memory barrier.
+// This adds a barrier and shared and global atomics to each
+// workgroup, so only compile it into pipelines used for profiling.
+// The pipeline alternatives compiled into the demo (extras/) only
+// record the start and end.
+//
 //         The following must all be undefined or all be defined:
 //
 //   * NVPRO_PYRAMID_SHARED_TYPE
@@ -134,6 +257,9 @@
   #if !defined(NVPRO_PYRAMID_LOAD_REDUCE4) || !NVPRO_PYRAMID_IS_FAST_PIPELINE
   #error "Missing required macro NVPRO_PYRAMID_LOAD"
   #endif
+  #ifdef NVPRO_PYRAMID_STORE_BAND
+  #error "Missing required macro NVPRO_PYRAMID_LOAD; needed when NVPRO_PYRAMID_STORE_BAND is defined."
+  #endif
 #endif
 #ifndef NVPRO_PYRAMID_STORE
 #error "Missing required macro NVPRO_PYRAMID_STORE"
@@ -161,6 +287,42 @@ layout(push_constant) uniform NvproPyramidPushConstantBlock_
 // Number of subsequent mip levels to fill.
 #define NVPRO_PYRAMID_LEVEL_COUNT_ int(uint(NVPRO_PYRAMID_PUSH_CONSTANT) & 31u)
 
+// Store wrapper, skipping all but the last level filled by this
+// dispatch if NVPRO_PYRAMID_SKIP_INTERMEDIATE_STORE is nonzero.
+#if defined(NVPRO_PYRAMID_SKIP_INTERMEDIATE_STORE) && NVPRO_PYRAMID_SKIP_INTERMEDIATE_STORE
+#define NVPRO_PYRAMID_STORE_(coord_, level_, in_) \
+  { \
+    if ((level_) == NVPRO_PYRAMID_INPUT_LEVEL_ + NVPRO_PYRAMID_LEVEL_COUNT_) \
+    { \
+      NVPRO_PYRAMID_STORE(coord_, level_, in_); \
+    } \
+  }
+#else
+#define NVPRO_PYRAMID_STORE_(coord_, level_, in_) \
+  NVPRO_PYRAMID_STORE(coord_, level_, in_)
+#endif
+
+// Same for NVPRO_PYRAMID_STORE_4X4 (never the last level, so far) and
+// the samples that it stores instead of NVPRO_PYRAMID_STORE_.
+#ifdef NVPRO_PYRAMID_STORE_4X4
+  #if defined(NVPRO_PYRAMID_SKIP_INTERMEDIATE_STORE) && NVPRO_PYRAMID_SKIP_INTERMEDIATE_STORE
+  #define NVPRO_PYRAMID_STORE_4X4_(coord_, level_, laneStride_, in00_, in10_, in01_, in11_) \
+    { \
+      if ((level_) == NVPRO_PYRAMID_INPUT_LEVEL_ + NVPRO_PYRAMID_LEVEL_COUNT_) \
+      { \
+        NVPRO_PYRAMID_STORE_4X4(coord_, level_, laneStride_, in00_, in10_, in01_, in11_); \
+      } \
+    }
+  #else
+  #define NVPRO_PYRAMID_STORE_4X4_(coord_, level_, laneStride_, in00_, in10_, in01_, in11_) \
+    NVPRO_PYRAMID_STORE_4X4(coord_, level_, laneStride_, in00_, in10_, in01_, in11_)
+  #endif
+  #define NVPRO_PYRAMID_STORE_UNLESS_4X4_(coord_, level_, in_)
+#else
+  #define NVPRO_PYRAMID_STORE_UNLESS_4X4_(coord_, level_, in_) \
+    NVPRO_PYRAMID_STORE_(coord_, level_, in_)
+#endif
+
 #ifndef NVPRO_PYRAMID_REDUCE2
 #define NVPRO_PYRAMID_REDUCE2(v0, v1, out_) \
   NVPRO_PYRAMID_REDUCE(0.5, v0, 0.5, v1, 0, v1, out_)
@@ -188,10 +350,93 @@ layout(push_constant) uniform NvproPyramidPushConstantBlock_
 }
 #endif
 
+// Loads of the input level, routed to NVPRO_PYRAMID_GENERATE if
+// defined and the input level is 0.
+#ifdef NVPRO_PYRAMID_GENERATE
+  #define NVPRO_PYRAMID_LOAD_(coord_, level_, out_) \
+  { \
+    if ((level_) == 0) \
+    { \
+      NVPRO_PYRAMID_GENERATE(coord_, out_); \
+    } \
+    else \
+    { \
+      NVPRO_PYRAMID_LOAD(coord_, level_, out_); \
+    } \
+  }
+#else
+  #define NVPRO_PYRAMID_LOAD_(coord_, level_, out_) \
+    NVPRO_PYRAMID_LOAD(coord_, level_, out_)
+#endif
+
+// Emit the bands of the 2x2 square of level srcLevel_ at srcCoord_
+// (even), reduced to coarse_; inXY_ is the sample at srcCoord_ + (X, Y).
+#ifdef NVPRO_PYRAMID_STORE_BAND
+  #ifdef NVPRO_PYRAMID_WIDE_KERNEL
+    #error "NVPRO_PYRAMID_STORE_BAND is not supported with NVPRO_PYRAMID_WIDE_KERNEL."
+  #endif
+  #define NVPRO_PYRAMID_STORE_BANDS_(srcCoord_, srcLevel_, in00_, in10_, in01_, in11_, coarse_) \
+  { \
+    NVPRO_PYRAMID_STORE_BAND((srcCoord_) + ivec2(0, 0), srcLevel_, in00_, coarse_); \
+    NVPRO_PYRAMID_STORE_BAND((srcCoord_) + ivec2(1, 0), srcLevel_, in10_, coarse_); \
+    NVPRO_PYRAMID_STORE_BAND((srcCoord_) + ivec2(0, 1), srcLevel_, in01_, coarse_); \
+    NVPRO_PYRAMID_STORE_BAND((srcCoord_) + ivec2(1, 1), srcLevel_, in11_, coarse_); \
+  }
+  // The input level's bands need each texel, so it cannot be reduced
+  // by NVPRO_PYRAMID_LOAD_REDUCE4.
+  #define NVPRO_PYRAMID_LOAD_REDUCE4_(srcCoord_, srcLevel_, out_) \
+  { \
+    NVPRO_PYRAMID_TYPE b00_, b01_, b10_, b11_; \
+    NVPRO_PYRAMID_LOAD_((srcCoord_) + ivec2(0, 0), srcLevel_, b00_); \
+    NVPRO_PYRAMID_LOAD_((srcCoord_) + ivec2(0, 1), srcLevel_, b01_); \
+    NVPRO_PYRAMID_LOAD_((srcCoord_) + ivec2(1, 0), srcLevel_, b10_); \
+    NVPRO_PYRAMID_LOAD_((srcCoord_) + ivec2(1, 1), srcLevel_, b11_); \
+    NVPRO_PYRAMID_REDUCE4(b00_, b01_, b10_, b11_, out_); \
+    NVPRO_PYRAMID_STORE_BANDS_(srcCoord_, srcLevel_, b00_, b10_, b01_, b11_, out_); \
+  }
+#else
+  #define NVPRO_PYRAMID_STORE_BANDS_(srcCoord_, srcLevel_, in00_, in10_, in01_, in11_, coarse_)
+#endif
+
+#if defined(NVPRO_PYRAMID_STORE_BAND)
+  // Defined above.
+#elif defined(NVPRO_PYRAMID_GENERATE)
+  #define NVPRO_PYRAMID_LOAD_REDUCE4_(srcCoord_, srcLevel_, out_) \
+  { \
+    if ((srcLevel_) == 0) \
+    { \
+      NVPRO_PYRAMID_TYPE g00_, g01_, g10_, g11_; \
+      NVPRO_PYRAMID_GENERATE((srcCoord_) + ivec2(0, 0), g00_); \
+      NVPRO_PYRAMID_GENERATE((srcCoord_) + ivec2(0, 1), g01_); \
+      NVPRO_PYRAMID_GENERATE((srcCoord_) + ivec2(1, 0), g10_); \
+      NVPRO_PYRAMID_GENERATE((srcCoord_) + ivec2(1, 1), g11_); \
+      NVPRO_PYRAMID_REDUCE4(g00_, g01_, g10_, g11_, out_); \
+    } \
+    else \
+    { \
+      NVPRO_PYRAMID_LOAD_REDUCE4(srcCoord_, srcLevel_, out_); \
+    } \
+  }
+#else
+  #define NVPRO_PYRAMID_LOAD_REDUCE4_(srcCoord_, srcLevel_, out_) \
+    NVPRO_PYRAMID_LOAD_REDUCE4(srcCoord_, srcLevel_, out_)
+#endif
+
 #if !defined(NVPRO_PYRAMID_SHUFFLE_XOR) && NVPRO_PYRAMID_IS_FAST_PIPELINE != 0
 #define NVPRO_PYRAMID_SHUFFLE_XOR(in_, mask_) subgroupShuffleXor(in_, mask_)
 #endif
 
+#ifndef NVPRO_PYRAMID_MIN_SUBGROUP_SIZE
+#define NVPRO_PYRAMID_MIN_SUBGROUP_SIZE 4
+#endif
+
+// Whether a team of 16 consecutive threads is within one subgroup.
+#if NVPRO_PYRAMID_MIN_SUBGROUP_SIZE >= 16
+#define NVPRO_PYRAMID_TEAM_IN_SUBGROUP_ true
+#else
+#define NVPRO_PYRAMID_TEAM_IN_SUBGROUP_ (gl_SubgroupSize >= 16)
+#endif
+
 // Handle optional specialized shared memory type.
 #ifdef NVPRO_PYRAMID_SHARED_TYPE
   #if !defined(NVPRO_PYRAMID_SHARED_LOAD) || !defined(NVPRO_PYRAMID_SHARED_STORE)
@@ -206,8 +451,117 @@ layout(push_constant) uniform NvproPyramidPushConstantBlock_
   #define NVPRO_PYRAMID_SHARED_STORE(smem_, in_) smem_ = in_
 #endif
 
+#if defined(NVPRO_PYRAMID_WIDE_KERNEL) != defined(NVPRO_PYRAMID_WIDE_KERNEL_RADIUS)
+  #error "NVPRO_PYRAMID_WIDE_KERNEL and NVPRO_PYRAMID_WIDE_KERNEL_RADIUS must be defined together."
+#endif
+
+#if defined(NVPRO_PYRAMID_WIDE_KERNEL_RADIUS) && NVPRO_PYRAMID_WIDE_KERNEL_RADIUS < 2
+  #error "NVPRO_PYRAMID_WIDE_KERNEL_RADIUS must be at least 2."
+#endif
+
+// Optional workgroup timestamps. The pipelines below define
+// nvproPyramidMainBody_, wrapped at the end of this file by an
+// nvproPyramidMain that records the start and end of each workgroup;
+// NVPRO_PYRAMID_INSTRUMENT_EVENT_(event_) records the intermediate
+// events, using the clock of invocation 0.
+#ifdef NVPRO_PYRAMID_INSTRUMENT
+  #if defined(NVPRO_PYRAMID_INSTRUMENT_REALTIME) && NVPRO_PYRAMID_INSTRUMENT_REALTIME
+    #define NVPRO_PYRAMID_INSTRUMENT_CLOCK_() clockRealtime2x32EXT()
+  #else
+    #define NVPRO_PYRAMID_INSTRUMENT_CLOCK_() clock2x32ARB()
+  #endif
+
+  // Change nvpro_pyramid_instrument.hpp if changed.
+  #define NVPRO_PYRAMID_INSTRUMENT_HEADER_UINTS_ 4u
+  #define NVPRO_PYRAMID_INSTRUMENT_RECORD_UINTS_ 16u
+  #define NVPRO_PYRAMID_INSTRUMENT_START_    0u
+  #define NVPRO_PYRAMID_INSTRUMENT_LOADED_   1u
+  #define NVPRO_PYRAMID_INSTRUMENT_SHUFFLED_ 2u
+  #define NVPRO_PYRAMID_INSTRUMENT_BARRIER_  3u
+  #define NVPRO_PYRAMID_INSTRUMENT_END_      4u
+
+  // Record index of this workgroup (~0u if the buffer is full), and
+  // number of invocations that finished.
+  shared uint instrumentRecord_;
+  shared uint instrumentDoneCount_;
+
+  void instrumentStore_(uint event_, uvec2 clock_)
+  {
+    if (instrumentRecord_ != ~0u)
+    {
+      uint i_ = NVPRO_PYRAMID_INSTRUMENT_HEADER_UINTS_
+              + instrumentRecord_ * NVPRO_PYRAMID_INSTRUMENT_RECORD_UINTS_
+              + 4u + 2u * event_;
+      NVPRO_PYRAMID_INSTRUMENT[i_]      = clock_.x;
+      NVPRO_PYRAMID_INSTRUMENT[i_ + 1u] = clock_.y;
+    }
+  }
+
+  // Called in uniform control flow, before anything else.
+  void instrumentBegin_()
+  {
+    if (gl_LocalInvocationIndex == 0u)
+    {
+      uvec2 start_  = NVPRO_PYRAMID_INSTRUMENT_CLOCK_();
+      uint  record_ = atomicAdd(NVPRO_PYRAMID_INSTRUMENT[0], 1u);
+      uint  base_   = NVPRO_PYRAMID_INSTRUMENT_HEADER_UINTS_
+                    + record_ * NVPRO_PYRAMID_INSTRUMENT_RECORD_UINTS_;
+      if (base_ + NVPRO_PYRAMID_INSTRUMENT_RECORD_UINTS_
+          > uint(NVPRO_PYRAMID_INSTRUMENT.length()))
+      {
+        record_ = ~0u;  // Still counted in the header.
+      }
+      else
+      {
+        NVPRO_PYRAMID_INSTRUMENT[base_ + 0u] = uint(NVPRO_PYRAMID_PUSH_CONSTANT);
+        NVPRO_PYRAMID_INSTRUMENT[base_ + 1u] = gl_WorkGroupID.x;
+        NVPRO_PYRAMID_INSTRUMENT[base_ + 2u] =
+            NVPRO_PYRAMID_IS_FAST_PIPELINE != 0 ? 1u : 0u;
+        NVPRO_PYRAMID_INSTRUMENT[base_ + 3u] = 0u;
+        // Zero marks events not reached (the buffer is not cleared).
+        for (uint i_ = base_ + 4u; i_ < base_ + NVPRO_PYRAMID_INSTRUMENT_RECORD_UINTS_; ++i_)
+        {
+          NVPRO_PYRAMID_INSTRUMENT[i_] = 0u;
+        }
+      }
+      instrumentRecord_    = record_;
+      instrumentDoneCount_ = 0u;
+      instrumentStore_(NVPRO_PYRAMID_INSTRUMENT_START_, start_);
+    }
+    barrier();
+  }
+
+  // Called by each invocation when it finishes; the last one records
+  // the end of the workgroup.
+  void instrumentEnd_()
+  {
+    uint invocations_ = gl_WorkGroupSize.x * gl_WorkGroupSize.y * gl_WorkGroupSize.z;
+    if (atomicAdd(instrumentDoneCount_, 1u) == invocations_ - 1u)
+    {
+      instrumentStore_(NVPRO_PYRAMID_INSTRUMENT_END_,
+                       NVPRO_PYRAMID_INSTRUMENT_CLOCK_());
+    }
+  }
+
+  #define NVPRO_PYRAMID_INSTRUMENT_EVENT_(event_) \
+    { \
+      if (gl_LocalInvocationIndex == 0u) \
+      { \
+        instrumentStore_(event_, NVPRO_PYRAMID_INSTRUMENT_CLOCK_()); \
+      } \
+    }
+
+  #define nvproPyramidMain nvproPyramidMainBody_
+#else
+  #define NVPRO_PYRAMID_INSTRUMENT_EVENT_(event_)
+#endif
+
 #if NVPRO_PYRAMID_IS_FAST_PIPELINE != 0
 
+#ifdef NVPRO_PYRAMID_WIDE_KERNEL
+  #error "NVPRO_PYRAMID_WIDE_KERNEL is only supported by the general pipeline."
+#endif
+
 // Code for testing alternative designs during development, can ignore.
 #if defined(NVPRO_USE_FAST_PIPELINE_ALTERNATIVE_) && NVPRO_USE_FAST_PIPELINE_ALTERNATIVE_ != 0
 #include "fast_pipeline_alternative.glsl"
@@ -224,7 +578,10 @@ layout(push_constant) uniform NvproPyramidPushConstantBlock_
 // to the power of NVPRO_PYRAMID_LEVEL_COUNT_, and
 // NVPRO_PYRAMID_LEVEL_COUNT_ can be at most 6.
 //
-// TODO: Test if this works for subgroup size != 32.
+// Teams of up to 16 consecutive threads exchange samples with shuffles,
+// so subgroups must consist of consecutive gl_LocalInvocationIndex
+// values. If gl_SubgroupSize < 16, the last shuffle stage of a team is
+// replaced with a trip through shared memory (sharedQuads_).
 
 layout(local_size_x = 256) in;
 
@@ -252,6 +609,13 @@ layout(local_size_x = 256) in;
 // These diagrams are referenced later.
 shared NVPRO_PYRAMID_SHARED_TYPE sharedTile_[16];
 
+// Used instead of shuffles when a team of 16 threads spans multiple
+// subgroups: entry n holds the sample of thread 4n, which is the
+// lower-level 2x2 quad-reduced sample for threads 4n to 4n+3.
+#if NVPRO_PYRAMID_MIN_SUBGROUP_SIZE < 16
+shared NVPRO_PYRAMID_SHARED_TYPE sharedQuads_[64];
+#endif
+
 
 // Handle the tile at the given input level and offset (position
 // of upper-left corner), and write out the resulting minified tiles
@@ -267,10 +631,15 @@ shared NVPRO_PYRAMID_SHARED_TYPE sharedTile_[16];
 // levelCount_  1   2   3   4
 // N            1   4  16  16 [NOT 64]
 //
+// Must be called in uniform control flow by the whole workgroup (there
+// may be a barrier for small subgroups); threads whose tile is outside
+// the input level pass tileValid_ == false and do no loads or stores.
+//
 // If sharedMemoryWrite_ == true, then the 1x1 sample generated for
 // the final output level is written to sharedTile_[sharedMemoryIdx_].
 void handleTile_(ivec2 srcTileOffset_, int inputLevel_, uint levelCount_,
-                 bool sharedMemoryWrite_, uint sharedMemoryIdx_)
+                 bool tileValid_, bool sharedMemoryWrite_,
+                 uint sharedMemoryIdx_)
 {
   // Discussion for levelCount_ == 3
   //
@@ -302,7 +671,11 @@ void handleTile_(ivec2 srcTileOffset_, int inputLevel_, uint levelCount_,
   uint idxInTeam_  = gl_LocalInvocationIndex & teamMask_;
 
   // NOTE the extra sharedMemoryWrite_ requirement!!!
-  if (sharedMemoryWrite_ && levelCount_ == 4)
+  if (!tileValid_)
+  {
+    // Nothing to load; still take part in the exchanges below.
+  }
+  else if (sharedMemoryWrite_ && levelCount_ == 4)
   {
     // The location of the sub-tile assigned to this thread in level inputLevel_
     uint  xOffset_    = (idxInTeam_ & 1) << 2 | (idxInTeam_ & 4) << 1;
@@ -314,33 +687,41 @@ void handleTile_(ivec2 srcTileOffset_, int inputLevel_, uint levelCount_,
     ivec2 srcCoord_, dstCoord_;
     srcCoord_ = srcSubTile_;
     dstCoord_ = dstSubTile_;
-    NVPRO_PYRAMID_LOAD_REDUCE4(srcCoord_, inputLevel_, sample00_);
-    NVPRO_PYRAMID_STORE(dstCoord_, dstLevel_, sample00_);
+    NVPRO_PYRAMID_LOAD_REDUCE4_(srcCoord_, inputLevel_, sample00_);
+    NVPRO_PYRAMID_STORE_UNLESS_4X4_(dstCoord_, dstLevel_, sample00_);
 
     // Thread calculates lower-left sample of 2x2 output sub-tile.
     srcCoord_ = srcSubTile_ + ivec2(0, 2);
     dstCoord_ = dstSubTile_ + ivec2(0, 1);
-    NVPRO_PYRAMID_LOAD_REDUCE4(srcCoord_, inputLevel_, sample01_);
-    NVPRO_PYRAMID_STORE(dstCoord_, dstLevel_, sample01_);
+    NVPRO_PYRAMID_LOAD_REDUCE4_(srcCoord_, inputLevel_, sample01_);
+    NVPRO_PYRAMID_STORE_UNLESS_4X4_(dstCoord_, dstLevel_, sample01_);
 
     // Thread calculates upper-right sample of 2x2 output sub-tile.
     srcCoord_ = srcSubTile_ + ivec2(2, 0);
     dstCoord_ = dstSubTile_ + ivec2(1, 0);
-    NVPRO_PYRAMID_LOAD_REDUCE4(srcCoord_, inputLevel_, sample10_);
-    NVPRO_PYRAMID_STORE(dstCoord_, dstLevel_, sample10_);
+    NVPRO_PYRAMID_LOAD_REDUCE4_(srcCoord_, inputLevel_, sample10_);
+    NVPRO_PYRAMID_STORE_UNLESS_4X4_(dstCoord_, dstLevel_, sample10_);
 
     // Thread calculates lower-right sample of 2x2 output sub-tile.
     srcCoord_ = srcSubTile_ + ivec2(2, 2);
     dstCoord_ = dstSubTile_ + ivec2(1, 1);
-    NVPRO_PYRAMID_LOAD_REDUCE4(srcCoord_, inputLevel_, sample11_);
-    NVPRO_PYRAMID_STORE(dstCoord_, dstLevel_, sample11_);
+    NVPRO_PYRAMID_LOAD_REDUCE4_(srcCoord_, inputLevel_, sample11_);
+    NVPRO_PYRAMID_STORE_UNLESS_4X4_(dstCoord_, dstLevel_, sample11_);
+
+#ifdef NVPRO_PYRAMID_STORE_4X4
+    // Each 4 consecutive threads hold a 4x4 block, as 2x2 sub-tiles.
+    NVPRO_PYRAMID_STORE_4X4_(dstSubTile_, dstLevel_, 1u, sample00_,
+                             sample10_, sample01_, sample11_);
+#endif
 
     // Now the full assigned 2x2 subtile has been filled, move on to
     // the 1x1 sample of the next level assigned to this thread.
     dstLevel_++;
     dstSubTile_ >>= 1;
     NVPRO_PYRAMID_REDUCE4(sample00_, sample01_, sample10_, sample11_, out_);
-    NVPRO_PYRAMID_STORE(dstSubTile_, dstLevel_, out_);
+    NVPRO_PYRAMID_STORE_UNLESS_4X4_(dstSubTile_, dstLevel_, out_);
+    NVPRO_PYRAMID_STORE_BANDS_((dstSubTile_ * 2), (dstLevel_ - 1), sample00_,
+                               sample10_, sample01_, sample11_, out_);
   }
   else  // levelCount_ != 4
   {
@@ -352,26 +733,59 @@ void handleTile_(ivec2 srcTileOffset_, int inputLevel_, uint levelCount_,
     dstSubTile_       = srcSubTile_ >> 1;
 
     // Thread calculates the sample in that sub-tile.
-    NVPRO_PYRAMID_LOAD_REDUCE4(srcSubTile_, inputLevel_, out_);
-    NVPRO_PYRAMID_STORE(dstSubTile_, dstLevel_, out_);
+    NVPRO_PYRAMID_LOAD_REDUCE4_(srcSubTile_, inputLevel_, out_);
+    if (levelCount_ >= 3)
+    {
+      NVPRO_PYRAMID_STORE_UNLESS_4X4_(dstSubTile_, dstLevel_, out_);
+    }
+    else
+    {
+      NVPRO_PYRAMID_STORE_(dstSubTile_, dstLevel_, out_);
+    }
   }
+  NVPRO_PYRAMID_INSTRUMENT_EVENT_(NVPRO_PYRAMID_INSTRUMENT_LOADED_);
 
   if (!sharedMemoryWrite_ && levelCount_ == 1) return;
 
   // The whole team computes the 2x2 tile in the next level; only 1
   // out of every 4 threads does this. Use shuffle to get the needed
   // data from the other three threads.
-  dstLevel_++;
-  dstSubTile_ >>= 1;
   sample00_ = out_;
   sample01_ = NVPRO_PYRAMID_SHUFFLE_XOR(out_, 1);
   sample10_ = NVPRO_PYRAMID_SHUFFLE_XOR(out_, 2);
   sample11_ = NVPRO_PYRAMID_SHUFFLE_XOR(out_, 3);
 
-  if (0 == (gl_SubgroupInvocationID & 3))
+#ifdef NVPRO_PYRAMID_STORE_4X4
+  // With teams of 16, the team holds a 4x4 block of the level just
+  // computed (one sample per thread), and threads 0, 4, 8, 12 of the
+  // team now hold its 2x2 sub-tiles (sample01_ is the x + 1 neighbor).
+  // Encoding it needs the whole team in one subgroup.
+  if (levelCount_ >= 3 && tileValid_)
+  {
+    if (NVPRO_PYRAMID_TEAM_IN_SUBGROUP_)
+    {
+      NVPRO_PYRAMID_STORE_4X4_(dstSubTile_, dstLevel_, 4u, sample00_,
+                               sample01_, sample10_, sample11_);
+    }
+#if NVPRO_PYRAMID_MIN_SUBGROUP_SIZE < 16
+    else
+    {
+      NVPRO_PYRAMID_STORE_(dstSubTile_, dstLevel_, out_);
+    }
+#endif
+  }
+#endif
+
+  dstLevel_++;
+  dstSubTile_ >>= 1;
+
+  if (tileValid_ && 0 == (gl_LocalInvocationIndex & 3))
   {
     NVPRO_PYRAMID_REDUCE4(sample00_, sample01_, sample10_, sample11_, out_);
-    NVPRO_PYRAMID_STORE(dstSubTile_, dstLevel_, out_);
+    NVPRO_PYRAMID_STORE_(dstSubTile_, dstLevel_, out_);
+    // Here sample01_ is the x + 1 neighbor, sample10_ the y + 1 one.
+    NVPRO_PYRAMID_STORE_BANDS_((dstSubTile_ * 2), (dstLevel_ - 1), sample00_,
+                               sample01_, sample10_, sample11_, out_);
   }
 
   if (!sharedMemoryWrite_ && levelCount_ == 2) return;
@@ -382,14 +796,35 @@ void handleTile_(ivec2 srcTileOffset_, int inputLevel_, uint levelCount_,
   dstLevel_++;
   dstSubTile_ >>= 1;
   sample00_ = out_;
-  sample01_ = NVPRO_PYRAMID_SHUFFLE_XOR(out_, 4);
-  sample10_ = NVPRO_PYRAMID_SHUFFLE_XOR(out_, 8);
-  sample11_ = NVPRO_PYRAMID_SHUFFLE_XOR(out_, 12);
+  if (NVPRO_PYRAMID_TEAM_IN_SUBGROUP_)
+  {
+    sample01_ = NVPRO_PYRAMID_SHUFFLE_XOR(out_, 4);
+    sample10_ = NVPRO_PYRAMID_SHUFFLE_XOR(out_, 8);
+    sample11_ = NVPRO_PYRAMID_SHUFFLE_XOR(out_, 12);
+  }
+#if NVPRO_PYRAMID_MIN_SUBGROUP_SIZE < 16
+  else
+  {
+    // The team spans several subgroups; gl_SubgroupSize is the same
+    // for the whole workgroup, so this barrier is in uniform control flow.
+    uint quadIdx_ = gl_LocalInvocationIndex >> 2u;
+    if (0 == (gl_LocalInvocationIndex & 3))
+    {
+      NVPRO_PYRAMID_SHARED_STORE(sharedQuads_[quadIdx_], out_);
+    }
+    barrier();
+    NVPRO_PYRAMID_SHARED_LOAD(sharedQuads_[quadIdx_ ^ 1u], sample01_);
+    NVPRO_PYRAMID_SHARED_LOAD(sharedQuads_[quadIdx_ ^ 2u], sample10_);
+    NVPRO_PYRAMID_SHARED_LOAD(sharedQuads_[quadIdx_ ^ 3u], sample11_);
+  }
+#endif
 
-  if (0 == (gl_SubgroupInvocationID & 15))
+  if (tileValid_ && 0 == (gl_LocalInvocationIndex & 15))
   {
     NVPRO_PYRAMID_REDUCE4(sample00_, sample01_, sample10_, sample11_, out_);
-    NVPRO_PYRAMID_STORE(dstSubTile_, dstLevel_, out_);
+    NVPRO_PYRAMID_STORE_(dstSubTile_, dstLevel_, out_);
+    NVPRO_PYRAMID_STORE_BANDS_((dstSubTile_ * 2), (dstLevel_ - 1), sample00_,
+                               sample01_, sample10_, sample11_, out_);
     if (sharedMemoryWrite_)
     {
       NVPRO_PYRAMID_SHARED_STORE(sharedTile_[sharedMemoryIdx_], out_);
@@ -419,14 +854,14 @@ void nvproPyramidMain()
   uint  verticalIndex_   = tileIndex_ / horizontalTiles_;
   ivec2 tileOffset_ = ivec2(horizontalIndex_, verticalIndex_) << levelCount_;
 
+  bool tileValid_ = verticalIndex_ < verticalTiles_;
+
   if (levelCount_ <= 3)
   {
-    if (verticalIndex_ < verticalTiles_)
-    {
-      // Reminder to self: can't handle 4 level case when
-      // sharedMemoryWrite_ is false.
-      handleTile_(tileOffset_, inputLevel_, levelCount_, false, 0);
-    }
+    // Reminder to self: can't handle 4 level case when
+    // sharedMemoryWrite_ is false.
+    handleTile_(tileOffset_, inputLevel_, levelCount_, tileValid_, false, 0);
+    NVPRO_PYRAMID_INSTRUMENT_EVENT_(NVPRO_PYRAMID_INSTRUMENT_SHUFFLED_);
     return;
   }
 
@@ -434,38 +869,38 @@ void nvproPyramidMain()
   // Need to split the tile into sub-tiles and teams into 16 thread sub-teams.
   // Each sub-team writes one sample to shared memory.
   // Refer to sharedTile_ diagram for details.
-  if (verticalIndex_ < verticalTiles_)
-  {
-    // Number of levels to fill for now.
-    int subLevelCount_ = levelCount_ == 6 ? 4 : 3;
 
-    // Calculate the index of the sub-team within the team.
-    int subTeamMask_ = levelCount_ == 4 ? 3 : 15;
-    int subTeamIdx_  = int(gl_GlobalInvocationID.x >> 4) & subTeamMask_;
+  // Number of levels to fill for now.
+  int subLevelCount_ = levelCount_ == 6 ? 4 : 3;
 
-    // Location of sub-tile; they are 8x8 or 16x16 depending on subLevelCount_
-    ivec2 subTeamOffset_;
-    subTeamOffset_.x = (subTeamIdx_ & 1) << 3 | (subTeamIdx_ & 4) << 2;
-    subTeamOffset_.y = (subTeamIdx_ & 2) << 2 | (subTeamIdx_ & 8) << 1;
-    if (subLevelCount_ == 4)
-    {
-      subTeamOffset_ <<= 1;
-    }
+  // Calculate the index of the sub-team within the team.
+  int subTeamMask_ = levelCount_ == 4 ? 3 : 15;
+  int subTeamIdx_  = int(gl_GlobalInvocationID.x >> 4) & subTeamMask_;
 
-    // Index in shared memory that this sub-team will write to.
-    uint sharedMemoryIndex_ = (gl_GlobalInvocationID.x >> 4u) & 15u;
+  // Location of sub-tile; they are 8x8 or 16x16 depending on subLevelCount_
+  ivec2 subTeamOffset_;
+  subTeamOffset_.x = (subTeamIdx_ & 1) << 3 | (subTeamIdx_ & 4) << 2;
+  subTeamOffset_.y = (subTeamIdx_ & 2) << 2 | (subTeamIdx_ & 8) << 1;
+  if (subLevelCount_ == 4)
+  {
+    subTeamOffset_ <<= 1;
+  }
 
-    // Handle the sub-tile and write the last level 1x1 sample to shared memory.
-    handleTile_(tileOffset_ + subTeamOffset_, inputLevel_, subLevelCount_,
-                true, sharedMemoryIndex_);
+  // Index in shared memory that this sub-team will write to.
+  uint sharedMemoryIndex_ = (gl_GlobalInvocationID.x >> 4u) & 15u;
 
-    // Problem reduces to handling 1 or 2 remaining levels.
-    inputLevel_ += subLevelCount_;
-    levelCount_ -= subLevelCount_;
-  }
+  // Handle the sub-tile and write the last level 1x1 sample to shared memory.
+  handleTile_(tileOffset_ + subTeamOffset_, inputLevel_, subLevelCount_,
+              tileValid_, true, sharedMemoryIndex_);
+  NVPRO_PYRAMID_INSTRUMENT_EVENT_(NVPRO_PYRAMID_INSTRUMENT_SHUFFLED_);
+
+  // Problem reduces to handling 1 or 2 remaining levels.
+  inputLevel_ += subLevelCount_;
+  levelCount_ -= subLevelCount_;
 
   // Wait for shared memory to fill.
   barrier();
+  NVPRO_PYRAMID_INSTRUMENT_EVENT_(NVPRO_PYRAMID_INSTRUMENT_BARRIER_);
 
   // Handle the remaining 1 or 2 levels.
   // Only 4 threads have to do this per workgroup (NOT per team)
@@ -489,7 +924,9 @@ void nvproPyramidMain()
         NVPRO_PYRAMID_SHARED_LOAD(sharedTile_[smemOffset_ + 2u], in01_);
         NVPRO_PYRAMID_SHARED_LOAD(sharedTile_[smemOffset_ + 3u], in11_);
         NVPRO_PYRAMID_REDUCE4(in00_, in01_, in10_, in11_, out_);
-        NVPRO_PYRAMID_STORE(tileOffset_, (inputLevel_ + 1), out_);
+        NVPRO_PYRAMID_STORE_(tileOffset_, (inputLevel_ + 1), out_);
+        NVPRO_PYRAMID_STORE_BANDS_((tileOffset_ * 2), inputLevel_, in00_,
+                                   in10_, in01_, in11_, out_);
       }
     }
     else  // levelCount_ == 2
@@ -513,8 +950,11 @@ void nvproPyramidMain()
         NVPRO_PYRAMID_REDUCE4(in00_, in01_, in10_, in11_, out_);
         ivec2 threadOffset_ = ivec2(gl_LocalInvocationIndex & 1,
                                     (gl_LocalInvocationIndex & 2) >> 1);
-        NVPRO_PYRAMID_STORE((tileOffset_ * 2 + threadOffset_),
+        NVPRO_PYRAMID_STORE_((tileOffset_ * 2 + threadOffset_),
                             (inputLevel_ + 1), out_);
+        NVPRO_PYRAMID_STORE_BANDS_(((tileOffset_ * 2 + threadOffset_) * 2),
+                                   inputLevel_, in00_, in10_, in01_, in11_,
+                                   out_);
         // Shuffle 4 samples and produce sole last level sample.
         in00_ = out_;
         in10_ = NVPRO_PYRAMID_SHUFFLE_XOR(out_, 1);
@@ -524,7 +964,9 @@ void nvproPyramidMain()
         if (gl_LocalInvocationIndex == 0u)
         {
           NVPRO_PYRAMID_REDUCE4(in00_, in01_, in10_, in11_, out_);
-          NVPRO_PYRAMID_STORE(tileOffset_, (inputLevel_ + 2), out_);
+          NVPRO_PYRAMID_STORE_(tileOffset_, (inputLevel_ + 2), out_);
+          NVPRO_PYRAMID_STORE_BANDS_((tileOffset_ * 2), (inputLevel_ + 1),
+                                     in00_, in10_, in01_, in11_, out_);
         }
       }
     }
@@ -538,6 +980,265 @@ void nvproPyramidMain()
 // Code for testing alternative designs during development, can ignore.
 #if defined(NVPRO_USE_GENERAL_PIPELINE_ALTERNATIVE_) && NVPRO_USE_GENERAL_PIPELINE_ALTERNATIVE_ != 0
 #include "general_pipeline_alternative.glsl"
+#elif defined(NVPRO_PYRAMID_WIDE_KERNEL)
+
+// General-case shader for generating 1 or 2 levels of the mip pyramid
+// with a wide separable kernel (see NVPRO_PYRAMID_WIDE_KERNEL). Same
+// schedule as the default general pipeline below: when generating 1
+// level, each thread computes one output sample directly. When
+// generating 2 levels, each workgroup handles a 8x8 tile of the last
+// output level, computing the intermediate level tile that it needs,
+// which now includes a halo shared with neighboring tiles. The halo is
+// recomputed redundantly rather than exchanged; each workgroup only
+// writes the intermediate samples "owned" by its 8x8 tile.
+//
+// Output sample x of a level of size n, generated from an input level
+// of size m, is centered at input texel coordinate c = (x + 0.5) * m / n.
+// Its taps are the 2 * RADIUS input texels nearest to c.
+//
+// Dispatch with y, z = 1
+layout(local_size_x = 4 * 32) in;
+
+#define NVPRO_PYRAMID_WIDE_R_ (NVPRO_PYRAMID_WIDE_KERNEL_RADIUS)
+#define NVPRO_PYRAMID_WIDE_TAPS_ (2 * NVPRO_PYRAMID_WIDE_R_)
+
+// Size of the intermediate level tile (including halo) needed for an
+// 8x8 tile of the last level, and number of input level rows needed for
+// that intermediate tile. Allows for the 3 : 1 ratio of odd sizes.
+#define NVPRO_PYRAMID_WIDE_TILE_ (2 * 8 + NVPRO_PYRAMID_WIDE_TAPS_ - 1)
+#define NVPRO_PYRAMID_WIDE_ROWS_ \
+  (2 * NVPRO_PYRAMID_WIDE_TILE_ + NVPRO_PYRAMID_WIDE_TAPS_ - 1)
+
+// Input rows, horizontally filtered for each intermediate tile
+// column; later reused for the horizontally filtered intermediate
+// rows needed for the last level tile.
+shared NVPRO_PYRAMID_SHARED_TYPE
+    sharedRows_[NVPRO_PYRAMID_WIDE_ROWS_][NVPRO_PYRAMID_WIDE_TILE_];
+
+// The intermediate level tile. Entry [y][x] corresponds to
+// intermediate level texel tileOrigin + (x, y), clamped to the level.
+shared NVPRO_PYRAMID_SHARED_TYPE
+    sharedLevel_[NVPRO_PYRAMID_WIDE_TILE_][NVPRO_PYRAMID_WIDE_TILE_];
+
+// Return the first tap (input texel index, not clamped) of the output
+// sample x_, i.e. floor(c + 0.5) - RADIUS. Exact unsigned arithmetic
+// (no overflow for sizes up to 65535) so that the tile/halo
+// bookkeeping is exact.
+int wideFirstTap_(int x_, int srcSize_, int dstSize_)
+{
+  uint num_ = uint(2 * x_ + 1) * uint(srcSize_) + uint(dstSize_);
+  return int(num_ / uint(2 * dstSize_)) - NVPRO_PYRAMID_WIDE_R_;
+}
+
+// Compute the normalized weights of the taps of output sample x_.
+void wideWeights_(int x_, int firstTap_, int srcSize_, int dstSize_,
+                  out float w_[NVPRO_PYRAMID_WIDE_TAPS_])
+{
+  float sum_ = 0.0;
+  for (int t_ = 0; t_ < NVPRO_PYRAMID_WIDE_TAPS_; ++t_)
+  {
+    // Distance (tap center - c) in output texels, i.e.
+    // ((2 * tap + 1) * n - (2 * x + 1) * m) / (2 * m), rearranged to
+    // keep the integer numerator small.
+    int j_   = firstTap_ + t_ - 2 * x_;
+    int num_ = 2 * x_ * (2 * dstSize_ - srcSize_) + (2 * j_ + 1) * dstSize_
+               - srcSize_;
+    w_[t_] = NVPRO_PYRAMID_WIDE_KERNEL((float(num_) / float(2 * srcSize_)));
+    sum_ += w_[t_];
+  }
+  float rcp_ = 1.0 / sum_;
+  for (int t_ = 0; t_ < NVPRO_PYRAMID_WIDE_TAPS_; ++t_)
+  {
+    w_[t_] *= rcp_;
+  }
+}
+
+// Accumulate taps t_ and t_ + 1 into acc_, weighted by w_.
+#define NVPRO_PYRAMID_WIDE_ACCUMULATE_(t_, w_, v0_, v1_, acc_) \
+  if (t_ == 0) \
+  { \
+    NVPRO_PYRAMID_REDUCE(w_[0], v0_, w_[1], v1_, 0.0, v1_, acc_); \
+  } \
+  else \
+  { \
+    NVPRO_PYRAMID_TYPE tmp_; \
+    NVPRO_PYRAMID_REDUCE(1.0, acc_, w_[t_], v0_, w_[t_ + 1], v1_, tmp_); \
+    acc_ = tmp_; \
+  }
+
+// Load input row srcY_ (clamped) of level srcLevel_, and filter it
+// horizontally for output column dstX_.
+NVPRO_PYRAMID_TYPE wideFilterRow_(int srcY_, int dstX_, int srcLevel_,
+                                  ivec2 srcSize_, ivec2 dstSize_)
+{
+  int   first_ = wideFirstTap_(dstX_, srcSize_.x, dstSize_.x);
+  float w_[NVPRO_PYRAMID_WIDE_TAPS_];
+  wideWeights_(dstX_, first_, srcSize_.x, dstSize_.x, w_);
+  srcY_ = clamp(srcY_, 0, srcSize_.y - 1);
+
+  NVPRO_PYRAMID_TYPE v0_, v1_, acc_;
+  for (int t_ = 0; t_ < NVPRO_PYRAMID_WIDE_TAPS_; t_ += 2)
+  {
+    int x0_ = clamp(first_ + t_, 0, srcSize_.x - 1);
+    int x1_ = clamp(first_ + t_ + 1, 0, srcSize_.x - 1);
+    NVPRO_PYRAMID_LOAD_(ivec2(x0_, srcY_), srcLevel_, v0_);
+    NVPRO_PYRAMID_LOAD_(ivec2(x1_, srcY_), srcLevel_, v1_);
+    NVPRO_PYRAMID_WIDE_ACCUMULATE_(t_, w_, v0_, v1_, acc_)
+  }
+  return acc_;
+}
+
+// Filter column x_ of sharedRows_ vertically, starting at row
+// firstRow_, using the given weights.
+NVPRO_PYRAMID_TYPE wideFilterSharedRowsColumn_(
+    int x_, int firstRow_, float w_[NVPRO_PYRAMID_WIDE_TAPS_])
+{
+  NVPRO_PYRAMID_TYPE v0_, v1_, acc_;
+  for (int t_ = 0; t_ < NVPRO_PYRAMID_WIDE_TAPS_; t_ += 2)
+  {
+    NVPRO_PYRAMID_SHARED_LOAD((sharedRows_[firstRow_ + t_][x_]), v0_);
+    NVPRO_PYRAMID_SHARED_LOAD((sharedRows_[firstRow_ + t_ + 1][x_]), v1_);
+    NVPRO_PYRAMID_WIDE_ACCUMULATE_(t_, w_, v0_, v1_, acc_)
+  }
+  return acc_;
+}
+
+void nvproPyramidMain()
+{
+  int   inputLevel_ = int(NVPRO_PYRAMID_INPUT_LEVEL_);
+  ivec2 srcSize_    = NVPRO_PYRAMID_LEVEL_SIZE(inputLevel_);
+  ivec2 midSize_    = NVPRO_PYRAMID_LEVEL_SIZE((inputLevel_ + 1));
+  uint  localIdx_   = gl_LocalInvocationIndex;
+
+  if (NVPRO_PYRAMID_LEVEL_COUNT_ == 1u)
+  {
+    ivec2 dstCoord_ = ivec2(int(gl_GlobalInvocationID.x) % midSize_.x,
+                            int(gl_GlobalInvocationID.x) / midSize_.x);
+    if (dstCoord_.y < midSize_.y)
+    {
+      int   first_ = wideFirstTap_(dstCoord_.y, srcSize_.y, midSize_.y);
+      float w_[NVPRO_PYRAMID_WIDE_TAPS_];
+      wideWeights_(dstCoord_.y, first_, srcSize_.y, midSize_.y, w_);
+
+      NVPRO_PYRAMID_TYPE v0_, v1_, acc_;
+      for (int t_ = 0; t_ < NVPRO_PYRAMID_WIDE_TAPS_; t_ += 2)
+      {
+        v0_ = wideFilterRow_(first_ + t_, dstCoord_.x, inputLevel_,
+                             srcSize_, midSize_);
+        v1_ = wideFilterRow_(first_ + t_ + 1, dstCoord_.x, inputLevel_,
+                             srcSize_, midSize_);
+        NVPRO_PYRAMID_WIDE_ACCUMULATE_(t_, w_, v0_, v1_, acc_)
+      }
+      NVPRO_PYRAMID_STORE_(dstCoord_, (inputLevel_ + 1), acc_);
+    }
+  }
+  else  // Handling two levels.
+  {
+    // Assign a 8x8 tile of mip level inputLevel_ + 2 to this workgroup.
+    ivec2 dstSize_ = NVPRO_PYRAMID_LEVEL_SIZE((inputLevel_ + 2));
+    ivec2 tileCount_;
+    tileCount_.x    = int(uint(dstSize_.x + 7) / 8u);
+    tileCount_.y    = int(uint(dstSize_.y + 7) / 8u);
+    ivec2 tileIdx_  = ivec2(gl_WorkGroupID.x % uint(tileCount_.x),
+                            gl_WorkGroupID.x / uint(tileCount_.x));
+    ivec2 dstTile_  = tileIdx_ * 8;
+
+    // Intermediate tile origin (first tap of the first sample of the
+    // 8x8 tile), and the first input row needed for it.
+    ivec2 midTile_ = ivec2(wideFirstTap_(dstTile_.x, midSize_.x, dstSize_.x),
+                           wideFirstTap_(dstTile_.y, midSize_.y, dstSize_.y));
+    int   srcRow0_ = wideFirstTap_(clamp(midTile_.y, 0, midSize_.y - 1),
+                                   srcSize_.y, midSize_.y);
+
+    // Range of intermediate samples this tile is responsible for
+    // writing out: the right/bottom tiles also own the extra sample of
+    // odd-size levels.
+    ivec2 ownedBegin_ = dstTile_ * 2;
+    ivec2 ownedEnd_   = ownedBegin_ + ivec2(16, 16);
+    if (tileIdx_.x == tileCount_.x - 1) ownedEnd_.x = midSize_.x;
+    if (tileIdx_.y == tileCount_.y - 1) ownedEnd_.y = midSize_.y;
+
+    // Filter the needed input rows horizontally.
+    for (uint i_ = localIdx_;
+         i_ < NVPRO_PYRAMID_WIDE_ROWS_ * NVPRO_PYRAMID_WIDE_TILE_; i_ += 128u)
+    {
+      int row_ = int(i_ / uint(NVPRO_PYRAMID_WIDE_TILE_));
+      int col_ = int(i_ % uint(NVPRO_PYRAMID_WIDE_TILE_));
+      int midX_ = clamp(midTile_.x + col_, 0, midSize_.x - 1);
+      NVPRO_PYRAMID_TYPE sample_ =
+          wideFilterRow_(srcRow0_ + row_, midX_, inputLevel_, srcSize_, midSize_);
+      NVPRO_PYRAMID_SHARED_STORE((sharedRows_[row_][col_]), sample_);
+    }
+    NVPRO_PYRAMID_INSTRUMENT_EVENT_(NVPRO_PYRAMID_INSTRUMENT_LOADED_);
+    barrier();
+    NVPRO_PYRAMID_INSTRUMENT_EVENT_(NVPRO_PYRAMID_INSTRUMENT_BARRIER_);
+
+    // Filter vertically to fill the intermediate tile, and write out
+    // the owned samples.
+    for (uint i_ = localIdx_;
+         i_ < NVPRO_PYRAMID_WIDE_TILE_ * NVPRO_PYRAMID_WIDE_TILE_; i_ += 128u)
+    {
+      ivec2 tileCoord_ = ivec2(i_ % uint(NVPRO_PYRAMID_WIDE_TILE_),
+                               i_ / uint(NVPRO_PYRAMID_WIDE_TILE_));
+      int   midY_  = clamp(midTile_.y + tileCoord_.y, 0, midSize_.y - 1);
+      int   first_ = wideFirstTap_(midY_, srcSize_.y, midSize_.y);
+      float w_[NVPRO_PYRAMID_WIDE_TAPS_];
+      wideWeights_(midY_, first_, srcSize_.y, midSize_.y, w_);
+      NVPRO_PYRAMID_TYPE sample_ =
+          wideFilterSharedRowsColumn_(tileCoord_.x, first_ - srcRow0_, w_);
+      NVPRO_PYRAMID_SHARED_STORE(
+          (sharedLevel_[tileCoord_.y][tileCoord_.x]), sample_);
+
+      ivec2 midCoord_ = midTile_ + tileCoord_;
+      if (all(greaterThanEqual(midCoord_, ownedBegin_))
+          && all(lessThan(midCoord_, ownedEnd_)))
+      {
+        NVPRO_PYRAMID_STORE_(midCoord_, (inputLevel_ + 1), sample_);
+      }
+    }
+    barrier();
+
+    // Filter the intermediate tile horizontally, for the 8 columns of
+    // the last level tile (reusing sharedRows_).
+    for (uint i_ = localIdx_; i_ < NVPRO_PYRAMID_WIDE_TILE_ * 8; i_ += 128u)
+    {
+      int   row_   = int(i_ / 8u);
+      int   col_   = int(i_ % 8u);
+      int   dstX_  = min(dstTile_.x + col_, dstSize_.x - 1);
+      int   first_ = wideFirstTap_(dstX_, midSize_.x, dstSize_.x) - midTile_.x;
+      float w_[NVPRO_PYRAMID_WIDE_TAPS_];
+      wideWeights_(dstX_, first_ + midTile_.x, midSize_.x, dstSize_.x, w_);
+
+      NVPRO_PYRAMID_TYPE v0_, v1_, acc_;
+      for (int t_ = 0; t_ < NVPRO_PYRAMID_WIDE_TAPS_; t_ += 2)
+      {
+        NVPRO_PYRAMID_SHARED_LOAD((sharedLevel_[row_][first_ + t_]), v0_);
+        NVPRO_PYRAMID_SHARED_LOAD((sharedLevel_[row_][first_ + t_ + 1]), v1_);
+        NVPRO_PYRAMID_WIDE_ACCUMULATE_(t_, w_, v0_, v1_, acc_)
+      }
+      // Safe to overwrite, all reads of sharedRows_ done before barrier.
+      NVPRO_PYRAMID_SHARED_STORE((sharedRows_[row_][col_]), acc_);
+    }
+    barrier();
+
+    // Filter vertically, and write out the 8x8 tile.
+    if (localIdx_ < 8 * 8)
+    {
+      ivec2 threadOffset_ = ivec2(localIdx_ % 8u, localIdx_ / 8u);
+      ivec2 dstCoord_     = dstTile_ + threadOffset_;
+      if (dstCoord_.x < dstSize_.x && dstCoord_.y < dstSize_.y)
+      {
+        int   first_ = wideFirstTap_(dstCoord_.y, midSize_.y, dstSize_.y);
+        float w_[NVPRO_PYRAMID_WIDE_TAPS_];
+        wideWeights_(dstCoord_.y, first_, midSize_.y, dstSize_.y, w_);
+        NVPRO_PYRAMID_TYPE sample_ = wideFilterSharedRowsColumn_(
+            threadOffset_.x, first_ - midTile_.y, w_);
+        NVPRO_PYRAMID_STORE_(dstCoord_, (inputLevel_ + 2), sample_);
+      }
+    }
+  }
+}
+
 #else
 
 // General-case shader for generating 1 or 2 levels of the mip pyramid.
@@ -563,6 +1264,35 @@ ivec2 kernelSizeFromInputSize_(ivec2 inputSize_)
 NVPRO_PYRAMID_TYPE
 loadSample_(ivec2 srcCoord_, int srcLevel_, bool loadFromShared_);
 
+#ifdef NVPRO_PYRAMID_STORE_BAND
+// Emit the bands of the input texels that upsample from the output
+// sample coarse_ at dstCoord_ (see NVPRO_PYRAMID_STORE_BAND): the 2x2
+// (or smaller) square at dstCoord_ * 2, plus the 3rd column / row of
+// a 3-texel kernel at the right / bottom edge. Other arguments as for
+// reduceStoreSample_ below, which consumed the loaded texels, so they
+// are loaded again.
+void storeBands_(ivec2 srcCoord_, int srcLevel_, bool loadFromShared_,
+                 ivec2 kernelSize_, ivec2 dstImageSize_,
+                 ivec2 dstCoord_, int dstLevel_,
+                 NVPRO_PYRAMID_TYPE coarse_)
+{
+  ivec2 owned_ = min(kernelSize_, ivec2(2));
+  if (kernelSize_.x == 3 && dstCoord_.x == dstImageSize_.x - 1) owned_.x = 3;
+  if (kernelSize_.y == 3 && dstCoord_.y == dstImageSize_.y - 1) owned_.y = 3;
+
+  for (int y_ = 0; y_ < owned_.y; ++y_)
+  {
+    for (int x_ = 0; x_ < owned_.x; ++x_)
+    {
+      NVPRO_PYRAMID_TYPE in_ =
+          loadSample_(srcCoord_ + ivec2(x_, y_), srcLevel_, loadFromShared_);
+      NVPRO_PYRAMID_STORE_BAND((dstCoord_ * 2 + ivec2(x_, y_)),
+                               (dstLevel_ - 1), in_, coarse_);
+    }
+  }
+}
+#endif
+
 // Handle loading and reducing a rectangle of size kernelSize_
 // with the given upper-left coordinate srcCoord_. Samples read from
 // mip level srcLevel_ if !loadFromShared_, sharedLevel_ otherwise.
@@ -572,6 +1302,25 @@ loadSample_(ivec2 srcCoord_, int srcLevel_, bool loadFromShared_);
 // Once computed, the sample is written to the given coordinate of the
 // specified destination mip level, and returned. The destination
 // image size is needed to compute the kernel weights.
+#ifdef NVPRO_PYRAMID_LOAD_BILINEAR
+// Split one axis of a 1- to 3-tap kernel with weights w0_, w1_, (1 - w0_ - w1_)
+// into bilinear taps: texels 0 and 1 (or texel 0 alone) at texel offset
+// pos0_, plus, for 3 taps, texel 2 at offset 2.5 with weight weight1_.
+void bilinearTaps_(int kernelSize_, float w0_, float w1_,
+                   out float pos0_, out float weight1_)
+{
+  weight1_ = 0.0f;
+  switch (kernelSize_)
+  {
+    case 1: pos0_ = 0.5f; break;
+    case 2: pos0_ = 1.0f; break;
+    default:
+      pos0_    = 0.5f + w1_ / (w0_ + w1_);
+      weight1_ = 1.0f - w0_ - w1_;
+  }
+}
+#endif
+
 NVPRO_PYRAMID_TYPE reduceStoreSample_(ivec2 srcCoord_, int srcLevel_,
                                       bool  loadFromShared_,
                                       ivec2 kernelSize_,
@@ -587,6 +1336,61 @@ NVPRO_PYRAMID_TYPE reduceStoreSample_(ivec2 srcCoord_, int srcLevel_,
 
   NVPRO_PYRAMID_TYPE v0_, v1_, v2_, h0_, h1_, h2_, out_;
 
+#ifdef NVPRO_PYRAMID_LOAD_BILINEAR
+  // Load from the input level with up to 2x2 bilinear taps instead.
+#ifdef NVPRO_PYRAMID_GENERATE
+  if (!loadFromShared_ && srcLevel_ != 0)
+#else
+  if (!loadFromShared_)
+#endif
+  {
+    float nx_   = dstImageSize_.x;
+    float rcpx_ = 1.0f / (2 * nx_ + 1);
+    vec2  pos0_, weight1_;
+    bilinearTaps_(kernelSize_.x, rcpx_ * (nx_ - dstCoord_.x), rcpx_ * nx_,
+                  pos0_.x, weight1_.x);
+    bilinearTaps_(kernelSize_.y, w0_, w1_, pos0_.y, weight1_.y);
+    vec2 srcPos_ = vec2(srcCoord_);
+
+    // Upper row (texels 0 and 1, or 0 alone) and, for 3x3 kernels,
+    // lower row (texel 2), each reduced horizontally the same way.
+    NVPRO_PYRAMID_LOAD_BILINEAR((srcPos_ + pos0_), srcLevel_, h0_);
+    if (kernelSize_.x == 3)
+    {
+      NVPRO_PYRAMID_LOAD_BILINEAR((srcPos_ + vec2(2.5f, pos0_.y)), srcLevel_, h1_);
+      NVPRO_PYRAMID_REDUCE((1.0f - weight1_.x), h0_, weight1_.x, h1_, 0.0f, h1_, v0_);
+    }
+    else
+    {
+      v0_ = h0_;
+    }
+    if (kernelSize_.y == 3)
+    {
+      NVPRO_PYRAMID_LOAD_BILINEAR((srcPos_ + vec2(pos0_.x, 2.5f)), srcLevel_, h0_);
+      if (kernelSize_.x == 3)
+      {
+        NVPRO_PYRAMID_LOAD_BILINEAR((srcPos_ + vec2(2.5f)), srcLevel_, h1_);
+        NVPRO_PYRAMID_REDUCE((1.0f - weight1_.x), h0_, weight1_.x, h1_, 0.0f, h1_, v1_);
+      }
+      else
+      {
+        v1_ = h0_;
+      }
+      NVPRO_PYRAMID_REDUCE((1.0f - weight1_.y), v0_, weight1_.y, v1_, 0.0f, v1_, out_);
+    }
+    else
+    {
+      out_ = v0_;
+    }
+    NVPRO_PYRAMID_STORE_(dstCoord_, dstLevel_, out_);
+#ifdef NVPRO_PYRAMID_STORE_BAND
+    storeBands_(srcCoord_, srcLevel_, loadFromShared_, kernelSize_,
+                dstImageSize_, dstCoord_, dstLevel_, out_);
+#endif
+    return out_;
+  }
+#endif
+
   // Reduce vertically up to 3 times (depending on kernel horizontal size)
   switch (kernelSize_.x)
   {
@@ -651,7 +1455,11 @@ NVPRO_PYRAMID_TYPE reduceStoreSample_(ivec2 srcCoord_, int srcLevel_,
   }
 
   // Write out sample.
-  NVPRO_PYRAMID_STORE(dstCoord_, dstLevel_, out_);
+  NVPRO_PYRAMID_STORE_(dstCoord_, dstLevel_, out_);
+#ifdef NVPRO_PYRAMID_STORE_BAND
+  storeBands_(srcCoord_, srcLevel_, loadFromShared_, kernelSize_,
+              dstImageSize_, dstCoord_, dstLevel_, out_);
+#endif
   return out_;
 }
 
@@ -665,7 +1473,7 @@ loadSample_(ivec2 srcCoord_, int srcLevel_, bool loadFromShared_)
   }
   else
   {
-    NVPRO_PYRAMID_LOAD(srcCoord_, srcLevel_, loaded_);
+    NVPRO_PYRAMID_LOAD_(srcCoord_, srcLevel_, loaded_);
   }
   return loaded_;
 }
@@ -865,7 +1673,9 @@ void nvproPyramidMain()
       // Compute the tile in level inputLevel_ + 1 that's needed to
       // compute the above 8x8 tile.
       fillIntermediateTile_(tileIdx_ * 2 * ivec2(8, 8), true);
+      NVPRO_PYRAMID_INSTRUMENT_EVENT_(NVPRO_PYRAMID_INSTRUMENT_LOADED_);
       barrier();
+      NVPRO_PYRAMID_INSTRUMENT_EVENT_(NVPRO_PYRAMID_INSTRUMENT_BARRIER_);
 
       // Compute the inputLevel_ + 2 tile of size 8x8, loading
       // inupts from shared memory.
@@ -875,15 +1685,30 @@ void nvproPyramidMain()
     {
       // Same with no bounds checking.
       fillIntermediateTile_(tileIdx_ * 2 * ivec2(8, 8), false);
+      NVPRO_PYRAMID_INSTRUMENT_EVENT_(NVPRO_PYRAMID_INSTRUMENT_LOADED_);
       barrier();
+      NVPRO_PYRAMID_INSTRUMENT_EVENT_(NVPRO_PYRAMID_INSTRUMENT_BARRIER_);
       fillLastTile_(tileIdx_ * ivec2(8, 8), false);
     }
   }
 }
 
-#endif /* !NVPRO_USE_GENERAL_PIPELINE_ALTERNATIVE_ */
+#endif /* !NVPRO_USE_GENERAL_PIPELINE_ALTERNATIVE_ && !NVPRO_PYRAMID_WIDE_KERNEL */
 #endif /* !NVPRO_PYRAMID_IS_FAST_PIPELINE */
 
+#ifdef NVPRO_PYRAMID_INSTRUMENT
+#undef nvproPyramidMain
+void nvproPyramidMain()
+{
+  instrumentBegin_();
+  nvproPyramidMainBody_();
+  instrumentEnd_();
+}
+#endif
+
 #undef NVPRO_PYRAMID_2D_REDUCE_
+#undef NVPRO_PYRAMID_STORE_
+#undef NVPRO_PYRAMID_STORE_4X4_
+#undef NVPRO_PYRAMID_STORE_UNLESS_4X4_
 #undef NVPRO_PYRAMID_LEVEL_COUNT_
 #undef NVPRO_PYRAMID_INPUT_LEVEL_
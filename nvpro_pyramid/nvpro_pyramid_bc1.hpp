@@ -0,0 +1,79 @@
+// Copyright 2021 NVIDIA CORPORATION
+// SPDX-License-Identifier: Apache-2.0
+#ifndef NVPRO_SAMPLES_COMPUTE_MIPMAPS_NVPRO_PYRAMID_BC1_HPP_
+#define NVPRO_SAMPLES_COMPUTE_MIPMAPS_NVPRO_PYRAMID_BC1_HPP_
+
+#include <cassert>
+#include <vulkan/vulkan_core.h>
+
+#include "nvpro_pyramid_dispatch.hpp"
+
+// Host side of srgba8_bc1_preamble.glsl: generating an sRGBA8 mip
+// chain and encoding every level to BC1 in the same dispatches.
+//
+// Resources (descriptor sets as in srgba8_bc1_preamble.glsl):
+//
+// * The uncompressed R8G8B8A8_SRGB pyramid (level 0 filled in),
+//   sampled with bilinear filtering and bound as RGBA8_UINT storage
+//   views, as for srgba8_mipmap_preamble.glsl.
+//
+// * The BC1_RGB_SRGB (or BC1_RGBA_SRGB) pyramid, of the same size and
+//   mip levels, created with VK_IMAGE_CREATE_BLOCK_TEXEL_VIEW_COMPATIBLE_BIT,
+//   VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT and VK_IMAGE_CREATE_EXTENDED_USAGE_BIT,
+//   storage and sampled usage. Bound as one R32G32_UINT storage view per
+//   mip level; each view texel aliases one compressed block.
+//
+// * The block counter buffer, nvproPyramidBc1CounterBytes bytes,
+//   zero-filled once when created. The shaders leave it zeroed.
+//
+// Pipelines: NvproPyramidPipelines compiled from
+// srgba8_bc1_fast_pipeline.comp and srgba8_bc1_general_pipeline.comp,
+// plus baseLevelPipeline compiled from srgba8_bc1_base_level.comp
+// with the same layout.
+
+// Size in bytes of the block counter buffer: one uint32_t per 4x4
+// block of mip levels 1+ (0: full mip chain, as for nvproCmdPyramidDispatch).
+inline VkDeviceSize nvproPyramidBc1CounterBytes(uint32_t baseWidth,
+                                                uint32_t baseHeight,
+                                                uint32_t mipLevels = 0u)
+{
+  VkDeviceSize blocks = 0;
+  for (uint32_t level = 1u; mipLevels == 0u || level < mipLevels; ++level)
+  {
+    uint32_t x = baseWidth >> level, y = baseHeight >> level;
+    if (x == 0u && y == 0u) break;
+    x = x ? x : 1u;
+    y = y ? y : 1u;
+    blocks += VkDeviceSize((x + 3u) / 4u) * VkDeviceSize((y + 3u) / 4u);
+  }
+  return blocks ? blocks * sizeof(uint32_t) : sizeof(uint32_t);
+}
+
+// Record commands for generating mip levels 1+ of the uncompressed
+// pyramid, and encoding levels 0+ to the BC1 pyramid. Same
+// responsibilities for the caller as nvproCmdPyramidDispatch
+// (descriptor sets, synchronization before and after); the BC1
+// pyramid is complete after the last dispatch.
+//
+// Only the levels loaded by later dispatches, and those that cannot
+// be encoded directly from registers (see srgba8_bc1_preamble.glsl),
+// are written to the uncompressed pyramid.
+inline void nvproCmdPyramidBc1Dispatch(VkCommandBuffer       cmdBuf,
+                                       NvproPyramidPipelines pipelines,
+                                       VkPipeline            baseLevelPipeline,
+                                       uint32_t              baseWidth,
+                                       uint32_t              baseHeight,
+                                       uint32_t              mipLevels = 0u)
+{
+  assert(baseLevelPipeline);
+
+  // Level 0; only reads level 0 of the uncompressed pyramid, which
+  // the pyramid dispatches also only read.
+  uint32_t blocksX = (baseWidth + 3u) / 4u, blocksY = (baseHeight + 3u) / 4u;
+  vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, baseLevelPipeline);
+  vkCmdDispatch(cmdBuf, (blocksX + 7u) / 8u, (blocksY + 7u) / 8u, 1u);
+
+  nvproCmdPyramidDispatch(cmdBuf, pipelines, baseWidth, baseHeight, mipLevels);
+}
+
+#endif
@@ -0,0 +1,85 @@
+// Copyright 2021 NVIDIA CORPORATION
+// SPDX-License-Identifier: Apache-2.0
+#ifndef NVPRO_SAMPLES_COMPUTE_MIPMAPS_NVPRO_PYRAMID_BLOOM_HPP_
+#define NVPRO_SAMPLES_COMPUTE_MIPMAPS_NVPRO_PYRAMID_BLOOM_HPP_
+
+#include <cassert>
+#include <vulkan/vulkan_core.h>
+
+#include "nvpro_pyramid_dispatch.hpp"
+
+// Struct for passing the pipelines and associated data for the bloom
+// dispatch function.
+//
+// downsample: pipelines compiled from bloom_downsample_general_pipeline.comp
+// and bloom_downsample_fast_pipeline.comp (see bloom_preamble.glsl).
+//
+// upsamplePipeline: compute pipeline compiled from bloom_upsample.comp;
+// must use downsample.layout, and reads its 32-bit push constant at
+// downsample.pushConstantOffset (0 for the shader as shipped).
+struct NvproPyramidBloomPipelines
+{
+  NvproPyramidPipelines downsample;
+  VkPipeline            upsamplePipeline;
+};
+
+// Record commands for the bloom down/upsample chain of a scene of the
+// given size; bloomLevels counts the scene as level 0, so the down and
+// up images need bloomLevels - 1 mip levels of half the scene size,
+// and level 0 of the up image holds the result (bloom level 1).
+//
+// The downsample runs through nvproCmdPyramidDispatch, so the fast
+// pipeline fills up to 6 levels per dispatch. The upsample fills 2
+// levels per dispatch. Compared to one dispatch per level and
+// direction, this cuts the barriers from about 2 * bloomLevels to
+// (typically) 1 + bloomLevels / 2.
+//
+// The caller is responsible for the same things as for
+// nvproCmdPyramidDispatch (descriptor sets, synchronization before and after).
+inline void nvproCmdPyramidBloomDispatch(VkCommandBuffer            cmdBuf,
+                                         NvproPyramidBloomPipelines pipelines,
+                                         uint32_t                   sceneWidth,
+                                         uint32_t                   sceneHeight,
+                                         uint32_t                   bloomLevels)
+{
+  assert(bloomLevels >= 3u && bloomLevels <= 17u);
+  nvproCmdPyramidDispatch(cmdBuf, pipelines.downsample, sceneWidth,
+                          sceneHeight, bloomLevels);
+
+  VkMemoryBarrier barrier{
+      VK_STRUCTURE_TYPE_MEMORY_BARRIER, 0,
+      VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT};
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                       1, &barrier, 0, 0, 0, 0);
+  vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE,
+                    pipelines.upsamplePipeline);
+
+  // Fill levels bloomLevels - 2 down to 1, coarsest first; if the count
+  // is odd, the first (smallest) dispatch fills only one level.
+  uint32_t level     = bloomLevels - 1u;
+  uint32_t remaining = bloomLevels - 2u;
+  while (1)
+  {
+    uint32_t levels = remaining % 2u == 0u ? 2u : 1u;
+    level -= levels;
+    remaining -= levels;
+
+    uint32_t pc = bloomLevels << 10u | level << 5u | levels;
+    vkCmdPushConstants(cmdBuf, pipelines.downsample.layout,
+                       VK_SHADER_STAGE_COMPUTE_BIT,
+                       pipelines.downsample.pushConstantOffset, sizeof pc, &pc);
+    uint32_t x = sceneWidth >> level, y = sceneHeight >> level;
+    x = x ? x : 1u;
+    y = y ? y : 1u;
+    vkCmdDispatch(cmdBuf, (x + 15u) / 16u, (y + 15u) / 16u, 1u);
+
+    // Put barriers only between dispatches.
+    if (remaining == 0u) break;
+    vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                         1, &barrier, 0, 0, 0, 0);
+  }
+}
+
+#endif
@@ -0,0 +1,207 @@
+// Copyright 2021 NVIDIA CORPORATION
+// SPDX-License-Identifier: Apache-2.0
+
+// Optional alpha-coverage preservation passes, for alpha-tested
+// textures (e.g. foliage atlases) whose coverage would otherwise shrink
+// in the distance as the averaged alpha falls below the alpha test
+// cutoff. Run after the mip pyramid is generated by nvpro_pyramid.glsl,
+// using nvproCmdPyramidCoverageDispatch (nvpro_pyramid_coverage.hpp).
+//
+// For each mip level 1+, alpha is scaled so that the fraction of
+// texels passing the alpha test is (at least, and as close as
+// possible to) that of level 0. Each level is scaled independently,
+// i.e. it is still generated from the unscaled previous level.
+//
+// Two pipelines are compiled from this file:
+//
+//   * NVPRO_PYRAMID_COVERAGE_PASS 0
+// Histogram pass: count the (8-bit quantized) alpha values of every
+// mip level into NVPRO_PYRAMID_COVERAGE_HISTOGRAM.
+//
+//   * NVPRO_PYRAMID_COVERAGE_PASS 1
+// Scale pass: find the scale for each level 1+ from the histograms,
+// and rescale alpha in-place.
+//
+// Both use the same NVPRO_PYRAMID_TYPE, NVPRO_PYRAMID_LOAD,
+// NVPRO_PYRAMID_STORE, and NVPRO_PYRAMID_LEVEL_SIZE macros as
+// nvpro_pyramid.glsl (so the same preamble can be included), plus:
+//
+//   * NVPRO_PYRAMID_COVERAGE_ALPHA(v : NVPRO_PYRAMID_TYPE)
+// Resolve to the alpha value of v in [0, 1], as an lvalue (e.g. v.a).
+//
+//   * NVPRO_PYRAMID_COVERAGE_HISTOGRAM
+// Name of a uint array in a storage buffer, with at least 16 * 256
+// entries (nvproPyramidCoverageHistogramBytes); zeroed by
+// nvproCmdPyramidCoverageDispatch before the histogram pass.
+//
+// The scale pass reads (NVPRO_PYRAMID_LOAD) and writes
+// (NVPRO_PYRAMID_STORE) the same texel of levels 1+; as each texel is
+// only accessed by one invocation, this is fine even if the loads go
+// through a texture descriptor. Texels whose alpha does not change
+// are not written.
+//
+// The push constant (see NVPRO_PYRAMID_PUSH_CONSTANT in
+// nvpro_pyramid.glsl) holds the mip level count in bits 0-4 and the
+// 8-bit alpha test cutoff in bits 8-15; texels pass the alpha test if
+// their 8-bit quantized alpha is >= the cutoff.
+
+#if !defined(NVPRO_PYRAMID_COVERAGE_PASS)
+#error "Missing required macro NVPRO_PYRAMID_COVERAGE_PASS (0 or 1)"
+#endif
+#ifndef NVPRO_PYRAMID_COVERAGE_ALPHA
+#error "Missing required macro NVPRO_PYRAMID_COVERAGE_ALPHA"
+#endif
+#ifndef NVPRO_PYRAMID_COVERAGE_HISTOGRAM
+#error "Missing required macro NVPRO_PYRAMID_COVERAGE_HISTOGRAM"
+#endif
+
+#ifndef NVPRO_PYRAMID_PUSH_CONSTANT
+layout(push_constant) uniform NvproPyramidPushConstantBlock_
+{
+  uint nvproPyramidPushConstant_;
+};
+#define NVPRO_PYRAMID_PUSH_CONSTANT nvproPyramidPushConstant_
+#endif
+
+#define NVPRO_PYRAMID_COVERAGE_LEVEL_COUNT_ \
+  int(uint(NVPRO_PYRAMID_PUSH_CONSTANT) & 31u)
+#define NVPRO_PYRAMID_COVERAGE_CUTOFF_ \
+  (uint(NVPRO_PYRAMID_PUSH_CONSTANT) >> 8u & 255u)
+
+// Each workgroup handles up to 1024 texels of one mip level.
+// Change nvpro_pyramid_coverage.hpp if changed.
+layout(local_size_x = 256) in;
+
+shared uint coverageHistogram_[256];
+#if NVPRO_PYRAMID_COVERAGE_PASS != 0
+shared uint coverageBaseHistogram_[256];
+shared uint coverageThreshold_;
+#endif
+
+uint coverageAlpha8_(NVPRO_PYRAMID_TYPE v_)
+{
+  return uint(clamp(float(NVPRO_PYRAMID_COVERAGE_ALPHA(v_)), 0.0, 1.0) * 255.0
+              + 0.5);
+}
+
+// Find the mip level handled by this workgroup, and the index of the
+// workgroup within that level. Workgroups are assigned to the levels
+// in order, starting from firstLevel_.
+void coverageFindLevel_(int firstLevel_, out int level_, out uint levelWorkgroup_)
+{
+  levelWorkgroup_ = gl_WorkGroupID.x;
+  for (level_ = firstLevel_; level_ < NVPRO_PYRAMID_COVERAGE_LEVEL_COUNT_ - 1;
+       ++level_)
+  {
+    ivec2 size_       = NVPRO_PYRAMID_LEVEL_SIZE(level_);
+    uint  workgroups_ = (uint(size_.x) * uint(size_.y) + 1023u) / 1024u;
+    if (levelWorkgroup_ < workgroups_) break;
+    levelWorkgroup_ -= workgroups_;
+  }
+}
+
+void nvproPyramidCoverageMain()
+{
+  uint localIdx_ = gl_LocalInvocationIndex;
+  int  level_;
+  uint levelWorkgroup_;
+  coverageFindLevel_(NVPRO_PYRAMID_COVERAGE_PASS, level_, levelWorkgroup_);
+  ivec2 levelSize_ = NVPRO_PYRAMID_LEVEL_SIZE(level_);
+  uint  texels_    = uint(levelSize_.x) * uint(levelSize_.y);
+  uint  cutoff_    = NVPRO_PYRAMID_COVERAGE_CUTOFF_;
+
+#if NVPRO_PYRAMID_COVERAGE_PASS == 0
+  // Count alpha values of up to 1024 texels in shared memory, then
+  // add to the global histogram of this level.
+  coverageHistogram_[localIdx_] = 0u;
+  barrier();
+  for (uint i_ = 0u; i_ < 4u; ++i_)
+  {
+    uint texelIdx_ = levelWorkgroup_ * 1024u + i_ * 256u + localIdx_;
+    if (texelIdx_ < texels_)
+    {
+      ivec2 coord_ = ivec2(texelIdx_ % uint(levelSize_.x),
+                           texelIdx_ / uint(levelSize_.x));
+      NVPRO_PYRAMID_TYPE v_;
+      NVPRO_PYRAMID_LOAD(coord_, level_, v_);
+      atomicAdd(coverageHistogram_[coverageAlpha8_(v_)], 1u);
+    }
+  }
+  barrier();
+  uint count_ = coverageHistogram_[localIdx_];
+  if (count_ != 0u)
+  {
+    atomicAdd(NVPRO_PYRAMID_COVERAGE_HISTOGRAM[level_ * 256 + int(localIdx_)],
+              count_);
+  }
+#else
+  // Suffix sums of the histograms of this level and level 0, i.e.
+  // number of texels with 8-bit alpha >= bin index.
+  coverageHistogram_[localIdx_] =
+      NVPRO_PYRAMID_COVERAGE_HISTOGRAM[level_ * 256 + int(localIdx_)];
+  coverageBaseHistogram_[localIdx_] =
+      NVPRO_PYRAMID_COVERAGE_HISTOGRAM[localIdx_];
+  coverageThreshold_ = 1u;
+  barrier();
+  for (uint offset_ = 1u; offset_ < 256u; offset_ *= 2u)
+  {
+    uint add_     = 0u;
+    uint baseAdd_ = 0u;
+    if (localIdx_ + offset_ < 256u)
+    {
+      add_     = coverageHistogram_[localIdx_ + offset_];
+      baseAdd_ = coverageBaseHistogram_[localIdx_ + offset_];
+    }
+    barrier();
+    coverageHistogram_[localIdx_] += add_;
+    coverageBaseHistogram_[localIdx_] += baseAdd_;
+    barrier();
+  }
+
+  // Find the largest alpha threshold t such that the coverage of this
+  // level, with texels passing if alpha >= t, is at least that of level
+  // 0 (defaults to t = 1); i.e. find the largest t such that
+  // passing(t) * texels(0) >= passing0 * texels(this level),
+  // compared exactly with 64-bit products.
+  if (localIdx_ >= 1u)
+  {
+    uint lhsHi_, lhsLo_, rhsHi_, rhsLo_;
+    umulExtended(coverageHistogram_[localIdx_], coverageBaseHistogram_[0],
+                 lhsHi_, lhsLo_);
+    umulExtended(coverageBaseHistogram_[cutoff_], coverageHistogram_[0],
+                 rhsHi_, rhsLo_);
+    if (lhsHi_ > rhsHi_ || (lhsHi_ == rhsHi_ && lhsLo_ >= rhsLo_))
+    {
+      atomicMax(coverageThreshold_, localIdx_);
+    }
+  }
+  barrier();
+  uint threshold_ = coverageThreshold_;
+
+  // Scale alpha by cutoff / threshold, making sure that texels pass
+  // the alpha test iff their original alpha >= threshold.
+  if (threshold_ != cutoff_)
+  {
+    for (uint i_ = 0u; i_ < 4u; ++i_)
+    {
+      uint texelIdx_ = levelWorkgroup_ * 1024u + i_ * 256u + localIdx_;
+      if (texelIdx_ < texels_)
+      {
+        ivec2 coord_ = ivec2(texelIdx_ % uint(levelSize_.x),
+                             texelIdx_ / uint(levelSize_.x));
+        NVPRO_PYRAMID_TYPE v_;
+        NVPRO_PYRAMID_LOAD(coord_, level_, v_);
+        uint alpha_  = coverageAlpha8_(v_);
+        uint scaled_ = (alpha_ * cutoff_ + threshold_ / 2u) / threshold_;
+        scaled_ = alpha_ >= threshold_ ? clamp(scaled_, cutoff_, 255u)
+                                       : min(scaled_, cutoff_ - 1u);
+        if (scaled_ != alpha_)
+        {
+          NVPRO_PYRAMID_COVERAGE_ALPHA(v_) = float(scaled_) * (1.0 / 255.0);
+          NVPRO_PYRAMID_STORE(coord_, level_, v_);
+        }
+      }
+    }
+  }
+#endif
+}
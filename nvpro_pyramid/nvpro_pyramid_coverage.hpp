@@ -0,0 +1,124 @@
+// Copyright 2021 NVIDIA CORPORATION
+// SPDX-License-Identifier: Apache-2.0
+#ifndef NVPRO_SAMPLES_COMPUTE_MIPMAPS_NVPRO_PYRAMID_COVERAGE_HPP_
+#define NVPRO_SAMPLES_COMPUTE_MIPMAPS_NVPRO_PYRAMID_COVERAGE_HPP_
+
+#include <cassert>
+#include <vulkan/vulkan_core.h>
+
+// Size in bytes of the histogram buffer region needed by
+// nvproCmdPyramidCoverageDispatch (16 levels x 256 bins x uint32_t).
+constexpr VkDeviceSize nvproPyramidCoverageHistogramBytes = 16u * 256u * 4u;
+
+// Struct for passing the pipelines and associated data for the
+// alpha-coverage dispatch function.
+//
+// histogramPipeline, scalePipeline: compute pipelines, created as
+// described in nvpro_pyramid_coverage.glsl with
+// NVPRO_PYRAMID_COVERAGE_PASS defined as 0 and 1 respectively.
+//
+// layout: shared pipeline layout for both pipelines.
+//
+// pushConstantOffset: as in NvproPyramidPipelines.
+struct NvproPyramidCoveragePipelines
+{
+  VkPipeline       histogramPipeline;
+  VkPipeline       scalePipeline;
+  VkPipelineLayout layout;
+  uint32_t         pushConstantOffset;
+};
+
+// Record commands for rescaling the alpha of mip levels 1+ so that
+// their alpha test coverage (alpha >= alphaCutoff / 255) matches that
+// of level 0. Intended to be recorded right after
+// nvproCmdPyramidDispatch with the same image size and mip levels.
+//
+// histogramBuffer (at histogramOffset) must be the buffer bound to
+// NVPRO_PYRAMID_COVERAGE_HISTOGRAM, with
+// nvproPyramidCoverageHistogramBytes bytes available and
+// VK_BUFFER_USAGE_TRANSFER_DST_BIT usage; it is cleared by this function.
+//
+// This handles:
+//
+// * Synchronizing with the preceding nvproCmdPyramidDispatch
+// * Clearing the histogram buffer
+// * Binding compute pipelines, recording dispatch commands, and
+//   inserting barriers between dispatches
+//
+// The caller is responsible for the same things as for
+// nvproCmdPyramidDispatch (descriptor sets, synchronization after).
+inline void nvproCmdPyramidCoverageDispatch(VkCommandBuffer cmdBuf,
+                                            NvproPyramidCoveragePipelines pipelines,
+                                            VkBuffer     histogramBuffer,
+                                            VkDeviceSize histogramOffset,
+                                            uint32_t     alphaCutoff,
+                                            uint32_t     baseWidth,
+                                            uint32_t     baseHeight,
+                                            uint32_t     mipLevels = 0u)
+{
+  assert(alphaCutoff >= 1u && alphaCutoff <= 255u);
+  if (mipLevels == 0)
+  {
+    uint32_t srcWidth = baseWidth, srcHeight = baseHeight;
+    while (srcWidth != 0 || srcHeight != 0)
+    {
+      srcWidth  >>= 1;
+      srcHeight >>= 1;
+      ++mipLevels;
+    }
+  }
+  assert(mipLevels <= 16u);
+  if (mipLevels <= 1u) return;
+
+  // Count the workgroups needed (1024 texels each) for levels 0 and 1+.
+  uint32_t baseWorkgroups = 0u, levelWorkgroups = 0u;
+  for (uint32_t level = 0u; level < mipLevels; ++level)
+  {
+    uint32_t x = baseWidth >> level, y = baseHeight >> level;
+    x = x ? x : 1u;
+    y = y ? y : 1u;
+    (level == 0u ? baseWorkgroups : levelWorkgroups) += (x * y + 1023u) / 1024u;
+  }
+
+  // Wait for mipmap generation to finish, and clear the histograms.
+  VkMemoryBarrier barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER, 0,
+                          VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT};
+  VkBufferMemoryBarrier histogramBarrier{
+      VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER, 0,
+      VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+      VK_ACCESS_TRANSFER_WRITE_BIT,
+      VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+      histogramBuffer, histogramOffset, nvproPyramidCoverageHistogramBytes};
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                       0, 0, 1, &histogramBarrier, 0, 0);
+  vkCmdFillBuffer(cmdBuf, histogramBuffer, histogramOffset,
+                  nvproPyramidCoverageHistogramBytes, 0u);
+  histogramBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  histogramBarrier.dstAccessMask =
+      VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(cmdBuf,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
+                           | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                       1, &barrier, 1, &histogramBarrier, 0, 0);
+
+  uint32_t pc = alphaCutoff << 8u | mipLevels;
+  vkCmdPushConstants(cmdBuf, pipelines.layout, VK_SHADER_STAGE_COMPUTE_BIT,
+                     pipelines.pushConstantOffset, sizeof pc, &pc);
+
+  // Histogram every level, then rescale levels 1+.
+  vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE,
+                    pipelines.histogramPipeline);
+  vkCmdDispatch(cmdBuf, baseWorkgroups + levelWorkgroups, 1u, 1u);
+
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                       1, &barrier, 0, 0, 0, 0);
+  vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE,
+                    pipelines.scalePipeline);
+  vkCmdDispatch(cmdBuf, levelWorkgroups, 1u, 1u);
+}
+
+#endif
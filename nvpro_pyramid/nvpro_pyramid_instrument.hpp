@@ -0,0 +1,156 @@
+// Copyright 2021 NVIDIA CORPORATION
+// SPDX-License-Identifier: Apache-2.0
+#ifndef NVPRO_SAMPLES_COMPUTE_MIPMAPS_NVPRO_PYRAMID_INSTRUMENT_HPP_
+#define NVPRO_SAMPLES_COMPUTE_MIPMAPS_NVPRO_PYRAMID_INSTRUMENT_HPP_
+
+#include <stdint.h>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "nvpro_pyramid_dispatch.hpp"
+
+// Host side of the optional NVPRO_PYRAMID_INSTRUMENT workgroup
+// timestamps (see nvpro_pyramid.glsl).
+//
+// Buffer layout, as uint32_t:
+//
+// * Header (nvproPyramidInstrumentHeaderUints): [0] is the number of
+//   workgroups that started, including those that found the buffer
+//   full; the rest is unused. Must be zeroed before the pyramid
+//   dispatches (nvproCmdPyramidInstrumentReset).
+//
+// * Records (nvproPyramidInstrumentRecordUints each), one per workgroup,
+//   in start order: [0] the nvpro_pyramid push constant of the dispatch,
+//   [1] gl_WorkGroupID.x, [2] 1 for the fast pipeline, 0 for the
+//   general pipeline, [3] unused, [4 + 2 * event] and
+//   [5 + 2 * event] the low and high 32 bits of the clock at each
+//   NvproPyramidInstrumentEvent (0 if not reached).
+
+// Change nvpro_pyramid.glsl if changed.
+constexpr uint32_t nvproPyramidInstrumentHeaderUints = 4u;
+constexpr uint32_t nvproPyramidInstrumentRecordUints = 16u;
+
+enum NvproPyramidInstrumentEvent : uint32_t
+{
+  nvproPyramidInstrumentStart,     // Workgroup start
+  nvproPyramidInstrumentLoaded,    // Input loaded, first level stored
+  nvproPyramidInstrumentShuffled,  // Subgroup shuffle levels done
+  nvproPyramidInstrumentBarrier,   // Shared memory barrier passed
+  nvproPyramidInstrumentEnd,       // Last invocation done
+  nvproPyramidInstrumentEventCount
+};
+
+// Upper bound of the number of workgroups launched by
+// nvproCmdPyramidDispatch for the default pipelines (each handles at
+// least a 32x32 texel area of its input level, or the whole level).
+inline uint32_t nvproPyramidInstrumentMaxWorkgroups(uint32_t baseWidth,
+                                                    uint32_t baseHeight,
+                                                    uint32_t mipLevels = 0u)
+{
+  uint32_t workgroups = 0u;
+  for (uint32_t level = 0u; mipLevels == 0u || level + 1u < mipLevels; ++level)
+  {
+    uint32_t x = baseWidth >> level, y = baseHeight >> level;
+    if (x <= 1u && y <= 1u) break;
+    x = x ? x : 1u;
+    y = y ? y : 1u;
+    workgroups += ((x + 31u) / 32u) * ((y + 31u) / 32u);
+  }
+  return workgroups;
+}
+
+// Size in bytes of a buffer holding the given number of records.
+inline VkDeviceSize nvproPyramidInstrumentBytes(uint32_t maxWorkgroups)
+{
+  return sizeof(uint32_t)
+         * (nvproPyramidInstrumentHeaderUints
+            + VkDeviceSize(maxWorkgroups) * nvproPyramidInstrumentRecordUints);
+}
+
+// Record commands for zeroing the header of the instrument buffer
+// (requires VK_BUFFER_USAGE_TRANSFER_DST_BIT), with barriers before
+// (earlier shader accesses) and after (the next pyramid dispatches).
+inline void nvproCmdPyramidInstrumentReset(VkCommandBuffer cmdBuf,
+                                           VkBuffer        buffer,
+                                           VkDeviceSize    offset)
+{
+  const VkDeviceSize headerBytes =
+      nvproPyramidInstrumentHeaderUints * sizeof(uint32_t);
+  VkBufferMemoryBarrier barrier{
+      VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER, 0,
+      VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+      VK_ACCESS_TRANSFER_WRITE_BIT,
+      VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+      buffer, offset, headerBytes};
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                       0, 0, 1, &barrier, 0, 0);
+  vkCmdFillBuffer(cmdBuf, buffer, offset, headerBytes, 0u);
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                       0, 0, 1, &barrier, 0, 0);
+}
+
+// One decoded workgroup record.
+struct NvproPyramidInstrumentRecord
+{
+  uint32_t pushConstant;
+  uint32_t workgroup;
+  bool     fastPipeline;
+  uint64_t events[nvproPyramidInstrumentEventCount];
+
+  uint32_t inputLevel() const
+  {
+    return pushConstant >> nvproPyramidInputLevelShift;
+  }
+  uint32_t levelCount() const
+  {
+    return pushConstant & ((1u << nvproPyramidInputLevelShift) - 1u);
+  }
+
+  // Clock of the given event, or of the latest earlier event reached
+  // if it was not reached (so that skipped phases take no time).
+  uint64_t eventOrEarlier(uint32_t event) const
+  {
+    while (event > 0u && events[event] == 0u) --event;
+    return events[event];
+  }
+};
+
+// Decode the records of the instrument buffer contents (bytes bytes,
+// e.g. mapped host-visible memory after the dispatches completed) into
+// *pRecords. Returns the number of workgroups that did not fit.
+inline uint32_t nvproPyramidInstrumentDecode(
+    const void*                                buffer,
+    VkDeviceSize                               bytes,
+    std::vector<NvproPyramidInstrumentRecord>* pRecords)
+{
+  const uint32_t* pUints = static_cast<const uint32_t*>(buffer);
+  VkDeviceSize    capacity =
+      (bytes / sizeof(uint32_t) - nvproPyramidInstrumentHeaderUints)
+      / nvproPyramidInstrumentRecordUints;
+  uint32_t started = pUints[0];
+  uint32_t count   = started < capacity ? started : uint32_t(capacity);
+
+  pRecords->clear();
+  pRecords->reserve(count);
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    const uint32_t* pRecord = pUints + nvproPyramidInstrumentHeaderUints
+                              + i * nvproPyramidInstrumentRecordUints;
+    NvproPyramidInstrumentRecord record;
+    record.pushConstant = pRecord[0];
+    record.workgroup    = pRecord[1];
+    record.fastPipeline = pRecord[2] != 0u;
+    for (uint32_t e = 0; e < nvproPyramidInstrumentEventCount; ++e)
+    {
+      record.events[e] = uint64_t(pRecord[5 + 2 * e]) << 32 | pRecord[4 + 2 * e];
+    }
+    pRecords->push_back(record);
+  }
+  return started - count;
+}
+
+#endif
@@ -0,0 +1,29 @@
+// Copyright 2021 NVIDIA CORPORATION
+// SPDX-License-Identifier: Apache-2.0
+#ifndef NVPRO_SAMPLES_COMPUTE_MIPMAPS_NVPRO_PYRAMID_LUMINANCE_HPP_
+#define NVPRO_SAMPLES_COMPUTE_MIPMAPS_NVPRO_PYRAMID_LUMINANCE_HPP_
+
+#include <vulkan/vulkan_core.h>
+
+// Size in bytes of the scratch buffer needed by luminance_preamble.glsl
+// to reduce a source image of the given size to 1x1: one float per
+// texel of levels 2 up to (excluding) the final 1x1 level, which are
+// the levels that nvproCmdPyramidDispatch may hand off between
+// dispatches. Never 0, so that the buffer can always be created.
+//
+// For comparison, storing the full mip chain would take about
+// 5 times as much (levels 1+ in the image format of the source).
+inline VkDeviceSize nvproPyramidLuminanceScratchBytes(uint32_t baseWidth,
+                                                      uint32_t baseHeight)
+{
+  VkDeviceSize texels = 0;
+  for (uint32_t level = 2; ; ++level)
+  {
+    uint32_t x = baseWidth >> level, y = baseHeight >> level;
+    if (x <= 1u && y <= 1u) break;
+    texels += VkDeviceSize(x ? x : 1u) * VkDeviceSize(y ? y : 1u);
+  }
+  return texels ? texels * sizeof(float) : sizeof(float);
+}
+
+#endif
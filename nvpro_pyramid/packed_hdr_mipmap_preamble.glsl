@@ -0,0 +1,135 @@
+// Copyright 2021 NVIDIA CORPORATION
+// SPDX-License-Identifier: Apache-2.0
+
+// Defines the pipeline interface and macros for nvproPyramidMain for
+// linear HDR RGB mipmap generation in a packed 32-bit format,
+// B10G11R11_UFLOAT_PACK32 or E5B9G9R9_UFLOAT_PACK32 (half the size of
+// RGBA16F; no alpha, no negative values); EXCEPT that
+// NVPRO_PYRAMID_IS_FAST_PIPELINE is not defined.
+//
+// Few devices support storage images of these formats, so the mip
+// levels are written through R32_UINT storage views (create the image
+// with VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT and
+// VK_IMAGE_CREATE_EXTENDED_USAGE_BIT), packed manually, rounding to
+// nearest and clamping to the largest finite value. Shared memory holds
+// the same packed form. Reads go through the sampler as usual.
+//
+// Configuration macros:
+//
+//   * PACKED_HDR_FORMAT
+// PACKED_HDR_R11G11B10 (default) or PACKED_HDR_RGB9E5.
+//
+//   * USE_BILINEAR_SAMPLING
+// If zero, do not use the sampler to reduce 2x2 texel squares (see
+// NVPRO_PYRAMID_LOAD_REDUCE4). Otherwise, the sampler must use linear
+// filtering.
+
+#define PACKED_HDR_R11G11B10 0
+#define PACKED_HDR_RGB9E5 1
+
+#ifndef PACKED_HDR_FORMAT
+#define PACKED_HDR_FORMAT PACKED_HDR_R11G11B10
+#endif
+
+// ************************************************************************
+// Input: Entire texture with bilinear filtering (nearest mipmap mode).
+layout(set=0, binding=0) uniform sampler2D hdrTex;
+// Output: Same texture, imageMipLevels[n] refers to mip level n.
+//         Requires manual packing (packHdr).
+layout(set=1, binding=0, r32ui) uniform writeonly uimage2D imageMipLevels[16];
+
+// ************************************************************************
+// Packing, following the Vulkan spec sections on unsigned 11-bit and
+// 10-bit floating-point numbers and on the shared exponent format.
+#if PACKED_HDR_FORMAT == PACKED_HDR_R11G11B10
+  // Round the bits of a finite, non-negative half float to an unsigned
+  // float with the same exponent and 10 - dropBits mantissa bits
+  // (nearest, ties to even).
+  uint ufloatFromHalfBits(uint halfBits, uint dropBits)
+  {
+    uint lsb = (halfBits >> dropBits) & 1u;
+    return (halfBits + (1u << (dropBits - 1u)) - 1u + lsb) >> dropBits;
+  }
+
+  uint packHdr(vec3 rgb)
+  {
+    // Largest finite 11-bit / 10-bit unsigned floats.
+    rgb = clamp(rgb, vec3(0), vec3(65024.0, 65024.0, 64512.0));
+    uint r = ufloatFromHalfBits(packHalf2x16(vec2(rgb.r, 0)), 4u);
+    uint g = ufloatFromHalfBits(packHalf2x16(vec2(rgb.g, 0)), 4u);
+    uint b = ufloatFromHalfBits(packHalf2x16(vec2(rgb.b, 0)), 5u);
+    return r | g << 11 | b << 22;
+  }
+
+  vec3 unpackHdr(uint packed)
+  {
+    return vec3(unpackHalf2x16((packed & 0x7FFu) << 4).x,
+                unpackHalf2x16((packed >> 11 & 0x7FFu) << 4).x,
+                unpackHalf2x16((packed >> 22) << 5).x);
+  }
+#elif PACKED_HDR_FORMAT == PACKED_HDR_RGB9E5
+  uint packHdr(vec3 rgb)
+  {
+    // (511 / 512) * 2^16, largest representable value.
+    rgb        = clamp(rgb, vec3(0), vec3(65408.0));
+    float maxc = max(rgb.r, max(rgb.g, rgb.b));
+    // Shared exponent max(-16, floor(log2(maxc))) + 16, exactly, from
+    // the float exponent bits (denormals and zero give -16).
+    int expShared = max(-16, (floatBitsToInt(maxc) >> 23) - 127) + 16;
+    if (floor(ldexp(maxc, 24 - expShared) + 0.5) == 512.0)
+    {
+      ++expShared;
+    }
+    uvec3 m = uvec3(floor(ldexp(rgb, ivec3(24 - expShared)) + 0.5));
+    return m.r | m.g << 9 | m.b << 18 | uint(expShared) << 27;
+  }
+
+  vec3 unpackHdr(uint packed)
+  {
+    uvec3 m = uvec3(packed, packed >> 9, packed >> 18) & 0x1FFu;
+    return ldexp(vec3(m), ivec3(int(packed >> 27) - 24));
+  }
+#else
+  #error "Unknown PACKED_HDR_FORMAT"
+#endif
+
+// ************************************************************************
+// Mandatory macros, except NVPRO_PYRAMID_IS_FAST_PIPELINE
+#define NVPRO_PYRAMID_TYPE vec3
+
+#define NVPRO_PYRAMID_LOAD(coord, level, out_) \
+  out_ = texelFetch(hdrTex, coord, level).rgb
+
+#define NVPRO_PYRAMID_REDUCE(a0, v0, a1, v1, a2, v2, out_) \
+   out_ = a0 * v0 + a1 * v1 + a2 * v2
+
+#define NVPRO_PYRAMID_STORE(coord, level, in_) \
+  imageStore(imageMipLevels[level], coord, uvec4(packHdr(in_), 0, 0, 0))
+
+ivec2 levelSize(int level) { return imageSize(imageMipLevels[level]); }
+#define NVPRO_PYRAMID_LEVEL_SIZE levelSize
+
+// ************************************************************************
+// Optional macros (including recommended NVPRO_PYRAMID_LOAD_REDUCE4)
+#define NVPRO_PYRAMID_REDUCE2(v0, v1, out_) out_ = 0.5 * (v0 + v1)
+
+#define NVPRO_PYRAMID_REDUCE4(v00, v01, v10, v11, out_) \
+  out_ = 0.25 * ((v00 + v01) + (v10 + v11))
+
+#if !defined(USE_BILINEAR_SAMPLING) || USE_BILINEAR_SAMPLING
+  void loadReduce4(in ivec2 srcTexelCoord, in int srcLevel, out vec3 out_)
+  {
+    // Sample in the exact center of the 4 texels we want (see
+    // srgba8_mipmap_preamble.glsl).
+    vec2 normCoord = (vec2(srcTexelCoord) + vec2(1))
+                   / vec2(imageSize(imageMipLevels[srcLevel]));
+    out_ = textureLod(hdrTex, normCoord, srcLevel).rgb;
+  }
+  #define NVPRO_PYRAMID_LOAD_REDUCE4 loadReduce4
+#endif
+
+// Samples in shared memory are also stored to the pyramid, so keeping
+// them packed costs no extra precision there.
+#define NVPRO_PYRAMID_SHARED_TYPE uint
+#define NVPRO_PYRAMID_SHARED_LOAD(smem_, out_) out_ = unpackHdr(smem_)
+#define NVPRO_PYRAMID_SHARED_STORE(smem_, in_) smem_ = packHdr(in_)
@@ -0,0 +1,89 @@
+// Copyright 2021 NVIDIA CORPORATION
+// SPDX-License-Identifier: Apache-2.0
+
+// Defines the pipeline interface and macros for nvproPyramidMain for
+// linear (HDR) RGBA16F or RGBA32F mipmap generation; EXCEPT that
+// NVPRO_PYRAMID_IS_FAST_PIPELINE is not defined.
+//
+// Configuration macros:
+//
+//   * HDR_RGBA32F
+// If nonzero, the output storage images are rgba32f instead of rgba16f.
+//
+//   * F16_ARITHMETIC
+// If nonzero, NVPRO_PYRAMID_TYPE is f16vec4, so that the reductions
+// (and shared memory) use packed half-precision math instead of fp32.
+// Requires the shaderFloat16 feature, and
+// #extension GL_EXT_shader_explicit_arithmetic_types : enable
+// before including this file. Note that half floats saturate at 65504,
+// and that RGBA32F input is rounded to half precision when loaded.
+//
+//   * USE_BILINEAR_SAMPLING
+// If zero, do not use the sampler to reduce 2x2 texel squares (see
+// NVPRO_PYRAMID_LOAD_REDUCE4); needed if the format does not support
+// VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT (RGBA32F on some
+// devices). Otherwise, the sampler must use linear filtering.
+
+// ************************************************************************
+// Input: Entire texture with bilinear filtering (nearest mipmap mode).
+layout(set=0, binding=0) uniform sampler2D hdrTex;
+// Output: Same texture, imageMipLevels[n] refers to mip level n.
+#if defined(HDR_RGBA32F) && HDR_RGBA32F
+layout(set=1, binding=0, rgba32f) uniform writeonly image2D imageMipLevels[16];
+#else
+layout(set=1, binding=0, rgba16f) uniform writeonly image2D imageMipLevels[16];
+#endif
+
+// ************************************************************************
+// Mandatory macros, except NVPRO_PYRAMID_IS_FAST_PIPELINE
+#if defined(F16_ARITHMETIC) && F16_ARITHMETIC
+  #define NVPRO_PYRAMID_TYPE f16vec4
+  #define HDR_SCALAR_ float16_t
+#else
+  #define NVPRO_PYRAMID_TYPE vec4
+  #define HDR_SCALAR_ float
+#endif
+
+#define NVPRO_PYRAMID_LOAD(coord, level, out_) \
+  out_ = NVPRO_PYRAMID_TYPE(texelFetch(hdrTex, coord, level))
+
+#define NVPRO_PYRAMID_REDUCE(a0, v0, a1, v1, a2, v2, out_) \
+  out_ = HDR_SCALAR_(a0) * v0 + HDR_SCALAR_(a1) * v1 + HDR_SCALAR_(a2) * v2
+
+#define NVPRO_PYRAMID_STORE(coord, level, in_) \
+  imageStore(imageMipLevels[level], coord, vec4(in_))
+
+ivec2 levelSize(int level) { return imageSize(imageMipLevels[level]); }
+#define NVPRO_PYRAMID_LEVEL_SIZE levelSize
+
+// ************************************************************************
+// Optional macros (including recommended NVPRO_PYRAMID_LOAD_REDUCE4)
+#define NVPRO_PYRAMID_REDUCE2(v0, v1, out_) out_ = HDR_SCALAR_(0.5) * (v0 + v1)
+
+#define NVPRO_PYRAMID_REDUCE4(v00, v01, v10, v11, out_) \
+  out_ = HDR_SCALAR_(0.25) * ((v00 + v01) + (v10 + v11))
+
+#if !defined(USE_BILINEAR_SAMPLING) || USE_BILINEAR_SAMPLING
+  void loadReduce4(in ivec2 srcTexelCoord, in int srcLevel,
+                   out NVPRO_PYRAMID_TYPE out_)
+  {
+    // Sample in the exact center of the 4 texels we want (see
+    // srgba8_mipmap_preamble.glsl).
+    vec2 normCoord = (vec2(srcTexelCoord) + vec2(1))
+                   / vec2(imageSize(imageMipLevels[srcLevel]));
+    out_ = NVPRO_PYRAMID_TYPE(textureLod(hdrTex, normCoord, srcLevel));
+  }
+  #define NVPRO_PYRAMID_LOAD_REDUCE4 loadReduce4
+#endif
+
+#if defined(F16_ARITHMETIC) && F16_ARITHMETIC && NVPRO_PYRAMID_IS_FAST_PIPELINE
+  // Shuffle as 2 packed 32-bit words, so that the shaderSubgroupExtendedTypes
+  // feature (GL_EXT_shader_subgroup_extended_types_float16) is not needed.
+  f16vec4 shuffleXorF16vec4(f16vec4 in_, uint mask_)
+  {
+    uvec2 packed_ = uvec2(packFloat2x16(in_.xy), packFloat2x16(in_.zw));
+    packed_       = subgroupShuffleXor(packed_, mask_);
+    return f16vec4(unpackFloat2x16(packed_.x), unpackFloat2x16(packed_.y));
+  }
+  #define NVPRO_PYRAMID_SHUFFLE_XOR shuffleXorF16vec4
+#endif
@@ -0,0 +1,184 @@
+// Copyright 2021 NVIDIA CORPORATION
+// SPDX-License-Identifier: Apache-2.0
+
+// Defines the pipeline interface and macros for nvproPyramidMain for
+// generating sRGBA8 mip levels and encoding them to BC1 (opaque;
+// alpha is ignored) in the same dispatches; EXCEPT that
+// NVPRO_PYRAMID_IS_FAST_PIPELINE is not defined. See
+// nvpro_pyramid_bc1.hpp for the host side.
+//
+// The fast pipeline encodes the levels where whole 4x4 blocks are
+// held in registers (NVPRO_PYRAMID_STORE_4X4) directly: the threads
+// holding a block find its bounding box and their texels' indices,
+// and combine them with subgroup shuffles. These levels are never
+// written to the uncompressed sRGBA8 image. This covers the largest
+// level of every fast dispatch of 3 or more levels.
+//
+// Other samples (the last 2 levels of fast dispatches, general
+// pipeline levels) are written to the uncompressed image, which is
+// also what the next dispatch loads from. Each block has a counter;
+// the thread storing the last texel of a block re-reads the block
+// (recently written, so likely from L2) and encodes it.
+//
+// Level 0 is not written by nvproPyramidMain, so it is encoded
+// separately by srgba8_bc1_base_level.comp.
+
+#include "bc1_encode.glsl"
+
+// ************************************************************************
+// Input: Entire uncompressed sRGBA8 pyramid with bilinear filtering
+//        (only level 0 and the levels loaded by later dispatches are written).
+layout(set=0, binding=0) uniform sampler2D srgbTex;
+// Output: Same texture, imageMipLevels[n] refers to mip level n.
+//         Requires manual linear (vec4) color to sRGBA8 conversion.
+//         Coherent as blocks are re-read by whichever thread completes them.
+layout(set=1, binding=0, rgba8ui) uniform coherent uimage2D imageMipLevels[16];
+// Output: BC1 pyramid, as R32G32_UINT views (1 texel per 4x4 block);
+//         bc1Blocks[n] refers to mip level n.
+layout(set=1, binding=1, rg32ui) uniform writeonly uimage2D bc1Blocks[16];
+// Number of texels stored so far of each block of levels 1+ that is not
+// encoded in registers, see nvproPyramidBc1CounterBytes. Must be
+// zero-initialized once; each block's counter is reset when it is encoded.
+layout(set=1, binding=2) buffer Bc1CounterBuffer
+{
+  uint bc1Counters[];
+};
+
+// ************************************************************************
+// sRGB conversion; BC1_SRGB interpolates sRGB-encoded endpoints, so
+// blocks are encoded in that space.
+float srgbComponentFromLinear(float linear)
+{
+  return linear <= 0.0031308 ? (323 / 25.) * linear
+                             : 1.055 * pow(linear, 1 / 2.4) - 0.055;
+}
+
+vec3 srgbFromLinear3(vec3 linear)
+{
+  return clamp(vec3(srgbComponentFromLinear(linear.r),
+                    srgbComponentFromLinear(linear.g),
+                    srgbComponentFromLinear(linear.b)),
+               vec3(0), vec3(1));
+}
+
+uvec4 srgbFromLinearVec(vec4 arg)
+{
+  vec4 srgba = vec4(srgbFromLinear3(arg.rgb), clamp(arg.a, 0.0, 1.0));
+  return uvec4(srgba * 255.0 + 0.5);
+}
+
+// ************************************************************************
+// Block encoding from the uncompressed image.
+
+ivec2 levelSize(int level) { return imageSize(imageMipLevels[level]); }
+
+// Encode the given block of the given level from imageMipLevels; texels
+// past the edge of the level are clamped.
+uvec2 bc1EncodeStoredBlock(ivec2 block, int level)
+{
+  ivec2 maxCoord = levelSize(level) - 1;
+  vec3  texels[16];
+  for (int i = 0; i < 16; ++i)
+  {
+    ivec2 coord = min(block * 4 + ivec2(i & 3, i >> 2), maxCoord);
+    texels[i]   = vec3(imageLoad(imageMipLevels[level], coord).rgb) * (1.0 / 255.0);
+  }
+  return bc1EncodeBlock(texels);
+}
+
+// Index of the first counter of the given level (1+).
+uint bc1CounterOffset(int level)
+{
+  uint offset = 0u;
+  for (int i = 1; i < level; ++i)
+  {
+    uvec2 blocks = uvec2(levelSize(i) + 3) >> 2;
+    offset += blocks.x * blocks.y;
+  }
+  return offset;
+}
+
+void bc1Store(ivec2 coord, int level, vec4 color)
+{
+  imageStore(imageMipLevels[level], coord, srgbFromLinearVec(color));
+  memoryBarrierImage();
+
+  ivec2 size      = levelSize(level);
+  ivec2 block     = coord >> 2;
+  ivec2 texels    = min(size - block * 4, ivec2(4));
+  uint  counterId = bc1CounterOffset(level)
+                   + uint(block.y * ((size.x + 3) >> 2) + block.x);
+  if (atomicAdd(bc1Counters[counterId], 1u) == uint(texels.x * texels.y) - 1u)
+  {
+    // Last texel of the block; the others are visible by now.
+    bc1Counters[counterId] = 0u;
+    imageStore(bc1Blocks[level], block, uvec4(bc1EncodeStoredBlock(block, level), 0, 0));
+  }
+}
+
+// ************************************************************************
+// Mandatory macros, except NVPRO_PYRAMID_IS_FAST_PIPELINE
+#define NVPRO_PYRAMID_TYPE vec4
+
+#define NVPRO_PYRAMID_LOAD(coord, level, out_) \
+  out_ = texelFetch(srgbTex, coord, level)
+
+#define NVPRO_PYRAMID_REDUCE(a0, v0, a1, v1, a2, v2, out_) \
+   out_ = a0 * v0 + a1 * v1 + a2 * v2
+
+#define NVPRO_PYRAMID_STORE(coord, level, in_) bc1Store(coord, level, in_)
+
+#define NVPRO_PYRAMID_LEVEL_SIZE levelSize
+
+// ************************************************************************
+// Optional macros (including recommended NVPRO_PYRAMID_LOAD_REDUCE4)
+#define NVPRO_PYRAMID_REDUCE2(v0, v1, out_) out_ = 0.5 * (v0 + v1)
+
+#define NVPRO_PYRAMID_REDUCE4(v00, v01, v10, v11, out_) \
+  out_ = 0.25 * ((v00 + v01) + (v10 + v11))
+
+void loadReduce4(in ivec2 srcTexelCoord, in int srcLevel, out vec4 out_)
+{
+  // Sample in the exact center of the 4 texels, as in
+  // srgba8_mipmap_preamble.glsl.
+  vec2 normCoord = (vec2(srcTexelCoord) + vec2(1))
+                 / vec2(imageSize(imageMipLevels[srcLevel]));
+  out_ = textureLod(srgbTex, normCoord, srcLevel);
+}
+#define NVPRO_PYRAMID_LOAD_REDUCE4 loadReduce4
+
+#if defined(NVPRO_PYRAMID_IS_FAST_PIPELINE) && NVPRO_PYRAMID_IS_FAST_PIPELINE
+  // Encode a block held as 2x2 quads by 4 threads (see
+  // NVPRO_PYRAMID_STORE_4X4 in nvpro_pyramid.glsl). The bounding box is
+  // the same in all 4 threads (min/max are exact), so they agree on
+  // the endpoints; the thread holding the upper-left quad stores.
+  void bc1Store4x4(ivec2 coord, int level, uint laneStride,
+                   vec4 in00, vec4 in10, vec4 in01, vec4 in11)
+  {
+    vec3 s00 = srgbFromLinear3(in00.rgb), s10 = srgbFromLinear3(in10.rgb);
+    vec3 s01 = srgbFromLinear3(in01.rgb), s11 = srgbFromLinear3(in11.rgb);
+    vec3 lo  = min(min(s00, s10), min(s01, s11));
+    vec3 hi  = max(max(s00, s10), max(s01, s11));
+    lo       = min(lo, subgroupShuffleXor(lo, laneStride));
+    hi       = max(hi, subgroupShuffleXor(hi, laneStride));
+    lo       = min(lo, subgroupShuffleXor(lo, 2u * laneStride));
+    hi       = max(hi, subgroupShuffleXor(hi, 2u * laneStride));
+
+    vec3  color0, color1;
+    uint  endpoints = bc1Endpoints(lo, hi, color0, color1);
+    uvec2 texel     = uvec2(coord & 3);
+    uint  shift     = 2u * (4u * texel.y + texel.x);
+    uint  indices   = bc1Index(s00, color0, color1) << shift
+                    | bc1Index(s10, color0, color1) << (shift + 2u)
+                    | bc1Index(s01, color0, color1) << (shift + 8u)
+                    | bc1Index(s11, color0, color1) << (shift + 10u);
+    indices |= subgroupShuffleXor(indices, laneStride);
+    indices |= subgroupShuffleXor(indices, 2u * laneStride);
+
+    if ((gl_SubgroupInvocationID & (4u * laneStride - 1u)) == 0u)
+    {
+      imageStore(bc1Blocks[level], coord >> 2, uvec4(endpoints, indices, 0, 0));
+    }
+  }
+  #define NVPRO_PYRAMID_STORE_4X4 bc1Store4x4
+#endif
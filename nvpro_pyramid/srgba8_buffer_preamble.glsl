@@ -0,0 +1,109 @@
+// Copyright 2021 NVIDIA CORPORATION
+// SPDX-License-Identifier: Apache-2.0
+
+// Defines the pipeline interface and macros for nvproPyramidMain for
+// generating sRGBA8 mipmaps in a buffer instead of an image; EXCEPT
+// that NVPRO_PYRAMID_IS_FAST_PIPELINE is not defined.
+//
+// The buffer holds all mip levels, tightly packed one after the other,
+// laid out as MipmapStorage<uint8_t, 4> (see getLevelOffsets); level 0
+// must be filled in. This can be a host-visible buffer for reading the
+// pyramid back on the host without an image-to-buffer copy; as each
+// dispatch reads the last level written by the previous one from the
+// same buffer, this is best suited for memory that is fast for the
+// device to access too (e.g. integrated GPUs, resizable BAR).
+//
+// There is no texture filtering for buffers, so the 2x2 reduction
+// loads each texel separately (default NVPRO_PYRAMID_LOAD_REDUCE4).
+
+// ************************************************************************
+// Input and output: all mip levels, 1 packed sRGBA8 texel per uint
+// (red in the least significant byte).
+layout(set=0, binding=0) buffer SrgbaTexelBuffer
+{
+  uint srgbaTexels[];
+};
+
+// The 32-bit push constant used by nvproCmdPyramidDispatch, followed by
+// the size of level 0 (offset 4), which the caller must push.
+layout(push_constant) uniform SrgbaBufferPushConstantBlock
+{
+  uint pyramidPushConstant;
+  uint baseWidth, baseHeight;
+};
+#define NVPRO_PYRAMID_PUSH_CONSTANT pyramidPushConstant
+
+// ************************************************************************
+// Level layout, same as MipmapStorage.
+ivec2 levelSize(int level)
+{
+  return max(ivec2(uvec2(baseWidth, baseHeight) >> level), ivec2(1));
+}
+
+uint levelOffset(int level)
+{
+  uint offset = 0u;
+  for (int i = 0; i < level; ++i)
+  {
+    ivec2 size = levelSize(i);
+    offset += uint(size.x * size.y);
+  }
+  return offset;
+}
+
+uint texelIndex(ivec2 coord, int level)
+{
+  return levelOffset(level) + uint(coord.y * levelSize(level).x + coord.x);
+}
+
+// ************************************************************************
+// sRGB conversion, as in srgba8_mipmap_preamble.glsl (sRGB=true).
+float linearFromSrgbComponent(float srgb)
+{
+  return srgb <= 0.04045 ? srgb * (25 / 323.)
+                         : pow((200 * srgb + 11) * (1/211.), 2.4);
+}
+
+vec4 linearFromSrgbPacked(uint srgbPacked)
+{
+  vec4 srgba = unpackUnorm4x8(srgbPacked);
+  return vec4(linearFromSrgbComponent(srgba.r),
+              linearFromSrgbComponent(srgba.g),
+              linearFromSrgbComponent(srgba.b), srgba.a);
+}
+
+uint srgbFromLinearComponent(float arg)
+{
+  float srgb = arg <= 0.0031308 ? (323/25.) * arg
+                                : 1.055 * pow(arg, 1/2.4) - 0.055;
+  return uint(clamp(srgb * 255. + 0.5, 0, 255));
+}
+
+uint srgbPackedFromLinear(vec4 arg)
+{
+  uint alpha = uint(clamp(arg.a * 255.0f + 0.5f, 0.0f, 255.0f));
+  return srgbFromLinearComponent(arg.r) | srgbFromLinearComponent(arg.g) << 8
+       | srgbFromLinearComponent(arg.b) << 16 | alpha << 24;
+}
+
+// ************************************************************************
+// Mandatory macros, except NVPRO_PYRAMID_IS_FAST_PIPELINE
+#define NVPRO_PYRAMID_TYPE vec4
+
+#define NVPRO_PYRAMID_LOAD(coord, level, out_) \
+  out_ = linearFromSrgbPacked(srgbaTexels[texelIndex(coord, level)])
+
+#define NVPRO_PYRAMID_REDUCE(a0, v0, a1, v1, a2, v2, out_) \
+   out_ = a0 * v0 + a1 * v1 + a2 * v2
+
+#define NVPRO_PYRAMID_STORE(coord, level, in_) \
+  srgbaTexels[texelIndex(coord, level)] = srgbPackedFromLinear(in_)
+
+#define NVPRO_PYRAMID_LEVEL_SIZE levelSize
+
+// ************************************************************************
+// Optional macros
+#define NVPRO_PYRAMID_REDUCE2(v0, v1, out_) out_ = 0.5 * (v0 + v1)
+
+#define NVPRO_PYRAMID_REDUCE4(v00, v01, v10, v11, out_) \
+  out_ = 0.25 * ((v00 + v01) + (v10 + v11))
@@ -55,6 +55,68 @@ ivec2 levelSize(int level) { return imageSize(imageMipLevels[level]); }
     out_ = textureLod(srgbTex, normCoord, srcLevel);
   }
   #define NVPRO_PYRAMID_LOAD_REDUCE4 loadReduce4
+
+  // If BILINEAR_NP2 is nonzero, bilinear sample at a position in texels,
+  // for the general pipeline's input loads (2 texels per axis per sample
+  // instead of 1). Opt-in, as odd-size kernels are then only approximated
+  // (within about one sRGB8 step).
+  #if defined(BILINEAR_NP2) && BILINEAR_NP2
+  void loadBilinear(in vec2 srcTexelPos, in int srcLevel, out vec4 out_)
+  {
+    vec2 normCoord = srcTexelPos / vec2(imageSize(imageMipLevels[srcLevel]));
+    out_ = textureLod(srgbTex, normCoord, srcLevel);
+  }
+  #define NVPRO_PYRAMID_LOAD_BILINEAR loadBilinear
+  #endif
+#endif
+
+// If WIDE_KERNEL is WIDE_KERNEL_LANCZOS or WIDE_KERNEL_KAISER, use an
+// 8-tap separable windowed sinc kernel instead of the box / NP2 kernel.
+// General pipeline only; must match wideKernelWeight in mipmap_storage.hpp.
+#define WIDE_KERNEL_LANCZOS 1
+#define WIDE_KERNEL_KAISER 2
+#if defined(WIDE_KERNEL) && WIDE_KERNEL != 0
+  #define WIDE_KERNEL_RADIUS 4
+
+  // sin(pi * x) / (pi * x), with the cutoff of the 2:1 downsample
+  // already applied (d in output texels).
+  float wideSinc(float x)
+  {
+    return abs(x) < 1e-5 ? 1.0 : sin(3.14159265 * x) / (3.14159265 * x);
+  }
+
+  #if WIDE_KERNEL == WIDE_KERNEL_LANCZOS
+    // Lanczos-2 (window = central lobe of a wider sinc).
+    float wideKernel(float d)
+    {
+      return abs(d) >= 2.0 ? 0.0 : wideSinc(d) * wideSinc(d * 0.5);
+    }
+  #elif WIDE_KERNEL == WIDE_KERNEL_KAISER
+    // Modified Bessel function of the first kind, order 0 (series).
+    float besselI0(float x)
+    {
+      float sum = 1.0, term = 1.0, halfX2 = 0.25 * x * x;
+      for (int k = 1; k < 12; ++k)
+      {
+        term *= halfX2 / float(k * k);
+        sum += term;
+      }
+      return sum;
+    }
+
+    // Kaiser-windowed sinc, window width 2 output texels, beta = 4.
+    float wideKernel(float d)
+    {
+      float t = d * 0.5;
+      return abs(t) >= 1.0 ? 0.0
+             : wideSinc(d) * besselI0(4.0 * sqrt(1.0 - t * t)) / besselI0(4.0);
+    }
+  #else
+    #error "Unknown WIDE_KERNEL"
+  #endif
+
+  #define NVPRO_PYRAMID_WIDE_KERNEL wideKernel
+  #define NVPRO_PYRAMID_WIDE_KERNEL_RADIUS WIDE_KERNEL_RADIUS
 #endif
 
 #if defined(SRGB_SHARED) && SRGB_SHARED
@@ -107,6 +169,21 @@ ivec2 levelSize(int level) { return imageSize(imageMipLevels[level]); }
   #define NVPRO_PYRAMID_SHARED_STORE(smem_, in_) smem_ = f16vec4(in_)
 #endif
 
+// If INSTRUMENT is nonzero, record workgroup timestamps to the buffer
+// at set=2, binding=2 (see NVPRO_PYRAMID_INSTRUMENT). Requires
+// GL_EXT_shader_realtime_clock if INSTRUMENT_REALTIME is nonzero,
+// GL_ARB_shader_clock otherwise.
+#if defined(INSTRUMENT) && INSTRUMENT
+  layout(set=2, binding=2) buffer InstrumentBuffer
+  {
+    uint instrumentTimestamps[];
+  };
+  #define NVPRO_PYRAMID_INSTRUMENT instrumentTimestamps
+  #if defined(INSTRUMENT_REALTIME) && INSTRUMENT_REALTIME
+    #define NVPRO_PYRAMID_INSTRUMENT_REALTIME 1
+  #endif
+#endif
+
 uint srgbFromLinearBias(float arg, float bias)
 {
   float srgb = arg <= 0.0031308 ? (323/25.) * arg
@@ -122,7 +199,7 @@ uint srgbFromLinear(float arg)
 
 uvec4 srgbFromLinearVec(vec4 arg)
 {
-  uint alpha = clamp(uint(arg.a * 255.0f + 0.5f), 0u, 255u);
+  uint alpha = uint(clamp(arg.a * 255.0f + 0.5f, 0.0f, 255.0f));
   return uvec4(srgbFromLinear(arg.r), srgbFromLinear(arg.g),
                srgbFromLinear(arg.b), alpha);
 }
@@ -0,0 +1,116 @@
+// Copyright 2021 NVIDIA CORPORATION
+// SPDX-License-Identifier: Apache-2.0
+
+// Defines the pipeline interface and macros for nvproPyramidMain for
+// linear 1- or 2-channel unorm mipmap generation (R8, RG8, R16, RG16;
+// e.g. masks, roughness, or height maps); EXCEPT that
+// NVPRO_PYRAMID_IS_FAST_PIPELINE is not defined.
+//
+// NVPRO_PYRAMID_TYPE is float or vec2 instead of vec4, so the
+// reductions, shuffles, and shared memory do not carry padding
+// channels. Storage images of these formats require the
+// shaderStorageImageExtendedFormats feature.
+//
+// Configuration macros:
+//
+//   * UNORM_CHANNELS
+// 1 or 2 (default 1). 4 is also accepted, to benchmark the same
+// data padded to RGBA (vec4 everywhere, no shared memory packing).
+//
+//   * UNORM_BITS
+// 8 or 16 (default 8): bits per channel of the images.
+//
+//   * UNORM_PACKED_SHARED
+// If nonzero (default), 2-channel samples are stored in shared memory
+// as one packUnorm2x16 word instead of a vec2 (1-channel samples are
+// always a single float). The 16-bit intermediate quantization is
+// exact for 8-bit data; for 16-bit data it may add 1/2 step of error.
+//
+//   * USE_BILINEAR_SAMPLING
+// If zero, do not use the sampler to reduce 2x2 texel squares (see
+// NVPRO_PYRAMID_LOAD_REDUCE4). Otherwise, the sampler must use linear
+// filtering.
+
+#ifndef UNORM_CHANNELS
+#define UNORM_CHANNELS 1
+#endif
+#ifndef UNORM_BITS
+#define UNORM_BITS 8
+#endif
+#ifndef UNORM_PACKED_SHARED
+#define UNORM_PACKED_SHARED 1
+#endif
+
+// ************************************************************************
+// Input: Entire texture with bilinear filtering (nearest mipmap mode).
+layout(set=0, binding=0) uniform sampler2D unormTex;
+// Output: Same texture, imageMipLevels[n] refers to mip level n.
+#if UNORM_CHANNELS == 1 && UNORM_BITS == 8
+layout(set=1, binding=0, r8) uniform writeonly image2D imageMipLevels[16];
+#elif UNORM_CHANNELS == 1 && UNORM_BITS == 16
+layout(set=1, binding=0, r16) uniform writeonly image2D imageMipLevels[16];
+#elif UNORM_CHANNELS == 2 && UNORM_BITS == 8
+layout(set=1, binding=0, rg8) uniform writeonly image2D imageMipLevels[16];
+#elif UNORM_CHANNELS == 2 && UNORM_BITS == 16
+layout(set=1, binding=0, rg16) uniform writeonly image2D imageMipLevels[16];
+#elif UNORM_CHANNELS == 4 && UNORM_BITS == 8
+layout(set=1, binding=0, rgba8) uniform writeonly image2D imageMipLevels[16];
+#elif UNORM_CHANNELS == 4 && UNORM_BITS == 16
+layout(set=1, binding=0, rgba16) uniform writeonly image2D imageMipLevels[16];
+#else
+#error "Unsupported UNORM_CHANNELS / UNORM_BITS"
+#endif
+
+// ************************************************************************
+// Mandatory macros, except NVPRO_PYRAMID_IS_FAST_PIPELINE
+#if UNORM_CHANNELS == 1
+  #define NVPRO_PYRAMID_TYPE float
+  #define UNORM_SWIZZLE_ r
+  #define UNORM_PAD_(in_) vec4(in_, 0, 0, 0)
+#elif UNORM_CHANNELS == 2
+  #define NVPRO_PYRAMID_TYPE vec2
+  #define UNORM_SWIZZLE_ rg
+  #define UNORM_PAD_(in_) vec4(in_, 0, 0)
+#else
+  #define NVPRO_PYRAMID_TYPE vec4
+  #define UNORM_SWIZZLE_ rgba
+  #define UNORM_PAD_(in_) (in_)
+#endif
+
+#define NVPRO_PYRAMID_LOAD(coord, level, out_) \
+  out_ = texelFetch(unormTex, coord, level).UNORM_SWIZZLE_
+
+#define NVPRO_PYRAMID_REDUCE(a0, v0, a1, v1, a2, v2, out_) \
+   out_ = a0 * v0 + a1 * v1 + a2 * v2
+
+#define NVPRO_PYRAMID_STORE(coord, level, in_) \
+  imageStore(imageMipLevels[level], coord, UNORM_PAD_(in_))
+
+ivec2 levelSize(int level) { return imageSize(imageMipLevels[level]); }
+#define NVPRO_PYRAMID_LEVEL_SIZE levelSize
+
+// ************************************************************************
+// Optional macros (including recommended NVPRO_PYRAMID_LOAD_REDUCE4)
+#define NVPRO_PYRAMID_REDUCE2(v0, v1, out_) out_ = 0.5 * (v0 + v1)
+
+#define NVPRO_PYRAMID_REDUCE4(v00, v01, v10, v11, out_) \
+  out_ = 0.25 * ((v00 + v01) + (v10 + v11))
+
+#if !defined(USE_BILINEAR_SAMPLING) || USE_BILINEAR_SAMPLING
+  void loadReduce4(in ivec2 srcTexelCoord, in int srcLevel,
+                   out NVPRO_PYRAMID_TYPE out_)
+  {
+    // Sample in the exact center of the 4 texels we want (see
+    // srgba8_mipmap_preamble.glsl).
+    vec2 normCoord = (vec2(srcTexelCoord) + vec2(1))
+                   / vec2(imageSize(imageMipLevels[srcLevel]));
+    out_ = textureLod(unormTex, normCoord, srcLevel).UNORM_SWIZZLE_;
+  }
+  #define NVPRO_PYRAMID_LOAD_REDUCE4 loadReduce4
+#endif
+
+#if UNORM_CHANNELS == 2 && UNORM_PACKED_SHARED
+  #define NVPRO_PYRAMID_SHARED_TYPE uint
+  #define NVPRO_PYRAMID_SHARED_LOAD(smem_, out_) out_ = unpackUnorm2x16(smem_)
+  #define NVPRO_PYRAMID_SHARED_STORE(smem_, in_) smem_ = packUnorm2x16(in_)
+#endif
@@ -0,0 +1,74 @@
+// Copyright 2021 NVIDIA CORPORATION
+// SPDX-License-Identifier: Apache-2.0
+
+// Defines the pipeline interface and macros for nvproPyramidMain for
+// filling the Julia Set color texture and all its mip levels in one
+// nvproCmdPyramidDispatch; EXCEPT that NVPRO_PYRAMID_IS_FAST_PIPELINE
+// is not defined. This is srgba8_mipmap_preamble.glsl (same descriptor
+// sets), except that level 0 is computed by NVPRO_PYRAMID_GENERATE,
+// which also stores it, instead of loaded from the texture.
+//
+// The push constant is the 32-bit nvproCmdPyramidDispatch push
+// constant, followed by JuliaPushConstant (offset 4), which the caller
+// must push.
+
+#include "julia.h"
+#include "../nvpro_pyramid/srgba8_mipmap_preamble.glsl"
+
+layout(push_constant) uniform JuliaPyramidPushConstantBlock
+{
+  uint              pyramidPushConstant;
+  JuliaPushConstant pc;
+};
+#define NVPRO_PYRAMID_PUSH_CONSTANT pyramidPushConstant
+
+void mul(in float ar, in float ai, in float br, in float bi, out float cr, out float ci)
+{
+  cr = ar * br - ai * bi;
+  ci = ar * bi + br * ai;
+}
+
+// sRGBA8 color visualizing the iteration count of the given texel.
+uvec4 juliaColor(ivec2 coord)
+{
+  // Scale and flip screen coordinate to calculate z_0
+  float zr = coord.x * pc.scale + pc.offset_real;
+  float zi = coord.y * -pc.scale + pc.offset_imag;
+
+  int iterations = 0;
+  while (iterations < pc.maxIterations && zr * zr + zi * zi <= 4)
+  {
+    float tmp_r, tmp_i;
+    mul(zr, zi, zr, zi, tmp_r, tmp_i);
+    zr = tmp_r + pc.c_real;
+    zi = tmp_i + pc.c_imag;
+    ++iterations;
+  }
+
+  // Color based on iteration count. TODO not sRGB correct???
+  if (iterations < 16)
+  {
+    float scale = (4 + iterations) * (1 / 20.);
+    return uvec4(vec4(0, 128, 255, 255) * scale);
+  }
+  uint n = uint(127.0 * (iterations - 16) / (pc.maxIterations - iterations));
+  return uvec4(n, 128 + n/4, 255 - n, 255);
+}
+
+float juliaLinearFromSrgb(uint srgb)
+{
+  float u = srgb * (1.0f / 255.0f);
+  return u <= 0.04045 ? u * (25.0f / 323.0f)
+                      : pow((200.0f * u + 11.0f) * (1.0f / 211.0f), 2.4f);
+}
+
+// Store the level 0 texel as sRGBA8 and return it as linear color; the
+// stored bytes only depend on coord, so generating a texel twice is fine.
+void juliaGenerate(ivec2 coord, out vec4 out_)
+{
+  uvec4 color = juliaColor(coord);
+  imageStore(imageMipLevels[0], coord, color);
+  out_ = vec4(juliaLinearFromSrgb(color.r), juliaLinearFromSrgb(color.g),
+              juliaLinearFromSrgb(color.b), color.a * (1.0f / 255.0f));
+}
+#define NVPRO_PYRAMID_GENERATE juliaGenerate
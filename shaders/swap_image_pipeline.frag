@@ -21,6 +21,8 @@ layout(set=1, binding=0) uniform CameraTransformsBuffer
 {
   CameraTransforms cameraTransforms;
 };
+// Bloom result, half the base color texture size (see bloom.hpp).
+layout(set=2, binding=0) uniform sampler2D bloomTex;
 
 layout(location=0) in  vec2 normalizedPixel;
 layout(location=0) out vec4 color;
@@ -104,6 +106,12 @@ vec4 sampleTexture()
     }
   }
 
+  if (pushConstant.bloomIntensity > 0)
+  {
+    sampledColor.rgb +=
+        pushConstant.bloomIntensity * textureLod(bloomTex, normCoord, 0).rgb;
+  }
+
   if (pushConstant.sceneMode == VK_COMPUTE_MIPMAPS_SCENE_MODE_2D_NOT_TILED)
   {
     if (clamp(normCoord, vec2(0), vec2(1)) != normCoord)
@@ -25,6 +25,9 @@ struct SwapImagePushConstant
   int   sceneMode;
   float explicitLod;
   float backgroundBrightness;
+
+  // Scale of the bloom texture added to the sampled color; 0 if disabled.
+  float bloomIntensity;
 };
 
 #ifdef __cplusplus